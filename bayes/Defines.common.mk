@@ -17,9 +17,12 @@ SRCS += \
 	$(LIB)/bitmap.c \
 	$(LIB)/list.c \
 	$(LIB)/mt19937ar.c \
+	$(LIB)/perfctr.c \
 	$(LIB)/queue.c \
 	$(LIB)/random.c \
+	$(LIB)/report.c \
 	$(LIB)/thread.c \
+	$(LIB)/timer.c \
 	$(LIB)/vector.c \
 #
 OBJS := ${SRCS:.c=.o}
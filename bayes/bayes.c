@@ -74,6 +74,7 @@
 #include "data.h"
 #include "learner.h"
 #include "net.h"
+#include "report.h"
 #include "thread.h"
 #include "timer.h"
 #include "tm.h"
@@ -246,6 +247,16 @@ MAIN(argc, argv)
     global_insertPenalty = global_params[PARAM_INSERT];
     global_maxNumEdgeLearned = global_params[PARAM_EDGE];
     SIM_GET_NUM_CPU(numThread);
+    report_startup("bayes", argc, (char**)argv);
+    report_addParam("threads", numThread);
+    report_addParam("vars", numVar);
+    report_addParam("records", numRecord);
+    report_addParam("seed", randomSeed);
+    report_addParam("max_parents", maxNumParent);
+    report_addParam("percent_parent", percentParent);
+    report_addParam("insert_penalty", global_insertPenalty);
+    report_addParam("max_edges_learned", global_maxNumEdgeLearned);
+    report_addParam("quality", global_operationQualityFactor);
     TM_STARTUP(numThread);
     P_MEMORY_STARTUP(numThread);
     thread_startup(numThread);
@@ -299,6 +310,7 @@ MAIN(argc, argv)
     fflush(stdout);
     printf("Adtree time = %f\n",
            TIMER_DIFF_SECONDS(adtreeStartTime, adtreeStopTime));
+    report_addTime("adtree", TIMER_DIFF_SECONDS(adtreeStartTime, adtreeStopTime));
     fflush(stdout);
 
     /*
@@ -333,6 +345,7 @@ MAIN(argc, argv)
     fflush(stdout);
     printf("Learn time = %f\n",
            TIMER_DIFF_SECONDS(learnStartTime, learnStopTime));
+    report_addTime("learn", TIMER_DIFF_SECONDS(learnStartTime, learnStopTime));
     fflush(stdout);
 
     /*
@@ -341,6 +354,7 @@ MAIN(argc, argv)
 
     bool_t status = net_isCycle(learnerPtr->netPtr);
     assert(!status);
+    report_setVerified(TRUE);
 
 #ifndef SIMULATOR
     float learnScore = learner_score(learnerPtr);
@@ -363,6 +377,7 @@ MAIN(argc, argv)
 
     TM_SHUTDOWN();
     P_MEMORY_SHUTDOWN();
+    report_write();
 
     GOTO_SIM();
 
@@ -19,8 +19,6 @@ OUTPUT +=
 
 LIB := ../lib
 
-STM := ../../tl2
-
 LOSTM := ../../OpenTM/lostm
 
 
@@ -18,12 +18,15 @@ SRCS += \
 	table.c \
 	$(LIB)/bitmap.c \
 	$(LIB)/hash.c \
-	$(LIB)/hashtable.c \
+	$(LIB)/oahashtable.c \
 	$(LIB)/pair.c \
+	$(LIB)/perfctr.c \
 	$(LIB)/random.c \
 	$(LIB)/list.c \
 	$(LIB)/mt19937ar.c \
+	$(LIB)/report.c \
 	$(LIB)/thread.c \
+	$(LIB)/timer.c \
 	$(LIB)/vector.c \
 #
 OBJS := ${SRCS:.c=.o}
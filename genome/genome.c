@@ -76,6 +76,7 @@
 #include <string.h>
 #include "gene.h"
 #include "random.h"
+#include "report.h"
 #include "segments.h"
 #include "sequencer.h"
 #include "thread.h"
@@ -198,6 +199,12 @@ MAIN (argc,argv)
     long minNumSegment = global_params[PARAM_NUMBER];
     long numThread = global_params[PARAM_THREAD];
 
+    report_startup("genome", argc, (char**)argv);
+    report_addParam("gene", geneLength);
+    report_addParam("segment", segmentLength);
+    report_addParam("number", minNumSegment);
+    report_addParam("threads", numThread);
+
     TM_STARTUP(numThread);
     P_MEMORY_STARTUP(numThread);
     thread_startup(numThread);
@@ -241,6 +248,10 @@ MAIN (argc,argv)
     puts("done.");
     printf("Time = %lf\n", TIMER_DIFF_SECONDS(start, stop));
     fflush(stdout);
+    report_addTime("total", TIMER_DIFF_SECONDS(start, stop));
+    report_setThroughput("segments",
+                         vector_getSize(segmentsPtr->contentsPtr),
+                         TIMER_DIFF_SECONDS(start, stop));
 
     /* Check result */
     {
@@ -253,6 +264,7 @@ MAIN (argc,argv)
         }
         fflush(stdout);
         assert(strlen(sequence) >= strlen(gene));
+        report_setVerified(result == 0);
     }
 
     /* Clean up */
@@ -267,6 +279,7 @@ MAIN (argc,argv)
 
     TM_SHUTDOWN();
     P_MEMORY_SHUTDOWN();
+    report_write();
 
     GOTO_SIM();
 
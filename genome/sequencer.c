@@ -84,11 +84,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include "hash.h"
-#include "hashtable.h"
+#include "oahashtable.h"
 #include "segments.h"
 #include "sequencer.h"
 #include "table.h"
 #include "thread.h"
+#include "timer.h"
 #include "utility.h"
 #include "vector.h"
 #include "types.h"
@@ -173,7 +174,7 @@ sequencer_alloc (long geneLength, long segmentLength, segments_t* segmentsPtr)
     }
 
     sequencerPtr->uniqueSegmentsPtr =
-        hashtable_alloc(geneLength, &hashSegment, &compareSegment, -1, -1);
+        oahashtable_alloc(maxNumUniqueSegment, &hashSegment, &compareSegment);
     if (sequencerPtr->uniqueSegmentsPtr == NULL) {
         return NULL;
     }
@@ -241,7 +242,7 @@ sequencer_run (void* argPtr)
 
     sequencer_t* sequencerPtr = (sequencer_t*)argPtr;
 
-    hashtable_t*      uniqueSegmentsPtr;
+    oahashtable_t*    uniqueSegmentsPtr;
     endInfoEntry_t*   endInfoEntries;
     table_t**         startHashToConstructEntryTables;
     constructEntry_t* constructEntries;
@@ -266,11 +267,12 @@ sequencer_run (void* argPtr)
     long numUniqueSegment;
     long substringLength;
     long entryIndex;
+    oahashtable_iter_t it;
 
     /*
      * Step 1: Remove duplicate segments
      */
-#if defined(HTM) || defined(STM)
+#if defined(HTM) || defined(STM) || defined(LOCK)
     long numThread = thread_getNumThread();
     {
         /* Choose disjoint segments [i_start,i_stop) for each thread */
@@ -282,10 +284,11 @@ sequencer_run (void* argPtr)
             i_stop = i_start + partitionSize;
         }
     }
-#else /* !(HTM || STM) */
+#else /* !(HTM || STM || LOCK) */
     i_start = 0;
     i_stop = numSegment;
-#endif /* !(HTM || STM) */
+#endif /* !(HTM || STM || LOCK) */
+    TIMER_PHASE_BEGIN("genome step 1");
     for (i = i_start; i < i_stop; i+=CHUNK_STEP1) {
         TM_BEGIN();
         {
@@ -293,13 +296,14 @@ sequencer_run (void* argPtr)
             long ii_stop = MIN(i_stop, (i+CHUNK_STEP1));
             for (ii = i; ii < ii_stop; ii++) {
                 void* segment = vector_at(segmentsContentsPtr, ii);
-                TMHASHTABLE_INSERT(uniqueSegmentsPtr,
-                                   segment,
-                                   segment);
+                TMOAHASHTABLE_INSERT(uniqueSegmentsPtr,
+                                     segment,
+                                     segment);
             } /* ii */
         }
         TM_END();
     }
+    TIMER_PHASE_END();
 
     thread_barrier_wait();
 
@@ -324,95 +328,79 @@ sequencer_run (void* argPtr)
      */
 
     /* uniqueSegmentsPtr is constant now */
-    numUniqueSegment = hashtable_getSize(uniqueSegmentsPtr);
+    numUniqueSegment = oahashtable_getSize(uniqueSegmentsPtr);
     entryIndex = 0;
 
-#if defined(HTM) || defined(STM)
-    {
-        /* Choose disjoint segments [i_start,i_stop) for each thread */
-        long num = uniqueSegmentsPtr->numBucket;
-        long partitionSize = (num + numThread/2) / numThread; /* with rounding */
-        i_start = threadId * partitionSize;
-        if (threadId == (numThread - 1)) {
-            i_stop = num;
-        } else {
-            i_stop = i_start + partitionSize;
-        }
-    }
+#if defined(HTM) || defined(STM) || defined(LOCK)
+    /* Choose disjoint parts of the table for each thread */
+    oahashtable_iter_resetPart(&it, uniqueSegmentsPtr, threadId, numThread);
     {
         /* Approximate disjoint segments of element allocation in constructEntries */
         long partitionSize = (numUniqueSegment + numThread/2) / numThread; /* with rounding */
         entryIndex = threadId * partitionSize;
     }
-#else /* !(HTM || STM) */
-    i_start = 0;
-    i_stop = uniqueSegmentsPtr->numBucket;
+#else /* !(HTM || STM || LOCK) */
+    oahashtable_iter_reset(&it, uniqueSegmentsPtr);
     entryIndex = 0;
-#endif /* !(HTM || STM) */
-
-    for (i = i_start; i < i_stop; i++) {
-
-        list_t* chainPtr = uniqueSegmentsPtr->buckets[i];
-        list_iter_t it;
-        list_iter_reset(&it, chainPtr);
+#endif /* !(HTM || STM || LOCK) */
 
-        while (list_iter_hasNext(&it, chainPtr)) {
+    TIMER_PHASE_BEGIN("genome step 2a");
+    while (oahashtable_iter_hasNext(&it, uniqueSegmentsPtr)) {
 
-            char* segment =
-                (char*)((pair_t*)list_iter_next(&it, chainPtr))->firstPtr;
-            constructEntry_t* constructEntryPtr;
-            long j;
-            ulong_t startHash;
-            bool_t status;
+        char* segment = (char*)oahashtable_iter_next(&it, uniqueSegmentsPtr);
+        constructEntry_t* constructEntryPtr;
+        long j;
+        ulong_t startHash;
+        bool_t status;
 
-            /* Find an empty constructEntries entry */
-            TM_BEGIN();
-            while (((void*)TM_SHARED_READ_P(constructEntries[entryIndex].segment)) != NULL) {
-                entryIndex = (entryIndex + 1) % numUniqueSegment; /* look for empty */
-            }
-            constructEntryPtr = &constructEntries[entryIndex];
-            TM_SHARED_WRITE_P(constructEntryPtr->segment, segment);
-            TM_END();
-            entryIndex = (entryIndex + 1) % numUniqueSegment;
-
-            /*
-             * Save hashes (sdbm algorithm) of segment substrings
-             *
-             * endHashes will be computed for shorter substrings after matches
-             * have been made (in the next phase of the code). This will reduce
-             * the number of substrings for which hashes need to be computed.
-             *
-             * Since we can compute startHashes incrementally, we go ahead
-             * and compute all of them here.
-             */
-            /* constructEntryPtr is local now */
-            constructEntryPtr->endHash = (ulong_t)hashString(&segment[1]);
-
-            startHash = 0;
-            for (j = 1; j < segmentLength; j++) {
-                startHash = (ulong_t)segment[j-1] +
-                            (startHash << 6) + (startHash << 16) - startHash;
-                TM_BEGIN();
-                status = TMTABLE_INSERT(startHashToConstructEntryTables[j],
-                                        (ulong_t)startHash,
-                                        (void*)constructEntryPtr );
-                TM_END();
-                assert(status);
-            }
+        /* Find an empty constructEntries entry */
+        TM_BEGIN();
+        while (((void*)TM_SHARED_READ_P(constructEntries[entryIndex].segment)) != NULL) {
+            entryIndex = (entryIndex + 1) % numUniqueSegment; /* look for empty */
+        }
+        constructEntryPtr = &constructEntries[entryIndex];
+        TM_SHARED_WRITE_P(constructEntryPtr->segment, segment);
+        TM_END();
+        entryIndex = (entryIndex + 1) % numUniqueSegment;
 
-            /*
-             * For looking up construct entries quickly
-             */
+        /*
+         * Save hashes (sdbm algorithm) of segment substrings
+         *
+         * endHashes will be computed for shorter substrings after matches
+         * have been made (in the next phase of the code). This will reduce
+         * the number of substrings for which hashes need to be computed.
+         *
+         * Since we can compute startHashes incrementally, we go ahead
+         * and compute all of them here.
+         */
+        /* constructEntryPtr is local now */
+        constructEntryPtr->endHash = (ulong_t)hashString(&segment[1]);
+
+        startHash = 0;
+        for (j = 1; j < segmentLength; j++) {
             startHash = (ulong_t)segment[j-1] +
                         (startHash << 6) + (startHash << 16) - startHash;
             TM_BEGIN();
-            status = TMTABLE_INSERT(hashToConstructEntryTable,
+            status = TMTABLE_INSERT(startHashToConstructEntryTables[j],
                                     (ulong_t)startHash,
-                                    (void*)constructEntryPtr);
+                                    (void*)constructEntryPtr );
             TM_END();
             assert(status);
         }
+
+        /*
+         * For looking up construct entries quickly
+         */
+        startHash = (ulong_t)segment[j-1] +
+                    (startHash << 6) + (startHash << 16) - startHash;
+        TM_BEGIN();
+        status = TMTABLE_INSERT(hashToConstructEntryTable,
+                                (ulong_t)startHash,
+                                (void*)constructEntryPtr);
+        TM_END();
+        assert(status);
     }
+    TIMER_PHASE_END();
 
     thread_barrier_wait();
 
@@ -429,7 +417,7 @@ sequencer_run (void* argPtr)
         long index_start;
         long index_stop;
 
-#if defined(HTM) || defined(STM)
+#if defined(HTM) || defined(STM) || defined(LOCK)
         {
             /* Choose disjoint segments [index_start,index_stop) for each thread */
             long partitionSize = (numUniqueSegment + numThread/2) / numThread; /* with rounding */
@@ -440,12 +428,13 @@ sequencer_run (void* argPtr)
                 index_stop = index_start + partitionSize;
             }
         }
-#else /* !(HTM || STM) */
+#else /* !(HTM || STM || LOCK) */
         index_start = 0;
         index_stop = numUniqueSegment;
-#endif /* !(HTM || STM) */
+#endif /* !(HTM || STM || LOCK) */
 
         /* Iterating over disjoint itervals in the range [0, numUniqueSegment) */
+        TIMER_PHASE_BEGIN("genome step 2b");
         for (entryIndex = index_start;
              entryIndex < index_stop;
              entryIndex += endInfoEntries[entryIndex].jumpToNext)
@@ -519,6 +508,7 @@ sequencer_run (void* argPtr)
             } /* iterate over chain */
 
         } /* for (endIndex < numUniqueSegment) */
+        TIMER_PHASE_END();
 
         thread_barrier_wait();
 
@@ -532,6 +522,7 @@ sequencer_run (void* argPtr)
 .        */
 
         if (threadId == 0) {
+            TIMER_PHASE_BEGIN("genome step 2c");
             if (substringLength > 1) {
                 long index = segmentLength - substringLength + 1;
                 /* initialization if j and i: with i being the next end after j=0 */
@@ -557,6 +548,7 @@ sequencer_run (void* argPtr)
                 }
                 endInfoEntries[j].jumpToNext = i - j;
             }
+            TIMER_PHASE_END();
         }
 
         thread_barrier_wait();
@@ -636,7 +628,7 @@ sequencer_free (sequencer_t* sequencerPtr)
     free(sequencerPtr->endInfoEntries);
 #if 0
     /* TODO: fix mixed sequential/parallel allocation */
-    hashtable_free(sequencerPtr->uniqueSegmentsPtr);
+    oahashtable_free(sequencerPtr->uniqueSegmentsPtr);
     if (sequencerPtr->sequence != NULL) {
         free(sequencerPtr->sequence);
     }
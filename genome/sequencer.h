@@ -73,7 +73,7 @@
 #define SEQUENCER_H 1
 
 
-#include "hashtable.h"
+#include "oahashtable.h"
 #include "segments.h"
 #include "table.h"
 #include "tm.h"
@@ -94,7 +94,7 @@ typedef struct sequencer {
     segments_t* segmentsPtr;
 
     /* For removing duplicate segments */
-    hashtable_t* uniqueSegmentsPtr;
+    oahashtable_t* uniqueSegmentsPtr;
 
     /* For matching segments */
     endInfoEntry_t* endInfoEntries;
@@ -15,18 +15,43 @@ SRCS += \
 	packet.c \
 	preprocessor.c \
 	stream.c \
+	$(LIB)/btree.c \
+	$(LIB)/hashtable.c \
 	$(LIB)/list.c \
 	$(LIB)/mt19937ar.c \
+	$(LIB)/oahashtable.c \
 	$(LIB)/pair.c \
+	$(LIB)/perfctr.c \
 	$(LIB)/queue.c \
 	$(LIB)/random.c \
 	$(LIB)/rbtree.c \
+	$(LIB)/report.c \
+	$(LIB)/skiplist.c \
 	$(LIB)/thread.c \
+	$(LIB)/timer.c \
+	$(LIB)/tmbatch.c \
 	$(LIB)/vector.c \
 #
 OBJS := ${SRCS:.c=.o}
 
+# MAP=btree keeps the maps in a B+-tree (lib/btree.c), MAP=skiplist in a
+# skip list (lib/skiplist.c), MAP=hashtable in a resizable chained hash
+# table (lib/hashtable.c) and MAP=oahashtable in an open-addressing hash table
+# (lib/oahashtable.c) instead of a red-black tree
+MAP ?= rbtree
+ifeq ($(MAP),btree)
+CFLAGS += -DMAP_USE_BTREE
+else ifeq ($(MAP),skiplist)
+CFLAGS += -DMAP_USE_SKIPLIST
+else ifeq ($(MAP),hashtable)
+CFLAGS += -DMAP_USE_HASHTABLE
+else ifeq ($(MAP),oahashtable)
+CFLAGS += -DMAP_USE_OAHASHTABLE
+else ifeq ($(MAP),rbtree)
 CFLAGS += -DMAP_USE_RBTREE
+else
+$(error unknown MAP=$(MAP); use rbtree, btree, skiplist, hashtable or oahashtable)
+endif
 
 
 # ==============================================================================
@@ -77,6 +77,7 @@
 #include "detector.h"
 #include "dictionary.h"
 #include "packet.h"
+#include "report.h"
 #include "stream.h"
 #include "thread.h"
 #include "timer.h"
@@ -193,47 +194,65 @@ processPackets (void* argPtr)
 
     vector_t* errorVectorPtr = errorVectors[threadId];
 
+    tmbatch_t batch;
+    char* packets[TMBATCH_MAX_SIZE];
+    long numPacket;
+    long p;
+
+    tmbatch_init(&batch);
+
     while (1) {
 
-        char* bytes;
-        TM_BEGIN();
-        bytes = TMSTREAM_GETPACKET(streamPtr);
-        TM_END();
-        if (!bytes) {
+        /* One transaction takes as many packets as the batch size allows */
+        TM_BATCH_BEGIN(&batch);
+        for (numPacket = 0; numPacket < TM_BATCH_SIZE(&batch); numPacket++) {
+            char* bytes = TMSTREAM_GETPACKET(streamPtr);
+            if (!bytes) {
+                break;
+            }
+            packets[numPacket] = bytes;
+        }
+        TM_BATCH_END(&batch);
+        if (numPacket == 0) {
             break;
         }
 
-        packet_t* packetPtr = (packet_t*)bytes;
-        long flowId = packetPtr->flowId;
-
-        error_t error;
-        TM_BEGIN();
-        error = TMDECODER_PROCESS(decoderPtr,
-                                  bytes,
-                                  (PACKET_HEADER_LENGTH + packetPtr->length));
-        TM_END();
-        if (error) {
-            /*
-             * Currently, stream_generate() does not create these errors.
-             */
-            assert(0);
-            bool_t status = PVECTOR_PUSHBACK(errorVectorPtr, (void*)flowId);
-            assert(status);
-        }
+        for (p = 0; p < numPacket; p++) {
+
+            char* bytes = packets[p];
+            packet_t* packetPtr = (packet_t*)bytes;
+            long flowId = packetPtr->flowId;
 
-        char* data;
-        long decodedFlowId;
-        TM_BEGIN();
-        data = TMDECODER_GETCOMPLETE(decoderPtr, &decodedFlowId);
-        TM_END();
-        if (data) {
-            error_t error = PDETECTOR_PROCESS(detectorPtr, data);
-            P_FREE(data);
+            error_t error;
+            TM_BEGIN();
+            error = TMDECODER_PROCESS(decoderPtr,
+                                      bytes,
+                                      (PACKET_HEADER_LENGTH +
+                                       packetPtr->length));
+            TM_END();
             if (error) {
-                bool_t status = PVECTOR_PUSHBACK(errorVectorPtr,
-                                                 (void*)decodedFlowId);
+                /*
+                 * Currently, stream_generate() does not create these errors.
+                 */
+                assert(0);
+                bool_t status = PVECTOR_PUSHBACK(errorVectorPtr, (void*)flowId);
                 assert(status);
             }
+
+            char* data;
+            long decodedFlowId;
+            TM_BEGIN();
+            data = TMDECODER_GETCOMPLETE(decoderPtr, &decodedFlowId);
+            TM_END();
+            if (data) {
+                error_t error = PDETECTOR_PROCESS(detectorPtr, data);
+                P_FREE(data);
+                if (error) {
+                    bool_t status = PVECTOR_PUSHBACK(errorVectorPtr,
+                                                     (void*)decodedFlowId);
+                    assert(status);
+                }
+            }
         }
 
     }
@@ -259,6 +278,8 @@ MAIN(argc, argv)
     parseArgs(argc, (char** const)argv);
     long numThread = global_params[PARAM_THREAD];
     SIM_GET_NUM_CPU(numThread);
+    report_startup("intruder", argc, (char**)argv);
+    report_addParam("threads", numThread);
     TM_STARTUP(numThread);
     P_MEMORY_STARTUP(numThread);
     thread_startup(numThread);
@@ -271,6 +292,10 @@ MAIN(argc, argv)
     printf("Max data length = %li\n", maxDataLength);
     printf("Num flow        = %li\n", numFlow);
     printf("Random seed     = %li\n", randomSeed);
+    report_addParam("attack", percentAttack);
+    report_addParam("length", maxDataLength);
+    report_addParam("num", numFlow);
+    report_addParam("seed", randomSeed);
 
     dictionary_t* dictionaryPtr = dictionary_alloc();
     assert(dictionaryPtr);
@@ -282,6 +307,7 @@ MAIN(argc, argv)
                                      randomSeed,
                                      maxDataLength);
     printf("Num attack      = %li\n", numAttack);
+    long numPacket = stream_getNumPacket(streamPtr);
 
     decoder_t* decoderPtr = decoder_alloc();
     assert(decoderPtr);
@@ -320,6 +346,10 @@ MAIN(argc, argv)
     TIMER_T stopTime;
     TIMER_READ(stopTime);
     printf("Elapsed time    = %f seconds\n", TIMER_DIFF_SECONDS(startTime, stopTime));
+    report_addTime("total", TIMER_DIFF_SECONDS(startTime, stopTime));
+    report_setThroughput("packets",
+                         numPacket,
+                         TIMER_DIFF_SECONDS(startTime, stopTime));
 
     /*
      * Check solution
@@ -339,6 +369,7 @@ MAIN(argc, argv)
     }
     printf("Num found       = %li\n", numFound);
     assert(numFound == numAttack);
+    report_setVerified(TRUE);
 
     /*
      * Clean up
@@ -354,6 +385,7 @@ MAIN(argc, argv)
 
     TM_SHUTDOWN();
     P_MEMORY_SHUTDOWN();
+    report_write();
 
     GOTO_SIM();
 
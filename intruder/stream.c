@@ -90,6 +90,7 @@ struct stream {
     vector_t* allocVectorPtr;
     queue_t* packetQueuePtr;
     MAP_T* attackMapPtr;
+    long numPacket;
 };
 
 
@@ -114,6 +115,7 @@ stream_alloc (long percentAttack)
         assert(streamPtr->packetQueuePtr);
         streamPtr->attackMapPtr = MAP_ALLOC(NULL, NULL);
         assert(streamPtr->attackMapPtr);
+        streamPtr->numPacket = 0;
     }
 
     return streamPtr;
@@ -148,9 +150,10 @@ stream_free (stream_t* streamPtr)
  * splitIntoPackets
  * -- Packets will be equal-size chunks except for last one, which will have
  *    all extra bytes
+ * -- Returns number of packets
  * =============================================================================
  */
-static void
+static long
 splitIntoPackets (char* str,
                   long flowId,
                   random_t* randomPtr,
@@ -193,6 +196,8 @@ splitIntoPackets (char* str,
     memcpy(packetPtr->data, (str + p * numDataByte), lastNumDataByte);
     status = queue_push(packetQueuePtr, (void*)packetPtr);
     assert(status);
+
+    return numPacket;
 }
 
 
@@ -222,6 +227,7 @@ stream_generate (stream_t* streamPtr,
 
     random_seed(randomPtr, seed);
     queue_clear(packetQueuePtr);
+    streamPtr->numPacket = 0;
 
     long range = '~' - ' ' + 1;
     assert(range > 0);
@@ -262,7 +268,8 @@ stream_generate (stream_t* streamPtr,
             }
             free(str2);
         }
-        splitIntoPackets(str, f, randomPtr, allocVectorPtr, packetQueuePtr);
+        streamPtr->numPacket +=
+            splitIntoPackets(str, f, randomPtr, allocVectorPtr, packetQueuePtr);
     }
 
     queue_shuffle(packetQueuePtr, randomPtr);
@@ -273,6 +280,18 @@ stream_generate (stream_t* streamPtr,
 }
 
 
+/* =============================================================================
+ * stream_getNumPacket
+ * -- Number of packets made by the last call to stream_generate
+ * =============================================================================
+ */
+long
+stream_getNumPacket (stream_t* streamPtr)
+{
+    return streamPtr->numPacket;
+}
+
+
 /* =============================================================================
  * stream_getPacket
  * -- If none, returns NULL
@@ -107,6 +107,15 @@ stream_generate (stream_t* streamPtr,
                  long maxLength);
 
 
+/* =============================================================================
+ * stream_getNumPacket
+ * -- Number of packets made by the last call to stream_generate
+ * =============================================================================
+ */
+long
+stream_getNumPacket (stream_t* streamPtr);
+
+
 /* =============================================================================
  * stream_getPacket
  * -- If none, returns NULL
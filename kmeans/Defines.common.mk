@@ -15,8 +15,12 @@ SRCS += \
 	kmeans.c \
 	normal.c \
 	$(LIB)/mt19937ar.c \
+	$(LIB)/perfctr.c \
 	$(LIB)/random.c \
+	$(LIB)/report.c \
 	$(LIB)/thread.c \
+	$(LIB)/timer.c \
+	$(LIB)/tmbatch.c \
 #
 OBJS := ${SRCS:.c=.o}
 
@@ -105,6 +105,7 @@
 #include <unistd.h>
 #include "cluster.h"
 #include "common.h"
+#include "report.h"
 #include "thread.h"
 #include "tm.h"
 #include "util.h"
@@ -274,6 +275,16 @@ MAIN(argc, argv)
         fclose(infile);
     }
 
+    report_startup("kmeans", argc, (char**)argv);
+    report_addParamString("input", filename);
+    report_addParam("objects", numObjects);
+    report_addParam("attributes", numAttributes);
+    report_addParam("max_clusters", max_nclusters);
+    report_addParam("min_clusters", min_nclusters);
+    report_addParam("threshold", threshold);
+    report_addParam("zscore", use_zscore_transform);
+    report_addParam("threads", nthreads);
+
     TM_STARTUP(nthreads);
     thread_startup(nthreads);
 
@@ -372,6 +383,9 @@ MAIN(argc, argv)
 #endif /* OUTPUT TO_STDOUT */
 
     printf("Time: %lg seconds\n", global_time);
+    report_addTime("total", global_time);
+    /* Every point is clustered once per number of clusters tried */
+    report_setThroughput("points", (double)numObjects * len, global_time);
 
     free(cluster_assign);
     free(attributes);
@@ -380,6 +394,7 @@ MAIN(argc, argv)
     free(buf);
 
     TM_SHUTDOWN();
+    report_write(); /* kmeans has no verification */
 
     GOTO_SIM();
 
@@ -88,6 +88,7 @@
 #include <float.h>
 #include <math.h>
 #include "common.h"
+#include "linetrace.h"
 #include "normal.h"
 #include "random.h"
 #include "thread.h"
@@ -138,14 +139,24 @@ work (void* argPtr)
     int j;
     int start;
     int stop;
+    int first;
+    int last;
     int myId;
+    tmbatch_t grabBatch;
+    tmbatch_t updateBatch;
 
     myId = thread_getId();
+    tmbatch_init(&grabBatch);
+    tmbatch_init(&updateBatch);
 
     start = myId * CHUNK;
+    stop = start + CHUNK;
 
+    TIMER_PHASE_BEGIN("kmeans assign");
     while (start < npoints) {
-        stop = (((start + CHUNK) < npoints) ? (start + CHUNK) : npoints);
+        if (stop > npoints) {
+            stop = npoints;
+        }
         for (i = start; i < stop; i++) {
 
             index = common_findNearestPoint(feature[i],
@@ -163,30 +174,45 @@ work (void* argPtr)
             /* Assign the membership to object i */
             /* membership[i] can't be changed by other thread */
             membership[i] = index;
+        }
 
-            /* Update new cluster centers : sum of objects located within */
-            TM_BEGIN();
-            TM_SHARED_WRITE(*new_centers_len[index],
-                            TM_SHARED_READ(*new_centers_len[index]) + 1);
-            for (j = 0; j < nfeatures; j++) {
-                TM_SHARED_WRITE_F(
-                    new_centers[index][j],
-                    (TM_SHARED_READ_F(new_centers[index][j]) + feature[i][j])
-                );
+        /*
+         * Update new cluster centers : sum of objects located within
+         * One transaction adds as many objects as the batch size allows
+         */
+        for (first = start; first < stop; first = last) {
+            TM_BATCH_BEGIN(&updateBatch);
+            last = first + (int)TM_BATCH_SIZE(&updateBatch);
+            if (last > stop) {
+                last = stop;
+            }
+            for (i = first; i < last; i++) {
+                index = membership[i];
+                TM_SHARED_WRITE(*new_centers_len[index],
+                                TM_SHARED_READ(*new_centers_len[index]) + 1);
+                for (j = 0; j < nfeatures; j++) {
+                    TM_SHARED_WRITE_F(
+                        new_centers[index][j],
+                        (TM_SHARED_READ_F(new_centers[index][j]) +
+                         feature[i][j])
+                    );
+                }
             }
-            TM_END();
+            TM_BATCH_END(&updateBatch);
         }
 
-        /* Update task queue */
-        if (start + CHUNK < npoints) {
-            TM_BEGIN();
+        /* Update task queue; one transaction may grab several chunks */
+        if (stop < npoints) {
+            TM_BATCH_BEGIN(&grabBatch);
             start = (int)TM_SHARED_READ(global_i);
-            TM_SHARED_WRITE(global_i, (start + CHUNK));
-            TM_END();
+            stop = start + CHUNK * (int)TM_BATCH_SIZE(&grabBatch);
+            TM_SHARED_WRITE(global_i, stop);
+            TM_BATCH_END(&grabBatch);
         } else {
             break;
         }
     }
+    TIMER_PHASE_END();
 
     TM_BEGIN();
     TM_SHARED_WRITE_F(global_delta, TM_SHARED_READ_F(global_delta) + delta);
@@ -259,6 +285,7 @@ normal_exec (int       nthreads,
             new_centers_len[i] = (int*)((char*)alloc_memory + cluster_size * i);
             new_centers[i] = (float*)((char*)alloc_memory + cluster_size * i + sizeof(int));
         }
+        LINETRACE_NAME_RANGE(alloc_memory, nclusters * cluster_size, "new_centers");
     }
 
     TIMER_READ(start);
@@ -279,6 +306,8 @@ normal_exec (int       nthreads,
 
         global_i = nthreads * CHUNK;
         global_delta = delta;
+        LINETRACE_NAME(global_i);
+        LINETRACE_NAME(global_delta);
 
 #ifdef OTM
 #pragma omp parallel
@@ -292,6 +321,7 @@ normal_exec (int       nthreads,
         delta = global_delta;
 
         /* Replace old cluster centers with new_centers */
+        TIMER_PHASE_BEGIN("kmeans update");
         for (i = 0; i < nclusters; i++) {
             for (j = 0; j < nfeatures; j++) {
                 if (new_centers_len[i] > 0) {
@@ -301,6 +331,7 @@ normal_exec (int       nthreads,
             }
             *new_centers_len[i] = 0;   /* set back to 0 */
         }
+        TIMER_PHASE_END();
 
         delta /= npoints;
 
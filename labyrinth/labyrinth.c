@@ -75,6 +75,7 @@
 #include <stdlib.h>
 #include "list.h"
 #include "maze.h"
+#include "report.h"
 #include "router.h"
 #include "thread.h"
 #include "timer.h"
@@ -197,6 +198,13 @@ MAIN(argc, argv)
     parseArgs(argc, (char** const)argv);
     long numThread = global_params[PARAM_THREAD];
     SIM_GET_NUM_CPU(numThread);
+    report_startup("labyrinth", argc, (char**)argv);
+    report_addParam("bend_cost", global_params[PARAM_BENDCOST]);
+    report_addParamString("input", global_inputFile);
+    report_addParam("threads", numThread);
+    report_addParam("x_cost", global_params[PARAM_XCOST]);
+    report_addParam("y_cost", global_params[PARAM_YCOST]);
+    report_addParam("z_cost", global_params[PARAM_ZCOST]);
     TM_STARTUP(numThread);
     P_MEMORY_STARTUP(numThread);
     thread_startup(numThread);
@@ -239,6 +247,10 @@ MAIN(argc, argv)
     }
     printf("Paths routed    = %li\n", numPathRouted);
     printf("Elapsed time    = %f seconds\n", TIMER_DIFF_SECONDS(startTime, stopTime));
+    report_addTime("total", TIMER_DIFF_SECONDS(startTime, stopTime));
+    report_setThroughput("paths",
+                         numPathRouted,
+                         TIMER_DIFF_SECONDS(startTime, stopTime));
 
     /*
      * Check solution and clean up
@@ -247,11 +259,13 @@ MAIN(argc, argv)
     bool_t status = maze_checkPaths(mazePtr, pathVectorListPtr, global_doPrint);
     assert(status == TRUE);
     puts("Verification passed.");
+    report_setVerified(TRUE);
     maze_free(mazePtr);
     router_free(routerPtr);
 
     TM_SHUTDOWN();
     P_MEMORY_SHUTDOWN();
+    report_write();
 
     GOTO_SIM();
 
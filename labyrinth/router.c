@@ -265,14 +265,16 @@ traceToNeighbor (grid_t* myGridPtr,
 
 
 /* =============================================================================
- * PdoTraceback
+ * TMdoTraceback
+ * -- Path vector is allocated transactionally so an abort reclaims it
  * =============================================================================
  */
 static vector_t*
-PdoTraceback (grid_t* gridPtr, grid_t* myGridPtr,
-              coordinate_t* dstPtr, long bendCost)
+TMdoTraceback (TM_ARGDECL
+               grid_t* gridPtr, grid_t* myGridPtr,
+               coordinate_t* dstPtr, long bendCost)
 {
-    vector_t* pointVectorPtr = PVECTOR_ALLOC(1);
+    vector_t* pointVectorPtr = TMVECTOR_ALLOC(1);
     assert(pointVectorPtr);
 
     point_t next;
@@ -285,7 +287,7 @@ PdoTraceback (grid_t* gridPtr, grid_t* myGridPtr,
     while (1) {
 
         long* gridPointPtr = grid_getPointRef(gridPtr, next.x, next.y, next.z);
-        PVECTOR_PUSHBACK(pointVectorPtr, (void*)gridPointPtr);
+        TMVECTOR_PUSHBACK(pointVectorPtr, (void*)gridPointPtr);
         grid_setPoint(myGridPtr, next.x, next.y, next.z, GRID_POINT_FULL);
 
         /* Check if we are done */
@@ -329,7 +331,7 @@ PdoTraceback (grid_t* gridPtr, grid_t* myGridPtr,
                 (curr.y == next.y) &&
                 (curr.z == next.z))
             {
-                PVECTOR_FREE(pointVectorPtr);
+                TMVECTOR_FREE(pointVectorPtr);
 #if DEBUG
                 puts("[dead]");
 #endif
@@ -397,12 +399,8 @@ router_solve (void* argPtr)
         grid_copy(myGridPtr, gridPtr); /* ok if not most up-to-date */
         if (PdoExpansion(routerPtr, myGridPtr, myExpansionQueuePtr,
                          srcPtr, dstPtr)) {
-            pointVectorPtr = PdoTraceback(gridPtr, myGridPtr, dstPtr, bendCost);
-            /*
-             * TODO: fix memory leak
-             *
-             * pointVectorPtr will be a memory leak if we abort this transaction
-             */
+            pointVectorPtr = TMdoTraceback(TM_ARG
+                                           gridPtr, myGridPtr, dstPtr, bendCost);
             if (pointVectorPtr) {
                 TMGRID_ADDPATH(gridPtr, pointVectorPtr);
                 TM_LOCAL_WRITE(success, TRUE);
@@ -89,6 +89,7 @@ using std::size_t;
 #endif
 
 #include "avltree.h"
+#include "memory.h"
 #include "tm.h"
 
 #ifndef HEIGHT_LIMIT
@@ -103,6 +104,9 @@ typedef struct jsw_avlnode {
   struct jsw_avlnode *link[2]; /* Left (0) and right (1) links */
 } jsw_avlnode_t;
 
+static memory_type_t global_nodeType =
+  MEMORY_TYPE_INITIALIZER ( sizeof ( jsw_avlnode_t ) );
+
 struct jsw_avltree {
   jsw_avlnode_t *root; /* Top of the tree */
   cmp_f          cmp;    /* Compare two items */
@@ -193,7 +197,7 @@ struct jsw_avltrav {
 
 static jsw_avlnode_t *new_node ( jsw_avltree_t *tree, void *data )
 {
-  jsw_avlnode_t *rn = (jsw_avlnode_t *)malloc ( sizeof *rn );
+  jsw_avlnode_t *rn = (jsw_avlnode_t *)memory_allocType ( &global_nodeType );
 
   if ( rn == NULL )
     return NULL;
@@ -212,7 +216,7 @@ static jsw_avlnode_t *new_node ( jsw_avltree_t *tree, void *data )
 
 static jsw_avlnode_t *Pnew_node ( jsw_avltree_t *tree, void *data )
 {
-  jsw_avlnode_t *rn = (jsw_avlnode_t *)P_MALLOC ( sizeof *rn );
+  jsw_avlnode_t *rn = (jsw_avlnode_t *)P_MALLOC_TYPE ( &global_nodeType );
 
   if ( rn == NULL )
     return NULL;
@@ -286,7 +290,7 @@ void jsw_avldelete ( jsw_avltree_t *tree )
 #if USE_DUP_AND_REL
       tree->rel ( it->data );
 #endif
-      free ( it );
+      memory_free ( it );
     }
     else {
       /* Rotate right */
@@ -507,7 +511,7 @@ long jsw_avlerase ( jsw_avltree_t *tree, void *data )
 #if USE_DUP_AND_REL
       tree->rel ( it->data );
 #endif
-      free ( it );
+      memory_free ( it );
     }
     else {
       /* Find the inorder successor */
@@ -535,7 +539,7 @@ long jsw_avlerase ( jsw_avltree_t *tree, void *data )
 #if USE_DUP_AND_REL
       tree->rel ( heir->data );
 #endif
-      free ( heir );
+      memory_free ( heir );
     }
 
     /* Walk back up the search path */
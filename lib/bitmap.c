@@ -73,6 +73,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "bitmap.h"
+#include "memory.h"
 #include "tm.h"
 #include "types.h"
 #include "utility.h"
@@ -132,7 +133,7 @@ Pbitmap_alloc (long numBit)
 
     bitmapPtr->bits = (ulong_t*)P_MALLOC(numWord * sizeof(ulong_t));
     if (bitmapPtr->bits == NULL) {
-        free(bitmapPtr);
+        P_FREE(bitmapPtr);
         return NULL;
     }
     memset(bitmapPtr->bits, 0, (numWord * sizeof(ulong_t)));
@@ -148,8 +149,8 @@ Pbitmap_alloc (long numBit)
 void
 bitmap_free (bitmap_t* bitmapPtr)
 {
-    free(bitmapPtr->bits);
-    free(bitmapPtr);
+    memory_free(bitmapPtr->bits);
+    memory_free(bitmapPtr);
 }
 
 
@@ -0,0 +1,1435 @@
+/* =============================================================================
+ *
+ * btree.c
+ * -- B+-tree ordered map with fat nodes
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ *
+ * Values are kept only in the leaves, which are linked in key order; inner
+ * nodes hold separator keys. Each node holds up to BTREE_MAX_KEY keys in one
+ * array that is searched by bisection, so a lookup reads a few keys from each
+ * of a few levels instead of one node per level of a binary tree.
+ *
+ * Nodes are split on the way down during insertion and refilled (borrowing
+ * from or merging with a sibling) on the way down during deletion, so every
+ * update makes one pass from the root to a leaf.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "btree.h"
+#include "memory.h"
+#include "tm.h"
+#include "types.h"
+
+
+#if (BTREE_MAX_KEY < 3) || ((BTREE_MAX_KEY % 2) == 0)
+#  error "BTREE_MAX_KEY must be odd and at least 3"
+#endif
+
+#define BTREE_MIN_KEY (BTREE_MAX_KEY / 2)
+
+typedef struct btree_node {
+    long numKey;
+    bool_t isLeaf;
+    void* keys[BTREE_MAX_KEY];
+    void* ptrs[BTREE_MAX_KEY + 1]; /* children, or values and next leaf */
+} btree_node_t;
+
+struct btree {
+    btree_node_t* root;
+    long (*compare)(const void*, const void*);
+};
+
+#define NEXT_LEAF BTREE_MAX_KEY /* index of next leaf in ptrs */
+
+#define LDNUM(n)            ((n)->numKey)
+#define STNUM(n,v)          ((n)->numKey = (v))
+#define LDKEY(n,i)          ((n)->keys[i])
+#define STKEY(n,i,v)        ((n)->keys[i] = (v))
+#define LDPTR(n,i)          ((n)->ptrs[i])
+#define STPTR(n,i,v)        ((n)->ptrs[i] = (void*)(v))
+#define LDNODE(n,i)         ((btree_node_t*)LDPTR(n, i))
+
+#define TX_LDNUM(n)         ((long)TM_SHARED_READ((n)->numKey))
+#define TX_STNUM(n,v)       TM_SHARED_WRITE((n)->numKey, (v))
+#define TX_LDKEY(n,i)       ((void*)TM_SHARED_READ_P((n)->keys[i]))
+#define TX_STKEY(n,i,v)     TM_SHARED_WRITE_P((n)->keys[i], (v))
+#define TX_LDPTR(n,i)       ((void*)TM_SHARED_READ_P((n)->ptrs[i]))
+#define TX_STPTR(n,i,v)     TM_SHARED_WRITE_P((n)->ptrs[i], (void*)(v))
+#define TX_LDNODE(n,i)      ((btree_node_t*)TX_LDPTR(n, i))
+
+
+/* =============================================================================
+ * compareKeysDefault
+ * =============================================================================
+ */
+static long
+compareKeysDefault (const void* a, const void* b)
+{
+    long aKey = (long)a;
+    long bKey = (long)b;
+
+    return ((aKey < bKey) ? -1 : ((aKey > bKey) ? 1 : 0));
+}
+
+
+/* =============================================================================
+ * allocNode
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+static btree_node_t*
+allocNode (bool_t isLeaf)
+{
+    btree_node_t* nodePtr = (btree_node_t*)malloc(sizeof(btree_node_t));
+
+    if (nodePtr != NULL) {
+        nodePtr->numKey = 0;
+        nodePtr->isLeaf = isLeaf;
+        nodePtr->ptrs[NEXT_LEAF] = NULL;
+    }
+
+    return nodePtr;
+}
+
+
+/* =============================================================================
+ * TMallocNode
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+static btree_node_t*
+TMallocNode (TM_ARGDECL  bool_t isLeaf)
+{
+    btree_node_t* nodePtr = (btree_node_t*)TM_MALLOC(sizeof(btree_node_t));
+
+    if (nodePtr != NULL) {
+        nodePtr->numKey = 0;
+        nodePtr->isLeaf = isLeaf;
+        nodePtr->ptrs[NEXT_LEAF] = NULL;
+    }
+
+    return nodePtr;
+}
+
+
+/* =============================================================================
+ * search
+ * -- Returns index of key if found, else index of first larger key
+ * =============================================================================
+ */
+static long
+search (btree_t* btreePtr, btree_node_t* nodePtr, void* key, bool_t* foundPtr)
+{
+    long lo = 0;
+    long hi = LDNUM(nodePtr);
+
+    while (lo < hi) {
+        long mid = (lo + hi) / 2;
+        long cmp = btreePtr->compare(key, LDKEY(nodePtr, mid));
+        if (cmp == 0) {
+            *foundPtr = TRUE;
+            return mid;
+        }
+        if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    *foundPtr = FALSE;
+
+    return lo;
+}
+
+
+/* =============================================================================
+ * TMsearch
+ * -- Returns index of key if found, else index of first larger key
+ * =============================================================================
+ */
+static long
+TMsearch (TM_ARGDECL
+          btree_t* btreePtr, btree_node_t* nodePtr, void* key, bool_t* foundPtr)
+{
+    long lo = 0;
+    long hi = TX_LDNUM(nodePtr);
+
+    while (lo < hi) {
+        long mid = (lo + hi) / 2;
+        long cmp = btreePtr->compare(key, TX_LDKEY(nodePtr, mid));
+        if (cmp == 0) {
+            *foundPtr = TRUE;
+            return mid;
+        }
+        if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    *foundPtr = FALSE;
+
+    return lo;
+}
+
+
+/* =============================================================================
+ * lookup
+ * -- Returns leaf holding key and sets *indexPtr, or NULL if not found
+ * =============================================================================
+ */
+static btree_node_t*
+lookup (btree_t* btreePtr, void* key, long* indexPtr)
+{
+    btree_node_t* nodePtr = btreePtr->root;
+    bool_t found;
+
+    while (!nodePtr->isLeaf) {
+        long c = search(btreePtr, nodePtr, key, &found);
+        nodePtr = LDNODE(nodePtr, (found ? (c + 1) : c));
+    }
+
+    *indexPtr = search(btreePtr, nodePtr, key, &found);
+
+    return (found ? nodePtr : NULL);
+}
+
+
+/* =============================================================================
+ * TMlookup
+ * -- Returns leaf holding key and sets *indexPtr, or NULL if not found
+ * =============================================================================
+ */
+static btree_node_t*
+TMlookup (TM_ARGDECL  btree_t* btreePtr, void* key, long* indexPtr)
+{
+    btree_node_t* nodePtr = (btree_node_t*)TM_SHARED_READ_P(btreePtr->root);
+    bool_t found;
+
+    while (!nodePtr->isLeaf) {
+        long c = TMsearch(TM_ARG  btreePtr, nodePtr, key, &found);
+        nodePtr = TX_LDNODE(nodePtr, (found ? (c + 1) : c));
+    }
+
+    *indexPtr = TMsearch(TM_ARG  btreePtr, nodePtr, key, &found);
+
+    return (found ? nodePtr : NULL);
+}
+
+
+/* =============================================================================
+ * splitChild
+ * -- Splits the full child c of a non-full parent into two nodes
+ * -- Returns FALSE on allocation failure
+ * =============================================================================
+ */
+static bool_t
+splitChild (btree_node_t* parentPtr, long c)
+{
+    btree_node_t* leftPtr = LDNODE(parentPtr, c);
+    btree_node_t* rightPtr = allocNode(leftPtr->isLeaf);
+    long numParentKey = LDNUM(parentPtr);
+    void* separator;
+    long mid;
+    long i;
+
+    if (rightPtr == NULL) {
+        return FALSE;
+    }
+
+    if (leftPtr->isLeaf) {
+        /* Upper half moves right; its first key is copied up */
+        mid = (BTREE_MAX_KEY + 1) / 2;
+        for (i = mid; i < BTREE_MAX_KEY; i++) {
+            rightPtr->keys[i - mid] = LDKEY(leftPtr, i);
+            rightPtr->ptrs[i - mid] = LDPTR(leftPtr, i);
+        }
+        rightPtr->numKey = BTREE_MAX_KEY - mid;
+        rightPtr->ptrs[NEXT_LEAF] = LDPTR(leftPtr, NEXT_LEAF);
+        STPTR(leftPtr, NEXT_LEAF, rightPtr);
+        separator = rightPtr->keys[0];
+    } else {
+        /* Upper half moves right; the middle key moves up */
+        mid = BTREE_MAX_KEY / 2;
+        for (i = mid + 1; i < BTREE_MAX_KEY; i++) {
+            rightPtr->keys[i - mid - 1] = LDKEY(leftPtr, i);
+        }
+        for (i = mid + 1; i <= BTREE_MAX_KEY; i++) {
+            rightPtr->ptrs[i - mid - 1] = LDPTR(leftPtr, i);
+        }
+        rightPtr->numKey = BTREE_MAX_KEY - mid - 1;
+        separator = LDKEY(leftPtr, mid);
+    }
+    STNUM(leftPtr, mid);
+
+    for (i = numParentKey; i > c; i--) {
+        STKEY(parentPtr, i, LDKEY(parentPtr, (i - 1)));
+        STPTR(parentPtr, (i + 1), LDPTR(parentPtr, i));
+    }
+    STKEY(parentPtr, c, separator);
+    STPTR(parentPtr, (c + 1), rightPtr);
+    STNUM(parentPtr, (numParentKey + 1));
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TMsplitChild
+ * -- The new node is private to the transaction until linked in, so it is
+ *    filled with plain stores and does not enter the write set
+ * =============================================================================
+ */
+static bool_t
+TMsplitChild (TM_ARGDECL  btree_node_t* parentPtr, long c)
+{
+    btree_node_t* leftPtr = TX_LDNODE(parentPtr, c);
+    btree_node_t* rightPtr = TMallocNode(TM_ARG  leftPtr->isLeaf);
+    long numParentKey = TX_LDNUM(parentPtr);
+    void* separator;
+    long mid;
+    long i;
+
+    if (rightPtr == NULL) {
+        return FALSE;
+    }
+
+    if (leftPtr->isLeaf) {
+        /* Upper half moves right; its first key is copied up */
+        mid = (BTREE_MAX_KEY + 1) / 2;
+        for (i = mid; i < BTREE_MAX_KEY; i++) {
+            rightPtr->keys[i - mid] = TX_LDKEY(leftPtr, i);
+            rightPtr->ptrs[i - mid] = TX_LDPTR(leftPtr, i);
+        }
+        rightPtr->numKey = BTREE_MAX_KEY - mid;
+        rightPtr->ptrs[NEXT_LEAF] = TX_LDPTR(leftPtr, NEXT_LEAF);
+        TX_STPTR(leftPtr, NEXT_LEAF, rightPtr);
+        separator = rightPtr->keys[0];
+    } else {
+        /* Upper half moves right; the middle key moves up */
+        mid = BTREE_MAX_KEY / 2;
+        for (i = mid + 1; i < BTREE_MAX_KEY; i++) {
+            rightPtr->keys[i - mid - 1] = TX_LDKEY(leftPtr, i);
+        }
+        for (i = mid + 1; i <= BTREE_MAX_KEY; i++) {
+            rightPtr->ptrs[i - mid - 1] = TX_LDPTR(leftPtr, i);
+        }
+        rightPtr->numKey = BTREE_MAX_KEY - mid - 1;
+        separator = TX_LDKEY(leftPtr, mid);
+    }
+    TX_STNUM(leftPtr, mid);
+
+    for (i = numParentKey; i > c; i--) {
+        TX_STKEY(parentPtr, i, TX_LDKEY(parentPtr, (i - 1)));
+        TX_STPTR(parentPtr, (i + 1), TX_LDPTR(parentPtr, i));
+    }
+    TX_STKEY(parentPtr, c, separator);
+    TX_STPTR(parentPtr, (c + 1), rightPtr);
+    TX_STNUM(parentPtr, (numParentKey + 1));
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * borrowFromLeft
+ * -- Moves the last entry of child c-1 to the front of child c
+ * =============================================================================
+ */
+static void
+borrowFromLeft (btree_node_t* parentPtr, long c)
+{
+    btree_node_t* leftPtr = LDNODE(parentPtr, (c - 1));
+    btree_node_t* childPtr = LDNODE(parentPtr, c);
+    long numLeftKey = LDNUM(leftPtr);
+    long numKey = LDNUM(childPtr);
+    long i;
+
+    if (childPtr->isLeaf) {
+        for (i = numKey; i > 0; i--) {
+            STKEY(childPtr, i, LDKEY(childPtr, (i - 1)));
+            STPTR(childPtr, i, LDPTR(childPtr, (i - 1)));
+        }
+        void* key = LDKEY(leftPtr, (numLeftKey - 1));
+        STKEY(childPtr, 0, key);
+        STPTR(childPtr, 0, LDPTR(leftPtr, (numLeftKey - 1)));
+        STKEY(parentPtr, (c - 1), key);
+    } else {
+        STPTR(childPtr, (numKey + 1), LDPTR(childPtr, numKey));
+        for (i = numKey; i > 0; i--) {
+            STKEY(childPtr, i, LDKEY(childPtr, (i - 1)));
+            STPTR(childPtr, i, LDPTR(childPtr, (i - 1)));
+        }
+        STKEY(childPtr, 0, LDKEY(parentPtr, (c - 1)));
+        STPTR(childPtr, 0, LDPTR(leftPtr, numLeftKey));
+        STKEY(parentPtr, (c - 1), LDKEY(leftPtr, (numLeftKey - 1)));
+    }
+
+    STNUM(leftPtr, (numLeftKey - 1));
+    STNUM(childPtr, (numKey + 1));
+}
+
+
+/* =============================================================================
+ * TMborrowFromLeft
+ * -- Moves the last entry of child c-1 to the front of child c
+ * =============================================================================
+ */
+static void
+TMborrowFromLeft (TM_ARGDECL  btree_node_t* parentPtr, long c)
+{
+    btree_node_t* leftPtr = TX_LDNODE(parentPtr, (c - 1));
+    btree_node_t* childPtr = TX_LDNODE(parentPtr, c);
+    long numLeftKey = TX_LDNUM(leftPtr);
+    long numKey = TX_LDNUM(childPtr);
+    long i;
+
+    if (childPtr->isLeaf) {
+        for (i = numKey; i > 0; i--) {
+            TX_STKEY(childPtr, i, TX_LDKEY(childPtr, (i - 1)));
+            TX_STPTR(childPtr, i, TX_LDPTR(childPtr, (i - 1)));
+        }
+        void* key = TX_LDKEY(leftPtr, (numLeftKey - 1));
+        TX_STKEY(childPtr, 0, key);
+        TX_STPTR(childPtr, 0, TX_LDPTR(leftPtr, (numLeftKey - 1)));
+        TX_STKEY(parentPtr, (c - 1), key);
+    } else {
+        TX_STPTR(childPtr, (numKey + 1), TX_LDPTR(childPtr, numKey));
+        for (i = numKey; i > 0; i--) {
+            TX_STKEY(childPtr, i, TX_LDKEY(childPtr, (i - 1)));
+            TX_STPTR(childPtr, i, TX_LDPTR(childPtr, (i - 1)));
+        }
+        TX_STKEY(childPtr, 0, TX_LDKEY(parentPtr, (c - 1)));
+        TX_STPTR(childPtr, 0, TX_LDPTR(leftPtr, numLeftKey));
+        TX_STKEY(parentPtr, (c - 1), TX_LDKEY(leftPtr, (numLeftKey - 1)));
+    }
+
+    TX_STNUM(leftPtr, (numLeftKey - 1));
+    TX_STNUM(childPtr, (numKey + 1));
+}
+
+
+/* =============================================================================
+ * borrowFromRight
+ * -- Moves the first entry of child c+1 to the end of child c
+ * =============================================================================
+ */
+static void
+borrowFromRight (btree_node_t* parentPtr, long c)
+{
+    btree_node_t* childPtr = LDNODE(parentPtr, c);
+    btree_node_t* rightPtr = LDNODE(parentPtr, (c + 1));
+    long numKey = LDNUM(childPtr);
+    long numRightKey = LDNUM(rightPtr);
+    long i;
+
+    if (childPtr->isLeaf) {
+        STKEY(childPtr, numKey, LDKEY(rightPtr, 0));
+        STPTR(childPtr, numKey, LDPTR(rightPtr, 0));
+        for (i = 0; i < (numRightKey - 1); i++) {
+            STKEY(rightPtr, i, LDKEY(rightPtr, (i + 1)));
+            STPTR(rightPtr, i, LDPTR(rightPtr, (i + 1)));
+        }
+        STKEY(parentPtr, c, LDKEY(rightPtr, 0));
+    } else {
+        STKEY(childPtr, numKey, LDKEY(parentPtr, c));
+        STPTR(childPtr, (numKey + 1), LDPTR(rightPtr, 0));
+        STKEY(parentPtr, c, LDKEY(rightPtr, 0));
+        for (i = 0; i < (numRightKey - 1); i++) {
+            STKEY(rightPtr, i, LDKEY(rightPtr, (i + 1)));
+        }
+        for (i = 0; i < numRightKey; i++) {
+            STPTR(rightPtr, i, LDPTR(rightPtr, (i + 1)));
+        }
+    }
+
+    STNUM(rightPtr, (numRightKey - 1));
+    STNUM(childPtr, (numKey + 1));
+}
+
+
+/* =============================================================================
+ * TMborrowFromRight
+ * -- Moves the first entry of child c+1 to the end of child c
+ * =============================================================================
+ */
+static void
+TMborrowFromRight (TM_ARGDECL  btree_node_t* parentPtr, long c)
+{
+    btree_node_t* childPtr = TX_LDNODE(parentPtr, c);
+    btree_node_t* rightPtr = TX_LDNODE(parentPtr, (c + 1));
+    long numKey = TX_LDNUM(childPtr);
+    long numRightKey = TX_LDNUM(rightPtr);
+    long i;
+
+    if (childPtr->isLeaf) {
+        TX_STKEY(childPtr, numKey, TX_LDKEY(rightPtr, 0));
+        TX_STPTR(childPtr, numKey, TX_LDPTR(rightPtr, 0));
+        for (i = 0; i < (numRightKey - 1); i++) {
+            TX_STKEY(rightPtr, i, TX_LDKEY(rightPtr, (i + 1)));
+            TX_STPTR(rightPtr, i, TX_LDPTR(rightPtr, (i + 1)));
+        }
+        TX_STKEY(parentPtr, c, TX_LDKEY(rightPtr, 0));
+    } else {
+        TX_STKEY(childPtr, numKey, TX_LDKEY(parentPtr, c));
+        TX_STPTR(childPtr, (numKey + 1), TX_LDPTR(rightPtr, 0));
+        TX_STKEY(parentPtr, c, TX_LDKEY(rightPtr, 0));
+        for (i = 0; i < (numRightKey - 1); i++) {
+            TX_STKEY(rightPtr, i, TX_LDKEY(rightPtr, (i + 1)));
+        }
+        for (i = 0; i < numRightKey; i++) {
+            TX_STPTR(rightPtr, i, TX_LDPTR(rightPtr, (i + 1)));
+        }
+    }
+
+    TX_STNUM(rightPtr, (numRightKey - 1));
+    TX_STNUM(childPtr, (numKey + 1));
+}
+
+
+/* =============================================================================
+ * mergeChildren
+ * -- Appends child s+1 and the separator between them to child s
+ * =============================================================================
+ */
+static void
+mergeChildren (btree_node_t* parentPtr, long s)
+{
+    btree_node_t* leftPtr = LDNODE(parentPtr, s);
+    btree_node_t* rightPtr = LDNODE(parentPtr, (s + 1));
+    long numLeftKey = LDNUM(leftPtr);
+    long numRightKey = LDNUM(rightPtr);
+    long numParentKey = LDNUM(parentPtr);
+    long i;
+
+    if (leftPtr->isLeaf) {
+        for (i = 0; i < numRightKey; i++) {
+            STKEY(leftPtr, (numLeftKey + i), LDKEY(rightPtr, i));
+            STPTR(leftPtr, (numLeftKey + i), LDPTR(rightPtr, i));
+        }
+        STPTR(leftPtr, NEXT_LEAF, LDPTR(rightPtr, NEXT_LEAF));
+        STNUM(leftPtr, (numLeftKey + numRightKey));
+    } else {
+        STKEY(leftPtr, numLeftKey, LDKEY(parentPtr, s));
+        for (i = 0; i < numRightKey; i++) {
+            STKEY(leftPtr, (numLeftKey + 1 + i), LDKEY(rightPtr, i));
+        }
+        for (i = 0; i <= numRightKey; i++) {
+            STPTR(leftPtr, (numLeftKey + 1 + i), LDPTR(rightPtr, i));
+        }
+        STNUM(leftPtr, (numLeftKey + 1 + numRightKey));
+    }
+
+    for (i = s; i < (numParentKey - 1); i++) {
+        STKEY(parentPtr, i, LDKEY(parentPtr, (i + 1)));
+        STPTR(parentPtr, (i + 1), LDPTR(parentPtr, (i + 2)));
+    }
+    STNUM(parentPtr, (numParentKey - 1));
+
+    memory_free(rightPtr);
+}
+
+
+/* =============================================================================
+ * TMmergeChildren
+ * -- Appends child s+1 and the separator between them to child s
+ * =============================================================================
+ */
+static void
+TMmergeChildren (TM_ARGDECL  btree_node_t* parentPtr, long s)
+{
+    btree_node_t* leftPtr = TX_LDNODE(parentPtr, s);
+    btree_node_t* rightPtr = TX_LDNODE(parentPtr, (s + 1));
+    long numLeftKey = TX_LDNUM(leftPtr);
+    long numRightKey = TX_LDNUM(rightPtr);
+    long numParentKey = TX_LDNUM(parentPtr);
+    long i;
+
+    if (leftPtr->isLeaf) {
+        for (i = 0; i < numRightKey; i++) {
+            TX_STKEY(leftPtr, (numLeftKey + i), TX_LDKEY(rightPtr, i));
+            TX_STPTR(leftPtr, (numLeftKey + i), TX_LDPTR(rightPtr, i));
+        }
+        TX_STPTR(leftPtr, NEXT_LEAF, TX_LDPTR(rightPtr, NEXT_LEAF));
+        TX_STNUM(leftPtr, (numLeftKey + numRightKey));
+    } else {
+        TX_STKEY(leftPtr, numLeftKey, TX_LDKEY(parentPtr, s));
+        for (i = 0; i < numRightKey; i++) {
+            TX_STKEY(leftPtr, (numLeftKey + 1 + i), TX_LDKEY(rightPtr, i));
+        }
+        for (i = 0; i <= numRightKey; i++) {
+            TX_STPTR(leftPtr, (numLeftKey + 1 + i), TX_LDPTR(rightPtr, i));
+        }
+        TX_STNUM(leftPtr, (numLeftKey + 1 + numRightKey));
+    }
+
+    for (i = s; i < (numParentKey - 1); i++) {
+        TX_STKEY(parentPtr, i, TX_LDKEY(parentPtr, (i + 1)));
+        TX_STPTR(parentPtr, (i + 1), TX_LDPTR(parentPtr, (i + 2)));
+    }
+    TX_STNUM(parentPtr, (numParentKey - 1));
+
+    TM_FREE(rightPtr);
+}
+
+
+/* =============================================================================
+ * fillChild
+ * -- Gives child c of parent more than BTREE_MIN_KEY keys, or merges it
+ * -- Returns the new index of the child
+ * =============================================================================
+ */
+static long
+fillChild (btree_node_t* parentPtr, long c)
+{
+    long numParentKey = LDNUM(parentPtr);
+
+    if ((c > 0) && (LDNUM(LDNODE(parentPtr, (c - 1))) > BTREE_MIN_KEY)) {
+        borrowFromLeft(parentPtr, c);
+        return c;
+    }
+    if ((c < numParentKey) &&
+        (LDNUM(LDNODE(parentPtr, (c + 1))) > BTREE_MIN_KEY))
+    {
+        borrowFromRight(parentPtr, c);
+        return c;
+    }
+    if (c < numParentKey) {
+        mergeChildren(parentPtr, c);
+        return c;
+    }
+    mergeChildren(parentPtr, (c - 1));
+
+    return (c - 1);
+}
+
+
+/* =============================================================================
+ * TMfillChild
+ * -- Gives child c of parent more than BTREE_MIN_KEY keys, or merges it
+ * -- Returns the new index of the child
+ * =============================================================================
+ */
+static long
+TMfillChild (TM_ARGDECL  btree_node_t* parentPtr, long c)
+{
+    long numParentKey = TX_LDNUM(parentPtr);
+
+    if ((c > 0) && (TX_LDNUM(TX_LDNODE(parentPtr, (c - 1))) > BTREE_MIN_KEY)) {
+        TMborrowFromLeft(TM_ARG  parentPtr, c);
+        return c;
+    }
+    if ((c < numParentKey) &&
+        (TX_LDNUM(TX_LDNODE(parentPtr, (c + 1))) > BTREE_MIN_KEY))
+    {
+        TMborrowFromRight(TM_ARG  parentPtr, c);
+        return c;
+    }
+    if (c < numParentKey) {
+        TMmergeChildren(TM_ARG  parentPtr, c);
+        return c;
+    }
+    TMmergeChildren(TM_ARG  parentPtr, (c - 1));
+
+    return (c - 1);
+}
+
+
+/* =============================================================================
+ * freeNodes
+ * =============================================================================
+ */
+static void
+freeNodes (btree_node_t* nodePtr)
+{
+    if (!nodePtr->isLeaf) {
+        long i;
+        for (i = 0; i <= nodePtr->numKey; i++) {
+            freeNodes(LDNODE(nodePtr, i));
+        }
+    }
+
+    memory_free(nodePtr);
+}
+
+
+/* =============================================================================
+ * TMfreeNodes
+ * =============================================================================
+ */
+static void
+TMfreeNodes (TM_ARGDECL  btree_node_t* nodePtr)
+{
+    if (!nodePtr->isLeaf) {
+        long numKey = TX_LDNUM(nodePtr);
+        long i;
+        for (i = 0; i <= numKey; i++) {
+            TMfreeNodes(TM_ARG  TX_LDNODE(nodePtr, i));
+        }
+    }
+
+    TM_FREE(nodePtr);
+}
+
+
+/* =============================================================================
+ * verifyNode
+ * -- Returns number of keys below node, or -1 on error
+ * =============================================================================
+ */
+static long
+verifyNode (btree_t* btreePtr, btree_node_t* nodePtr,
+            void* lowKey, bool_t hasLow, void* highKey, bool_t hasHigh,
+            long depth, long* leafDepthPtr, btree_node_t** leafPtrPtr)
+{
+    long numKey = nodePtr->numKey;
+    long numEntry = 0;
+    long i;
+
+    if ((numKey > BTREE_MAX_KEY) ||
+        ((nodePtr != btreePtr->root) && (numKey < BTREE_MIN_KEY)))
+    {
+        printf("  (WARNING) node %p has %li keys\n", (void*)nodePtr, numKey);
+        return -1;
+    }
+
+    for (i = 0; i < numKey; i++) {
+        void* key = nodePtr->keys[i];
+        if ((i > 0 && btreePtr->compare(nodePtr->keys[i - 1], key) >= 0) ||
+            (hasLow && btreePtr->compare(key, lowKey) < 0) ||
+            (hasHigh && btreePtr->compare(key, highKey) >= 0))
+        {
+            printf("  (WARNING) node %p key %li out of order\n",
+                   (void*)nodePtr, i);
+            return -1;
+        }
+    }
+
+    if (nodePtr->isLeaf) {
+        if (*leafDepthPtr < 0) {
+            *leafDepthPtr = depth;
+        } else if (*leafDepthPtr != depth) {
+            printf("  (WARNING) leaf %p at depth %li\n", (void*)nodePtr, depth);
+            return -1;
+        }
+        /* Leaves are visited in order, so each must be the last one's next */
+        if ((*leafPtrPtr != NULL) &&
+            ((*leafPtrPtr)->ptrs[NEXT_LEAF] != (void*)nodePtr))
+        {
+            printf("  (WARNING) leaf %p not linked\n", (void*)nodePtr);
+            return -1;
+        }
+        *leafPtrPtr = nodePtr;
+        return numKey;
+    }
+
+    for (i = 0; i <= numKey; i++) {
+        long numChildEntry =
+            verifyNode(btreePtr, LDNODE(nodePtr, i),
+                       ((i > 0) ? nodePtr->keys[i - 1] : lowKey),
+                       ((i > 0) ? TRUE : hasLow),
+                       ((i < numKey) ? nodePtr->keys[i] : highKey),
+                       ((i < numKey) ? TRUE : hasHigh),
+                       (depth + 1), leafDepthPtr, leafPtrPtr);
+        if (numChildEntry < 0) {
+            return -1;
+        }
+        numEntry += numChildEntry;
+    }
+
+    return numEntry;
+}
+
+
+/* =============================================================================
+ * btree_verify
+ * -- Returns number of keys, or -1 if the tree is malformed
+ * =============================================================================
+ */
+long
+btree_verify (btree_t* btreePtr, long verbose)
+{
+    long leafDepth = -1;
+    btree_node_t* lastLeafPtr = NULL;
+    long numEntry;
+
+    if (verbose) {
+       printf("Integrity check: ");
+    }
+
+    numEntry = verifyNode(btreePtr, btreePtr->root, NULL, FALSE, NULL, FALSE,
+                          0, &leafDepth, &lastLeafPtr);
+    if ((numEntry >= 0) && (lastLeafPtr->ptrs[NEXT_LEAF] != NULL)) {
+        printf("  (WARNING) last leaf has a next leaf\n");
+        numEntry = -1;
+    }
+
+    if (verbose) {
+        printf("%li keys, depth %li\n", numEntry, leafDepth);
+    }
+
+    return numEntry;
+}
+
+
+/* =============================================================================
+ * btree_alloc
+ * -- If NULL passed for 'compare', keys are compared by value
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+btree_t*
+btree_alloc (long (*compare)(const void*, const void*))
+{
+    btree_t* btreePtr = (btree_t*)malloc(sizeof(btree_t));
+
+    if (btreePtr != NULL) {
+        btreePtr->compare = (compare ? compare : &compareKeysDefault);
+        btreePtr->root = allocNode(TRUE);
+        if (btreePtr->root == NULL) {
+            memory_free(btreePtr);
+            return NULL;
+        }
+    }
+
+    return btreePtr;
+}
+
+
+/* =============================================================================
+ * TMbtree_alloc
+ * -- If NULL passed for 'compare', keys are compared by value
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+btree_t*
+TMbtree_alloc (TM_ARGDECL  long (*compare)(const void*, const void*))
+{
+    btree_t* btreePtr = (btree_t*)TM_MALLOC(sizeof(btree_t));
+
+    if (btreePtr != NULL) {
+        btreePtr->compare = (compare ? compare : &compareKeysDefault);
+        btreePtr->root = TMallocNode(TM_ARG  TRUE);
+        if (btreePtr->root == NULL) {
+            TM_FREE(btreePtr);
+            return NULL;
+        }
+    }
+
+    return btreePtr;
+}
+
+
+/* =============================================================================
+ * btree_free
+ * =============================================================================
+ */
+void
+btree_free (btree_t* btreePtr)
+{
+    freeNodes(btreePtr->root);
+    memory_free(btreePtr);
+}
+
+
+/* =============================================================================
+ * TMbtree_free
+ * =============================================================================
+ */
+void
+TMbtree_free (TM_ARGDECL  btree_t* btreePtr)
+{
+    TMfreeNodes(TM_ARG  (btree_node_t*)TM_SHARED_READ_P(btreePtr->root));
+    TM_FREE(btreePtr);
+}
+
+
+/* =============================================================================
+ * btree_insert
+ * -- Returns TRUE on success, FALSE if key is already present
+ * =============================================================================
+ */
+bool_t
+btree_insert (btree_t* btreePtr, void* key, void* val)
+{
+    btree_node_t* nodePtr = btreePtr->root;
+    bool_t found;
+    long numKey;
+    long i;
+
+    if (LDNUM(nodePtr) == BTREE_MAX_KEY) {
+        btree_node_t* rootPtr = allocNode(FALSE);
+        if (rootPtr == NULL) {
+            return FALSE;
+        }
+        rootPtr->ptrs[0] = nodePtr;
+        if (!splitChild(rootPtr, 0)) {
+            memory_free(rootPtr);
+            return FALSE;
+        }
+        btreePtr->root = rootPtr;
+        nodePtr = rootPtr;
+    }
+
+    /* Split full nodes on the way down so that a parent always has room */
+    while (!nodePtr->isLeaf) {
+        long c = search(btreePtr, nodePtr, key, &found);
+        btree_node_t* childPtr;
+        if (found) {
+            c++;
+        }
+        childPtr = LDNODE(nodePtr, c);
+        if (LDNUM(childPtr) == BTREE_MAX_KEY) {
+            if (!splitChild(nodePtr, c)) {
+                return FALSE;
+            }
+            if (btreePtr->compare(key, LDKEY(nodePtr, c)) >= 0) {
+                c++;
+            }
+            childPtr = LDNODE(nodePtr, c);
+        }
+        nodePtr = childPtr;
+    }
+
+    i = search(btreePtr, nodePtr, key, &found);
+    if (found) {
+        return FALSE;
+    }
+
+    numKey = LDNUM(nodePtr);
+    for (; numKey > i; numKey--) {
+        STKEY(nodePtr, numKey, LDKEY(nodePtr, (numKey - 1)));
+        STPTR(nodePtr, numKey, LDPTR(nodePtr, (numKey - 1)));
+    }
+    STKEY(nodePtr, i, key);
+    STPTR(nodePtr, i, val);
+    STNUM(nodePtr, (LDNUM(nodePtr) + 1));
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TMbtree_insert
+ * -- Returns TRUE on success, FALSE if key is already present
+ * =============================================================================
+ */
+bool_t
+TMbtree_insert (TM_ARGDECL  btree_t* btreePtr, void* key, void* val)
+{
+    btree_node_t* nodePtr = (btree_node_t*)TM_SHARED_READ_P(btreePtr->root);
+    bool_t found;
+    long numKey;
+    long i;
+
+    if (TX_LDNUM(nodePtr) == BTREE_MAX_KEY) {
+        btree_node_t* rootPtr = TMallocNode(TM_ARG  FALSE);
+        if (rootPtr == NULL) {
+            return FALSE;
+        }
+        rootPtr->ptrs[0] = nodePtr;
+        if (!TMsplitChild(TM_ARG  rootPtr, 0)) {
+            TM_FREE(rootPtr);
+            return FALSE;
+        }
+        TM_SHARED_WRITE_P(btreePtr->root, rootPtr);
+        nodePtr = rootPtr;
+    }
+
+    /* Split full nodes on the way down so that a parent always has room */
+    while (!nodePtr->isLeaf) {
+        long c = TMsearch(TM_ARG  btreePtr, nodePtr, key, &found);
+        btree_node_t* childPtr;
+        if (found) {
+            c++;
+        }
+        childPtr = TX_LDNODE(nodePtr, c);
+        if (TX_LDNUM(childPtr) == BTREE_MAX_KEY) {
+            if (!TMsplitChild(TM_ARG  nodePtr, c)) {
+                return FALSE;
+            }
+            if (btreePtr->compare(key, TX_LDKEY(nodePtr, c)) >= 0) {
+                c++;
+            }
+            childPtr = TX_LDNODE(nodePtr, c);
+        }
+        nodePtr = childPtr;
+    }
+
+    i = TMsearch(TM_ARG  btreePtr, nodePtr, key, &found);
+    if (found) {
+        return FALSE;
+    }
+
+    numKey = TX_LDNUM(nodePtr);
+    for (; numKey > i; numKey--) {
+        TX_STKEY(nodePtr, numKey, TX_LDKEY(nodePtr, (numKey - 1)));
+        TX_STPTR(nodePtr, numKey, TX_LDPTR(nodePtr, (numKey - 1)));
+    }
+    TX_STKEY(nodePtr, i, key);
+    TX_STPTR(nodePtr, i, val);
+    TX_STNUM(nodePtr, (TX_LDNUM(nodePtr) + 1));
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * btree_delete
+ * -- Returns TRUE if key was present
+ * =============================================================================
+ */
+bool_t
+btree_delete (btree_t* btreePtr, void* key)
+{
+    btree_node_t* nodePtr = btreePtr->root;
+    bool_t found;
+    long numKey;
+    long i;
+
+    /* Refill minimal nodes on the way down so that a parent can lose a key */
+    while (!nodePtr->isLeaf) {
+        long c = search(btreePtr, nodePtr, key, &found);
+        btree_node_t* childPtr;
+        if (found) {
+            c++;
+        }
+        if (LDNUM(LDNODE(nodePtr, c)) <= BTREE_MIN_KEY) {
+            c = fillChild(nodePtr, c);
+        }
+        childPtr = LDNODE(nodePtr, c);
+        if (LDNUM(nodePtr) == 0) {
+            /* Only the root can lose its last key */
+            btreePtr->root = childPtr;
+            memory_free(nodePtr);
+        }
+        nodePtr = childPtr;
+    }
+
+    i = search(btreePtr, nodePtr, key, &found);
+    if (!found) {
+        return FALSE;
+    }
+
+    numKey = LDNUM(nodePtr);
+    for (; i < (numKey - 1); i++) {
+        STKEY(nodePtr, i, LDKEY(nodePtr, (i + 1)));
+        STPTR(nodePtr, i, LDPTR(nodePtr, (i + 1)));
+    }
+    STNUM(nodePtr, (numKey - 1));
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TMbtree_delete
+ * -- Returns TRUE if key was present
+ * =============================================================================
+ */
+bool_t
+TMbtree_delete (TM_ARGDECL  btree_t* btreePtr, void* key)
+{
+    btree_node_t* nodePtr = (btree_node_t*)TM_SHARED_READ_P(btreePtr->root);
+    bool_t found;
+    long numKey;
+    long i;
+
+    /* Refill minimal nodes on the way down so that a parent can lose a key */
+    while (!nodePtr->isLeaf) {
+        long c = TMsearch(TM_ARG  btreePtr, nodePtr, key, &found);
+        btree_node_t* childPtr;
+        if (found) {
+            c++;
+        }
+        if (TX_LDNUM(TX_LDNODE(nodePtr, c)) <= BTREE_MIN_KEY) {
+            c = TMfillChild(TM_ARG  nodePtr, c);
+        }
+        childPtr = TX_LDNODE(nodePtr, c);
+        if (TX_LDNUM(nodePtr) == 0) {
+            /* Only the root can lose its last key */
+            TM_SHARED_WRITE_P(btreePtr->root, childPtr);
+            TM_FREE(nodePtr);
+        }
+        nodePtr = childPtr;
+    }
+
+    i = TMsearch(TM_ARG  btreePtr, nodePtr, key, &found);
+    if (!found) {
+        return FALSE;
+    }
+
+    numKey = TX_LDNUM(nodePtr);
+    for (; i < (numKey - 1); i++) {
+        TX_STKEY(nodePtr, i, TX_LDKEY(nodePtr, (i + 1)));
+        TX_STPTR(nodePtr, i, TX_LDPTR(nodePtr, (i + 1)));
+    }
+    TX_STNUM(nodePtr, (numKey - 1));
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * btree_get
+ * -- Returns NULL if key is not present
+ * =============================================================================
+ */
+void*
+btree_get (btree_t* btreePtr, void* key)
+{
+    long i;
+    btree_node_t* nodePtr = lookup(btreePtr, key, &i);
+
+    return ((nodePtr != NULL) ? LDPTR(nodePtr, i) : NULL);
+}
+
+
+/* =============================================================================
+ * TMbtree_get
+ * -- Returns NULL if key is not present
+ * =============================================================================
+ */
+void*
+TMbtree_get (TM_ARGDECL  btree_t* btreePtr, void* key)
+{
+    long i;
+    btree_node_t* nodePtr = TMlookup(TM_ARG  btreePtr, key, &i);
+
+    return ((nodePtr != NULL) ? TX_LDPTR(nodePtr, i) : NULL);
+}
+
+
+/* =============================================================================
+ * btree_contains
+ * =============================================================================
+ */
+bool_t
+btree_contains (btree_t* btreePtr, void* key)
+{
+    long i;
+
+    return ((lookup(btreePtr, key, &i) != NULL) ? TRUE : FALSE);
+}
+
+
+/* =============================================================================
+ * TMbtree_contains
+ * =============================================================================
+ */
+bool_t
+TMbtree_contains (TM_ARGDECL  btree_t* btreePtr, void* key)
+{
+    long i;
+
+    return ((TMlookup(TM_ARG  btreePtr, key, &i) != NULL) ? TRUE : FALSE);
+}
+
+
+/* =============================================================================
+ * TEST_BTREE
+ * =============================================================================
+ */
+#ifdef TEST_BTREE
+
+
+#include <sched.h>
+#include "thread.h"
+
+#define NUM_SEQ_KEY    (2048) /* power of 2, so odd strides permute the keys */
+#define NUM_SHARED_KEY (1024)
+#define NUM_OP         (8192) /* per thread */
+#define NUM_THREAD     (4)
+
+static btree_t* global_btreePtr;
+static long global_numInsert[NUM_THREAD][NUM_SHARED_KEY];
+static long global_numDelete[NUM_THREAD][NUM_SHARED_KEY];
+
+
+static long
+compare (const void* a, const void* b)
+{
+    return (*((const long*)a) - *((const long*)b));
+}
+
+
+static long global_seqKeys[NUM_SEQ_KEY];
+
+
+/* Keys are compared by value unless a compare function is given */
+static void*
+seqKey (long (*compareFunc)(const void*, const void*), long k)
+{
+    global_seqKeys[k] = k;
+    return ((compareFunc != NULL) ? (void*)&global_seqKeys[k] : (void*)k);
+}
+
+
+/* =============================================================================
+ * fillAndDrain
+ * -- Inserts all keys in the order k = i * stride, then deletes the even keys
+ *    (leaving half-full leaves that borrow) and then the odd ones (merges)
+ * =============================================================================
+ */
+static void
+fillAndDrain (long (*compareFunc)(const void*, const void*), long stride)
+{
+    btree_t* btreePtr = btree_alloc(compareFunc);
+    long parity;
+    long numLeft;
+    long i;
+
+    assert(btreePtr);
+
+    for (i = 0; i < NUM_SEQ_KEY; i++) {
+        long k = (i * stride) % NUM_SEQ_KEY;
+        bool_t status = btree_insert(btreePtr, seqKey(compareFunc, k),
+                                     (void*)(k + 1));
+        assert(status);
+        if ((i % 256) == 0) {
+            assert(btree_verify(btreePtr, 0) == (i + 1));
+        }
+    }
+    for (i = 0; i < NUM_SEQ_KEY; i++) {
+        bool_t status = btree_insert(btreePtr, seqKey(compareFunc, i), NULL);
+        assert(!status);
+        assert(btree_get(btreePtr, seqKey(compareFunc, i)) == (void*)(i + 1));
+    }
+    assert(btree_verify(btreePtr, 0) == NUM_SEQ_KEY);
+
+    numLeft = NUM_SEQ_KEY;
+    for (parity = 0; parity < 2; parity++) {
+        for (i = 0; i < NUM_SEQ_KEY; i++) {
+            long k = (i * stride) % NUM_SEQ_KEY;
+            if ((k % 2) == parity) {
+                bool_t status = btree_delete(btreePtr, seqKey(compareFunc, k));
+                assert(status);
+                status = btree_delete(btreePtr, seqKey(compareFunc, k));
+                assert(!status);
+                numLeft--;
+                if ((numLeft % 256) == 0) {
+                    assert(btree_verify(btreePtr, 0) == numLeft);
+                }
+            }
+        }
+        for (i = 0; i < NUM_SEQ_KEY; i++) {
+            bool_t isPresent = ((i % 2) > parity);
+            assert(btree_contains(btreePtr, seqKey(compareFunc, i)) == isPresent);
+        }
+    }
+
+    btree_free(btreePtr);
+}
+
+
+/* xorshift; the low bits of consecutive values are correlated, use the high */
+static ulong_t
+nextRandom (ulong_t* seedPtr)
+{
+    ulong_t x = *seedPtr;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *seedPtr = x;
+
+    return x;
+}
+
+
+/* =============================================================================
+ * updateShared
+ * -- All threads insert and delete random keys of the same small range, first
+ *    mostly inserting (splits) and then mostly deleting (borrows and merges)
+ * -- Every 16th transaction also updates the neighbouring key, which is
+ *    usually in the same leaf, after yielding, so that leaf changes race
+ * =============================================================================
+ */
+static void
+updateShared (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    ulong_t seed = id + 1;
+    long op;
+
+    for (op = 0; op < NUM_OP; op++) {
+        long percentInsert = ((op < (NUM_OP / 2)) ? 70 : 30);
+        long k = (nextRandom(&seed) >> 32) % NUM_SHARED_KEY;
+        long next = (k + 1) % NUM_SHARED_KEY;
+        bool_t isInsert = ((long)((nextRandom(&seed) >> 32) % 100) <
+                           percentInsert);
+        bool_t isPair = ((op % 16) == id);
+        bool_t status;
+        bool_t nextStatus;
+
+        TM_BEGIN();
+        nextStatus = FALSE;
+        if (isInsert) {
+            status = TMBTREE_INSERT(global_btreePtr, k, (k + 1));
+            assert(TMBTREE_GET(global_btreePtr, k) == (void*)(k + 1));
+        } else {
+            status = TMBTREE_DELETE(global_btreePtr, k);
+            assert(!TMBTREE_CONTAINS(global_btreePtr, k));
+        }
+        if (isPair) {
+            sched_yield();
+            if (isInsert) {
+                nextStatus = TMBTREE_DELETE(global_btreePtr, next);
+            } else {
+                nextStatus = TMBTREE_INSERT(global_btreePtr, next, (next + 1));
+            }
+        }
+        TM_END();
+
+        if (status) {
+            (isInsert ? global_numInsert : global_numDelete)[id][k]++;
+        }
+        if (nextStatus) {
+            (isInsert ? global_numDelete : global_numInsert)[id][next]++;
+        }
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+/* =============================================================================
+ * checkShared
+ * -- Each key must have been inserted as often as deleted, or once more if it
+ *    is in the tree; the tree must also be well formed
+ * =============================================================================
+ */
+static void
+checkShared (btree_t* btreePtr)
+{
+    long numPresent = 0;
+    long k;
+
+    for (k = 0; k < NUM_SHARED_KEY; k++) {
+        long net = 0;
+        long t;
+        for (t = 0; t < NUM_THREAD; t++) {
+            net += global_numInsert[t][k] - global_numDelete[t][k];
+        }
+        assert(net == 0 || net == 1);
+        if (net == 1) {
+            assert(btree_get(btreePtr, (void*)k) == (void*)(k + 1));
+            numPresent++;
+        } else {
+            assert(!btree_contains(btreePtr, (void*)k));
+        }
+    }
+
+    assert(btree_verify(btreePtr, 1) == numPresent);
+}
+
+
+int
+main ()
+{
+    puts("Starting...");
+
+    fillAndDrain(NULL, 1);
+    fillAndDrain(NULL, (NUM_SEQ_KEY - 1)); /* descending */
+    fillAndDrain(NULL, 1027);
+    fillAndDrain(&compare, 1027);
+
+    global_btreePtr = btree_alloc(NULL);
+    assert(global_btreePtr);
+    TM_STARTUP(NUM_THREAD);
+    thread_startup(NUM_THREAD);
+    thread_start(updateShared, NULL);
+    thread_shutdown();
+    TM_SHUTDOWN();
+
+    checkShared(global_btreePtr);
+    btree_free(global_btreePtr);
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_BTREE */
+
+
+/* =============================================================================
+ *
+ * End of btree.c
+ *
+ * =============================================================================
+ */
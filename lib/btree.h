@@ -0,0 +1,234 @@
+/* =============================================================================
+ *
+ * btree.h
+ * -- B+-tree ordered map with fat nodes
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef BTREE_H
+#define BTREE_H 1
+
+
+#include "tm.h"
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Keys per node; must be odd so that a merged inner node fits. Override with
+ * -DBTREE_MAX_KEY=<n>.
+ */
+#ifndef BTREE_MAX_KEY
+#  define BTREE_MAX_KEY (15)
+#endif
+
+
+typedef struct btree btree_t;
+
+
+/* =============================================================================
+ * btree_verify
+ * -- Returns number of keys, or -1 if the tree is malformed
+ * =============================================================================
+ */
+long
+btree_verify (btree_t* btreePtr, long verbose);
+
+
+/* =============================================================================
+ * btree_alloc
+ * -- If NULL passed for 'compare', keys are compared by value
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+btree_t*
+btree_alloc (long (*compare)(const void*, const void*));
+
+
+/* =============================================================================
+ * TMbtree_alloc
+ * -- If NULL passed for 'compare', keys are compared by value
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+btree_t*
+TMbtree_alloc (TM_ARGDECL  long (*compare)(const void*, const void*));
+
+
+/* =============================================================================
+ * btree_free
+ * =============================================================================
+ */
+void
+btree_free (btree_t* btreePtr);
+
+
+/* =============================================================================
+ * TMbtree_free
+ * =============================================================================
+ */
+void
+TMbtree_free (TM_ARGDECL  btree_t* btreePtr);
+
+
+/* =============================================================================
+ * btree_insert
+ * -- Returns TRUE on success, FALSE if key is already present
+ * =============================================================================
+ */
+bool_t
+btree_insert (btree_t* btreePtr, void* key, void* val);
+
+
+/* =============================================================================
+ * TMbtree_insert
+ * -- Returns TRUE on success, FALSE if key is already present
+ * =============================================================================
+ */
+bool_t
+TMbtree_insert (TM_ARGDECL  btree_t* btreePtr, void* key, void* val);
+
+
+/* =============================================================================
+ * btree_delete
+ * -- Returns TRUE if key was present
+ * =============================================================================
+ */
+bool_t
+btree_delete (btree_t* btreePtr, void* key);
+
+
+/* =============================================================================
+ * TMbtree_delete
+ * -- Returns TRUE if key was present
+ * =============================================================================
+ */
+bool_t
+TMbtree_delete (TM_ARGDECL  btree_t* btreePtr, void* key);
+
+
+/* =============================================================================
+ * btree_get
+ * -- Returns NULL if key is not present
+ * =============================================================================
+ */
+void*
+btree_get (btree_t* btreePtr, void* key);
+
+
+/* =============================================================================
+ * TMbtree_get
+ * -- Returns NULL if key is not present
+ * =============================================================================
+ */
+void*
+TMbtree_get (TM_ARGDECL  btree_t* btreePtr, void* key);
+
+
+/* =============================================================================
+ * btree_contains
+ * =============================================================================
+ */
+bool_t
+btree_contains (btree_t* btreePtr, void* key);
+
+
+/* =============================================================================
+ * TMbtree_contains
+ * =============================================================================
+ */
+bool_t
+TMbtree_contains (TM_ARGDECL  btree_t* btreePtr, void* key);
+
+
+#define TMBTREE_ALLOC(c)          TMbtree_alloc(TM_ARG  c)
+#define TMBTREE_FREE(b)           TMbtree_free(TM_ARG  b)
+#define TMBTREE_INSERT(b, k, v)   TMbtree_insert(TM_ARG  b, (void*)(k), (void*)(v))
+#define TMBTREE_DELETE(b, k)      TMbtree_delete(TM_ARG  b, (void*)(k))
+#define TMBTREE_GET(b, k)         TMbtree_get(TM_ARG  b, (void*)(k))
+#define TMBTREE_CONTAINS(b, k)    TMbtree_contains(TM_ARG  b, (void*)(k))
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* BTREE_H */
+
+
+/* =============================================================================
+ *
+ * End of btree.h
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,568 @@
+/* =============================================================================
+ *
+ * cm.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cm.h"
+#include "types.h"
+
+
+#if defined(__i386__) || defined(__x86_64__)
+#  define CM_PAUSE()                    __asm__ __volatile__ ("pause" ::: "memory")
+#else
+#  define CM_PAUSE()                    __asm__ __volatile__ ("" ::: "memory")
+#endif
+
+enum cm_status {
+    CM_ACTIVE     = 0,
+    CM_COMMITTING = 1,
+    CM_KILLED     = 2,
+};
+
+enum cm_tuning {
+    CM_SPIN_LIMIT        = 64,  /* conflict retries before giving up */
+    CM_MAX_WAIT_EXP      = 10,  /* cap on 2^numTry pauses in cm_wait */
+    CM_YIELD_TRY         = 16,  /* yield the CPU after this many waits */
+    CM_BACKOFF_UNIT      = 32,  /* pauses per backoff slot */
+    CM_MAX_BACKOFF_EXP   = 16,
+    CM_YIELD_BACKOFF_EXP = 8,   /* sleep instead of spin past this */
+    CM_CACHE_LINE_SIZE   = 64,
+};
+
+/* One cache line per slot */
+typedef struct cm_slot {
+    volatile long isUsed;
+    volatile long status;
+    volatile unsigned long karma;     /* published priority */
+    volatile unsigned long timestamp; /* of first attempt */
+    unsigned long baseKarma;          /* work of aborted attempts */
+    unsigned long numConsecutiveAbort;
+    unsigned long seed;
+    volatile long isInTx;             /* an attempt is running */
+} __attribute__ ((aligned (CM_CACHE_LINE_SIZE))) cm_slot_t;
+
+static cm_policy_t    global_policy = CM_BACKOFF;
+static cm_slot_t      global_slots[CM_MAX_THREAD];
+static volatile unsigned long global_ticket = 0;
+
+/* Read at every cm_begin, written only around irrevocable transactions */
+static struct {
+    char padding1[CM_CACHE_LINE_SIZE];
+    volatile long slot; /* holder of the token, or -1 */
+    char padding2[CM_CACHE_LINE_SIZE];
+} global_irrevocable = { {0}, -1, {0} };
+
+static unsigned long          global_irrevocableAfter =
+                                  CM_DEFAULT_IRREVOCABLE_AFTER;
+static volatile unsigned long global_numIrrevocable = 0;
+
+static const char* global_policyNames[CM_NUM_POLICY] = {
+    "aggressive",
+    "backoff",
+    "karma",
+    "timestamp",
+};
+
+
+/* =============================================================================
+ * cm_startup
+ * =============================================================================
+ */
+void
+cm_startup ()
+{
+    const char* name = getenv("TM_CM");
+
+    global_policy = CM_BACKOFF;
+    if (name != NULL && name[0] != '\0') {
+        long p;
+        for (p = 0; p < CM_NUM_POLICY; p++) {
+            if (strcmp(name, global_policyNames[p]) == 0) {
+                global_policy = (cm_policy_t)p;
+                break;
+            }
+        }
+        if (strcmp(name, "polka") == 0) {
+            global_policy = CM_KARMA;
+        } else if (p == CM_NUM_POLICY) {
+            fprintf(stderr, "Unknown TM_CM=%s; using %s\n",
+                    name, global_policyNames[global_policy]);
+        }
+    }
+
+    global_irrevocableAfter = CM_DEFAULT_IRREVOCABLE_AFTER;
+    name = getenv("TM_IRREVOCABLE_AFTER");
+    if (name != NULL && name[0] != '\0') {
+        char* end;
+        long value = strtol(name, &end, 10);
+        if (*end != '\0' || value < 0) {
+            fprintf(stderr, "Bad TM_IRREVOCABLE_AFTER=%s; using %lu\n",
+                    name, global_irrevocableAfter);
+        } else {
+            global_irrevocableAfter = (unsigned long)value;
+        }
+    }
+
+    global_ticket = 0;
+    global_irrevocable.slot = -1;
+    global_numIrrevocable = 0;
+}
+
+
+/* =============================================================================
+ * cm_getPolicy
+ * =============================================================================
+ */
+cm_policy_t
+cm_getPolicy ()
+{
+    return global_policy;
+}
+
+
+/* =============================================================================
+ * cm_getPolicyName
+ * =============================================================================
+ */
+const char*
+cm_getPolicyName ()
+{
+    return global_policyNames[global_policy];
+}
+
+
+/* =============================================================================
+ * cm_newThread
+ * =============================================================================
+ */
+long
+cm_newThread ()
+{
+    long s;
+
+    for (s = 0; s < CM_MAX_THREAD; s++) {
+        long expected = 0;
+        if (!global_slots[s].isUsed &&
+            __atomic_compare_exchange_n(&global_slots[s].isUsed,
+                                        &expected,
+                                        1,
+                                        FALSE,
+                                        __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED))
+        {
+            cm_slot_t* slotPtr = &global_slots[s];
+            slotPtr->status              = CM_ACTIVE;
+            slotPtr->karma               = 0;
+            slotPtr->timestamp           = 0;
+            slotPtr->baseKarma           = 0;
+            slotPtr->numConsecutiveAbort = 0;
+            slotPtr->seed                = (unsigned long)s * 2654435761UL + 1;
+            slotPtr->isInTx              = 0;
+            return s;
+        }
+    }
+
+    return -1;
+}
+
+
+/* =============================================================================
+ * cm_freeThread
+ * =============================================================================
+ */
+void
+cm_freeThread (long slot)
+{
+    __atomic_store_n(&global_slots[slot].isUsed, 0, __ATOMIC_RELEASE);
+}
+
+
+/* =============================================================================
+ * enterShared
+ * -- Publishes that an attempt is running, unless one is running irrevocably
+ * -- Pairs with the token and scan in enterIrrevocable (both sequentially
+ *    consistent, so at least one side sees the other)
+ * =============================================================================
+ */
+static void
+enterShared (long slot)
+{
+    cm_slot_t* slotPtr = &global_slots[slot];
+
+    while (1) {
+        long numTry = 0;
+        __atomic_store_n(&slotPtr->isInTx, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&global_irrevocable.slot, __ATOMIC_SEQ_CST) < 0) {
+            return;
+        }
+        __atomic_store_n(&slotPtr->isInTx, 0, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&global_irrevocable.slot, __ATOMIC_ACQUIRE) >= 0) {
+            cm_wait(slot, numTry++);
+        }
+    }
+}
+
+
+/* =============================================================================
+ * enterIrrevocable
+ * -- Takes the token, then waits for every running attempt to finish
+ * =============================================================================
+ */
+static void
+enterIrrevocable (long slot)
+{
+    long numTry = 0;
+    long s;
+
+    while (1) {
+        long expected = -1;
+        if (__atomic_compare_exchange_n(&global_irrevocable.slot,
+                                        &expected,
+                                        slot,
+                                        FALSE,
+                                        __ATOMIC_SEQ_CST,
+                                        __ATOMIC_RELAXED))
+        {
+            break;
+        }
+        cm_wait(slot, numTry++);
+    }
+
+    for (s = 0; s < CM_MAX_THREAD; s++) {
+        numTry = 0;
+        while (s != slot &&
+               __atomic_load_n(&global_slots[s].isInTx, __ATOMIC_SEQ_CST))
+        {
+            cm_wait(slot, numTry++);
+        }
+    }
+}
+
+
+/* =============================================================================
+ * cm_begin
+ * =============================================================================
+ */
+bool_t
+cm_begin (long slot, bool_t isRetry, bool_t isIrrevocable)
+{
+    cm_slot_t* slotPtr = &global_slots[slot];
+
+    if (!isRetry) {
+        slotPtr->baseKarma = 0;
+        slotPtr->karma = 0;
+        if (global_policy == CM_TIMESTAMP) {
+            slotPtr->timestamp =
+                __atomic_add_fetch(&global_ticket, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    if (global_irrevocableAfter > 0 &&
+        slotPtr->numConsecutiveAbort >= global_irrevocableAfter)
+    {
+        isIrrevocable = TRUE; /* starving */
+    }
+
+    if (isIrrevocable) {
+        enterIrrevocable(slot);
+    } else {
+        enterShared(slot);
+    }
+
+    __atomic_store_n(&slotPtr->status, CM_ACTIVE, __ATOMIC_RELEASE);
+
+    return isIrrevocable;
+}
+
+
+/* =============================================================================
+ * cm_onConflict
+ * =============================================================================
+ */
+cm_decision_t
+cm_onConflict (long slot, long enemySlot, long numTry, long work)
+{
+    cm_slot_t* slotPtr = &global_slots[slot];
+    cm_slot_t* enemyPtr = &global_slots[enemySlot];
+
+    switch (global_policy) {
+
+        case CM_AGGRESSIVE:
+            return CM_ABORT_SELF;
+
+        case CM_BACKOFF:
+            return ((numTry < CM_SPIN_LIMIT) ? CM_WAIT : CM_ABORT_SELF);
+
+        case CM_KARMA: {
+            unsigned long myKarma = slotPtr->baseKarma + work;
+            unsigned long enemyKarma = enemyPtr->karma;
+            slotPtr->karma = myKarma;
+            if (enemyKarma > myKarma &&
+                (unsigned long)numTry < (enemyKarma - myKarma))
+            {
+                return CM_WAIT;
+            }
+            return CM_ABORT_ENEMY;
+        }
+
+        case CM_TIMESTAMP:
+            if (slotPtr->timestamp < enemyPtr->timestamp) {
+                return CM_ABORT_ENEMY;
+            }
+            return ((numTry < CM_SPIN_LIMIT) ? CM_WAIT : CM_ABORT_SELF);
+
+        default:
+            assert(0);
+    }
+
+    return CM_ABORT_SELF;
+}
+
+
+/* =============================================================================
+ * cm_kill
+ * =============================================================================
+ */
+bool_t
+cm_kill (long enemySlot)
+{
+    long expected = CM_ACTIVE;
+
+    return __atomic_compare_exchange_n(&global_slots[enemySlot].status,
+                                       &expected,
+                                       CM_KILLED,
+                                       FALSE,
+                                       __ATOMIC_ACQ_REL,
+                                       __ATOMIC_RELAXED);
+}
+
+
+/* =============================================================================
+ * cm_isKilled
+ * =============================================================================
+ */
+bool_t
+cm_isKilled (long slot)
+{
+    return (__atomic_load_n(&global_slots[slot].status, __ATOMIC_ACQUIRE) ==
+            CM_KILLED);
+}
+
+
+/* =============================================================================
+ * cm_tryCommit
+ * =============================================================================
+ */
+bool_t
+cm_tryCommit (long slot)
+{
+    long expected = CM_ACTIVE;
+
+    return __atomic_compare_exchange_n(&global_slots[slot].status,
+                                       &expected,
+                                       CM_COMMITTING,
+                                       FALSE,
+                                       __ATOMIC_ACQ_REL,
+                                       __ATOMIC_ACQUIRE);
+}
+
+
+/* =============================================================================
+ * cm_reactivate
+ * =============================================================================
+ */
+void
+cm_reactivate (long slot)
+{
+    __atomic_store_n(&global_slots[slot].status, CM_ACTIVE, __ATOMIC_RELEASE);
+}
+
+
+/* =============================================================================
+ * cm_wait
+ * =============================================================================
+ */
+void
+cm_wait (long slot, long numTry)
+{
+    long numPause = 1L << ((numTry < CM_MAX_WAIT_EXP) ? numTry : CM_MAX_WAIT_EXP);
+    long i;
+
+    if (numTry >= CM_YIELD_TRY) {
+        sched_yield();
+        return;
+    }
+
+    for (i = 0; i < numPause; i++) {
+        CM_PAUSE();
+    }
+}
+
+
+/* =============================================================================
+ * cm_onAbort
+ * =============================================================================
+ */
+void
+cm_onAbort (long slot, long work)
+{
+    cm_slot_t* slotPtr = &global_slots[slot];
+
+    assert(global_irrevocable.slot != slot); /* irrevocable cannot abort */
+    __atomic_store_n(&slotPtr->isInTx, 0, __ATOMIC_RELEASE);
+
+    slotPtr->baseKarma += work;
+    slotPtr->karma = slotPtr->baseKarma;
+    slotPtr->numConsecutiveAbort++;
+
+    if (global_policy == CM_BACKOFF) {
+        cm_backoff(slot);
+    }
+}
+
+
+/* =============================================================================
+ * cm_backoff
+ * =============================================================================
+ */
+void
+cm_backoff (long slot)
+{
+    cm_slot_t* slotPtr = &global_slots[slot];
+    unsigned long exp = slotPtr->numConsecutiveAbort;
+    unsigned long delay;
+    unsigned long i;
+
+    if (exp > CM_MAX_BACKOFF_EXP) {
+        exp = CM_MAX_BACKOFF_EXP;
+    }
+
+    /* xorshift */
+    slotPtr->seed ^= slotPtr->seed << 13;
+    slotPtr->seed ^= slotPtr->seed >> 7;
+    slotPtr->seed ^= slotPtr->seed << 17;
+    delay = slotPtr->seed % (1UL << exp);
+
+    if (exp > CM_YIELD_BACKOFF_EXP) {
+        /* Long waits: give the CPU to whoever we conflict with */
+        for (i = 0; i <= (delay >> CM_YIELD_BACKOFF_EXP); i++) {
+            sched_yield();
+        }
+    } else {
+        for (i = 0; i < delay * CM_BACKOFF_UNIT; i++) {
+            CM_PAUSE();
+        }
+    }
+}
+
+
+/* =============================================================================
+ * cm_onCommit
+ * =============================================================================
+ */
+void
+cm_onCommit (long slot)
+{
+    cm_slot_t* slotPtr = &global_slots[slot];
+
+    slotPtr->numConsecutiveAbort = 0;
+    slotPtr->baseKarma = 0;
+    slotPtr->karma = 0;
+
+    if (global_irrevocable.slot == slot) {
+        global_numIrrevocable++;
+        __atomic_store_n(&global_irrevocable.slot, -1, __ATOMIC_RELEASE);
+    } else {
+        __atomic_store_n(&slotPtr->isInTx, 0, __ATOMIC_RELEASE);
+    }
+}
+
+
+/* =============================================================================
+ * cm_getNumIrrevocable
+ * =============================================================================
+ */
+unsigned long
+cm_getNumIrrevocable ()
+{
+    return global_numIrrevocable;
+}
+
+
+/* =============================================================================
+ *
+ * End of cm.c
+ *
+ * =============================================================================
+ */
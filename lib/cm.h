@@ -0,0 +1,292 @@
+/* =============================================================================
+ *
+ * cm.h
+ * -- Contention managers for transactional memory
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef CM_H
+#define CM_H 1
+
+
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Contention management
+ *
+ * The policy is chosen at TM_STARTUP from the TM_CM environment variable:
+ *
+ * aggressive  Abort self on conflict and restart immediately
+ * backoff     Wait briefly on conflict; after an abort, sleep for a random
+ *             interval that doubles with every consecutive abort (default)
+ * karma       Polka: priority is the work done across retries; wait up to
+ *             (enemy - self) exponential intervals, then abort the enemy
+ * timestamp   Oldest (first attempted earliest) transaction wins
+ *
+ * Every thread owns a slot in a global table that other threads may read to
+ * compare priorities and may write to request that the owner abort. A
+ * transaction that is about to write back must move its status from
+ * CM_ACTIVE to CM_COMMITTING, which fails if it has been killed.
+ *
+ * An attempt may also run irrevocably: it takes a global token, waits until
+ * every other transaction has committed or aborted, and then runs alone
+ * while new transactions wait at cm_begin, so it can neither conflict nor
+ * abort. This happens when the runtime asks for it (TM_BEGIN_IRREVOCABLE)
+ * and, to guarantee progress, when a transaction has aborted
+ * TM_IRREVOCABLE_AFTER times in a row (environment variable; default
+ * CM_DEFAULT_IRREVOCABLE_AFTER, 0 disables the escalation).
+ * =============================================================================
+ */
+
+typedef enum cm_policy {
+    CM_AGGRESSIVE = 0,
+    CM_BACKOFF,
+    CM_KARMA,
+    CM_TIMESTAMP,
+    CM_NUM_POLICY
+} cm_policy_t;
+
+typedef enum cm_decision {
+    CM_WAIT = 0,
+    CM_ABORT_SELF,
+    CM_ABORT_ENEMY
+} cm_decision_t;
+
+enum cm_config {
+    CM_MAX_THREAD = 1024, /* slots; fits the STM lock word encoding */
+    CM_SLOT_BITS  = 10,
+    CM_DEFAULT_IRREVOCABLE_AFTER = 64,
+};
+
+
+/* =============================================================================
+ * cm_startup
+ * -- Reads TM_CM and TM_IRREVOCABLE_AFTER; bad values fall back to the
+ *    defaults with a warning
+ * =============================================================================
+ */
+void
+cm_startup ();
+
+
+/* =============================================================================
+ * cm_getPolicy
+ * =============================================================================
+ */
+cm_policy_t
+cm_getPolicy ();
+
+
+/* =============================================================================
+ * cm_getPolicyName
+ * =============================================================================
+ */
+const char*
+cm_getPolicyName ();
+
+
+/* =============================================================================
+ * cm_newThread
+ * -- Returns slot, or -1 if all are in use
+ * =============================================================================
+ */
+long
+cm_newThread ();
+
+
+/* =============================================================================
+ * cm_freeThread
+ * =============================================================================
+ */
+void
+cm_freeThread (long slot);
+
+
+/* =============================================================================
+ * cm_begin
+ * -- Call at every attempt; isRetry is FALSE for the first attempt
+ * -- Waits while another transaction runs irrevocably
+ * -- Returns TRUE if this attempt runs irrevocably (requested with
+ *    isIrrevocable, or escalated after too many aborts)
+ * =============================================================================
+ */
+bool_t
+cm_begin (long slot, bool_t isRetry, bool_t isIrrevocable);
+
+
+/* =============================================================================
+ * cm_onConflict
+ * -- Called repeatedly while the enemy blocks us; numTry counts the calls
+ * -- work is the number of accesses made by the current attempt
+ * =============================================================================
+ */
+cm_decision_t
+cm_onConflict (long slot, long enemySlot, long numTry, long work);
+
+
+/* =============================================================================
+ * cm_kill
+ * -- Requests that the enemy abort; fails once it is committing
+ * =============================================================================
+ */
+bool_t
+cm_kill (long enemySlot);
+
+
+/* =============================================================================
+ * cm_isKilled
+ * =============================================================================
+ */
+bool_t
+cm_isKilled (long slot);
+
+
+/* =============================================================================
+ * cm_tryCommit
+ * -- Returns FALSE if the transaction has been killed
+ * =============================================================================
+ */
+bool_t
+cm_tryCommit (long slot);
+
+
+/* =============================================================================
+ * cm_reactivate
+ * -- For a transaction that goes on after an open nested child committed
+ *    (leaving it CM_COMMITTING) or was killed in its place
+ * =============================================================================
+ */
+void
+cm_reactivate (long slot);
+
+
+/* =============================================================================
+ * cm_wait
+ * -- Short pause between retries of a blocked access
+ * =============================================================================
+ */
+void
+cm_wait (long slot, long numTry);
+
+
+/* =============================================================================
+ * cm_onAbort
+ * -- Called before re-executing; may sleep according to the policy
+ * =============================================================================
+ */
+void
+cm_onAbort (long slot, long work);
+
+
+/* =============================================================================
+ * cm_backoff
+ * -- Randomized exponential sleep based on the number of consecutive aborts
+ * -- For runtimes that cannot identify the enemy (e.g., reader/writer locks)
+ * =============================================================================
+ */
+void
+cm_backoff (long slot);
+
+
+/* =============================================================================
+ * cm_onCommit
+ * =============================================================================
+ */
+void
+cm_onCommit (long slot);
+
+
+/* =============================================================================
+ * cm_getNumIrrevocable
+ * -- Number of transactions committed irrevocably since cm_startup
+ * =============================================================================
+ */
+unsigned long
+cm_getNumIrrevocable ();
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* CM_H */
+
+
+/* =============================================================================
+ *
+ * End of cm.h
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,463 @@
+/* =============================================================================
+ *
+ * epoch.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+#include "epoch.h"
+#include "memory.h"
+#include "types.h"
+
+
+#define EPOCH_QUIESCENT                 (~0UL)
+
+enum epoch_tuning {
+    EPOCH_NUM_BUCKET       = 3,  /* retired in epochs e - 2, e - 1, and e */
+    EPOCH_ADVANCE_INTERVAL = 64, /* retirements between attempts to advance */
+    EPOCH_CACHE_LINE_SIZE  = 64,
+};
+
+typedef struct epoch_bucket {
+    unsigned long epoch;
+    void** ptrs;
+    long size;
+    long capacity;
+} epoch_bucket_t;
+
+/* Two cache lines per slot */
+typedef struct epoch_slot {
+    volatile long isUsed;
+    volatile unsigned long epoch; /* announced, or EPOCH_QUIESCENT */
+    long numRetiredSinceAdvance;
+    epoch_bucket_t buckets[EPOCH_NUM_BUCKET];
+} __attribute__ ((aligned (EPOCH_CACHE_LINE_SIZE))) epoch_slot_t;
+
+static struct {
+    char padding1[EPOCH_CACHE_LINE_SIZE];
+    volatile unsigned long value;
+    char padding2[EPOCH_CACHE_LINE_SIZE];
+} global_epoch;
+
+static epoch_slot_t  global_slots[EPOCH_MAX_THREAD];
+static volatile long global_numSlot = 0; /* high-water mark */
+
+
+/* =============================================================================
+ * reclaimBucket
+ * =============================================================================
+ */
+static void
+reclaimBucket (epoch_bucket_t* bucketPtr)
+{
+    long i;
+
+    for (i = 0; i < bucketPtr->size; i++) {
+        memory_free(bucketPtr->ptrs[i]);
+    }
+    bucketPtr->size = 0;
+}
+
+
+/* =============================================================================
+ * tryAdvance
+ * -- Moves the global epoch forward if every active thread has announced it
+ * =============================================================================
+ */
+static void
+tryAdvance ()
+{
+    unsigned long e = __atomic_load_n(&global_epoch.value, __ATOMIC_SEQ_CST);
+    long numSlot = __atomic_load_n(&global_numSlot, __ATOMIC_ACQUIRE);
+    long s;
+
+    for (s = 0; s < numSlot; s++) {
+        unsigned long announced =
+            __atomic_load_n(&global_slots[s].epoch, __ATOMIC_SEQ_CST);
+        if (announced != EPOCH_QUIESCENT && announced != e) {
+            return;
+        }
+    }
+
+    __atomic_compare_exchange_n(&global_epoch.value,
+                                &e,
+                                e + 1,
+                                FALSE,
+                                __ATOMIC_SEQ_CST,
+                                __ATOMIC_RELAXED);
+}
+
+
+/* =============================================================================
+ * epoch_startup
+ * =============================================================================
+ */
+void
+epoch_startup ()
+{
+    global_epoch.value = 0;
+}
+
+
+/* =============================================================================
+ * epoch_shutdown
+ * =============================================================================
+ */
+void
+epoch_shutdown ()
+{
+    long s;
+
+    for (s = 0; s < global_numSlot; s++) {
+        long b;
+        for (b = 0; b < EPOCH_NUM_BUCKET; b++) {
+            epoch_bucket_t* bucketPtr = &global_slots[s].buckets[b];
+            reclaimBucket(bucketPtr);
+            bucketPtr->epoch = 0;
+        }
+    }
+
+    global_epoch.value = 0;
+}
+
+
+/* =============================================================================
+ * epoch_newThread
+ * =============================================================================
+ */
+long
+epoch_newThread ()
+{
+    long s;
+
+    for (s = 0; s < EPOCH_MAX_THREAD; s++) {
+        long expected = 0;
+        if (!global_slots[s].isUsed &&
+            __atomic_compare_exchange_n(&global_slots[s].isUsed,
+                                        &expected,
+                                        1,
+                                        FALSE,
+                                        __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED))
+        {
+            long numSlot = __atomic_load_n(&global_numSlot, __ATOMIC_RELAXED);
+            global_slots[s].epoch = EPOCH_QUIESCENT;
+            global_slots[s].numRetiredSinceAdvance = 0;
+            while (numSlot <= s &&
+                   !__atomic_compare_exchange_n(&global_numSlot,
+                                                &numSlot,
+                                                s + 1,
+                                                FALSE,
+                                                __ATOMIC_RELEASE,
+                                                __ATOMIC_RELAXED))
+            {
+                /* numSlot reloaded by failed CAS */
+            }
+            return s;
+        }
+    }
+
+    return -1;
+}
+
+
+/* =============================================================================
+ * epoch_freeThread
+ * =============================================================================
+ */
+void
+epoch_freeThread (long slot)
+{
+    __atomic_store_n(&global_slots[slot].epoch, EPOCH_QUIESCENT,
+                     __ATOMIC_RELEASE);
+    __atomic_store_n(&global_slots[slot].isUsed, 0, __ATOMIC_RELEASE);
+}
+
+
+/* =============================================================================
+ * epoch_enter
+ * =============================================================================
+ */
+void
+epoch_enter (long slot)
+{
+    unsigned long e = __atomic_load_n(&global_epoch.value, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&global_slots[slot].epoch, e, __ATOMIC_RELAXED);
+
+    /* Announcement must be visible before we read anything shared */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+
+/* =============================================================================
+ * epoch_exit
+ * =============================================================================
+ */
+void
+epoch_exit (long slot)
+{
+    __atomic_store_n(&global_slots[slot].epoch, EPOCH_QUIESCENT,
+                     __ATOMIC_RELEASE);
+}
+
+
+/* =============================================================================
+ * epoch_retire
+ * =============================================================================
+ */
+void
+epoch_retire (long slot, void* ptr)
+{
+    epoch_slot_t* slotPtr = &global_slots[slot];
+    epoch_bucket_t* bucketPtr;
+    unsigned long e;
+    long b;
+
+    /* The unlinking writes must precede the epoch we tag the object with */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    e = __atomic_load_n(&global_epoch.value, __ATOMIC_RELAXED);
+
+    /* A bucket holding an older epoch is at least three behind: safe */
+    bucketPtr = &slotPtr->buckets[e % EPOCH_NUM_BUCKET];
+    if (bucketPtr->epoch != e) {
+        reclaimBucket(bucketPtr);
+        bucketPtr->epoch = e;
+    }
+
+    if (bucketPtr->size == bucketPtr->capacity) {
+        long newCapacity = ((bucketPtr->capacity > 0) ?
+                            (2 * bucketPtr->capacity) :
+                            EPOCH_ADVANCE_INTERVAL);
+        void** newPtrs =
+            (void**)realloc(bucketPtr->ptrs, newCapacity * sizeof(void*));
+        if (newPtrs == NULL) {
+            /*
+             * Cannot defer, and waiting for quiescence here could deadlock:
+             * leak ptr rather than free it while others may still read it
+             */
+            return;
+        }
+        bucketPtr->ptrs = newPtrs;
+        bucketPtr->capacity = newCapacity;
+    }
+    bucketPtr->ptrs[bucketPtr->size++] = ptr;
+
+    if (++slotPtr->numRetiredSinceAdvance < EPOCH_ADVANCE_INTERVAL) {
+        return;
+    }
+    slotPtr->numRetiredSinceAdvance = 0;
+
+    tryAdvance();
+    e = __atomic_load_n(&global_epoch.value, __ATOMIC_ACQUIRE);
+    for (b = 0; b < EPOCH_NUM_BUCKET; b++) {
+        bucketPtr = &slotPtr->buckets[b];
+        if (bucketPtr->size > 0 && bucketPtr->epoch + 2 <= e) {
+            reclaimBucket(bucketPtr);
+        }
+    }
+}
+
+
+/* =============================================================================
+ * epoch_getNumRetired
+ * -- Only exact when no thread is retiring
+ * =============================================================================
+ */
+long
+epoch_getNumRetired ()
+{
+    long numRetired = 0;
+    long s;
+
+    for (s = 0; s < global_numSlot; s++) {
+        long b;
+        for (b = 0; b < EPOCH_NUM_BUCKET; b++) {
+            numRetired += global_slots[s].buckets[b].size;
+        }
+    }
+
+    return numRetired;
+}
+
+
+/* =============================================================================
+ * TEST_EPOCH
+ * =============================================================================
+ */
+#ifdef TEST_EPOCH
+
+
+#include <sched.h>
+#include <stdio.h>
+#include "thread.h"
+
+#define NUM_THREAD (4)
+#define NUM_SWAP   (200000)
+#define MAGIC      (0x5eedUL)
+
+typedef struct node {
+    unsigned long magic;
+    long value;
+} node_t;
+
+static node_t* volatile global_nodePtr;
+static volatile long    global_isDone;
+static volatile long    global_numRead;
+
+
+/* Readers check that nothing they can reach has been reclaimed */
+static void
+readOrSwap (void* argPtr)
+{
+    long slot = epoch_newThread();
+    long numRead = 0;
+    long i;
+
+    assert(slot >= 0);
+
+    if (thread_getId() == 0) {
+        for (i = 0; i < NUM_SWAP; i++) {
+            node_t* newPtr = (node_t*)memory_alloc(sizeof(node_t));
+            node_t* oldPtr;
+            assert(newPtr);
+            newPtr->magic = MAGIC;
+            newPtr->value = i;
+            oldPtr = __atomic_exchange_n(&global_nodePtr, newPtr,
+                                         __ATOMIC_SEQ_CST);
+            epoch_retire(slot, (void*)oldPtr);
+        }
+        __atomic_store_n(&global_isDone, 1, __ATOMIC_RELEASE);
+    } else {
+        while (!__atomic_load_n(&global_isDone, __ATOMIC_ACQUIRE)) {
+            node_t* nodePtr;
+            long value;
+            epoch_enter(slot);
+            nodePtr = __atomic_load_n(&global_nodePtr, __ATOMIC_ACQUIRE);
+            value = nodePtr->value;
+            if ((numRead % 64) == 0) {
+                sched_yield(); /* let the writer retire what we hold */
+            }
+            for (i = 0; i < 100; i++) {
+                assert(nodePtr->magic == MAGIC);
+                assert(nodePtr->value == value);
+            }
+            epoch_exit(slot);
+            numRead++;
+        }
+        __atomic_add_fetch(&global_numRead, numRead, __ATOMIC_RELAXED);
+    }
+
+    epoch_freeThread(slot);
+}
+
+
+int
+main ()
+{
+    long numRetired;
+
+    puts("Starting...");
+
+    epoch_startup();
+    thread_startup(NUM_THREAD);
+
+    global_nodePtr = (node_t*)memory_alloc(sizeof(node_t));
+    global_nodePtr->magic = MAGIC;
+    global_nodePtr->value = -1;
+
+    thread_start(readOrSwap, NULL);
+
+    /* Readers preempted inside may stall it, but reclamation must progress */
+    numRetired = epoch_getNumRetired();
+    printf("Reads = %li, still retired = %li of %li\n",
+           global_numRead, numRetired, (long)NUM_SWAP);
+    assert(numRetired < NUM_SWAP);
+
+    epoch_shutdown();
+    assert(epoch_getNumRetired() == 0);
+    memory_free((void*)global_nodePtr);
+
+    thread_shutdown();
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_EPOCH */
+
+
+/* =============================================================================
+ *
+ * End of epoch.c
+ *
+ * =============================================================================
+ */
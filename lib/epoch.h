@@ -0,0 +1,188 @@
+/* =============================================================================
+ *
+ * epoch.h
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef EPOCH_H
+#define EPOCH_H 1
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Epoch-based reclamation
+ *
+ * Memory freed by a committed transaction may still be read by concurrent
+ * transactions that have not yet noticed the conflict. Such memory is
+ * retired instead of freed: it goes on a per-thread list tagged with the
+ * global epoch at the time of retirement, and is handed to memory_free once
+ * the global epoch is two ahead of the tag.
+ *
+ * A thread announces the current epoch when it starts a transaction and
+ * becomes quiescent when the transaction ends. The global epoch advances
+ * only when every thread inside a transaction has announced it, so by the
+ * time it has advanced twice, every transaction that could have reached a
+ * retired object has finished.
+ * =============================================================================
+ */
+
+enum epoch_config {
+    EPOCH_MAX_THREAD = 1024,
+};
+
+
+/* =============================================================================
+ * epoch_startup
+ * =============================================================================
+ */
+void
+epoch_startup ();
+
+
+/* =============================================================================
+ * epoch_shutdown
+ * -- Reclaims everything still retired; no thread may be in a transaction
+ * =============================================================================
+ */
+void
+epoch_shutdown ();
+
+
+/* =============================================================================
+ * epoch_newThread
+ * -- Returns slot, or -1 if all are in use
+ * =============================================================================
+ */
+long
+epoch_newThread ();
+
+
+/* =============================================================================
+ * epoch_freeThread
+ * -- Objects still retired by this slot are reclaimed by its next owner
+ * =============================================================================
+ */
+void
+epoch_freeThread (long slot);
+
+
+/* =============================================================================
+ * epoch_enter
+ * -- Call before the first shared access of every transaction attempt
+ * =============================================================================
+ */
+void
+epoch_enter (long slot);
+
+
+/* =============================================================================
+ * epoch_exit
+ * -- Call once the attempt can no longer touch shared memory
+ * =============================================================================
+ */
+void
+epoch_exit (long slot);
+
+
+/* =============================================================================
+ * epoch_retire
+ * -- Defers memory_free(ptr) until no transaction can still be reading it
+ * -- ptr must already be unreachable from shared data
+ * =============================================================================
+ */
+void
+epoch_retire (long slot, void* ptr);
+
+
+/* =============================================================================
+ * epoch_getNumRetired
+ * -- Returns number of objects retired but not yet reclaimed
+ * =============================================================================
+ */
+long
+epoch_getNumRetired ();
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* EPOCH_H */
+
+
+/* =============================================================================
+ *
+ * End of epoch.h
+ *
+ * =============================================================================
+ */
@@ -13,7 +13,9 @@
  *
  * LIST_NO_DUPLICATES (default: allow duplicates)
  *
- * HASHTABLE_RESIZABLE (enable dynamically increasing number of buckets)
+ * HASHTABLE_RESIZABLE (enable dynamically increasing number of buckets;
+ *     entries are moved to the new buckets a few at a time by later
+ *     updates, also inside transactions)
  *
  * HASHTABLE_SIZE_FIELD (size is explicitely stored in
  *     hashtable and not implicitly defined by the sizes of
@@ -85,6 +87,7 @@
 #include <stdlib.h>
 #include "hashtable.h"
 #include "list.h"
+#include "memory.h"
 #include "pair.h"
 #include "types.h"
 
@@ -92,9 +95,123 @@
 # include "STAMP_config.h"
 #endif
 
-#if defined(HASHTABLE_RESIZABLE) && (defined(HTM) || defined(STM))
-#  warning "hash table resizing currently disabled for TM"
-#endif
+
+/* =============================================================================
+ * hashKeyValue
+ * -- Default hash function: the key pointer is the key
+ * =============================================================================
+ */
+static ulong_t
+hashKeyValue (const void* keyPtr)
+{
+    return (ulong_t)keyPtr;
+}
+
+
+/* =============================================================================
+ * compareKeyValues
+ * -- Default compare function: the key pointers are the keys
+ * =============================================================================
+ */
+static long
+compareKeyValues (const pair_t* a, const pair_t* b)
+{
+    ulong_t aKey = (ulong_t)a->firstPtr;
+    ulong_t bKey = (ulong_t)b->firstPtr;
+
+    return ((aKey < bKey) ? -1 : ((aKey > bKey) ? 1 : 0));
+}
+
+
+/* =============================================================================
+ * getNumIterBucket
+ * -- While the table is resized, the not yet migrated old buckets are
+ *    iterated first (see getIterChain())
+ * =============================================================================
+ */
+static long
+getNumIterBucket (hashtable_t* hashtablePtr)
+{
+    long numBucket = hashtablePtr->numBucket;
+
+    if (hashtablePtr->oldBuckets != NULL) {
+        numBucket += hashtablePtr->oldNumBucket;
+    }
+
+    return numBucket;
+}
+
+
+/* =============================================================================
+ * TMgetNumIterBucket
+ * =============================================================================
+ */
+static long
+TMgetNumIterBucket (TM_ARGDECL  hashtable_t* hashtablePtr)
+{
+    long numBucket = (long)TM_SHARED_READ(hashtablePtr->numBucket);
+
+    if (TM_SHARED_READ_P(hashtablePtr->oldBuckets) != NULL) {
+        numBucket += (long)TM_SHARED_READ(hashtablePtr->oldNumBucket);
+    }
+
+    return numBucket;
+}
+
+
+/* =============================================================================
+ * getIterChain
+ * -- Migrated old buckets are NULL and read as the (empty) dummy bucket
+ * =============================================================================
+ */
+static list_t*
+getIterChain (hashtable_t* hashtablePtr, long bucket)
+{
+    list_t** oldBuckets = hashtablePtr->oldBuckets;
+
+    if (oldBuckets != NULL) {
+        long oldNumBucket = hashtablePtr->oldNumBucket;
+        if (bucket < oldNumBucket) {
+            list_t* chainPtr = oldBuckets[bucket];
+            if (chainPtr != NULL) {
+                return chainPtr;
+            }
+            bucket = oldNumBucket + hashtablePtr->numBucket;
+        }
+        bucket -= oldNumBucket;
+    }
+
+    /* May use dummy bucket; see allocBuckets() */
+    return hashtablePtr->buckets[bucket];
+}
+
+
+/* =============================================================================
+ * TMgetIterChain
+ * =============================================================================
+ */
+static list_t*
+TMgetIterChain (TM_ARGDECL  hashtable_t* hashtablePtr, long bucket)
+{
+    list_t** oldBuckets = (list_t**)TM_SHARED_READ_P(hashtablePtr->oldBuckets);
+    list_t** buckets = (list_t**)TM_SHARED_READ_P(hashtablePtr->buckets);
+    long numBucket = (long)TM_SHARED_READ(hashtablePtr->numBucket);
+
+    if (oldBuckets != NULL) {
+        long oldNumBucket = (long)TM_SHARED_READ(hashtablePtr->oldNumBucket);
+        if (bucket < oldNumBucket) {
+            list_t* chainPtr = (list_t*)TM_SHARED_READ_P(oldBuckets[bucket]);
+            if (chainPtr != NULL) {
+                return chainPtr;
+            }
+            bucket = oldNumBucket + numBucket;
+        }
+        bucket -= oldNumBucket;
+    }
+
+    /* May use dummy bucket; see allocBuckets() */
+    return buckets[bucket];
+}
 
 
 /* =============================================================================
@@ -105,7 +222,7 @@ void
 hashtable_iter_reset (hashtable_iter_t* itPtr, hashtable_t* hashtablePtr)
 {
     itPtr->bucket = 0;
-    list_iter_reset(&(itPtr->it), hashtablePtr->buckets[0]);
+    list_iter_reset(&(itPtr->it), getIterChain(hashtablePtr, 0));
 }
 
 
@@ -118,7 +235,7 @@ TMhashtable_iter_reset (TM_ARGDECL
                         hashtable_iter_t* itPtr, hashtable_t* hashtablePtr)
 {
     itPtr->bucket = 0;
-    TMLIST_ITER_RESET(&(itPtr->it), hashtablePtr->buckets[0]);
+    TMLIST_ITER_RESET(&(itPtr->it), TMgetIterChain(TM_ARG  hashtablePtr, 0));
 }
 
 
@@ -130,17 +247,15 @@ bool_t
 hashtable_iter_hasNext (hashtable_iter_t* itPtr, hashtable_t* hashtablePtr)
 {
     long bucket;
-    long numBucket = hashtablePtr->numBucket;
-    list_t** buckets = hashtablePtr->buckets;
+    long numBucket = getNumIterBucket(hashtablePtr);
     list_iter_t it = itPtr->it;
 
     for (bucket = itPtr->bucket; bucket < numBucket; /* inside body */) {
-        list_t* chainPtr = buckets[bucket];
+        list_t* chainPtr = getIterChain(hashtablePtr, bucket);
         if (list_iter_hasNext(&it, chainPtr)) {
             return TRUE;
         }
-        /* May use dummy bucket; see allocBuckets() */
-        list_iter_reset(&it, buckets[++bucket]);
+        list_iter_reset(&it, getIterChain(hashtablePtr, ++bucket));
     }
 
     return FALSE;
@@ -156,17 +271,15 @@ TMhashtable_iter_hasNext (TM_ARGDECL
                           hashtable_iter_t* itPtr, hashtable_t* hashtablePtr)
 {
     long bucket;
-    long numBucket = hashtablePtr->numBucket;
-    list_t** buckets = hashtablePtr->buckets;
+    long numBucket = TMgetNumIterBucket(TM_ARG  hashtablePtr);
     list_iter_t it = itPtr->it;
 
     for (bucket = itPtr->bucket; bucket < numBucket; /* inside body */) {
-        list_t* chainPtr = buckets[bucket];
+        list_t* chainPtr = TMgetIterChain(TM_ARG  hashtablePtr, bucket);
         if (TMLIST_ITER_HASNEXT(&it, chainPtr)) {
             return TRUE;
         }
-        /* May use dummy bucket; see allocBuckets() */
-        TMLIST_ITER_RESET(&it, buckets[++bucket]);
+        TMLIST_ITER_RESET(&it, TMgetIterChain(TM_ARG  hashtablePtr, ++bucket));
     }
 
     return FALSE;
@@ -181,20 +294,18 @@ void*
 hashtable_iter_next (hashtable_iter_t* itPtr, hashtable_t* hashtablePtr)
 {
     long bucket;
-    long numBucket = hashtablePtr->numBucket;
-    list_t** buckets = hashtablePtr->buckets;
+    long numBucket = getNumIterBucket(hashtablePtr);
     list_iter_t it = itPtr->it;
     void* dataPtr = NULL;
 
     for (bucket = itPtr->bucket; bucket < numBucket; /* inside body */) {
-        list_t* chainPtr = hashtablePtr->buckets[bucket];
+        list_t* chainPtr = getIterChain(hashtablePtr, bucket);
         if (list_iter_hasNext(&it, chainPtr)) {
             pair_t* pairPtr = (pair_t*)list_iter_next(&it, chainPtr);
             dataPtr = pairPtr->secondPtr;
             break;
         }
-        /* May use dummy bucket; see allocBuckets() */
-        list_iter_reset(&it, buckets[++bucket]);
+        list_iter_reset(&it, getIterChain(hashtablePtr, ++bucket));
     }
 
     itPtr->bucket = bucket;
@@ -213,20 +324,18 @@ TMhashtable_iter_next (TM_ARGDECL
                        hashtable_iter_t* itPtr, hashtable_t* hashtablePtr)
 {
     long bucket;
-    long numBucket = hashtablePtr->numBucket;
-    list_t** buckets = hashtablePtr->buckets;
+    long numBucket = TMgetNumIterBucket(TM_ARG  hashtablePtr);
     list_iter_t it = itPtr->it;
     void* dataPtr = NULL;
 
     for (bucket = itPtr->bucket; bucket < numBucket; /* inside body */) {
-        list_t* chainPtr = hashtablePtr->buckets[bucket];
+        list_t* chainPtr = TMgetIterChain(TM_ARG  hashtablePtr, bucket);
         if (TMLIST_ITER_HASNEXT(&it, chainPtr)) {
             pair_t* pairPtr = (pair_t*)TMLIST_ITER_NEXT(&it, chainPtr);
             dataPtr = pairPtr->secondPtr;
             break;
         }
-        /* May use dummy bucket; see allocBuckets() */
-        TMLIST_ITER_RESET(&it, buckets[++bucket]);
+        TMLIST_ITER_RESET(&it, TMgetIterChain(TM_ARG  hashtablePtr, ++bucket));
     }
 
     itPtr->bucket = bucket;
@@ -260,6 +369,7 @@ allocBuckets (long numBucket, long (*comparePairs)(const pair_t*, const pair_t*)
             while (--i >= 0) {
                 list_free(buckets[i]);
             }
+            memory_free(buckets);
             return NULL;
         }
         buckets[i] = chainPtr;
@@ -294,6 +404,7 @@ TMallocBuckets (TM_ARGDECL
             while (--i >= 0) {
                 TMLIST_FREE(buckets[i]);
             }
+            TM_FREE(buckets);
             return NULL;
         }
         buckets[i] = chainPtr;
@@ -307,6 +418,8 @@ TMallocBuckets (TM_ARGDECL
  * hashtable_alloc
  * -- Returns NULL on failure
  * -- Negative values for resizeRatio or growthFactor select default values
+ * -- If NULL is passed for hash and comparePairs, keys are hashed and compared
+ *    by value
  * =============================================================================
  */
 hashtable_t*
@@ -323,18 +436,24 @@ hashtable_alloc (long initNumBucket,
         return NULL;
     }
 
-    hashtablePtr->buckets = allocBuckets(initNumBucket, comparePairs);
+    hashtablePtr->hash = ((hash != NULL) ? hash : &hashKeyValue);
+    hashtablePtr->comparePairs = ((comparePairs != NULL) ?
+                                  comparePairs : &compareKeyValues);
+
+    hashtablePtr->buckets = allocBuckets(initNumBucket,
+                                         hashtablePtr->comparePairs);
     if (hashtablePtr->buckets == NULL) {
-        free(hashtablePtr);
+        memory_free(hashtablePtr);
         return NULL;
     }
 
     hashtablePtr->numBucket = initNumBucket;
+    hashtablePtr->oldBuckets = NULL;
+    hashtablePtr->oldNumBucket = 0;
+    hashtablePtr->numChunkLeft = 0;
 #ifdef HASHTABLE_SIZE_FIELD
     hashtablePtr->size = 0;
 #endif
-    hashtablePtr->hash = hash;
-    hashtablePtr->comparePairs = comparePairs;
     hashtablePtr->resizeRatio = ((resizeRatio < 0) ?
                                   HASHTABLE_DEFAULT_RESIZE_RATIO : resizeRatio);
     hashtablePtr->growthFactor = ((growthFactor < 0) ?
@@ -348,6 +467,8 @@ hashtable_alloc (long initNumBucket,
  * TMhashtable_alloc
  * -- Returns NULL on failure
  * -- Negative values for resizeRatio or growthFactor select default values
+ * -- If NULL is passed for hash and comparePairs, keys are hashed and compared
+ *    by value
  * =============================================================================
  */
 hashtable_t*
@@ -365,18 +486,25 @@ TMhashtable_alloc (TM_ARGDECL
         return NULL;
     }
 
-    hashtablePtr->buckets = TMallocBuckets(TM_ARG  initNumBucket, comparePairs);
+    hashtablePtr->hash = ((hash != NULL) ? hash : &hashKeyValue);
+    hashtablePtr->comparePairs = ((comparePairs != NULL) ?
+                                  comparePairs : &compareKeyValues);
+
+    hashtablePtr->buckets = TMallocBuckets(TM_ARG
+                                           initNumBucket,
+                                           hashtablePtr->comparePairs);
     if (hashtablePtr->buckets == NULL) {
         TM_FREE(hashtablePtr);
         return NULL;
     }
 
     hashtablePtr->numBucket = initNumBucket;
+    hashtablePtr->oldBuckets = NULL;
+    hashtablePtr->oldNumBucket = 0;
+    hashtablePtr->numChunkLeft = 0;
 #ifdef HASHTABLE_SIZE_FIELD
     hashtablePtr->size = 0;
 #endif
-    hashtablePtr->hash = hash;
-    hashtablePtr->comparePairs = comparePairs;
     hashtablePtr->resizeRatio = ((resizeRatio < 0) ?
                                   HASHTABLE_DEFAULT_RESIZE_RATIO : resizeRatio);
     hashtablePtr->growthFactor = ((growthFactor < 0) ?
@@ -388,6 +516,7 @@ TMhashtable_alloc (TM_ARGDECL
 
 /* =============================================================================
  * freeBuckets
+ * -- Also frees the dummy bucket; migrated (NULL) buckets are skipped
  * =============================================================================
  */
 static void
@@ -395,11 +524,13 @@ freeBuckets (list_t** buckets, long numBucket)
 {
     long i;
 
-    for (i = 0; i < numBucket; i++) {
-        list_free(buckets[i]);
+    for (i = 0; i < (numBucket + 1); i++) {
+        if (buckets[i] != NULL) {
+            list_free(buckets[i]);
+        }
     }
 
-    free(buckets);
+    memory_free(buckets);
 }
 
 
@@ -412,8 +543,11 @@ TMfreeBuckets (TM_ARGDECL  list_t** buckets, long numBucket)
 {
     long i;
 
-    for (i = 0; i < numBucket; i++) {
-        TMLIST_FREE( buckets[i]);
+    for (i = 0; i < (numBucket + 1); i++) {
+        list_t* chainPtr = (list_t*)TM_SHARED_READ_P(buckets[i]);
+        if (chainPtr != NULL) {
+            TMLIST_FREE(chainPtr);
+        }
     }
 
     TM_FREE(buckets);
@@ -427,8 +561,11 @@ TMfreeBuckets (TM_ARGDECL  list_t** buckets, long numBucket)
 void
 hashtable_free (hashtable_t* hashtablePtr)
 {
+    if (hashtablePtr->oldBuckets != NULL) {
+        freeBuckets(hashtablePtr->oldBuckets, hashtablePtr->oldNumBucket);
+    }
     freeBuckets(hashtablePtr->buckets, hashtablePtr->numBucket);
-    free(hashtablePtr);
+    memory_free(hashtablePtr);
 }
 
 
@@ -439,7 +576,16 @@ hashtable_free (hashtable_t* hashtablePtr)
 void
 TMhashtable_free (TM_ARGDECL  hashtable_t* hashtablePtr)
 {
-    TMfreeBuckets(TM_ARG  hashtablePtr->buckets, hashtablePtr->numBucket);
+    list_t** oldBuckets = (list_t**)TM_SHARED_READ_P(hashtablePtr->oldBuckets);
+
+    if (oldBuckets != NULL) {
+        TMfreeBuckets(TM_ARG
+                      oldBuckets,
+                      (long)TM_SHARED_READ(hashtablePtr->oldNumBucket));
+    }
+    TMfreeBuckets(TM_ARG
+                  (list_t**)TM_SHARED_READ_P(hashtablePtr->buckets),
+                  (long)TM_SHARED_READ(hashtablePtr->numBucket));
     TM_FREE(hashtablePtr);
 }
 
@@ -454,10 +600,11 @@ hashtable_isEmpty (hashtable_t* hashtablePtr)
 #ifdef HASHTABLE_SIZE_FIELD
     return ((hashtablePtr->size == 0) ? TRUE : FALSE);
 #else
+    long numBucket = getNumIterBucket(hashtablePtr);
     long i;
 
-    for (i = 0; i < hashtablePtr->numBucket; i++) {
-        if (!list_isEmpty(hashtablePtr->buckets[i])) {
+    for (i = 0; i < numBucket; i++) {
+        if (!list_isEmpty(getIterChain(hashtablePtr, i))) {
             return FALSE;
         }
     }
@@ -477,10 +624,11 @@ TMhashtable_isEmpty (TM_ARGDECL  hashtable_t* hashtablePtr)
 #ifdef HASHTABLE_SIZE_FIELD
     return ((TM_SHARED_READ(hashtablePtr->size) == 0) ? TRUE : FALSE);
 #else
+    long numBucket = TMgetNumIterBucket(TM_ARG  hashtablePtr);
     long i;
 
-    for (i = 0; i < hashtablePtr->numBucket; i++) {
-        if (!TMLIST_ISEMPTY(hashtablePtr->buckets[i])) {
+    for (i = 0; i < numBucket; i++) {
+        if (!TMLIST_ISEMPTY(TMgetIterChain(TM_ARG  hashtablePtr, i))) {
             return FALSE;
         }
     }
@@ -501,11 +649,12 @@ hashtable_getSize (hashtable_t* hashtablePtr)
 #ifdef HASHTABLE_SIZE_FIELD
     return hashtablePtr->size;
 #else
+    long numBucket = getNumIterBucket(hashtablePtr);
     long i;
     long size = 0;
 
-    for (i = 0; i < hashtablePtr->numBucket; i++) {
-        size += list_getSize(hashtablePtr->buckets[i]);
+    for (i = 0; i < numBucket; i++) {
+        size += list_getSize(getIterChain(hashtablePtr, i));
     }
 
     return size;
@@ -524,11 +673,12 @@ TMhashtable_getSize (TM_ARGDECL  hashtable_t* hashtablePtr)
 #ifdef HASHTABLE_SIZE_FIELD
     return (long)TM_SHARED_READ(hashtablePtr->size);
 #else
+    long numBucket = TMgetNumIterBucket(TM_ARG  hashtablePtr);
     long i;
     long size = 0;
 
-    for (i = 0; i < hashtablePtr->numBucket; i++) {
-        size += TMLIST_GETSIZE(hashtablePtr->buckets[i]);
+    for (i = 0; i < numBucket; i++) {
+        size += TMLIST_GETSIZE(TMgetIterChain(TM_ARG  hashtablePtr, i));
     }
 
     return size;
@@ -536,6 +686,64 @@ TMhashtable_getSize (TM_ARGDECL  hashtable_t* hashtablePtr)
 }
 
 
+/* =============================================================================
+ * getChain
+ * -- Returns the bucket list that holds (or would hold) the key: its old
+ *    bucket if that has not been migrated yet, else its new one
+ * =============================================================================
+ */
+static list_t*
+getChain (hashtable_t* hashtablePtr, ulong_t hash)
+{
+#ifdef HASHTABLE_RESIZABLE
+    list_t** oldBuckets = hashtablePtr->oldBuckets;
+
+    if (oldBuckets != NULL) {
+        list_t* chainPtr = oldBuckets[hash % hashtablePtr->oldNumBucket];
+        if (chainPtr != NULL) {
+            return chainPtr;
+        }
+    }
+#endif
+
+    return hashtablePtr->buckets[hash % hashtablePtr->numBucket];
+}
+
+
+/* =============================================================================
+ * TMgetChain
+ * -- Only the table header and the key's old bucket are read, so lookups do
+ *    not conflict with the migration of other buckets
+ * =============================================================================
+ */
+static list_t*
+TMgetChain (TM_ARGDECL  hashtable_t* hashtablePtr, ulong_t hash)
+{
+#ifdef HASHTABLE_RESIZABLE
+    list_t** oldBuckets = (list_t**)TM_SHARED_READ_P(hashtablePtr->oldBuckets);
+    list_t** buckets;
+    long numBucket;
+
+    if (oldBuckets != NULL) {
+        long oldNumBucket = (long)TM_SHARED_READ(hashtablePtr->oldNumBucket);
+        list_t* chainPtr =
+            (list_t*)TM_SHARED_READ_P(oldBuckets[hash % oldNumBucket]);
+        if (chainPtr != NULL) {
+            return chainPtr;
+        }
+    }
+
+    /* Bucket arrays do not change after they are published */
+    buckets = (list_t**)TM_SHARED_READ_P(hashtablePtr->buckets);
+    numBucket = (long)TM_SHARED_READ(hashtablePtr->numBucket);
+
+    return buckets[hash % numBucket];
+#else
+    return hashtablePtr->buckets[hash % hashtablePtr->numBucket];
+#endif
+}
+
+
 /* =============================================================================
  * hashtable_containsKey
  * =============================================================================
@@ -543,12 +751,12 @@ TMhashtable_getSize (TM_ARGDECL  hashtable_t* hashtablePtr)
 bool_t
 hashtable_containsKey (hashtable_t* hashtablePtr, void* keyPtr)
 {
-    long i = hashtablePtr->hash(keyPtr) % hashtablePtr->numBucket;
+    list_t* chainPtr = getChain(hashtablePtr, hashtablePtr->hash(keyPtr));
     pair_t* pairPtr;
     pair_t findPair;
 
     findPair.firstPtr = keyPtr;
-    pairPtr = (pair_t*)list_find(hashtablePtr->buckets[i], &findPair);
+    pairPtr = (pair_t*)list_find(chainPtr, &findPair);
 
     return ((pairPtr != NULL) ? TRUE : FALSE);
 }
@@ -561,12 +769,13 @@ hashtable_containsKey (hashtable_t* hashtablePtr, void* keyPtr)
 bool_t
 TMhashtable_containsKey (TM_ARGDECL  hashtable_t* hashtablePtr, void* keyPtr)
 {
-    long i = hashtablePtr->hash(keyPtr) % hashtablePtr->numBucket;
+    list_t* chainPtr =
+        TMgetChain(TM_ARG  hashtablePtr, hashtablePtr->hash(keyPtr));
     pair_t* pairPtr;
     pair_t findPair;
 
     findPair.firstPtr = keyPtr;
-    pairPtr = (pair_t*)TMLIST_FIND(hashtablePtr->buckets[i], &findPair);
+    pairPtr = (pair_t*)TMLIST_FIND(chainPtr, &findPair);
 
     return ((pairPtr != NULL) ? TRUE : FALSE);
 }
@@ -580,12 +789,12 @@ TMhashtable_containsKey (TM_ARGDECL  hashtable_t* hashtablePtr, void* keyPtr)
 void*
 hashtable_find (hashtable_t* hashtablePtr, void* keyPtr)
 {
-    long i = hashtablePtr->hash(keyPtr) % hashtablePtr->numBucket;
+    list_t* chainPtr = getChain(hashtablePtr, hashtablePtr->hash(keyPtr));
     pair_t* pairPtr;
     pair_t findPair;
 
     findPair.firstPtr = keyPtr;
-    pairPtr = (pair_t*)list_find(hashtablePtr->buckets[i], &findPair);
+    pairPtr = (pair_t*)list_find(chainPtr, &findPair);
     if (pairPtr == NULL) {
         return NULL;
     }
@@ -602,12 +811,13 @@ hashtable_find (hashtable_t* hashtablePtr, void* keyPtr)
 void*
 TMhashtable_find (TM_ARGDECL  hashtable_t* hashtablePtr, void* keyPtr)
 {
-    long i = hashtablePtr->hash(keyPtr) % hashtablePtr->numBucket;
+    list_t* chainPtr =
+        TMgetChain(TM_ARG  hashtablePtr, hashtablePtr->hash(keyPtr));
     pair_t* pairPtr;
     pair_t findPair;
 
     findPair.firstPtr = keyPtr;
-    pairPtr = (pair_t*)TMLIST_FIND(hashtablePtr->buckets[i], &findPair);
+    pairPtr = (pair_t*)TMLIST_FIND(chainPtr, &findPair);
     if (pairPtr == NULL) {
         return NULL;
     }
@@ -616,39 +826,273 @@ TMhashtable_find (TM_ARGDECL  hashtable_t* hashtablePtr, void* keyPtr)
 }
 
 
-#if defined(HASHTABLE_RESIZABLE) && !(defined(HTM) || defined(STM))
+#ifdef HASHTABLE_RESIZABLE
 /* =============================================================================
- * rehash
+ * getChunk
+ * -- Old buckets are moved in chunks of HASHTABLE_MIGRATE_CHUNK; returns the
+ *    first old bucket of the chunk that hash falls in and sets *stopPtr
  * =============================================================================
  */
-static list_t**
-rehash (hashtable_t* hashtablePtr)
+static long
+getChunk (ulong_t hash, long oldNumBucket, long* stopPtr)
 {
-    list_t** oldBuckets = hashtablePtr->buckets;
-    long oldNumBucket = hashtablePtr->numBucket;
-    long newNumBucket = hashtablePtr->growthFactor * oldNumBucket;
-    list_t** newBuckets;
+    long first = hash % oldNumBucket;
+    long stop;
+
+    first -= first % HASHTABLE_MIGRATE_CHUNK;
+    stop = first + HASHTABLE_MIGRATE_CHUNK;
+    *stopPtr = ((stop > oldNumBucket) ? oldNumBucket : stop);
+
+    return first;
+}
+
+
+/* =============================================================================
+ * migrate
+ * -- Moves one old bucket of the chunk that hash falls in to the new buckets:
+ *    the caller's own bucket if it is still there, else the first one left
+ * -- The update that empties a chunk counts it off, and the one that counts
+ *    off the last chunk frees the old bucket array
+ * =============================================================================
+ */
+static void
+migrate (hashtable_t* hashtablePtr, ulong_t hash)
+{
+    list_t** oldBuckets = hashtablePtr->oldBuckets;
+    list_t** buckets = hashtablePtr->buckets;
+    long numBucket = hashtablePtr->numBucket;
+    long oldNumBucket;
+    long first;
+    long stop;
+    long b;
+
+    if (oldBuckets == NULL) {
+        return;
+    }
+
+    oldNumBucket = hashtablePtr->oldNumBucket;
+    first = getChunk(hash, oldNumBucket, &stop);
+    b = hash % oldNumBucket;
+    if (oldBuckets[b] == NULL) {
+        for (b = first; b < stop && oldBuckets[b] == NULL; b++) {
+            /* nothing */
+        }
+        if (b == stop) {
+            return; /* chunk already moved */
+        }
+    }
+
+    list_t* chainPtr = oldBuckets[b];
+    list_iter_t it;
+    list_iter_reset(&it, chainPtr);
+    while (list_iter_hasNext(&it, chainPtr)) {
+        pair_t* transferPtr = (pair_t*)list_iter_next(&it, chainPtr);
+        long j = hashtablePtr->hash(transferPtr->firstPtr) % numBucket;
+        bool_t status = list_insert(buckets[j], (void*)transferPtr);
+        assert(status);
+    }
+    list_free(chainPtr);
+    oldBuckets[b] = NULL;
+
+    for (b = first; b < stop; b++) {
+        if (oldBuckets[b] != NULL) {
+            return;
+        }
+    }
+
+    hashtablePtr->numChunkLeft--;
+    if (hashtablePtr->numChunkLeft == 0) {
+        list_free(oldBuckets[oldNumBucket]); /* dummy */
+        memory_free(oldBuckets);
+        hashtablePtr->oldBuckets = NULL;
+    }
+}
+
+
+/* =============================================================================
+ * TMmigrate
+ * -- Reads and writes only old buckets of the caller's chunk, so updates in
+ *    other chunks do not conflict; numChunkLeft is written once per chunk
+ * =============================================================================
+ */
+static void
+TMmigrate (TM_ARGDECL  hashtable_t* hashtablePtr, ulong_t hash)
+{
+    list_t** oldBuckets = (list_t**)TM_SHARED_READ_P(hashtablePtr->oldBuckets);
+    list_t** buckets;
+    long numBucket;
+    long oldNumBucket;
+    long numChunkLeft;
+    long first;
+    long stop;
+    long b;
+
+    if (oldBuckets == NULL) {
+        return;
+    }
+
+    oldNumBucket = (long)TM_SHARED_READ(hashtablePtr->oldNumBucket);
+    first = getChunk(hash, oldNumBucket, &stop);
+    b = hash % oldNumBucket;
+    if (TM_SHARED_READ_P(oldBuckets[b]) == NULL) {
+        for (b = first; b < stop; b++) {
+            if (TM_SHARED_READ_P(oldBuckets[b]) != NULL) {
+                break;
+            }
+        }
+        if (b == stop) {
+            return; /* chunk already moved */
+        }
+    }
+
+    buckets = (list_t**)TM_SHARED_READ_P(hashtablePtr->buckets);
+    numBucket = (long)TM_SHARED_READ(hashtablePtr->numBucket);
+
+    list_t* chainPtr = (list_t*)TM_SHARED_READ_P(oldBuckets[b]);
+    list_iter_t it;
+    TMLIST_ITER_RESET(&it, chainPtr);
+    while (TMLIST_ITER_HASNEXT(&it, chainPtr)) {
+        pair_t* transferPtr = (pair_t*)TMLIST_ITER_NEXT(&it, chainPtr);
+        long j = hashtablePtr->hash(transferPtr->firstPtr) % numBucket;
+        bool_t status = TMLIST_INSERT(buckets[j], (void*)transferPtr);
+        assert(status);
+    }
+    TMLIST_FREE(chainPtr);
+    TM_SHARED_WRITE_P(oldBuckets[b], NULL);
+
+    for (b = first; b < stop; b++) {
+        if (TM_SHARED_READ_P(oldBuckets[b]) != NULL) {
+            return;
+        }
+    }
+
+    numChunkLeft = (long)TM_SHARED_READ(hashtablePtr->numChunkLeft) - 1;
+    TM_SHARED_WRITE(hashtablePtr->numChunkLeft, numChunkLeft);
+    if (numChunkLeft == 0) {
+        TMLIST_FREE(oldBuckets[oldNumBucket]); /* dummy */
+        TM_FREE(oldBuckets);
+        TM_SHARED_WRITE_P(hashtablePtr->oldBuckets, NULL);
+    }
+}
+
+
+/* =============================================================================
+ * isOverloaded
+ * -- Checked only when the chain an insert lands in has grown long, so that
+ *    inserts do not need a global size; a sample of other buckets confirms
+ *    the load, so that a poor hash function does not make the table grow
+ * =============================================================================
+ */
+static bool_t
+isOverloaded (hashtable_t* hashtablePtr, list_t* chainPtr, ulong_t hash)
+{
+    list_t** buckets = hashtablePtr->buckets;
+    long numBucket = hashtablePtr->numBucket;
+    long resizeRatio = hashtablePtr->resizeRatio;
+    long numSample;
+    long stride;
+    long size = 0;
+    long i;
+
+    if (list_getSize(chainPtr) <= (2 * resizeRatio)) {
+        return FALSE;
+    }
+
+    numSample = ((numBucket < HASHTABLE_RESIZE_SAMPLE) ?
+                 numBucket : HASHTABLE_RESIZE_SAMPLE);
+    stride = numBucket / numSample;
+    for (i = 1; i <= numSample; i++) {
+        size += list_getSize(buckets[(hash + i * stride) % numBucket]);
+    }
+
+    return ((size >= (numSample * resizeRatio)) ? TRUE : FALSE);
+}
+
+
+/* =============================================================================
+ * TMisOverloaded
+ * =============================================================================
+ */
+static bool_t
+TMisOverloaded (TM_ARGDECL
+                hashtable_t* hashtablePtr, list_t* chainPtr, ulong_t hash)
+{
+    list_t** buckets;
+    long numBucket;
+    long resizeRatio = hashtablePtr->resizeRatio;
+    long numSample;
+    long stride;
+    long size = 0;
     long i;
 
+    if (TMLIST_GETSIZE(chainPtr) <= (2 * resizeRatio)) {
+        return FALSE;
+    }
+
+    buckets = (list_t**)TM_SHARED_READ_P(hashtablePtr->buckets);
+    numBucket = (long)TM_SHARED_READ(hashtablePtr->numBucket);
+    numSample = ((numBucket < HASHTABLE_RESIZE_SAMPLE) ?
+                 numBucket : HASHTABLE_RESIZE_SAMPLE);
+    stride = numBucket / numSample;
+    for (i = 1; i <= numSample; i++) {
+        size += TMLIST_GETSIZE(buckets[(hash + i * stride) % numBucket]);
+    }
+
+    return ((size >= (numSample * resizeRatio)) ? TRUE : FALSE);
+}
+
+
+/* =============================================================================
+ * startResize
+ * -- Publishes a larger, empty bucket array; entries are moved to it later by
+ *    migrate(), one bucket per update, instead of all at once
+ * =============================================================================
+ */
+static void
+startResize (hashtable_t* hashtablePtr)
+{
+    long numBucket = hashtablePtr->numBucket;
+    long newNumBucket = hashtablePtr->growthFactor * numBucket;
+    list_t** newBuckets;
+
     newBuckets = allocBuckets(newNumBucket, hashtablePtr->comparePairs);
     if (newBuckets == NULL) {
-        return NULL;
+        return; /* keep the current buckets */
     }
 
-    for (i = 0; i < oldNumBucket; i++) {
-        list_t* chainPtr = oldBuckets[i];
-        list_iter_t it;
-        list_iter_reset(&it, chainPtr);
-        while (list_iter_hasNext(&it, chainPtr)) {
-            pair_t* transferPtr = (pair_t*)list_iter_next(&it, chainPtr);
-            long j = hashtablePtr->hash(transferPtr->firstPtr) % newNumBucket;
-            if (list_insert(newBuckets[j], (void*)transferPtr) == FALSE) {
-                return NULL;
-            }
-        }
+    hashtablePtr->oldBuckets = hashtablePtr->buckets;
+    hashtablePtr->oldNumBucket = numBucket;
+    hashtablePtr->numChunkLeft = ((numBucket + HASHTABLE_MIGRATE_CHUNK - 1) /
+                                  HASHTABLE_MIGRATE_CHUNK);
+    hashtablePtr->buckets = newBuckets;
+    hashtablePtr->numBucket = newNumBucket;
+}
+
+
+/* =============================================================================
+ * TMstartResize
+ * =============================================================================
+ */
+static void
+TMstartResize (TM_ARGDECL  hashtable_t* hashtablePtr)
+{
+    list_t** buckets = (list_t**)TM_SHARED_READ_P(hashtablePtr->buckets);
+    long numBucket = (long)TM_SHARED_READ(hashtablePtr->numBucket);
+    long newNumBucket = hashtablePtr->growthFactor * numBucket;
+    list_t** newBuckets;
+
+    newBuckets = TMallocBuckets(TM_ARG  newNumBucket, hashtablePtr->comparePairs);
+    if (newBuckets == NULL) {
+        return; /* keep the current buckets */
     }
 
-    return newBuckets;
+    TM_SHARED_WRITE_P(hashtablePtr->oldBuckets, buckets);
+    TM_SHARED_WRITE(hashtablePtr->oldNumBucket, numBucket);
+    TM_SHARED_WRITE(hashtablePtr->numChunkLeft,
+                    ((numBucket + HASHTABLE_MIGRATE_CHUNK - 1) /
+                     HASHTABLE_MIGRATE_CHUNK));
+    TM_SHARED_WRITE_P(hashtablePtr->buckets, newBuckets);
+    TM_SHARED_WRITE(hashtablePtr->numBucket, newNumBucket);
 }
 #endif /* HASHTABLE_RESIZABLE */
 
@@ -660,15 +1104,17 @@ rehash (hashtable_t* hashtablePtr)
 bool_t
 hashtable_insert (hashtable_t* hashtablePtr, void* keyPtr, void* dataPtr)
 {
-    long numBucket = hashtablePtr->numBucket;
-    long i = hashtablePtr->hash(keyPtr) % numBucket;
-#if defined(HASHTABLE_SIZE_FIELD) || defined(HASHTABLE_RESIZABLE)
-    long newSize;
+    ulong_t hash = hashtablePtr->hash(keyPtr);
+    list_t* chainPtr;
+
+#ifdef HASHTABLE_RESIZABLE
+    migrate(hashtablePtr, hash);
 #endif
+    chainPtr = getChain(hashtablePtr, hash);
 
     pair_t findPair;
     findPair.firstPtr = keyPtr;
-    pair_t* pairPtr = (pair_t*)list_find(hashtablePtr->buckets[i], &findPair);
+    pair_t* pairPtr = (pair_t*)list_find(chainPtr, &findPair);
     if (pairPtr != NULL) {
         return FALSE;
     }
@@ -678,37 +1124,24 @@ hashtable_insert (hashtable_t* hashtablePtr, void* keyPtr, void* dataPtr)
         return FALSE;
     }
 
+    /* Add new entry  */
+    if (list_insert(chainPtr, insertPtr) == FALSE) {
+        pair_free(insertPtr);
+        return FALSE;
+    }
 #ifdef HASHTABLE_SIZE_FIELD
-    newSize = hashtablePtr->size + 1;
-    assert(newSize > 0);
-#elif defined(HASHTABLE_RESIZABLE)
-    newSize = hashtable_getSize(hashtablePtr) + 1;
-    assert(newSize > 0);
+    hashtablePtr->size++;
+    assert(hashtablePtr->size > 0);
 #endif
 
 #ifdef HASHTABLE_RESIZABLE
     /* Increase number of buckets to maintain size ratio */
-    if (newSize >= (numBucket * hashtablePtr->resizeRatio)) {
-        list_t** newBuckets = rehash(hashtablePtr);
-        if (newBuckets == NULL) {
-            return FALSE;
-        }
-        freeBuckets(hashtablePtr->buckets, numBucket);
-        numBucket *= hashtablePtr->growthFactor;
-        hashtablePtr->buckets = newBuckets;
-        hashtablePtr->numBucket = numBucket;
-        i = hashtablePtr->hash(keyPtr) % numBucket;
-
-    }
-#endif
-
-    /* Add new entry  */
-    if (list_insert(hashtablePtr->buckets[i], insertPtr) == FALSE) {
-        pair_free(insertPtr);
-        return FALSE;
+    if ((hashtablePtr->oldBuckets == NULL) &&
+        (hashtablePtr->growthFactor > 1) &&
+        isOverloaded(hashtablePtr, chainPtr, hash))
+    {
+        startResize(hashtablePtr);
     }
-#ifdef HASHTABLE_SIZE_FIELD
-    hashtablePtr->size = newSize;
 #endif
 
     return TRUE;
@@ -723,12 +1156,17 @@ bool_t
 TMhashtable_insert (TM_ARGDECL
                     hashtable_t* hashtablePtr, void* keyPtr, void* dataPtr)
 {
-    long numBucket = hashtablePtr->numBucket;
-    long i = hashtablePtr->hash(keyPtr) % numBucket;
+    ulong_t hash = hashtablePtr->hash(keyPtr);
+    list_t* chainPtr;
+
+#ifdef HASHTABLE_RESIZABLE
+    TMmigrate(TM_ARG  hashtablePtr, hash);
+#endif
+    chainPtr = TMgetChain(TM_ARG  hashtablePtr, hash);
 
     pair_t findPair;
     findPair.firstPtr = keyPtr;
-    pair_t* pairPtr = (pair_t*)TMLIST_FIND(hashtablePtr->buckets[i], &findPair);
+    pair_t* pairPtr = (pair_t*)TMLIST_FIND(chainPtr, &findPair);
     if (pairPtr != NULL) {
         return FALSE;
     }
@@ -739,17 +1177,27 @@ TMhashtable_insert (TM_ARGDECL
     }
 
     /* Add new entry  */
-    if (TMLIST_INSERT(hashtablePtr->buckets[i], insertPtr) == FALSE) {
+    if (TMLIST_INSERT(chainPtr, insertPtr) == FALSE) {
         TMPAIR_FREE(insertPtr);
         return FALSE;
     }
 
 #ifdef HASHTABLE_SIZE_FIELD
-    long newSize = TM_SHARED_READ(hashtablePtr->size) + 1;
+    long newSize = (long)TM_SHARED_READ(hashtablePtr->size) + 1;
     assert(newSize > 0);
     TM_SHARED_WRITE(hashtablePtr->size, newSize);
 #endif
 
+#ifdef HASHTABLE_RESIZABLE
+    /* Increase number of buckets to maintain size ratio */
+    if ((TM_SHARED_READ_P(hashtablePtr->oldBuckets) == NULL) &&
+        (hashtablePtr->growthFactor > 1) &&
+        TMisOverloaded(TM_ARG  hashtablePtr, chainPtr, hash))
+    {
+        TMstartResize(TM_ARG  hashtablePtr);
+    }
+#endif
+
     return TRUE;
 }
 
@@ -762,12 +1210,16 @@ TMhashtable_insert (TM_ARGDECL
 bool_t
 hashtable_remove (hashtable_t* hashtablePtr, void* keyPtr)
 {
-    long numBucket = hashtablePtr->numBucket;
-    long i = hashtablePtr->hash(keyPtr) % numBucket;
-    list_t* chainPtr = hashtablePtr->buckets[i];
+    ulong_t hash = hashtablePtr->hash(keyPtr);
+    list_t* chainPtr;
     pair_t* pairPtr;
     pair_t removePair;
 
+#ifdef HASHTABLE_RESIZABLE
+    migrate(hashtablePtr, hash);
+#endif
+    chainPtr = getChain(hashtablePtr, hash);
+
     removePair.firstPtr = keyPtr;
     pairPtr = (pair_t*)list_find(chainPtr, &removePair);
     if (pairPtr == NULL) {
@@ -795,12 +1247,16 @@ hashtable_remove (hashtable_t* hashtablePtr, void* keyPtr)
 bool_t
 TMhashtable_remove (TM_ARGDECL  hashtable_t* hashtablePtr, void* keyPtr)
 {
-    long numBucket = hashtablePtr->numBucket;
-    long i = hashtablePtr->hash(keyPtr) % numBucket;
-    list_t* chainPtr = hashtablePtr->buckets[i];
+    ulong_t hash = hashtablePtr->hash(keyPtr);
+    list_t* chainPtr;
     pair_t* pairPtr;
     pair_t removePair;
 
+#ifdef HASHTABLE_RESIZABLE
+    TMmigrate(TM_ARG  hashtablePtr, hash);
+#endif
+    chainPtr = TMgetChain(TM_ARG  hashtablePtr, hash);
+
     removePair.firstPtr = keyPtr;
     pairPtr = (pair_t*)TMLIST_FIND(chainPtr, &removePair);
     if (pairPtr == NULL) {
@@ -812,9 +1268,9 @@ TMhashtable_remove (TM_ARGDECL  hashtable_t* hashtablePtr, void* keyPtr)
     TMPAIR_FREE(pairPtr);
 
 #ifdef HASHTABLE_SIZE_FIELD
-    TM_SHARED_WRITE(hashtablePtr->size
-                    (long)TM_SHARED_READ(hashtablePtr->size)-1);
-    assert(hashtablePtr->size >= 0);
+    long newSize = (long)TM_SHARED_READ(hashtablePtr->size) - 1;
+    assert(newSize >= 0);
+    TM_SHARED_WRITE(hashtablePtr->size, newSize);
 #endif
 
     return TRUE;
@@ -829,6 +1285,17 @@ TMhashtable_remove (TM_ARGDECL  hashtable_t* hashtablePtr, void* keyPtr)
 
 
 #include <stdio.h>
+#include <string.h>
+#include "cm.h"
+#include "thread.h"
+#include "tmstats.h"
+
+#define NUM_KEY       (4096)
+#define NUM_THREAD    (4)
+#define NUM_READ_SIZE (100)
+
+static char global_isPresent[NUM_KEY];
+static hashtable_t* global_hashtablePtr;
 
 
 static ulong_t
@@ -892,11 +1359,169 @@ removeInt (hashtable_t* hashtablePtr, long* data)
 }
 
 
+static ulong_t
+hashConstant (const void* keyPtr)
+{
+    return 42;
+}
+
+
+static void
+check (hashtable_t* hashtablePtr)
+{
+    hashtable_iter_t it;
+    long numPresent = 0;
+    long numIter = 0;
+    long i;
+
+    for (i = 0; i < NUM_KEY; i++) {
+        void* dataPtr = hashtable_find(hashtablePtr, (void*)i);
+        if (global_isPresent[i]) {
+            assert(dataPtr == (void*)(i + 1));
+            numPresent++;
+        } else {
+            assert(dataPtr == NULL);
+        }
+    }
+    assert(hashtable_getSize(hashtablePtr) == numPresent);
+    assert(hashtable_isEmpty(hashtablePtr) == (numPresent == 0));
+
+    hashtable_iter_reset(&it, hashtablePtr);
+    while (hashtable_iter_hasNext(&it, hashtablePtr)) {
+        long i = (long)hashtable_iter_next(&it, hashtablePtr) - 1;
+        assert(global_isPresent[i]);
+        numIter++;
+    }
+    assert(numIter == numPresent);
+}
+
+
+static void
+testSequential (ulong_t (*hash)(const void*), long numKey)
+{
+    hashtable_t* hashtablePtr;
+    long round;
+    long i;
+
+    hashtablePtr = hashtable_alloc(1, hash, NULL, -1, -1);
+    assert(hashtablePtr);
+    memset(global_isPresent, 0, sizeof(global_isPresent));
+
+    /* Checks run both during and after migrations */
+    srand(0);
+    for (round = 0; round < 8; round++) {
+        for (i = 0; i < 4 * numKey; i++) {
+            long k = rand() % numKey;
+            if (rand() % 3) {
+                bool_t status =
+                    hashtable_insert(hashtablePtr, (void*)k, (void*)(k + 1));
+                assert(status == !global_isPresent[k]);
+                global_isPresent[k] = TRUE;
+            } else {
+                bool_t status = hashtable_remove(hashtablePtr, (void*)k);
+                assert(status == global_isPresent[k]);
+                global_isPresent[k] = FALSE;
+            }
+        }
+        check(hashtablePtr);
+    }
+
+    if (hash == NULL) {
+        assert(hashtablePtr->numBucket >=
+               (numKey / (2 * HASHTABLE_DEFAULT_RESIZE_RATIO)));
+    } else {
+        assert(hashtablePtr->numBucket <= HASHTABLE_RESIZE_SAMPLE + 1);
+    }
+
+    hashtable_free(hashtablePtr);
+}
+
+
+static void
+insertRemove (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    long i;
+
+    /* Starts from one bucket, so that transactions grow the table */
+    for (i = id; i < NUM_KEY; i += NUM_THREAD) {
+        bool_t status;
+        TM_BEGIN();
+        status = TMHASHTABLE_INSERT(global_hashtablePtr,
+                                    (void*)i,
+                                    (void*)(i + 1));
+        TM_END();
+        assert(status);
+    }
+
+    thread_barrier_wait();
+
+    for (i = id; i < NUM_KEY; i += NUM_THREAD) {
+        if (i % 3 == 0) {
+            bool_t status;
+            TM_BEGIN();
+            status = TMHASHTABLE_REMOVE(global_hashtablePtr, (void*)i);
+            TM_END();
+            assert(status);
+        } else {
+            void* dataPtr;
+            TM_BEGIN();
+            dataPtr = TMHASHTABLE_FIND(global_hashtablePtr, (void*)i);
+            TM_END();
+            assert(dataPtr == (void*)(i + 1));
+        }
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+/* A transaction that reads the size before it updates it must not abort */
+static void
+readSizeInsert (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long i;
+
+    if (thread_getId() == 0) {
+        for (i = 0; i < NUM_READ_SIZE; i++) {
+            bool_t status;
+            TM_BEGIN();
+            assert(TMHASHTABLE_GETSIZE(global_hashtablePtr) == i);
+            assert(TMHASHTABLE_ISEMPTY(global_hashtablePtr) == (i == 0));
+            status = TMHASHTABLE_INSERT(global_hashtablePtr,
+                                        (void*)i,
+                                        (void*)(i + 1));
+            TM_END();
+            assert(status);
+        }
+        for (i = 0; i < NUM_READ_SIZE; i++) {
+            bool_t status;
+            TM_BEGIN();
+            assert(TMHASHTABLE_GETSIZE(global_hashtablePtr) ==
+                   NUM_READ_SIZE - i);
+            status = TMHASHTABLE_REMOVE(global_hashtablePtr, (void*)i);
+            TM_END();
+            assert(status);
+        }
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
 int
 main ()
 {
     hashtable_t* hashtablePtr;
     long data[] = {3, 1, 4, 1, 5, 9, 2, 6, 8, 7, -1};
+    unsigned long numCommit;
+    unsigned long numAbort;
+    unsigned long numAbortAfter;
+    unsigned long numIrrevocable;
     long i;
 
     puts("Starting...");
@@ -915,6 +1540,38 @@ main ()
 
     hashtable_free(hashtablePtr);
 
+    testSequential(NULL, NUM_KEY);
+    testSequential(&hashConstant, 200); /* every key collides */
+
+    global_hashtablePtr = hashtable_alloc(1, NULL, NULL, -1, -1);
+    assert(global_hashtablePtr);
+    TM_STARTUP(NUM_THREAD);
+    thread_startup(NUM_THREAD);
+    thread_start(insertRemove, NULL);
+
+    for (i = 0; i < NUM_KEY; i++) {
+        global_isPresent[i] = (i % 3 != 0);
+    }
+    check(global_hashtablePtr);
+    assert(global_hashtablePtr->numBucket >=
+           (NUM_KEY / (2 * HASHTABLE_DEFAULT_RESIZE_RATIO)));
+    hashtable_free(global_hashtablePtr);
+
+    /* One thread works, so any abort comes from the transaction itself */
+    global_hashtablePtr = hashtable_alloc(1, NULL, NULL, -1, -1);
+    assert(global_hashtablePtr);
+    tmstats_getTotals(&numCommit, &numAbort);
+    numIrrevocable = cm_getNumIrrevocable();
+    thread_start(readSizeInsert, NULL);
+    tmstats_getTotals(&numCommit, &numAbortAfter);
+    assert(numAbortAfter == numAbort);
+    assert(cm_getNumIrrevocable() == numIrrevocable);
+    assert(hashtable_isEmpty(global_hashtablePtr));
+    hashtable_free(global_hashtablePtr);
+
+    thread_shutdown();
+    TM_SHUTDOWN();
+
     puts("Done.");
 
     return 0;
@@ -13,7 +13,9 @@
  *
  * LIST_NO_DUPLICATES (default: allow duplicates)
  *
- * HASHTABLE_RESIZABLE (enable dynamically increasing number of buckets)
+ * HASHTABLE_RESIZABLE (enable dynamically increasing number of buckets;
+ *     entries are moved to the new buckets a few at a time by later
+ *     updates, also inside transactions; implied by MAP_USE_HASHTABLE)
  *
  * HASHTABLE_SIZE_FIELD (size is explicitely stored in
  *     hashtable and not implicitly defined by the sizes of
@@ -96,14 +98,25 @@ extern "C" {
 #endif
 
 
+/* lib/map.h allocates its tables with one bucket, so they have to grow */
+#if defined(MAP_USE_HASHTABLE) && !defined(HASHTABLE_RESIZABLE)
+#  define HASHTABLE_RESIZABLE
+#endif
+
+
 enum hashtable_config {
     HASHTABLE_DEFAULT_RESIZE_RATIO  = 3,
-    HASHTABLE_DEFAULT_GROWTH_FACTOR = 3
+    HASHTABLE_DEFAULT_GROWTH_FACTOR = 3,
+    HASHTABLE_MIGRATE_CHUNK         = 8, /* old buckets counted off together */
+    HASHTABLE_RESIZE_SAMPLE         = 8  /* buckets sampled before growing */
 };
 
 typedef struct hashtable {
     list_t** buckets;
     long numBucket;
+    list_t** oldBuckets; /* non-NULL while entries move to buckets */
+    long oldNumBucket;
+    long numChunkLeft;   /* chunks of old buckets not all moved (NULL) */
 #ifdef HASHTABLE_SIZE_FIELD
     long size;
 #endif
@@ -176,6 +189,8 @@ TMhashtable_iter_next (TM_ARGDECL
  * hashtable_alloc
  * -- Returns NULL on failure
  * -- Negative values for resizeRatio or growthFactor select default values
+ * -- If NULL is passed for hash and comparePairs, keys are hashed and compared
+ *    by value
  * =============================================================================
  */
 hashtable_t*
@@ -190,6 +205,8 @@ hashtable_alloc (long initNumBucket,
  * TMhashtable_alloc
  * -- Returns NULL on failure
  * -- Negative values for resizeRatio or growthFactor select default values
+ * -- If NULL is passed for hash and comparePairs, keys are hashed and compared
+ *    by value
  * =============================================================================
  */
 hashtable_t*
@@ -323,13 +340,14 @@ TMhashtable_remove (TM_ARGDECL  hashtable_t* hashtablePtr, void* keyPtr);
 #define TMHASHTABLE_ITER_RESET(it, ht)    TMhashtable_iter_reset(TM_ARG  it, ht)
 #define TMHASHTABLE_ITER_HASNEXT(it, ht)  TMhashtable_iter_hasNext(TM_ARG  it, ht)
 #define TMHASHTABLE_ITER_NEXT(it, ht)     TMhashtable_iter_next(TM_ARG  it, ht)
-#define TMHASHTABLE_ALLOC(i, h, c, r, g)  TMhashtable_alloc(TM_ARG, i, h, c, r, g)
+#define TMHASHTABLE_ALLOC(i, h, c, r, g)  TMhashtable_alloc(TM_ARG  i, h, c, r, g)
 #define TMHASHTABLE_FREE(ht)              TMhashtable_free(TM_ARG  ht)
 #define TMHASHTABLE_ISEMPTY(ht)           TMhashtable_isEmpty(TM_ARG  ht)
 #define TMHASHTABLE_GETSIZE(ht)           TMhashtable_getSize(TM_ARG  ht)
+#define TMHASHTABLE_CONTAINSKEY(ht, k)    TMhashtable_containsKey(TM_ARG  ht, k)
 #define TMHASHTABLE_FIND(ht, k)           TMhashtable_find(TM_ARG  ht, k)
 #define TMHASHTABLE_INSERT(ht, k, d)      TMhashtable_insert(TM_ARG  ht, k, d)
-#define TMHASHTABLE_REMOVE(ht)            TMhashtable_remove(TM_ARG  ht)
+#define TMHASHTABLE_REMOVE(ht, k)         TMhashtable_remove(TM_ARG  ht, k)
 
 
 #ifdef __cplusplus
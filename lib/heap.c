@@ -72,6 +72,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include "heap.h"
+#include "memory.h"
 #include "tm.h"
 #include "types.h"
 
@@ -132,8 +133,8 @@ heap_alloc (long initCapacity, long (*compare)(const void*, const void*))
 void
 heap_free (heap_t* heapPtr)
 {
-    free(heapPtr->elements);
-    free(heapPtr);
+    memory_free(heapPtr->elements);
+    memory_free(heapPtr);
 }
 
 
@@ -212,7 +213,7 @@ heap_insert (heap_t* heapPtr, void* dataPtr)
         for (i = 0; i <= size; i++) {
             newElements[i] = elements[i];
         }
-        free(heapPtr->elements);
+        memory_free(heapPtr->elements);
         heapPtr->elements = newElements;
     }
 
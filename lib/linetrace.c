@@ -0,0 +1,468 @@
+/* =============================================================================
+ *
+ * linetrace.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "linetrace.h"
+#include "thread.h"
+#include "timer.h"
+#include "types.h"
+
+
+enum linetrace_config {
+    LINETRACE_CACHE_LINE_SIZE = 64,
+    LINETRACE_BUFFER_SIZE     = 1 << 16, /* records per thread */
+    LINETRACE_MAX_PATH        = 4096,
+};
+
+/* Each thread writes only its own record */
+typedef struct linetrace_thread {
+    FILE* file;
+    bool_t isActive;
+    unsigned int txId;
+    long numBuffer;
+    long numRecord;
+    linetrace_record_t* buffer;
+} __attribute__ ((aligned (LINETRACE_CACHE_LINE_SIZE))) linetrace_thread_t;
+
+typedef struct linetrace_name {
+    void* addr;
+    long size;
+    char* name;
+    struct linetrace_name* nextPtr;
+} linetrace_name_t;
+
+static long                global_numThread = 0;
+static linetrace_thread_t* global_threads   = NULL;
+static linetrace_name_t*   global_names     = NULL;
+static char                global_prefix[LINETRACE_MAX_PATH - 32]; /* room for suffix */
+
+
+/* =============================================================================
+ * flushThread
+ * =============================================================================
+ */
+static void
+flushThread (linetrace_thread_t* threadPtr)
+{
+    if (threadPtr->numBuffer > 0 && threadPtr->file != NULL) {
+        size_t n = fwrite(threadPtr->buffer,
+                          sizeof(linetrace_record_t),
+                          threadPtr->numBuffer,
+                          threadPtr->file);
+        if (n != (size_t)threadPtr->numBuffer) {
+            fprintf(stderr, "linetrace: write failed; trace is truncated\n");
+            fclose(threadPtr->file);
+            threadPtr->file = NULL;
+        }
+    }
+    threadPtr->numBuffer = 0;
+}
+
+
+/* =============================================================================
+ * writeNames
+ * =============================================================================
+ */
+static void
+writeNames ()
+{
+    char path[LINETRACE_MAX_PATH];
+    FILE* file;
+    linetrace_name_t* namePtr;
+
+    snprintf(path, sizeof(path), "%s.names", global_prefix);
+    file = fopen(path, "w");
+    if (file == NULL) {
+        perror(path);
+        return;
+    }
+    for (namePtr = global_names; namePtr != NULL; namePtr = namePtr->nextPtr) {
+        fprintf(file, "%#llx %ld %s\n",
+                (unsigned long long)(unsigned long)namePtr->addr,
+                namePtr->size,
+                namePtr->name);
+    }
+    fclose(file);
+}
+
+
+/* =============================================================================
+ * linetrace_startup
+ * =============================================================================
+ */
+void
+linetrace_startup (long numThread)
+{
+    const char* prefix = getenv("LINE_TRACE_FILE");
+    long t;
+
+    assert(global_threads == NULL);
+
+    if (prefix == NULL || prefix[0] == '\0') {
+        prefix = "linetrace";
+    }
+    snprintf(global_prefix, sizeof(global_prefix), "%s", prefix);
+
+    global_threads = (linetrace_thread_t*)calloc(numThread,
+                                                 sizeof(linetrace_thread_t));
+    assert(global_threads);
+    global_numThread = numThread;
+
+    for (t = 0; t < numThread; t++) {
+        linetrace_thread_t* threadPtr = &global_threads[t];
+        linetrace_header_t header;
+        char path[LINETRACE_MAX_PATH];
+
+        threadPtr->buffer = (linetrace_record_t*)
+            malloc(LINETRACE_BUFFER_SIZE * sizeof(linetrace_record_t));
+        assert(threadPtr->buffer);
+
+        snprintf(path, sizeof(path), "%s.%ld", global_prefix, t);
+        threadPtr->file = fopen(path, "wb");
+        if (threadPtr->file == NULL) {
+            perror(path);
+            continue;
+        }
+        memset(&header, 0, sizeof(header));
+        strncpy(header.magic, LINETRACE_MAGIC, sizeof(header.magic));
+        header.threadId = t;
+        header.numThread = numThread;
+        if (fwrite(&header, sizeof(header), 1, threadPtr->file) != 1) {
+            perror(path);
+            fclose(threadPtr->file);
+            threadPtr->file = NULL;
+        }
+    }
+}
+
+
+/* =============================================================================
+ * linetrace_shutdown
+ * =============================================================================
+ */
+void
+linetrace_shutdown ()
+{
+    long numRecord = 0;
+    long t;
+
+    if (global_threads == NULL) {
+        return;
+    }
+
+    for (t = 0; t < global_numThread; t++) {
+        linetrace_thread_t* threadPtr = &global_threads[t];
+        flushThread(threadPtr);
+        if (threadPtr->file != NULL) {
+            fclose(threadPtr->file);
+        }
+        free(threadPtr->buffer);
+        numRecord += threadPtr->numRecord;
+    }
+    writeNames();
+
+    printf("Line trace: %ld accesses by %ld threads in %s.*\n",
+           numRecord, global_numThread, global_prefix);
+
+    free(global_threads);
+    global_threads = NULL;
+    global_numThread = 0;
+}
+
+
+/* =============================================================================
+ * linetrace_begin
+ * =============================================================================
+ */
+void
+linetrace_begin (long threadId)
+{
+    if (threadId < global_numThread) {
+        global_threads[threadId].isActive = TRUE;
+    }
+}
+
+
+/* =============================================================================
+ * linetrace_end
+ * =============================================================================
+ */
+void
+linetrace_end (long threadId)
+{
+    if (threadId < global_numThread) {
+        global_threads[threadId].isActive = FALSE;
+    }
+}
+
+
+/* =============================================================================
+ * linetrace_beginTx
+ * =============================================================================
+ */
+void
+linetrace_beginTx ()
+{
+    long threadId = thread_getId();
+
+    if (threadId < global_numThread) {
+        global_threads[threadId].txId++;
+    }
+}
+
+
+/* =============================================================================
+ * linetrace_access
+ * =============================================================================
+ */
+void
+linetrace_access (volatile void* addr, long size, bool_t isWrite)
+{
+    long threadId = thread_getId();
+    linetrace_thread_t* threadPtr;
+    linetrace_record_t* recordPtr;
+
+    if (threadId >= global_numThread) {
+        return;
+    }
+    threadPtr = &global_threads[threadId];
+    if (!threadPtr->isActive) {
+        return;
+    }
+
+    recordPtr = &threadPtr->buffer[threadPtr->numBuffer];
+    recordPtr->addr = (unsigned long long)(unsigned long)addr;
+    recordPtr->time = timer_getNanoseconds();
+    recordPtr->txId = threadPtr->txId;
+    recordPtr->size = (unsigned short)size;
+    recordPtr->isWrite = (isWrite ? 1 : 0);
+    recordPtr->pad = 0;
+    threadPtr->numRecord++;
+    if (++threadPtr->numBuffer == LINETRACE_BUFFER_SIZE) {
+        flushThread(threadPtr);
+    }
+}
+
+
+/* =============================================================================
+ * linetrace_name
+ * =============================================================================
+ */
+void
+linetrace_name (void* addr, long size, const char* name)
+{
+    linetrace_name_t* namePtr;
+
+    for (namePtr = global_names; namePtr != NULL; namePtr = namePtr->nextPtr) {
+        if (namePtr->addr == addr &&
+            namePtr->size == size &&
+            strcmp(namePtr->name, name) == 0)
+        {
+            return; /* e.g., registered again in a loop */
+        }
+    }
+
+    namePtr = (linetrace_name_t*)malloc(sizeof(*namePtr));
+    assert(namePtr);
+    namePtr->addr = addr;
+    namePtr->size = size;
+    namePtr->name = strdup(name);
+    assert(namePtr->name);
+    namePtr->nextPtr = global_names;
+    global_names = namePtr;
+}
+
+
+/* =============================================================================
+ * linetrace_getNumRecord
+ * =============================================================================
+ */
+long
+linetrace_getNumRecord (long threadId)
+{
+    if (threadId >= global_numThread) {
+        return 0;
+    }
+    return global_threads[threadId].numRecord;
+}
+
+
+/* =============================================================================
+ * TEST_LINETRACE
+ * =============================================================================
+ */
+#ifdef TEST_LINETRACE
+
+
+#define NUM_THREAD (2)
+#define NUM_ITER   (100000) /* spans several buffer flushes */
+
+static long global_counters[NUM_THREAD]; /* adjacent: false sharing */
+
+
+static void
+bump (void* argPtr)
+{
+    long threadId = thread_getId();
+    long i;
+
+    for (i = 0; i < NUM_ITER; i++) {
+        LINETRACE_BEGIN_TX();
+        LINETRACE_WRITE(global_counters[threadId],
+                        global_counters[threadId] =
+                            LINETRACE_READ(global_counters[threadId],
+                                           global_counters[threadId]) + 1);
+    }
+}
+
+
+int
+main ()
+{
+    const char* prefix = "/tmp/test_linetrace";
+    char path[LINETRACE_MAX_PATH];
+    linetrace_header_t header;
+    linetrace_record_t record;
+    FILE* file;
+    long t;
+
+    puts("Starting...");
+
+    setenv("LINE_TRACE_FILE", prefix, 1);
+    LINETRACE_NAME(global_counters);
+
+    /* Only parallel regions are traced */
+    linetrace_startup(NUM_THREAD);
+    linetrace_access(&global_counters[0], sizeof(long), TRUE);
+    assert(linetrace_getNumRecord(0) == 0);
+    linetrace_shutdown();
+
+    thread_startup(NUM_THREAD);
+    thread_start(bump, NULL);
+    for (t = 0; t < NUM_THREAD; t++) {
+        assert(linetrace_getNumRecord(t) == 2 * NUM_ITER);
+    }
+    thread_shutdown();
+
+    for (t = 0; t < NUM_THREAD; t++) {
+        long numRecord = 0;
+        long numWrite = 0;
+        snprintf(path, sizeof(path), "%s.%ld", prefix, t);
+        file = fopen(path, "rb");
+        assert(file);
+        assert(fread(&header, sizeof(header), 1, file) == 1);
+        assert(strcmp(header.magic, LINETRACE_MAGIC) == 0);
+        assert(header.threadId == t);
+        assert(header.numThread == NUM_THREAD);
+        while (fread(&record, sizeof(record), 1, file) == 1) {
+            assert(record.addr ==
+                   (unsigned long long)(unsigned long)&global_counters[t]);
+            assert(record.size == sizeof(long));
+            assert(record.txId == (unsigned int)(numRecord / 2 + 1));
+            numWrite += record.isWrite;
+            numRecord++;
+        }
+        assert(numRecord == 2 * NUM_ITER);
+        assert(numWrite == NUM_ITER);
+        assert(global_counters[t] == NUM_ITER);
+        fclose(file);
+        remove(path);
+    }
+
+    snprintf(path, sizeof(path), "%s.names", prefix);
+    file = fopen(path, "r");
+    assert(file);
+    {
+        char line[256];
+        assert(fgets(line, sizeof(line), file));
+        assert(strstr(line, "global_counters"));
+    }
+    fclose(file);
+    remove(path);
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_LINETRACE */
+
+
+/* =============================================================================
+ *
+ * End of linetrace.c
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,231 @@
+/* =============================================================================
+ *
+ * linetrace.h
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef LINETRACE_H
+#define LINETRACE_H 1
+
+
+#include <stdio.h>
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Cache-line sharing trace
+ *
+ * Building the STM or lock flavor with LINE_TRACE=yes records every
+ * TM_SHARED_READ* and TM_SHARED_WRITE* executed inside a parallel region
+ * (including those of aborted attempts) as one linetrace_record_t in a
+ * per-thread buffer. Full buffers are appended to the file
+ * <prefix>.<threadId>, where the prefix is taken from the LINE_TRACE_FILE
+ * environment variable ("linetrace" by default). Names of interesting
+ * variables, registered with LINETRACE_NAME, are written to <prefix>.names.
+ *
+ * linetrace_analyze reads these files offline and ranks cache lines by how
+ * often they move between threads (see linetrace_analyze.c).
+ *
+ * Without LINE_TRACE, the macros below expand to their plain access and
+ * LINETRACE_NAME* to nothing, so applications may use them unconditionally.
+ * =============================================================================
+ */
+
+#define LINETRACE_MAGIC                 "LTRACE1"
+
+typedef struct linetrace_header {
+    char magic[8];
+    long threadId;
+    long numThread;
+} linetrace_header_t;
+
+typedef struct linetrace_record {
+    unsigned long long addr;
+    unsigned long long time;     /* ns, comparable across threads */
+    unsigned int txId;           /* atomic blocks begun by this thread */
+    unsigned short size;
+    unsigned char isWrite;
+    unsigned char pad;
+} linetrace_record_t;
+
+#ifdef LINE_TRACE
+#  define LINETRACE_READ(var, expr)     (linetrace_access((volatile void*)&(var), \
+                                                          sizeof(var), \
+                                                          FALSE), \
+                                         (expr))
+#  define LINETRACE_WRITE(var, expr)    (linetrace_access((volatile void*)&(var), \
+                                                          sizeof(var), \
+                                                          TRUE), \
+                                         (expr))
+#  define LINETRACE_BEGIN_TX()          linetrace_beginTx();
+#  define LINETRACE_NAME(var)           linetrace_name((void*)&(var), \
+                                                       sizeof(var), \
+                                                       #var)
+#  define LINETRACE_NAME_RANGE(ptr, size, name) \
+                                        linetrace_name((void*)(ptr), size, name)
+#else /* !LINE_TRACE */
+#  define LINETRACE_READ(var, expr)     (expr)
+#  define LINETRACE_WRITE(var, expr)    (expr)
+#  define LINETRACE_BEGIN_TX()          /* nothing */
+#  define LINETRACE_NAME(var)           /* nothing */
+#  define LINETRACE_NAME_RANGE(ptr, size, name) \
+                                        /* nothing */
+#endif /* !LINE_TRACE */
+
+
+/* =============================================================================
+ * linetrace_startup
+ * -- Called by thread_startup; creates one trace file per thread
+ * =============================================================================
+ */
+void
+linetrace_startup (long numThread);
+
+
+/* =============================================================================
+ * linetrace_shutdown
+ * -- Called by thread_shutdown; flushes and closes the trace files
+ * =============================================================================
+ */
+void
+linetrace_shutdown ();
+
+
+/* =============================================================================
+ * linetrace_begin
+ * -- Called by each thread before its part of a parallel region
+ * =============================================================================
+ */
+void
+linetrace_begin (long threadId);
+
+
+/* =============================================================================
+ * linetrace_end
+ * =============================================================================
+ */
+void
+linetrace_end (long threadId);
+
+
+/* =============================================================================
+ * linetrace_beginTx
+ * -- Called once per atomic block, before any retry
+ * =============================================================================
+ */
+void
+linetrace_beginTx ();
+
+
+/* =============================================================================
+ * linetrace_access
+ * -- Ignored outside a parallel region
+ * =============================================================================
+ */
+void
+linetrace_access (volatile void* addr, long size, bool_t isWrite);
+
+
+/* =============================================================================
+ * linetrace_name
+ * -- Labels [addr, addr+size) in the analyzer output
+ * -- Call from one thread at a time; names are kept until exit
+ * =============================================================================
+ */
+void
+linetrace_name (void* addr, long size, const char* name);
+
+
+/* =============================================================================
+ * linetrace_getNumRecord
+ * -- Records written so far by threadId
+ * =============================================================================
+ */
+long
+linetrace_getNumRecord (long threadId);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* LINETRACE_H */
+
+
+/* =============================================================================
+ *
+ * End of linetrace.h
+ *
+ * =============================================================================
+ */
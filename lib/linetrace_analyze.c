@@ -0,0 +1,572 @@
+/* =============================================================================
+ *
+ * linetrace_analyze.c
+ * -- Ranks cache lines by cross-thread traffic in a LINE_TRACE trace
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+/* =============================================================================
+ * Reads the per-thread files written by a LINE_TRACE build and, for every
+ * cache line, replays the accesses of all threads in time order through a
+ * simple invalidation protocol: a line has at most one writer, and every
+ * other thread must fetch it again after a write. It counts
+ *
+ *   write-write: a write by one thread to a line last written by another
+ *   read-write:  a read of a line last written by another thread, or a write
+ *                to a line that other threads have read since its last write
+ *
+ * Lines are ranked by the sum. A line is reported as "false" sharing when no
+ * byte written by one thread is accessed by any other thread, so padding or
+ * realigning the data would remove the traffic; otherwise it is "true"
+ * sharing.
+ *
+ * Usage: linetrace_analyze [-l line size] [-n number of lines] <prefix>
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "linetrace.h"
+
+
+enum analyze_config {
+    DEFAULT_LINE_SIZE = 64,
+    MAX_LINE_SIZE     = 64, /* bytes of a line fit in one mask */
+    DEFAULT_NUM_LINE  = 20,
+    MAX_NAME_PER_LINE = 3,
+    MAX_PATH          = 4096,
+};
+
+typedef struct access {
+    unsigned long long line;
+    unsigned long long time;
+    unsigned long long mask; /* bytes of the line touched */
+    unsigned int txId;
+    unsigned int threadId;
+    bool_t isWrite;
+} access_t;
+
+typedef struct line_stat {
+    unsigned long long line;
+    long numWriteWrite;
+    long numReadWrite;
+    long numAccess;
+    long numWrite;
+    long numThread;
+    long numTx;
+    bool_t isFalse;
+} line_stat_t;
+
+typedef struct name {
+    unsigned long long addr;
+    unsigned long long size;
+    char* name;
+} name_t;
+
+static long         global_lineSize = DEFAULT_LINE_SIZE;
+static long         global_numThread = 0;
+static access_t*    global_accesses = NULL;
+static long         global_numAccess = 0;
+static long         global_capacity = 0;
+static name_t*      global_names = NULL;
+static long         global_numName = 0;
+
+
+/* =============================================================================
+ * displayUsage
+ * =============================================================================
+ */
+static void
+displayUsage (const char* appName)
+{
+    printf("Usage: %s [options] <prefix>\n", appName);
+    puts("\nOptions:                    (defaults)\n");
+    printf("    l <UINT>   [l]ine size  (%i)\n", DEFAULT_LINE_SIZE);
+    printf("    n <UINT>   [n]umber of lines to show (%i)\n", DEFAULT_NUM_LINE);
+    puts("\nReads <prefix>.0, <prefix>.1, ... and <prefix>.names");
+    exit(1);
+}
+
+
+/* =============================================================================
+ * addAccess
+ * -- Splits accesses that straddle a line boundary
+ * =============================================================================
+ */
+static void
+addAccess (const linetrace_record_t* recordPtr, long threadId)
+{
+    unsigned long long addr = recordPtr->addr;
+    unsigned long long end = recordPtr->addr + (recordPtr->size ? recordPtr->size : 1);
+
+    while (addr < end) {
+        unsigned long long line = addr / global_lineSize;
+        unsigned long long offset = addr % global_lineSize;
+        unsigned long long stop = (line + 1) * global_lineSize;
+        unsigned long long n = ((end < stop) ? end : stop) - addr;
+        access_t* accessPtr;
+
+        if (global_numAccess == global_capacity) {
+            global_capacity = (global_capacity ? 2 * global_capacity : 1 << 20);
+            global_accesses = (access_t*)realloc(global_accesses,
+                                                 global_capacity * sizeof(access_t));
+            assert(global_accesses);
+        }
+        accessPtr = &global_accesses[global_numAccess++];
+        accessPtr->line = line;
+        accessPtr->time = recordPtr->time;
+        accessPtr->mask = ((n == 64) ? ~0ULL : ((1ULL << n) - 1)) << offset;
+        accessPtr->txId = recordPtr->txId;
+        accessPtr->threadId = (unsigned int)threadId;
+        accessPtr->isWrite = (recordPtr->isWrite ? TRUE : FALSE);
+
+        addr += n;
+    }
+}
+
+
+/* =============================================================================
+ * readTrace
+ * -- Returns FALSE if the first file cannot be read
+ * =============================================================================
+ */
+static bool_t
+readTrace (const char* prefix)
+{
+    long t;
+
+    for (t = 0; t == 0 || t < global_numThread; t++) {
+        char path[MAX_PATH];
+        linetrace_header_t header;
+        linetrace_record_t records[4096];
+        size_t n;
+        FILE* file;
+
+        snprintf(path, sizeof(path), "%s.%ld", prefix, t);
+        file = fopen(path, "rb");
+        if (file == NULL) {
+            perror(path);
+            return (t > 0);
+        }
+        if (fread(&header, sizeof(header), 1, file) != 1 ||
+            strncmp(header.magic, LINETRACE_MAGIC, sizeof(header.magic)) != 0)
+        {
+            fprintf(stderr, "%s: not a line trace\n", path);
+            fclose(file);
+            return FALSE;
+        }
+        if (t == 0) {
+            global_numThread = header.numThread;
+        }
+        while ((n = fread(records, sizeof(records[0]), 4096, file)) > 0) {
+            size_t i;
+            for (i = 0; i < n; i++) {
+                addAccess(&records[i], header.threadId);
+            }
+        }
+        fclose(file);
+    }
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * readNames
+ * -- The names file is optional
+ * =============================================================================
+ */
+static void
+readNames (const char* prefix)
+{
+    char path[MAX_PATH];
+    char buffer[1024];
+    long capacity = 0;
+    FILE* file;
+
+    snprintf(path, sizeof(path), "%s.names", prefix);
+    file = fopen(path, "r");
+    if (file == NULL) {
+        return;
+    }
+    while (fgets(buffer, sizeof(buffer), file)) {
+        unsigned long long addr;
+        unsigned long long size;
+        char name[sizeof(buffer)];
+        if (sscanf(buffer, "%llx %llu %1023s", &addr, &size, name) != 3) {
+            continue;
+        }
+        if (global_numName == capacity) {
+            capacity = (capacity ? 2 * capacity : 16);
+            global_names = (name_t*)realloc(global_names,
+                                            capacity * sizeof(name_t));
+            assert(global_names);
+        }
+        global_names[global_numName].addr = addr;
+        global_names[global_numName].size = size;
+        global_names[global_numName].name = strdup(name);
+        assert(global_names[global_numName].name);
+        global_numName++;
+    }
+    fclose(file);
+}
+
+
+/* =============================================================================
+ * compareAccess
+ * -- By line, then time
+ * =============================================================================
+ */
+static int
+compareAccess (const void* aPtr, const void* bPtr)
+{
+    const access_t* a = (const access_t*)aPtr;
+    const access_t* b = (const access_t*)bPtr;
+
+    if (a->line != b->line) {
+        return ((a->line < b->line) ? -1 : 1);
+    }
+    if (a->time != b->time) {
+        return ((a->time < b->time) ? -1 : 1);
+    }
+    return ((int)a->threadId - (int)b->threadId);
+}
+
+
+/* =============================================================================
+ * compareStat
+ * -- Most cross-thread traffic first
+ * =============================================================================
+ */
+static int
+compareStat (const void* aPtr, const void* bPtr)
+{
+    const line_stat_t* a = (const line_stat_t*)aPtr;
+    const line_stat_t* b = (const line_stat_t*)bPtr;
+    long aTotal = a->numWriteWrite + a->numReadWrite;
+    long bTotal = b->numWriteWrite + b->numReadWrite;
+
+    if (aTotal != bTotal) {
+        return ((aTotal > bTotal) ? -1 : 1);
+    }
+    if (a->numWriteWrite != b->numWriteWrite) {
+        return ((a->numWriteWrite > b->numWriteWrite) ? -1 : 1);
+    }
+    return ((a->line < b->line) ? -1 : (a->line > b->line));
+}
+
+
+/* =============================================================================
+ * analyzeLine
+ * -- Replays accesses[0..numAccess) of one line
+ * =============================================================================
+ */
+static void
+analyzeLine (line_stat_t* statPtr,
+             const access_t* accesses,
+             long numAccess,
+             long* sharerGens,               /* [numThread] */
+             unsigned int* lastTxs,          /* [numThread] */
+             unsigned long long* readMasks,  /* [numThread] */
+             unsigned long long* writeMasks) /* [numThread] */
+{
+    long numThread = global_numThread;
+    long owner = -1;
+    long gen = 0; /* bumped on every write */
+    long numSharer = 0;
+    long i;
+    long t;
+
+    memset(statPtr, 0, sizeof(*statPtr));
+    statPtr->line = accesses[0].line;
+    for (t = 0; t < numThread; t++) {
+        sharerGens[t] = -1;
+        lastTxs[t] = UINT_MAX;
+        readMasks[t] = 0;
+        writeMasks[t] = 0;
+    }
+
+    for (i = 0; i < numAccess; i++) {
+        const access_t* accessPtr = &accesses[i];
+        long tid = accessPtr->threadId;
+        bool_t isSharer = (sharerGens[tid] == gen);
+
+        if (accessPtr->isWrite) {
+            if (owner >= 0 && owner != tid) {
+                statPtr->numWriteWrite++;
+            } else if (numSharer - (isSharer ? 1 : 0) > 0) {
+                statPtr->numReadWrite++;
+            }
+            owner = tid;
+            gen++;
+            sharerGens[tid] = gen;
+            numSharer = 1;
+            writeMasks[tid] |= accessPtr->mask;
+            statPtr->numWrite++;
+        } else {
+            if (!isSharer) {
+                if (owner >= 0 && owner != tid) {
+                    statPtr->numReadWrite++;
+                }
+                sharerGens[tid] = gen;
+                numSharer++;
+            }
+            readMasks[tid] |= accessPtr->mask;
+        }
+
+        if (lastTxs[tid] != accessPtr->txId) {
+            lastTxs[tid] = accessPtr->txId;
+            statPtr->numTx++;
+        }
+        statPtr->numAccess++;
+    }
+
+    statPtr->isFalse = TRUE;
+    for (t = 0; t < numThread; t++) {
+        unsigned long long others = 0;
+        long u;
+        if ((readMasks[t] | writeMasks[t]) == 0) {
+            continue;
+        }
+        statPtr->numThread++;
+        for (u = 0; u < numThread; u++) {
+            if (u != t) {
+                others |= readMasks[u] | writeMasks[u];
+            }
+        }
+        if (writeMasks[t] & others) {
+            statPtr->isFalse = FALSE;
+        }
+    }
+}
+
+
+/* =============================================================================
+ * printNames
+ * =============================================================================
+ */
+static void
+printNames (unsigned long long line)
+{
+    unsigned long long begin = line * global_lineSize;
+    unsigned long long end = begin + global_lineSize;
+    long numPrinted = 0;
+    long i;
+
+    for (i = 0; i < global_numName; i++) {
+        const name_t* namePtr = &global_names[i];
+        if (namePtr->addr < end && begin < namePtr->addr + namePtr->size) {
+            if (numPrinted == MAX_NAME_PER_LINE) {
+                printf(",...");
+                break;
+            }
+            printf("%s%s", (numPrinted ? "," : ""), namePtr->name);
+            if (namePtr->addr < begin || namePtr->size > (unsigned long long)global_lineSize) {
+                printf("+%llu", begin > namePtr->addr ? begin - namePtr->addr : 0);
+            }
+            numPrinted++;
+        }
+    }
+}
+
+
+/* =============================================================================
+ * main
+ * =============================================================================
+ */
+int
+main (int argc, char** argv)
+{
+    long numLineShown = DEFAULT_NUM_LINE;
+    line_stat_t* stats;
+    long numStat = 0;
+    long* sharerGens;
+    unsigned int* lastTxs;
+    unsigned long long* readMasks;
+    unsigned long long* writeMasks;
+    long totalWriteWrite = 0;
+    long totalReadWrite = 0;
+    long falseTraffic = 0;
+    long i;
+    long j;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "l:n:")) != -1) {
+        switch (opt) {
+            case 'l':
+                global_lineSize = atol(optarg);
+                break;
+            case 'n':
+                numLineShown = atol(optarg);
+                break;
+            default:
+                displayUsage(argv[0]);
+        }
+    }
+    if (optind != argc - 1 ||
+        global_lineSize <= 0 ||
+        global_lineSize > MAX_LINE_SIZE ||
+        (global_lineSize & (global_lineSize - 1)) != 0)
+    {
+        displayUsage(argv[0]);
+    }
+
+    if (!readTrace(argv[optind])) {
+        return 1;
+    }
+    readNames(argv[optind]);
+
+    qsort(global_accesses, global_numAccess, sizeof(access_t), &compareAccess);
+
+    stats = (line_stat_t*)malloc((global_numAccess + 1) * sizeof(line_stat_t));
+    sharerGens = (long*)malloc(global_numThread * sizeof(long));
+    lastTxs = (unsigned int*)malloc(global_numThread * sizeof(unsigned int));
+    readMasks = (unsigned long long*)malloc(global_numThread *
+                                            sizeof(unsigned long long));
+    writeMasks = (unsigned long long*)malloc(global_numThread *
+                                             sizeof(unsigned long long));
+    assert(stats && sharerGens && lastTxs && readMasks && writeMasks);
+
+    for (i = 0; i < global_numAccess; i = j) {
+        line_stat_t* statPtr = &stats[numStat++];
+        for (j = i + 1;
+             j < global_numAccess && global_accesses[j].line == global_accesses[i].line;
+             j++)
+        {
+            /* find end of line */
+        }
+        analyzeLine(statPtr, &global_accesses[i], (j - i),
+                    sharerGens, lastTxs, readMasks, writeMasks);
+        totalWriteWrite += statPtr->numWriteWrite;
+        totalReadWrite += statPtr->numReadWrite;
+        if (statPtr->isFalse) {
+            falseTraffic += statPtr->numWriteWrite + statPtr->numReadWrite;
+        }
+    }
+
+    qsort(stats, numStat, sizeof(line_stat_t), &compareStat);
+
+    printf("Accesses            = %ld\n", global_numAccess);
+    printf("Threads             = %ld\n", global_numThread);
+    printf("Line size           = %ld\n", global_lineSize);
+    printf("Lines               = %ld\n", numStat);
+    printf("Write-write         = %ld\n", totalWriteWrite);
+    printf("Read-write          = %ld\n", totalReadWrite);
+    printf("False sharing       = %ld (%.1f%%)\n",
+           falseTraffic,
+           ((totalWriteWrite + totalReadWrite) ?
+            (100.0 * falseTraffic / (totalWriteWrite + totalReadWrite)) : 0.0));
+    puts("");
+    printf("%4s  %-18s  %11s  %10s  %10s  %10s  %7s  %8s  %-7s  %s\n",
+           "Rank", "Line", "Write-write", "Read-write", "Accesses", "Writes",
+           "Threads", "Txs", "Sharing", "Names");
+    for (i = 0; i < numStat && i < numLineShown; i++) {
+        const line_stat_t* statPtr = &stats[i];
+        if (statPtr->numWriteWrite + statPtr->numReadWrite == 0) {
+            break;
+        }
+        printf("%4ld  %#-18llx  %11ld  %10ld  %10ld  %10ld  %7ld  %8ld  %-7s  ",
+               (i + 1),
+               statPtr->line * global_lineSize,
+               statPtr->numWriteWrite,
+               statPtr->numReadWrite,
+               statPtr->numAccess,
+               statPtr->numWrite,
+               statPtr->numThread,
+               statPtr->numTx,
+               (statPtr->isFalse ? "false" : "true"));
+        printNames(statPtr->line);
+        puts("");
+    }
+
+    free(stats);
+    free(sharerGens);
+    free(lastTxs);
+    free(readMasks);
+    free(writeMasks);
+    for (i = 0; i < global_numName; i++) {
+        free(global_names[i].name);
+    }
+    free(global_names);
+    free(global_accesses);
+
+    return 0;
+}
+
+
+/* =============================================================================
+ *
+ * End of linetrace_analyze.c
+ *
+ * =============================================================================
+ */
@@ -74,6 +74,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include "list.h"
+#include "memory.h"
 #include "types.h"
 #include "tm.h"
 
@@ -179,6 +180,10 @@ TMlist_iter_next (TM_ARGDECL  list_iter_t* itPtr, list_t* listPtr)
 }
 
 
+static memory_type_t global_nodeType =
+    MEMORY_TYPE_INITIALIZER(sizeof(list_node_t));
+
+
 /* =============================================================================
  * allocNode
  * -- Returns NULL on failure
@@ -187,7 +192,7 @@ TMlist_iter_next (TM_ARGDECL  list_iter_t* itPtr, list_t* listPtr)
 static list_node_t*
 allocNode (void* dataPtr)
 {
-    list_node_t* nodePtr = (list_node_t*)malloc(sizeof(list_node_t));
+    list_node_t* nodePtr = (list_node_t*)memory_allocType(&global_nodeType);
     if (nodePtr == NULL) {
         return NULL;
     }
@@ -207,7 +212,7 @@ allocNode (void* dataPtr)
 static list_node_t*
 PallocNode (void* dataPtr)
 {
-    list_node_t* nodePtr = (list_node_t*)P_MALLOC(sizeof(list_node_t));
+    list_node_t* nodePtr = (list_node_t*)P_MALLOC_TYPE(&global_nodeType);
     if (nodePtr == NULL) {
         return NULL;
     }
@@ -227,7 +232,7 @@ PallocNode (void* dataPtr)
 static list_node_t*
 TMallocNode (TM_ARGDECL  void* dataPtr)
 {
-    list_node_t* nodePtr = (list_node_t*)TM_MALLOC(sizeof(list_node_t));
+    list_node_t* nodePtr = (list_node_t*)TM_MALLOC_TYPE(&global_nodeType);
     if (nodePtr == NULL) {
         return NULL;
     }
@@ -330,7 +335,7 @@ TMlist_alloc (TM_ARGDECL  long (*compare)(const void*, const void*))
 static void
 freeNode (list_node_t* nodePtr)
 {
-    free(nodePtr);
+    memory_free(nodePtr);
 }
 
 
@@ -407,7 +412,7 @@ void
 list_free (list_t* listPtr)
 {
     freeList(listPtr->head.nextPtr);
-    free(listPtr);
+    memory_free(listPtr);
 }
 
 
@@ -0,0 +1,973 @@
+/* =============================================================================
+ *
+ * lock.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <sched.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cm.h"
+#include "epoch.h"
+#include "memory.h"
+#include "lock.h"
+#include "tmstats.h"
+#include "types.h"
+
+
+enum lock_config {
+    LOCK_TABLE_LOG2       = 20,
+    LOCK_SHIFT            = 3, /* one stripe per 8-byte word */
+    LOCK_INIT_LOG_CAPACITY = 64,
+    LOCK_CACHE_LINE_SIZE  = 64,
+    LOCK_SPIN_LIMIT       = 1024,
+    LOCK_SPIN_YIELD       = 64,
+};
+
+#define LOCK_TABLE_SIZE                 (1L << LOCK_TABLE_LOG2)
+#define LOCK_TABLE_MASK                 (LOCK_TABLE_SIZE - 1)
+
+#define STRIPE_WRITER                   (1UL)
+#define STRIPE_READER                   (2UL)
+
+#define GET_STRIPE(addr) \
+    (&global_stripes[((unsigned long)(addr) >> LOCK_SHIFT) & LOCK_TABLE_MASK])
+
+typedef volatile unsigned long lock_stripe_t;
+
+typedef struct lock_undo {
+    volatile void* addr;
+    long value;
+    long numByte;
+} lock_undo_t;
+
+typedef struct lock_held {
+    lock_stripe_t* stripePtr;
+    unsigned long mode; /* STRIPE_READER or STRIPE_WRITER */
+} lock_held_t;
+
+typedef struct lock_log {
+    void* elements;
+    long size;
+    long capacity;
+} lock_log_t;
+
+struct lock_thread {
+    long id;
+    long slot;           /* contention manager */
+    long epochSlot;      /* deferred reclamation */
+    bool_t isRetry;
+    sigjmp_buf* envPtr;
+    bool_t isInTx;
+    bool_t isIrrevocable; /* running alone; no stripes or undo log */
+    lock_log_t undoLog;  /* lock_undo_t */
+    lock_log_t heldSet;  /* lock_held_t */
+    lock_log_t allocLog; /* void* */
+    lock_log_t freeLog;  /* void* */
+    long* heldIndex;     /* open-addressed: heldSet position + 1 */
+    long heldIndexCapacity;
+    tmstats_thread_t* statsPtr;
+};
+
+#ifdef LOCK_STRIPED
+static lock_stripe_t global_stripes[LOCK_TABLE_SIZE];
+#else
+static struct {
+    char padding1[LOCK_CACHE_LINE_SIZE];
+    volatile long isLocked;
+    char padding2[LOCK_CACHE_LINE_SIZE];
+} global_lock;
+#endif
+
+
+
+/* =============================================================================
+ * log_init
+ * =============================================================================
+ */
+static void
+log_init (lock_log_t* logPtr, size_t elementSize)
+{
+    logPtr->size = 0;
+    logPtr->capacity = LOCK_INIT_LOG_CAPACITY;
+    logPtr->elements = malloc(logPtr->capacity * elementSize);
+    assert(logPtr->elements);
+}
+
+
+/* =============================================================================
+ * log_append
+ * -- Returns pointer to new (uninitialized) element
+ * =============================================================================
+ */
+static inline void*
+log_append (lock_log_t* logPtr, size_t elementSize)
+{
+    if (logPtr->size == logPtr->capacity) {
+        logPtr->capacity *= 2;
+        logPtr->elements = realloc(logPtr->elements,
+                                   logPtr->capacity * elementSize);
+        assert(logPtr->elements);
+    }
+
+    return (void*)((char*)logPtr->elements + elementSize * logPtr->size++);
+}
+
+
+/* =============================================================================
+ * loadValue
+ * =============================================================================
+ */
+static inline long
+loadValue (volatile void* addr, size_t numByte)
+{
+    switch (numByte) {
+        case 1: return (long)*(volatile char*)addr;
+        case 2: return (long)*(volatile short*)addr;
+        case 4: return (long)*(volatile int*)addr;
+        case 8: return (long)*(volatile long long*)addr;
+        default: assert(0);
+    }
+
+    return 0;
+}
+
+
+/* =============================================================================
+ * storeValue
+ * =============================================================================
+ */
+static inline void
+storeValue (volatile void* addr, long value, size_t numByte)
+{
+    switch (numByte) {
+        case 1: *(volatile char*)addr = (char)value; break;
+        case 2: *(volatile short*)addr = (short)value; break;
+        case 4: *(volatile int*)addr = (int)value; break;
+        case 8: *(volatile long long*)addr = (long long)value; break;
+        default: assert(0);
+    }
+}
+
+
+#ifndef LOCK_STRIPED
+
+
+/* =============================================================================
+ * acquireGlobal
+ * -- Test-and-test-and-set; yields so oversubscribed runs make progress
+ * =============================================================================
+ */
+static void
+acquireGlobal ()
+{
+    long numSpin = 0;
+
+    while (1) {
+        if (!global_lock.isLocked &&
+            !__atomic_exchange_n(&global_lock.isLocked, 1, __ATOMIC_ACQUIRE))
+        {
+            return;
+        }
+        if (++numSpin % LOCK_SPIN_YIELD == 0) {
+            sched_yield();
+        }
+    }
+}
+
+
+/* =============================================================================
+ * releaseGlobal
+ * =============================================================================
+ */
+static inline void
+releaseGlobal ()
+{
+    __atomic_store_n(&global_lock.isLocked, 0, __ATOMIC_RELEASE);
+}
+
+
+#else /* LOCK_STRIPED */
+
+
+/* =============================================================================
+ * hashStripe
+ * =============================================================================
+ */
+static inline unsigned long
+hashStripe (lock_stripe_t* stripePtr)
+{
+    unsigned long a = (unsigned long)stripePtr >> 3;
+
+    return a ^ (a >> 9) ^ (a >> 17);
+}
+
+
+/* =============================================================================
+ * findHeld
+ * -- Returns NULL if the stripe is not held by this atomic block
+ * =============================================================================
+ */
+static inline lock_held_t*
+findHeld (lock_thread_t* threadPtr, lock_stripe_t* stripePtr)
+{
+    lock_held_t* helds = (lock_held_t*)threadPtr->heldSet.elements;
+    long* index = threadPtr->heldIndex;
+    unsigned long mask = threadPtr->heldIndexCapacity - 1;
+    unsigned long i = hashStripe(stripePtr) & mask;
+
+    while (index[i] != 0) {
+        lock_held_t* heldPtr = &helds[index[i] - 1];
+        if (heldPtr->stripePtr == stripePtr) {
+            return heldPtr;
+        }
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+
+/* =============================================================================
+ * insertIndex
+ * =============================================================================
+ */
+static inline void
+insertIndex (long* index, long capacity,
+             lock_stripe_t* stripePtr, long position)
+{
+    unsigned long mask = capacity - 1;
+    unsigned long i = hashStripe(stripePtr) & mask;
+
+    while (index[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    index[i] = position + 1;
+}
+
+
+/* =============================================================================
+ * appendHeld
+ * =============================================================================
+ */
+static void
+appendHeld (lock_thread_t* threadPtr,
+            lock_stripe_t* stripePtr, unsigned long mode)
+{
+    lock_held_t* heldPtr;
+    long position = threadPtr->heldSet.size;
+
+    if ((position + 1) * 2 > threadPtr->heldIndexCapacity) {
+        long capacity = threadPtr->heldIndexCapacity * 2;
+        long* index = (long*)calloc(capacity, sizeof(long));
+        lock_held_t* helds = (lock_held_t*)threadPtr->heldSet.elements;
+        long h;
+        assert(index);
+        for (h = 0; h < position; h++) {
+            insertIndex(index, capacity, helds[h].stripePtr, h);
+        }
+        free(threadPtr->heldIndex);
+        threadPtr->heldIndex = index;
+        threadPtr->heldIndexCapacity = capacity;
+    }
+
+    heldPtr = (lock_held_t*)log_append(&threadPtr->heldSet, sizeof(lock_held_t));
+    heldPtr->stripePtr = stripePtr;
+    heldPtr->mode = mode;
+    insertIndex(threadPtr->heldIndex, threadPtr->heldIndexCapacity,
+                stripePtr, position);
+}
+
+
+#endif /* LOCK_STRIPED */
+
+
+/* =============================================================================
+ * releaseAll
+ * =============================================================================
+ */
+static void
+releaseAll (lock_thread_t* threadPtr)
+{
+#ifdef LOCK_STRIPED
+    lock_held_t* helds = (lock_held_t*)threadPtr->heldSet.elements;
+    long numHeld = threadPtr->heldSet.size;
+    long h;
+
+    for (h = 0; h < numHeld; h++) {
+        if (helds[h].mode == STRIPE_WRITER) {
+            __atomic_store_n(helds[h].stripePtr, 0, __ATOMIC_RELEASE);
+        } else {
+            __atomic_fetch_sub(helds[h].stripePtr, STRIPE_READER,
+                               __ATOMIC_RELEASE);
+        }
+    }
+
+    if (numHeld * 8 < threadPtr->heldIndexCapacity) {
+        long* index = threadPtr->heldIndex;
+        unsigned long mask = threadPtr->heldIndexCapacity - 1;
+        for (h = 0; h < numHeld; h++) {
+            unsigned long i = hashStripe(helds[h].stripePtr) & mask;
+            while (index[i] != h + 1) {
+                i = (i + 1) & mask;
+            }
+            index[i] = 0;
+        }
+    } else {
+        memset(threadPtr->heldIndex, 0,
+               threadPtr->heldIndexCapacity * sizeof(long));
+    }
+    threadPtr->heldSet.size = 0;
+#else /* !LOCK_STRIPED */
+    releaseGlobal();
+#endif /* !LOCK_STRIPED */
+}
+
+
+/* =============================================================================
+ * abortTx
+ * =============================================================================
+ */
+static void
+abortTx (lock_thread_t* threadPtr)
+{
+    lock_undo_t* undos = (lock_undo_t*)threadPtr->undoLog.elements;
+    void** allocs = (void**)threadPtr->allocLog.elements;
+    long i;
+
+    for (i = threadPtr->undoLog.size - 1; i >= 0; i--) {
+        storeValue(undos[i].addr, undos[i].value, undos[i].numByte);
+    }
+
+    releaseAll(threadPtr);
+
+    for (i = 0; i < threadPtr->allocLog.size; i++) {
+        memory_free(allocs[i]);
+    }
+
+    threadPtr->isInTx = FALSE;
+    threadPtr->isRetry = TRUE;
+    epoch_exit(threadPtr->epochSlot);
+    tmstats_abort(threadPtr->statsPtr);
+
+    /*
+     * Stripes do not record their readers, so there is no enemy to compare
+     * against: the priority-based policies degrade to plain backoff.
+     */
+    cm_onAbort(threadPtr->slot, threadPtr->heldSet.size);
+    switch (cm_getPolicy()) {
+        case CM_AGGRESSIVE:
+            /* Let the conflicting owner finish before retrying */
+            sched_yield();
+            break;
+        case CM_KARMA:
+        case CM_TIMESTAMP:
+            cm_backoff(threadPtr->slot);
+            break;
+        default:
+            break;
+    }
+
+    siglongjmp(*threadPtr->envPtr, 1);
+}
+
+
+#ifdef LOCK_STRIPED
+
+
+/* =============================================================================
+ * acquireStripe
+ * -- Aborts if the stripe cannot be acquired in the requested mode
+ * =============================================================================
+ */
+static void
+acquireStripe (lock_thread_t* threadPtr,
+               lock_stripe_t* stripePtr, unsigned long mode)
+{
+    lock_held_t* heldPtr = findHeld(threadPtr, stripePtr);
+    long numSpin = 0;
+
+    if (heldPtr != NULL) {
+        if (heldPtr->mode == STRIPE_WRITER || mode == STRIPE_READER) {
+            return;
+        }
+        /* Upgrade: succeeds only if we are the sole reader */
+        while (1) {
+            unsigned long expected = STRIPE_READER;
+            if (__atomic_compare_exchange_n(stripePtr,
+                                            &expected,
+                                            STRIPE_WRITER,
+                                            FALSE,
+                                            __ATOMIC_ACQUIRE,
+                                            __ATOMIC_RELAXED))
+            {
+                heldPtr->mode = STRIPE_WRITER;
+                return;
+            }
+            if (++numSpin > LOCK_SPIN_LIMIT) {
+                abortTx(threadPtr);
+            }
+        }
+    }
+
+    while (1) {
+        unsigned long l = __atomic_load_n(stripePtr, __ATOMIC_RELAXED);
+        if (mode == STRIPE_READER) {
+            if (!(l & STRIPE_WRITER) &&
+                __atomic_compare_exchange_n(stripePtr,
+                                            &l,
+                                            l + STRIPE_READER,
+                                            FALSE,
+                                            __ATOMIC_ACQUIRE,
+                                            __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        } else {
+            if (l == 0 &&
+                __atomic_compare_exchange_n(stripePtr,
+                                            &l,
+                                            STRIPE_WRITER,
+                                            FALSE,
+                                            __ATOMIC_ACQUIRE,
+                                            __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        if (++numSpin > LOCK_SPIN_LIMIT) {
+            abortTx(threadPtr);
+        }
+    }
+
+    appendHeld(threadPtr, stripePtr, mode);
+}
+
+
+#endif /* LOCK_STRIPED */
+
+
+/* =============================================================================
+ * lock_startup
+ * =============================================================================
+ */
+void
+lock_startup ()
+{
+#ifdef LOCK_STRIPED
+    memset((void*)global_stripes, 0, sizeof(global_stripes));
+#else
+    global_lock.isLocked = 0;
+#endif
+    tmstats_reset();
+    cm_startup();
+    epoch_startup();
+}
+
+
+/* =============================================================================
+ * lock_shutdown
+ * =============================================================================
+ */
+void
+lock_shutdown ()
+{
+    unsigned long numCommit;
+    unsigned long numAbort;
+
+    tmstats_getTotals(&numCommit, &numAbort);
+#ifdef LOCK_STRIPED
+    printf("LOCK (striped): commits = %lu, aborts = %lu, irrevocable = %lu"
+           " (contention manager: %s)\n",
+           numCommit, numAbort, cm_getNumIrrevocable(), cm_getPolicyName());
+#else
+    printf("LOCK (global): commits = %lu, aborts = %lu, irrevocable = %lu\n",
+           numCommit, numAbort, cm_getNumIrrevocable());
+#endif
+    tmstats_print(stdout);
+    epoch_shutdown();
+}
+
+
+/* =============================================================================
+ * lock_newThread
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+lock_thread_t*
+lock_newThread ()
+{
+    lock_thread_t* threadPtr;
+
+    if (posix_memalign((void**)&threadPtr,
+                       LOCK_CACHE_LINE_SIZE,
+                       sizeof(lock_thread_t)) != 0)
+    {
+        return NULL;
+    }
+
+    threadPtr->id      = -1;
+    threadPtr->slot    = cm_newThread();
+    if (threadPtr->slot < 0) {
+        free(threadPtr);
+        return NULL;
+    }
+    threadPtr->epochSlot = epoch_newThread();
+    if (threadPtr->epochSlot < 0) {
+        cm_freeThread(threadPtr->slot);
+        free(threadPtr);
+        return NULL;
+    }
+    threadPtr->isRetry = FALSE;
+    threadPtr->envPtr  = NULL;
+    threadPtr->isInTx  = FALSE;
+    threadPtr->isIrrevocable = FALSE;
+    log_init(&threadPtr->undoLog, sizeof(lock_undo_t));
+    log_init(&threadPtr->heldSet, sizeof(lock_held_t));
+    log_init(&threadPtr->allocLog, sizeof(void*));
+    log_init(&threadPtr->freeLog, sizeof(void*));
+    threadPtr->heldIndexCapacity = 2 * LOCK_INIT_LOG_CAPACITY;
+    threadPtr->heldIndex =
+        (long*)calloc(threadPtr->heldIndexCapacity, sizeof(long));
+    assert(threadPtr->heldIndex);
+    threadPtr->statsPtr = tmstats_newThread();
+    assert(threadPtr->statsPtr);
+
+    return threadPtr;
+}
+
+
+/* =============================================================================
+ * lock_initThread
+ * =============================================================================
+ */
+void
+lock_initThread (lock_thread_t* threadPtr, long id)
+{
+    threadPtr->id = id;
+}
+
+
+/* =============================================================================
+ * lock_freeThread
+ * =============================================================================
+ */
+void
+lock_freeThread (lock_thread_t* threadPtr)
+{
+    tmstats_freeThread(threadPtr->statsPtr);
+    cm_freeThread(threadPtr->slot);
+    epoch_freeThread(threadPtr->epochSlot);
+    free(threadPtr->undoLog.elements);
+    free(threadPtr->heldSet.elements);
+    free(threadPtr->allocLog.elements);
+    free(threadPtr->freeLog.elements);
+    free(threadPtr->heldIndex);
+    free(threadPtr);
+}
+
+
+/* =============================================================================
+ * lock_start
+ * =============================================================================
+ */
+void
+lock_start (lock_thread_t* threadPtr,
+            sigjmp_buf* envPtr,
+            bool_t isIrrevocable,
+            tmstats_site_t* sitePtr)
+{
+    tmstats_begin(threadPtr->statsPtr, sitePtr);
+    threadPtr->isIrrevocable =
+        cm_begin(threadPtr->slot, threadPtr->isRetry, isIrrevocable);
+    epoch_enter(threadPtr->epochSlot);
+
+    threadPtr->envPtr        = envPtr;
+    threadPtr->undoLog.size  = 0;
+    threadPtr->allocLog.size = 0;
+    threadPtr->freeLog.size  = 0;
+
+#ifndef LOCK_STRIPED
+    acquireGlobal();
+#endif
+
+    threadPtr->isInTx = TRUE;
+}
+
+
+/* =============================================================================
+ * lock_commit
+ * =============================================================================
+ */
+void
+lock_commit (lock_thread_t* threadPtr)
+{
+    void** frees = (void**)threadPtr->freeLog.elements;
+    long i;
+
+    releaseAll(threadPtr);
+    epoch_exit(threadPtr->epochSlot);
+
+    /*
+     * With stripes, transactions read immutable fields without locking, so a block
+     * may still be in use after its stripes are released.
+     */
+    for (i = 0; i < threadPtr->freeLog.size; i++) {
+        epoch_retire(threadPtr->epochSlot, frees[i]);
+    }
+
+    threadPtr->isInTx = FALSE;
+    threadPtr->isRetry = FALSE;
+    threadPtr->isIrrevocable = FALSE;
+    cm_onCommit(threadPtr->slot);
+    tmstats_commit(threadPtr->statsPtr);
+}
+
+
+/* =============================================================================
+ * lock_restart
+ * =============================================================================
+ */
+void
+lock_restart (lock_thread_t* threadPtr)
+{
+    assert(!threadPtr->isIrrevocable);
+    abortTx(threadPtr);
+}
+
+
+/* =============================================================================
+ * lock_read
+ * =============================================================================
+ */
+long
+lock_read (lock_thread_t* threadPtr, volatile void* addr, size_t numByte)
+{
+#ifdef LOCK_STRIPED
+    if (threadPtr->isInTx && !threadPtr->isIrrevocable) {
+        acquireStripe(threadPtr, GET_STRIPE(addr), STRIPE_READER);
+    }
+#endif
+
+    return loadValue(addr, numByte);
+}
+
+
+/* =============================================================================
+ * lock_readFloat
+ * =============================================================================
+ */
+float
+lock_readFloat (lock_thread_t* threadPtr, volatile float* addr)
+{
+    union {
+        int i;
+        float f;
+    } convert;
+
+    convert.i = (int)lock_read(threadPtr, (volatile void*)addr, sizeof(float));
+
+    return convert.f;
+}
+
+
+/* =============================================================================
+ * lock_write
+ * =============================================================================
+ */
+void
+lock_write (lock_thread_t* threadPtr,
+            volatile void* addr, long value, size_t numByte)
+{
+#ifdef LOCK_STRIPED
+    if (threadPtr->isInTx && !threadPtr->isIrrevocable) {
+        acquireStripe(threadPtr, GET_STRIPE(addr), STRIPE_WRITER);
+    }
+#endif
+
+    lock_writeLocal(threadPtr, addr, value, numByte);
+}
+
+
+/* =============================================================================
+ * lock_writeFloat
+ * =============================================================================
+ */
+void
+lock_writeFloat (lock_thread_t* threadPtr, volatile float* addr, float value)
+{
+    union {
+        int i;
+        float f;
+    } convert;
+
+    convert.f = value;
+    lock_write(threadPtr, (volatile void*)addr, (long)convert.i, sizeof(float));
+}
+
+
+/* =============================================================================
+ * lock_writeLocal
+ * =============================================================================
+ */
+void
+lock_writeLocal (lock_thread_t* threadPtr,
+                 volatile void* addr, long value, size_t numByte)
+{
+    if (threadPtr->isInTx && !threadPtr->isIrrevocable) {
+        lock_undo_t* undoPtr =
+            (lock_undo_t*)log_append(&threadPtr->undoLog, sizeof(lock_undo_t));
+        undoPtr->addr    = addr;
+        undoPtr->value   = loadValue(addr, numByte);
+        undoPtr->numByte = numByte;
+    }
+
+    storeValue(addr, value, numByte);
+}
+
+
+/* =============================================================================
+ * lock_writeLocalFloat
+ * =============================================================================
+ */
+void
+lock_writeLocalFloat (lock_thread_t* threadPtr, volatile float* addr, float value)
+{
+    union {
+        int i;
+        float f;
+    } convert;
+
+    convert.f = value;
+    lock_writeLocal(threadPtr, (volatile void*)addr, (long)convert.i, sizeof(float));
+}
+
+
+/* =============================================================================
+ * lock_alloc
+ * =============================================================================
+ */
+void*
+lock_alloc (lock_thread_t* threadPtr, size_t numByte)
+{
+    void* ptr = memory_alloc(numByte);
+
+    if (ptr != NULL && threadPtr->isInTx && !threadPtr->isIrrevocable) {
+        *(void**)log_append(&threadPtr->allocLog, sizeof(void*)) = ptr;
+    }
+
+    return ptr;
+}
+
+
+/* =============================================================================
+ * lock_allocType
+ * =============================================================================
+ */
+void*
+lock_allocType (lock_thread_t* threadPtr, memory_type_t* typePtr)
+{
+    void* ptr = memory_allocType(typePtr);
+
+    if (ptr != NULL && threadPtr->isInTx && !threadPtr->isIrrevocable) {
+        *(void**)log_append(&threadPtr->allocLog, sizeof(void*)) = ptr;
+    }
+
+    return ptr;
+}
+
+
+/* =============================================================================
+ * lock_free
+ * =============================================================================
+ */
+void
+lock_free (lock_thread_t* threadPtr, void* ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    if (!threadPtr->isInTx || threadPtr->isIrrevocable) {
+        memory_free(ptr);
+        return;
+    }
+
+    *(void**)log_append(&threadPtr->freeLog, sizeof(void*)) = ptr;
+}
+
+
+/* =============================================================================
+ * TEST_LOCK
+ * =============================================================================
+ */
+#ifdef TEST_LOCK
+
+
+#include "thread.h"
+#include "tm.h"
+
+#define NUM_THREAD     (4)
+#define NUM_ACCOUNT    (64)
+#define NUM_TRANSFER   (100000)
+#define INIT_BALANCE   (1000)
+#define AUDIT_PERIOD   (1000)
+
+long global_accounts[NUM_ACCOUNT];
+int global_counters[2];
+
+
+static void
+transfer (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    unsigned long seed = (unsigned long)id + 1;
+    long i;
+
+    for (i = 0; i < NUM_TRANSFER; i++) {
+        long from;
+        long to;
+        seed = seed * 1103515245 + 12345;
+        from = (seed >> 8) % NUM_ACCOUNT;
+        to = (seed >> 20) % NUM_ACCOUNT;
+        if (i % AUDIT_PERIOD == 0) {
+            /* Runs alone, so it always sees a consistent total */
+            long total = 0;
+            long a;
+            TM_BEGIN_IRREVOCABLE();
+            for (a = 0; a < NUM_ACCOUNT; a++) {
+                total += (long)TM_SHARED_READ(global_accounts[a]);
+            }
+            TM_END();
+            assert(total == NUM_ACCOUNT * INIT_BALANCE);
+        }
+        TM_BEGIN();
+        long balance = (long)TM_SHARED_READ(global_accounts[from]);
+        TM_SHARED_WRITE(global_accounts[from], balance - 1);
+        balance = (long)TM_SHARED_READ(global_accounts[to]);
+        TM_SHARED_WRITE(global_accounts[to], balance + 1);
+        TM_SHARED_WRITE(global_counters[id % 2],
+                        TM_SHARED_READ(global_counters[id % 2]) + 1);
+        TM_END();
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+int
+main ()
+{
+    long i;
+    long sum = 0;
+
+    puts("Starting...");
+
+    for (i = 0; i < NUM_ACCOUNT; i++) {
+        global_accounts[i] = INIT_BALANCE;
+    }
+
+    TM_STARTUP(NUM_THREAD);
+    thread_startup(NUM_THREAD);
+    thread_start(transfer, NULL);
+    assert(cm_getNumIrrevocable() == NUM_THREAD * (NUM_TRANSFER / AUDIT_PERIOD));
+
+    /* Escalate at the first abort */
+    setenv("TM_IRREVOCABLE_AFTER", "1", 1);
+    cm_startup();
+    thread_start(transfer, NULL);
+    assert(cm_getNumIrrevocable() >= NUM_THREAD * (NUM_TRANSFER / AUDIT_PERIOD));
+    thread_shutdown();
+    TM_SHUTDOWN();
+
+    for (i = 0; i < NUM_ACCOUNT; i++) {
+        sum += global_accounts[i];
+    }
+    assert(sum == NUM_ACCOUNT * INIT_BALANCE);
+    assert(global_counters[0] + global_counters[1] == 2 * NUM_THREAD * NUM_TRANSFER);
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_LOCK */
+
+
+/* =============================================================================
+ *
+ * End of lock.c
+ *
+ * =============================================================================
+ */
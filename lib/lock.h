@@ -0,0 +1,349 @@
+/* =============================================================================
+ *
+ * lock.h
+ * -- Lock-based transactional memory baseline
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef LOCK_H
+#define LOCK_H 1
+
+
+#include <setjmp.h>
+#include <stddef.h>
+#include "memory.h"
+#include "tmstats.h"
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Lock-based atomic blocks
+ *
+ * Two modes, selected at compile time:
+ *
+ * default       A single global spinlock is held from TM_BEGIN to TM_END.
+ *               Shared reads are plain loads.
+ *
+ * LOCK_STRIPED  Addresses hash onto a table of reader/writer locks. Each
+ *               TM_SHARED_READ/TM_SHARED_WRITE acquires the covering stripe
+ *               and all stripes are held until TM_END (two-phase locking).
+ *               A stripe that cannot be acquired after a bounded spin aborts
+ *               the block, so there is no deadlock.
+ *
+ * In both modes writes are done in place with an undo log, so TM_RESTART
+ * (e.g., labyrinth's TMgrid_addPath) rolls back and re-executes the block.
+ *
+ * An irrevocable block (LOCK_BEGIN_IRREVOCABLE, or one escalated by the
+ * contention manager after repeated aborts; see cm.h) runs alone, so it
+ * takes no stripes and keeps no undo log; it cannot be restarted.
+ * =============================================================================
+ */
+
+typedef struct lock_thread lock_thread_t;
+
+#define LOCK_THREAD_T                   lock_thread_t
+#define LOCK_SELF                       lockSelf
+#define LOCK_JMPBUF_T                   sigjmp_buf
+
+#define LOCK_STARTUP()                  lock_startup()
+#define LOCK_SHUTDOWN()                 lock_shutdown()
+
+#define LOCK_NEW_THREAD()               lock_newThread()
+#define LOCK_INIT_THREAD(t, id)         lock_initThread(t, id)
+#define LOCK_FREE_THREAD(t)             lock_freeThread(t)
+
+#define LOCK_BEGIN_MODE(isIrrevocable)  do { \
+                                            static tmstats_site_t LOCK_SITE = \
+                                                TMSTATS_SITE_INIT; \
+                                            LOCK_JMPBUF_T LOCK_JMPBUF; \
+                                            sigsetjmp(LOCK_JMPBUF, 0); \
+                                            lock_start(LOCK_SELF, \
+                                                       &LOCK_JMPBUF, \
+                                                       isIrrevocable, \
+                                                       &LOCK_SITE)
+#define LOCK_BEGIN()                    LOCK_BEGIN_MODE(FALSE)
+#define LOCK_BEGIN_IRREVOCABLE()        LOCK_BEGIN_MODE(TRUE)
+#define LOCK_END()                      lock_commit(LOCK_SELF); \
+                                        } while (0)
+#define LOCK_RESTART()                  lock_restart(LOCK_SELF)
+
+#ifdef LOCK_STRIPED
+#  define LOCK_READ(var)                lock_read(LOCK_SELF, \
+                                                  (volatile void*)&(var), \
+                                                  sizeof(var))
+#  define LOCK_READ_P(var)              ((void*)lock_read(LOCK_SELF, \
+                                                          (volatile void*)&(var), \
+                                                          sizeof(var)))
+#  define LOCK_READ_F(var)              lock_readFloat(LOCK_SELF, \
+                                                       (volatile float*)&(var))
+#else /* !LOCK_STRIPED */
+#  define LOCK_READ(var)                (var)
+#  define LOCK_READ_P(var)              (var)
+#  define LOCK_READ_F(var)              (var)
+#endif /* !LOCK_STRIPED */
+
+#define LOCK_WRITE(var, val)            lock_write(LOCK_SELF, \
+                                                   (volatile void*)&(var), \
+                                                   (long)(val), \
+                                                   sizeof(var))
+#define LOCK_WRITE_P(var, val)          lock_write(LOCK_SELF, \
+                                                   (volatile void*)&(var), \
+                                                   (long)(void*)(val), \
+                                                   sizeof(var))
+#define LOCK_WRITE_F(var, val)          lock_writeFloat(LOCK_SELF, \
+                                                        (volatile float*)&(var), \
+                                                        (float)(val))
+
+#define LOCK_LOCAL_WRITE(var, val)      lock_writeLocal(LOCK_SELF, \
+                                                        (volatile void*)&(var), \
+                                                        (long)(val), \
+                                                        sizeof(var))
+#define LOCK_LOCAL_WRITE_P(var, val)    lock_writeLocal(LOCK_SELF, \
+                                                        (volatile void*)&(var), \
+                                                        (long)(void*)(val), \
+                                                        sizeof(var))
+#define LOCK_LOCAL_WRITE_F(var, val)    lock_writeLocalFloat(LOCK_SELF, \
+                                                             (volatile float*)&(var), \
+                                                             (float)(val))
+
+#define LOCK_MALLOC(size)               lock_alloc(LOCK_SELF, size)
+#define LOCK_MALLOC_TYPE(typePtr)       lock_allocType(LOCK_SELF, typePtr)
+#define LOCK_FREE(ptr)                  lock_free(LOCK_SELF, ptr)
+
+
+/* =============================================================================
+ * lock_startup
+ * =============================================================================
+ */
+void
+lock_startup ();
+
+
+/* =============================================================================
+ * lock_shutdown
+ * -- Prints commit/abort totals and per-site statistics
+ * =============================================================================
+ */
+void
+lock_shutdown ();
+
+
+/* =============================================================================
+ * lock_newThread
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+lock_thread_t*
+lock_newThread ();
+
+
+/* =============================================================================
+ * lock_initThread
+ * =============================================================================
+ */
+void
+lock_initThread (lock_thread_t* threadPtr, long id);
+
+
+/* =============================================================================
+ * lock_freeThread
+ * =============================================================================
+ */
+void
+lock_freeThread (lock_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * lock_start
+ * -- Called by LOCK_BEGIN after every sigsetjmp, so also on each retry
+ * =============================================================================
+ */
+void
+lock_start (lock_thread_t* threadPtr,
+            sigjmp_buf* envPtr,
+            bool_t isIrrevocable,
+            tmstats_site_t* sitePtr);
+
+
+/* =============================================================================
+ * lock_commit
+ * -- Releases all locks held by the atomic block
+ * =============================================================================
+ */
+void
+lock_commit (lock_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * lock_restart
+ * -- Rolls back and re-executes the current atomic block
+ * =============================================================================
+ */
+void
+lock_restart (lock_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * lock_read
+ * -- Only used with LOCK_STRIPED; numByte is 1, 2, 4, or 8
+ * =============================================================================
+ */
+long
+lock_read (lock_thread_t* threadPtr, volatile void* addr, size_t numByte);
+
+
+/* =============================================================================
+ * lock_readFloat
+ * =============================================================================
+ */
+float
+lock_readFloat (lock_thread_t* threadPtr, volatile float* addr);
+
+
+/* =============================================================================
+ * lock_write
+ * -- numByte is 1, 2, 4, or 8
+ * =============================================================================
+ */
+void
+lock_write (lock_thread_t* threadPtr,
+            volatile void* addr, long value, size_t numByte);
+
+
+/* =============================================================================
+ * lock_writeFloat
+ * =============================================================================
+ */
+void
+lock_writeFloat (lock_thread_t* threadPtr, volatile float* addr, float value);
+
+
+/* =============================================================================
+ * lock_writeLocal
+ * -- For thread-private data: never locks, but is undone on abort
+ * =============================================================================
+ */
+void
+lock_writeLocal (lock_thread_t* threadPtr,
+                 volatile void* addr, long value, size_t numByte);
+
+
+/* =============================================================================
+ * lock_writeLocalFloat
+ * =============================================================================
+ */
+void
+lock_writeLocalFloat (lock_thread_t* threadPtr, volatile float* addr, float value);
+
+
+/* =============================================================================
+ * lock_alloc
+ * -- Allocation is undone if the atomic block aborts
+ * =============================================================================
+ */
+void*
+lock_alloc (lock_thread_t* threadPtr, size_t numByte);
+
+
+/* =============================================================================
+ * lock_allocType
+ * -- Like lock_alloc, but from the type's own spans (see memory.h)
+ * =============================================================================
+ */
+void*
+lock_allocType (lock_thread_t* threadPtr, memory_type_t* typePtr);
+
+
+/* =============================================================================
+ * lock_free
+ * -- Deallocation is deferred until the atomic block commits
+ * =============================================================================
+ */
+void
+lock_free (lock_thread_t* threadPtr, void* ptr);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* LOCK_H */
+
+
+/* =============================================================================
+ *
+ * End of lock.h
+ *
+ * =============================================================================
+ */
@@ -91,6 +91,32 @@
 #  define MAP_INSERT(map, key, data)  hashtable_insert(map, (void*)(key), (void*)(data))
 #  define MAP_REMOVE(map, key)        hashtable_remove(map, (void*)(key))
 
+#  define TMMAP_CONTAINS(map, key)    TMHASHTABLE_CONTAINSKEY(map, (void*)(key))
+#  define TMMAP_FIND(map, key)        TMHASHTABLE_FIND(map, (void*)(key))
+#  define TMMAP_INSERT(map, key, data) \
+    TMHASHTABLE_INSERT(map, (void*)(key), (void*)(data))
+#  define TMMAP_REMOVE(map, key)      TMHASHTABLE_REMOVE(map, (void*)(key))
+
+#elif defined(MAP_USE_OAHASHTABLE)
+
+/* Without hash and cmp, keys are hashed and compared by value */
+#  include "oahashtable.h"
+
+#  define MAP_T                       oahashtable_t
+#  define MAP_ALLOC(hash, cmp)        oahashtable_alloc(1, hash, cmp)
+#  define MAP_FREE(map)               oahashtable_free(map)
+#  define MAP_CONTAINS(map, key)      oahashtable_containsKey(map, (void*)(key))
+#  define MAP_FIND(map, key)          oahashtable_find(map, (void*)(key))
+#  define MAP_INSERT(map, key, data) \
+    oahashtable_insert(map, (void*)(key), (void*)(data))
+#  define MAP_REMOVE(map, key)        oahashtable_remove(map, (void*)(key))
+
+#  define TMMAP_CONTAINS(map, key)    TMOAHASHTABLE_CONTAINSKEY(map, (void*)(key))
+#  define TMMAP_FIND(map, key)        TMOAHASHTABLE_FIND(map, (void*)(key))
+#  define TMMAP_INSERT(map, key, data) \
+    TMOAHASHTABLE_INSERT(map, (void*)(key), (void*)(data))
+#  define TMMAP_REMOVE(map, key)      TMOAHASHTABLE_REMOVE(map, (void*)(key))
+
 #elif defined(MAP_USE_ATREE)
 
 #  include "atree.h"
@@ -222,6 +248,27 @@
      })
 
 
+#elif defined(MAP_USE_BTREE)
+
+#  include "btree.h"
+
+#  define MAP_T                       btree_t
+#  define MAP_ALLOC(hash, cmp)        btree_alloc(cmp)
+#  define MAP_FREE(map)               btree_free(map)
+
+#  define MAP_CONTAINS(map, key)      btree_contains(map, (void*)(key))
+#  define MAP_FIND(map, key)          btree_get(map, (void*)(key))
+#  define MAP_INSERT(map, key, data) \
+    btree_insert(map, (void*)(key), (void*)(data))
+#  define MAP_REMOVE(map, key)        btree_delete(map, (void*)(key))
+
+#  define TMMAP_CONTAINS(map, key)    TMBTREE_CONTAINS(map, (void*)(key))
+#  define TMMAP_FIND(map, key)        TMBTREE_GET(map, (void*)(key))
+#  define TMMAP_INSERT(map, key, data) \
+    TMBTREE_INSERT(map, (void*)(key), (void*)(data))
+#  define TMMAP_REMOVE(map, key)      TMBTREE_DELETE(map, (void*)(key))
+
+
 #elif defined(MAP_USE_RBTREE)
 
 #  include "rbtree.h"
@@ -247,56 +294,28 @@
 
 #  include "skiplist.h"
 
-#  define SKIPLIST_MAX_HEIGHT (64)
+#  define MAP_T                       skiplist_t
+#  define MAP_ALLOC(hash, cmp)        skiplist_alloc(cmp)
+#  define MAP_FREE(map)               skiplist_free(map)
 
-#  define MAP_T                       jsw_skip_t
-#  define MAP_ALLOC(hash, cmp)        jsw_snew(SKIPLIST_MAX_HEIGHT, (cmp_f)cmp)
-#  define MAP_FREE(map)               jsw_sdelete(map)
-#  define MAP_CONTAINS(map, key) \
-    ({ \
-        bool_t success = FALSE; \
-        pair_t searchPair; \
-        searchPair.firstPtr = (void*)key; \
-        if (jsw_sfind(map, (void*)&searchPair) != NULL) { \
-            success = TRUE; \
-        } \
-        success; \
-     })
-#  define MAP_FIND(map, key) \
-    ({ \
-        void* dataPtr = NULL; \
-        pair_t* pairPtr; \
-        pair_t searchPair; \
-        searchPair.firstPtr = (void*)(key); \
-        pairPtr = (pair_t*)jsw_sfind(map, (void*)&searchPair); \
-        if (pairPtr != NULL) { \
-            dataPtr = pairPtr->secondPtr; \
-        } \
-        dataPtr; \
-     })
+#  define MAP_CONTAINS(map, key)      skiplist_contains(map, (void*)(key))
+#  define MAP_FIND(map, key)          skiplist_find(map, (void*)(key))
 #  define MAP_INSERT(map, key, data) \
-    ({ \
-        bool_t success = FALSE; \
-        pair_t* insertPtr = pair_alloc((void*)(key), (void*)data); \
-        if (insertPtr != NULL) { \
-            if (jsw_sinsert(map, (void*)insertPtr)) { \
-                success = TRUE; \
-            } \
-        } \
-        success; \
-     })
-#  define MAP_REMOVE(map, key) \
-    ({ \
-        bool_t success = FALSE; \
-        pair_t searchPair; \
-        searchPair.firstPtr = (void*)(key); \
-        pairPtr = (pair_t*)jsw_sfind(map, (void*)&searchPair); \
-        if (jsw_serase(map, (void*)&searchPair)) { \
-            pair_free(pairPtr); \
-            success = TRUE; \
-        } \
-        success; \
-     })
+    skiplist_insert(map, (void*)(key), (void*)(data))
+#  define MAP_REMOVE(map, key)        skiplist_remove(map, (void*)(key))
+
+#  define PMAP_ALLOC(hash, cmp)       Pskiplist_alloc(cmp)
+#  define PMAP_FREE(map)              Pskiplist_free(map)
+#  define PMAP_INSERT(map, key, data) \
+    Pskiplist_insert(map, (void*)(key), (void*)(data))
+#  define PMAP_REMOVE(map, key)       Pskiplist_remove(map, (void*)(key))
+
+#  define TMMAP_CONTAINS(map, key)    TMSKIPLIST_CONTAINS(map, (void*)(key))
+#  define TMMAP_FIND(map, key)        TMSKIPLIST_FIND(map, (void*)(key))
+#  define TMMAP_INSERT(map, key, data) \
+    TMSKIPLIST_INSERT(map, (void*)(key), (void*)(data))
+#  define TMMAP_REMOVE(map, key)      TMSKIPLIST_REMOVE(map, (void*)(key))
+
 
 #else
 
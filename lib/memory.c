@@ -71,10 +71,20 @@
 
 
 #include <assert.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdlib.h>
+#include <string.h>
+#ifdef __GLIBC__
+#  include <malloc.h>
+#endif
 #include "memory.h"
 #include "types.h"
 
+#if defined(__GLIBC__) && !defined(SIMULATOR)
+#  define MEMORY_USE_SLAB
+#endif
+
 /* We want to use enum bool_t */
 #ifdef FALSE
 #  undef FALSE
@@ -360,6 +370,586 @@ memory_get (long threadId, size_t numByte)
 }
 
 
+/* =============================================================================
+ * Size-class slab allocator
+ *
+ * Small requests (<= MEMORY_MAX_SMALL bytes) are rounded up to one of
+ * MEMORY_NUM_CLASS - 1 size classes and served from 64 KB spans that hold
+ * objects of a single class. A radix map from span address to class lets
+ * memory_free recognize slab memory; anything else goes to the C library.
+ *
+ * Each thread caches free objects per class and never synchronizes on the
+ * fast path. When a cache grows past 2 * MEMORY_BATCH objects (e.g., a
+ * consumer freeing what a producer allocated), MEMORY_BATCH of them move to
+ * the class's central list in one step; an empty cache takes a whole batch
+ * back. Memory freed by committing transactions reaches memory_free only
+ * once no transaction can still read it (see epoch.h).
+ *
+ * Up to MEMORY_NUM_TYPE node types (memory_type_t) get classes of their own,
+ * with spans that hold nothing else.
+ *
+ * Slab memory must be released with memory_free (P_FREE, TM_FREE), never
+ * free(); memory_free also accepts memory from malloc, so code that cannot
+ * tell where a pointer came from calls it. Under SIMULATOR (and without
+ * glibc), memory_alloc/memory_free are plain malloc/free.
+ * =============================================================================
+ */
+#ifdef MEMORY_USE_SLAB
+
+
+enum memory_slab_config {
+    MEMORY_SPAN_LOG2       = 16,
+    MEMORY_MAX_SMALL       = 2048,
+    MEMORY_NUM_CLASS       = 25, /* class 0 marks non-slab memory */
+    MEMORY_NUM_TYPE        = 32, /* classes MEMORY_NUM_CLASS and up */
+    MEMORY_MAX_CLASS       = MEMORY_NUM_CLASS + MEMORY_NUM_TYPE,
+    MEMORY_BATCH           = 32,
+    MEMORY_RADIX_LEAF_LOG2 = 16,
+    MEMORY_ADDRESS_BITS    = 48,
+    MEMORY_CACHE_LINE_SIZE = 64,
+};
+
+#define MEMORY_SPAN_SIZE                (1UL << MEMORY_SPAN_LOG2)
+#define MEMORY_RADIX_LEAF_SIZE          (1UL << MEMORY_RADIX_LEAF_LOG2)
+#define MEMORY_RADIX_ROOT_SIZE \
+    (1UL << (MEMORY_ADDRESS_BITS - MEMORY_SPAN_LOG2 - MEMORY_RADIX_LEAF_LOG2))
+
+typedef struct memory_object {
+    struct memory_object* nextPtr;
+    struct memory_object* nextBatchPtr; /* only on central lists */
+} memory_object_t;
+
+typedef struct memory_list {
+    memory_object_t* headPtr;
+    long count;
+} memory_list_t;
+
+typedef struct memory_cache {
+    memory_list_t frees[MEMORY_MAX_CLASS];
+} memory_cache_t;
+
+typedef struct memory_central {
+    volatile long isLocked;
+    memory_object_t* batchesPtr;
+    char padding[MEMORY_CACHE_LINE_SIZE - sizeof(long) - sizeof(void*)];
+} memory_central_t;
+
+static unsigned char* volatile global_radix[MEMORY_RADIX_ROOT_SIZE];
+static memory_central_t        global_centrals[MEMORY_MAX_CLASS];
+static size_t                  global_typeSizes[MEMORY_NUM_TYPE];
+static long                    global_numType = 0;
+static pthread_mutex_t         global_typeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t           global_cacheKey;
+static pthread_once_t          global_cacheKeyOnce = PTHREAD_ONCE_INIT;
+static __thread memory_cache_t* global_cachePtr = NULL;
+
+
+/* =============================================================================
+ * sizeToClass
+ * -- 16-byte steps up to 128, then four classes per power of two
+ * =============================================================================
+ */
+static inline long
+sizeToClass (size_t numByte)
+{
+    long exp;
+    size_t step;
+
+    if (numByte <= 128) {
+        return ((numByte <= 16) ? 1 : (long)((numByte + 15) >> 4));
+    }
+
+    exp = (long)(sizeof(unsigned long) * 8 - 1) -
+          __builtin_clzl((unsigned long)(numByte - 1));
+    step = 1UL << (exp - 2);
+
+    return 9 + (exp - 7) * 4 + (long)((numByte - 1 - (1UL << exp)) / step);
+}
+
+
+/* =============================================================================
+ * classToSize
+ * =============================================================================
+ */
+static inline size_t
+classToSize (long c)
+{
+    long exp;
+
+    if (c >= MEMORY_NUM_CLASS) {
+        return global_typeSizes[c - MEMORY_NUM_CLASS];
+    }
+    if (c <= 8) {
+        return (size_t)c << 4;
+    }
+
+    exp = 7 + (c - 9) / 4;
+
+    return (1UL << exp) + (size_t)((c - 9) % 4 + 1) * (1UL << (exp - 2));
+}
+
+
+/* =============================================================================
+ * lookupClass
+ * -- Returns 0 if ptr is not slab memory
+ * =============================================================================
+ */
+static inline long
+lookupClass (void* ptr)
+{
+    unsigned long span = (unsigned long)ptr >> MEMORY_SPAN_LOG2;
+    unsigned long rootIndex = span >> MEMORY_RADIX_LEAF_LOG2;
+    unsigned char* leaf;
+
+    if (rootIndex >= MEMORY_RADIX_ROOT_SIZE) {
+        return 0;
+    }
+    leaf = __atomic_load_n(&global_radix[rootIndex], __ATOMIC_ACQUIRE);
+    if (leaf == NULL) {
+        return 0;
+    }
+
+    return leaf[span & (MEMORY_RADIX_LEAF_SIZE - 1)];
+}
+
+
+/* =============================================================================
+ * registerSpan
+ * -- Returns FALSE if the span lies outside the radix map
+ * =============================================================================
+ */
+static bool_t
+registerSpan (void* spanPtr, long c)
+{
+    unsigned long span = (unsigned long)spanPtr >> MEMORY_SPAN_LOG2;
+    unsigned long rootIndex = span >> MEMORY_RADIX_LEAF_LOG2;
+    unsigned char* leaf;
+
+    if (rootIndex >= MEMORY_RADIX_ROOT_SIZE) {
+        return FALSE;
+    }
+
+    leaf = __atomic_load_n(&global_radix[rootIndex], __ATOMIC_ACQUIRE);
+    if (leaf == NULL) {
+        unsigned char* newLeaf =
+            (unsigned char*)calloc(MEMORY_RADIX_LEAF_SIZE, sizeof(unsigned char));
+        assert(newLeaf);
+        if (__atomic_compare_exchange_n(&global_radix[rootIndex],
+                                        &leaf,
+                                        newLeaf,
+                                        FALSE,
+                                        __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE))
+        {
+            leaf = newLeaf;
+        } else {
+            free(newLeaf); /* lost the race; leaf holds the winner */
+        }
+    }
+
+    __atomic_store_n(&leaf[span & (MEMORY_RADIX_LEAF_SIZE - 1)],
+                     (unsigned char)c,
+                     __ATOMIC_RELEASE);
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * lockCentral
+ * =============================================================================
+ */
+static inline void
+lockCentral (memory_central_t* centralPtr)
+{
+    while (__atomic_exchange_n(&centralPtr->isLocked, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&centralPtr->isLocked, __ATOMIC_RELAXED)) {
+            sched_yield();
+        }
+    }
+}
+
+
+/* =============================================================================
+ * unlockCentral
+ * =============================================================================
+ */
+static inline void
+unlockCentral (memory_central_t* centralPtr)
+{
+    __atomic_store_n(&centralPtr->isLocked, 0, __ATOMIC_RELEASE);
+}
+
+
+/* =============================================================================
+ * pushBatch
+ * -- headPtr is a NULL-terminated list of objects
+ * =============================================================================
+ */
+static void
+pushBatch (long c, memory_object_t* headPtr)
+{
+    memory_central_t* centralPtr = &global_centrals[c];
+
+    lockCentral(centralPtr);
+    headPtr->nextBatchPtr = centralPtr->batchesPtr;
+    centralPtr->batchesPtr = headPtr;
+    unlockCentral(centralPtr);
+}
+
+
+/* =============================================================================
+ * popBatch
+ * -- Returns NULL if the central list is empty
+ * =============================================================================
+ */
+static memory_object_t*
+popBatch (long c)
+{
+    memory_central_t* centralPtr = &global_centrals[c];
+    memory_object_t* headPtr;
+
+    if (centralPtr->batchesPtr == NULL) {
+        return NULL; /* racy peek; avoids the lock when empty */
+    }
+
+    lockCentral(centralPtr);
+    headPtr = centralPtr->batchesPtr;
+    if (headPtr != NULL) {
+        centralPtr->batchesPtr = headPtr->nextBatchPtr;
+    }
+    unlockCentral(centralPtr);
+
+    return headPtr;
+}
+
+
+/* =============================================================================
+ * releaseBatch
+ * -- Moves MEMORY_BATCH objects (or all if fewer) from listPtr to central
+ * =============================================================================
+ */
+static void
+releaseBatch (memory_list_t* listPtr, long c)
+{
+    memory_object_t* headPtr = listPtr->headPtr;
+    memory_object_t* lastPtr = headPtr;
+    long n = 1;
+
+    if (headPtr == NULL) {
+        return;
+    }
+
+    while (n < MEMORY_BATCH && lastPtr->nextPtr != NULL) {
+        lastPtr = lastPtr->nextPtr;
+        n++;
+    }
+    listPtr->headPtr = lastPtr->nextPtr;
+    listPtr->count -= n;
+    lastPtr->nextPtr = NULL;
+
+    pushBatch(c, headPtr);
+}
+
+
+/* =============================================================================
+ * freeCache
+ * -- Thread exit: hand every cached object to the central lists
+ * =============================================================================
+ */
+static void
+freeCache (void* argPtr)
+{
+    memory_cache_t* cachePtr = (memory_cache_t*)argPtr;
+    long c;
+
+    for (c = 1; c < MEMORY_MAX_CLASS; c++) {
+        while (cachePtr->frees[c].headPtr != NULL) {
+            releaseBatch(&cachePtr->frees[c], c);
+        }
+    }
+
+    global_cachePtr = NULL;
+    free(cachePtr);
+}
+
+
+/* =============================================================================
+ * createCacheKey
+ * =============================================================================
+ */
+static void
+createCacheKey ()
+{
+    pthread_key_create(&global_cacheKey, &freeCache);
+}
+
+
+/* =============================================================================
+ * getCache
+ * =============================================================================
+ */
+static inline memory_cache_t*
+getCache ()
+{
+    memory_cache_t* cachePtr = global_cachePtr;
+
+    if (cachePtr == NULL) {
+        pthread_once(&global_cacheKeyOnce, &createCacheKey);
+        cachePtr = (memory_cache_t*)calloc(1, sizeof(memory_cache_t));
+        assert(cachePtr);
+        pthread_setspecific(global_cacheKey, cachePtr);
+        global_cachePtr = cachePtr;
+    }
+
+    return cachePtr;
+}
+
+
+/* =============================================================================
+ * carveSpan
+ * -- Returns FALSE if no span could be allocated
+ * =============================================================================
+ */
+static bool_t
+carveSpan (memory_list_t* listPtr, long c)
+{
+    size_t size = classToSize(c);
+    long numObject = (long)(MEMORY_SPAN_SIZE / size);
+    char* spanPtr;
+    long i;
+
+    if (posix_memalign((void**)&spanPtr, MEMORY_SPAN_SIZE, MEMORY_SPAN_SIZE) != 0) {
+        return FALSE;
+    }
+    if (!registerSpan(spanPtr, c)) {
+        free(spanPtr);
+        return FALSE;
+    }
+
+    for (i = numObject - 1; i >= 0; i--) {
+        memory_object_t* objectPtr = (memory_object_t*)(spanPtr + i * size);
+        objectPtr->nextPtr = listPtr->headPtr;
+        listPtr->headPtr = objectPtr;
+    }
+    listPtr->count += numObject;
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * refill
+ * -- Returns FALSE if out of memory
+ * =============================================================================
+ */
+static bool_t
+refill (memory_cache_t* cachePtr, long c)
+{
+    memory_list_t* listPtr = &cachePtr->frees[c];
+    memory_object_t* batchPtr;
+
+    batchPtr = popBatch(c);
+    if (batchPtr != NULL) {
+        memory_object_t* objectPtr;
+        listPtr->headPtr = batchPtr;
+        listPtr->count = 0;
+        for (objectPtr = batchPtr; objectPtr != NULL; objectPtr = objectPtr->nextPtr) {
+            listPtr->count++;
+        }
+        return TRUE;
+    }
+
+    return carveSpan(listPtr, c);
+}
+
+
+/* =============================================================================
+ * allocFromClass
+ * =============================================================================
+ */
+static inline void*
+allocFromClass (long c, size_t numByte)
+{
+    memory_cache_t* cachePtr = getCache();
+    memory_list_t* listPtr = &cachePtr->frees[c];
+    memory_object_t* objectPtr;
+
+    if (listPtr->headPtr == NULL && !refill(cachePtr, c)) {
+        return malloc(numByte);
+    }
+
+    objectPtr = listPtr->headPtr;
+    listPtr->headPtr = objectPtr->nextPtr;
+    listPtr->count--;
+
+    return (void*)objectPtr;
+}
+
+
+/* =============================================================================
+ * memory_alloc
+ * =============================================================================
+ */
+void*
+memory_alloc (size_t numByte)
+{
+    if (numByte > MEMORY_MAX_SMALL) {
+        return malloc(numByte);
+    }
+
+    return allocFromClass(sizeToClass(numByte), numByte);
+}
+
+
+/* =============================================================================
+ * registerType
+ * -- Falls back to the shared size class once all type classes are taken,
+ *    and to -1 (plain memory_alloc) for large types
+ * =============================================================================
+ */
+static long
+registerType (memory_type_t* typePtr)
+{
+    long c;
+
+    pthread_mutex_lock(&global_typeLock);
+
+    c = typePtr->sizeClass;
+    if (c == 0) {
+        if (typePtr->numByte > MEMORY_MAX_SMALL) {
+            c = -1;
+        } else if (global_numType < MEMORY_NUM_TYPE) {
+            size_t size = (typePtr->numByte + 15) & ~(size_t)15;
+            global_typeSizes[global_numType] =
+                ((size < sizeof(memory_object_t)) ? sizeof(memory_object_t) : size);
+            c = MEMORY_NUM_CLASS + global_numType;
+            global_numType++;
+        } else {
+            c = sizeToClass(typePtr->numByte);
+        }
+        __atomic_store_n(&typePtr->sizeClass, c, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&global_typeLock);
+
+    return c;
+}
+
+
+/* =============================================================================
+ * memory_allocType
+ * =============================================================================
+ */
+void*
+memory_allocType (memory_type_t* typePtr)
+{
+    long c = __atomic_load_n(&typePtr->sizeClass, __ATOMIC_ACQUIRE);
+
+    if (c == 0) {
+        c = registerType(typePtr);
+    }
+    if (c < 0) {
+        return malloc(typePtr->numByte);
+    }
+
+    return allocFromClass(c, typePtr->numByte);
+}
+
+
+/* =============================================================================
+ * memory_free
+ * =============================================================================
+ */
+void
+memory_free (void* ptr)
+{
+    memory_list_t* listPtr;
+    memory_object_t* objectPtr;
+    long c = lookupClass(ptr);
+
+    if (c == 0) {
+        free(ptr);
+        return;
+    }
+
+    listPtr = &getCache()->frees[c];
+    objectPtr = (memory_object_t*)ptr;
+    objectPtr->nextPtr = listPtr->headPtr;
+    listPtr->headPtr = objectPtr;
+    if (++listPtr->count > 2 * MEMORY_BATCH) {
+        releaseBatch(listPtr, c);
+    }
+}
+
+
+/* =============================================================================
+ * memory_usableSize
+ * =============================================================================
+ */
+size_t
+memory_usableSize (void* ptr)
+{
+    long c = lookupClass(ptr);
+
+    return ((c == 0) ? malloc_usable_size(ptr) : classToSize(c));
+}
+
+
+#else /* !MEMORY_USE_SLAB */
+
+
+/* =============================================================================
+ * memory_alloc
+ * =============================================================================
+ */
+void*
+memory_alloc (size_t numByte)
+{
+    return malloc(numByte);
+}
+
+
+/* =============================================================================
+ * memory_allocType
+ * =============================================================================
+ */
+void*
+memory_allocType (memory_type_t* typePtr)
+{
+    return malloc(typePtr->numByte);
+}
+
+
+/* =============================================================================
+ * memory_free
+ * =============================================================================
+ */
+void
+memory_free (void* ptr)
+{
+    free(ptr);
+}
+
+
+/* =============================================================================
+ * memory_usableSize
+ * =============================================================================
+ */
+size_t
+memory_usableSize (void* ptr)
+{
+#ifdef __GLIBC__
+    return malloc_usable_size(ptr);
+#else
+    return 0;
+#endif
+}
+
+
+#endif /* !MEMORY_USE_SLAB */
+
+
 /* =============================================================================
  * TEST_MEMORY
  * =============================================================================
@@ -370,8 +960,10 @@ memory_get (long threadId, size_t numByte)
 #include <stdio.h>
 
 #define NUM_ALLOC (10)
+#define NUM_SLAB_ALLOC (100000)
 
 char* mem0Array[NUM_ALLOC];
+char* global_slabArray[NUM_SLAB_ALLOC];
 
 
 static void
@@ -400,6 +992,25 @@ printMemory (memory_t* memoryPtr)
 }
 
 
+/* Frees what main allocated, from another thread */
+static void*
+freeAll (void* argPtr)
+{
+    long i;
+
+    for (i = 0; i < NUM_SLAB_ALLOC; i++) {
+        char* ptr = global_slabArray[i];
+        size_t size = (size_t)(i % (4096 + 1));
+        if (size > 0) {
+            assert(ptr[0] == (char)i && ptr[size - 1] == (char)i);
+        }
+        memory_free(ptr);
+    }
+
+    return NULL;
+}
+
+
 int
 main ()
 {
@@ -441,6 +1052,78 @@ main ()
 
     memory_destroy();
 
+    puts("Testing slab allocator...");
+    {
+        long round;
+        pthread_t thread;
+        char* ptr;
+
+        for (round = 0; round < 3; round++) {
+            for (i = 0; i < NUM_SLAB_ALLOC; i++) {
+                size = i % (4096 + 1);
+                global_slabArray[i] = (char*)memory_alloc(size);
+                assert(global_slabArray[i] != NULL);
+                assert(((size_t)global_slabArray[i] % 16) == 0 || size < 16);
+                assert(memory_usableSize(global_slabArray[i]) >= (size_t)size);
+                if (size > 0) {
+                    global_slabArray[i][0] = (char)i;
+                    global_slabArray[i][size - 1] = (char)i;
+                }
+            }
+            pthread_create(&thread, NULL, &freeAll, NULL);
+            pthread_join(thread, NULL);
+        }
+
+        ptr = (char*)malloc(10);
+        assert(memory_usableSize(ptr) >= 10);
+        memory_free(ptr); /* foreign memory */
+    }
+
+    puts("Testing typed classes...");
+    {
+        static memory_type_t type24 = MEMORY_TYPE_INITIALIZER(24);
+        static memory_type_t typeLarge = MEMORY_TYPE_INITIALIZER(8192);
+        char* prevPtr = NULL;
+        char* ptr;
+
+        for (i = 0; i < NUM_SLAB_ALLOC; i++) {
+            ptr = (char*)memory_allocType(&type24);
+            assert(ptr != NULL);
+            assert(((size_t)ptr % 16) == 0);
+#ifdef MEMORY_USE_SLAB
+            assert(type24.sizeClass >= MEMORY_NUM_CLASS);
+            assert(lookupClass(ptr) == type24.sizeClass);
+            assert(memory_usableSize(ptr) == 32);
+            /* Objects of a fresh span are handed out in address order */
+            if (((size_t)ptr % MEMORY_SPAN_SIZE) != 0) {
+                assert(ptr == prevPtr + 32);
+            }
+#endif
+            memset(ptr, (char)i, 24);
+            global_slabArray[i] = prevPtr = ptr;
+        }
+        for (i = 0; i < NUM_SLAB_ALLOC; i++) {
+            assert(global_slabArray[i][23] == (char)i);
+            memory_free(global_slabArray[i]);
+        }
+#ifdef MEMORY_USE_SLAB
+        /* Freed objects are reused only for the same type */
+        ptr = (char*)memory_alloc(24);
+        assert(lookupClass(ptr) == sizeToClass(24));
+        memory_free(ptr);
+        ptr = (char*)memory_allocType(&type24);
+        assert(lookupClass(ptr) == type24.sizeClass);
+        memory_free(ptr);
+#endif
+
+        ptr = (char*)memory_allocType(&typeLarge);
+        assert(ptr != NULL);
+#ifdef MEMORY_USE_SLAB
+        assert(typeLarge.sizeClass == -1);
+#endif
+        memory_free(ptr);
+    }
+
     puts("All tests passed.");
 
     return 0;
@@ -88,6 +88,21 @@ enum {
 
 typedef struct memory memory_t;
 
+/*
+ * Objects of one memory_type_t are carved from spans of their own instead of
+ * sharing them with everything else of their size class, so that the nodes
+ * of one data structure lie together. Define one per node type with
+ * MEMORY_TYPE_INITIALIZER; it is registered on first use. A data structure
+ * keeps a single static type, so the nodes of all its instances (e.g., of
+ * every list) share the same spans.
+ */
+typedef struct memory_type {
+    size_t numByte;
+    long sizeClass; /* 0 until registered */
+} memory_type_t;
+
+#define MEMORY_TYPE_INITIALIZER(numByte)  { (numByte), 0 }
+
 
 /* =============================================================================
  * memory_init
@@ -115,6 +130,44 @@ void*
 memory_get (long threadId, size_t numByte);
 
 
+/* =============================================================================
+ * memory_alloc
+ * -- Thread-caching size-class allocator; returns NULL on failure
+ * -- Memory must be released with memory_free, not free
+ * =============================================================================
+ */
+void*
+memory_alloc (size_t numByte);
+
+
+/* =============================================================================
+ * memory_allocType
+ * -- Like memory_alloc(typePtr->numByte), but from the type's own spans
+ * -- Memory must be released with memory_free, not free
+ * =============================================================================
+ */
+void*
+memory_allocType (memory_type_t* typePtr);
+
+
+/* =============================================================================
+ * memory_free
+ * -- Also accepts memory from malloc
+ * =============================================================================
+ */
+void
+memory_free (void* ptr);
+
+
+/* =============================================================================
+ * memory_usableSize
+ * -- Returns number of bytes usable at ptr
+ * =============================================================================
+ */
+size_t
+memory_usableSize (void* ptr);
+
+
 #ifdef __cplusplus
 }
 #endif
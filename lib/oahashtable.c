@@ -0,0 +1,1069 @@
+/* =============================================================================
+ *
+ * oahashtable.c
+ * -- Open-addressing hash table with inline entries and control words
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+#include "memory.h"
+#include "oahashtable.h"
+#include "pair.h"
+#include "tm.h"
+#include "types.h"
+#include "utility.h"
+
+
+/*
+ * Control bytes: an empty or deleted slot has its high bit set, a full slot
+ * holds the top 7 bits of its entry's (mixed) hash.
+ */
+#define CONTROL_EMPTY                   ((ulong_t)0x80)
+#define CONTROL_DELETED                 ((ulong_t)0xFE)
+#define CONTROL_ONES                    (~(ulong_t)0 / 0xFF) /* 0x0101... */
+#define CONTROL_HIGHS                   (CONTROL_ONES << 7)  /* 0x8080... */
+#define NUM_HASH_BIT                    (8 * sizeof(ulong_t))
+
+
+/* =============================================================================
+ * mixHash
+ * -- Spreads weak hashes (e.g., small integers) over all bits
+ * =============================================================================
+ */
+static inline ulong_t
+mixHash (oahashtable_t* hashtablePtr, void* keyPtr)
+{
+    ulong_t hash = ((hashtablePtr->hash != NULL) ?
+                    hashtablePtr->hash(keyPtr) : (ulong_t)keyPtr);
+
+    hash *= (ulong_t)0x9E3779B97F4A7C15ULL;
+
+    return (hash ^ (hash >> (NUM_HASH_BIT / 2)));
+}
+
+
+/* =============================================================================
+ * getTag
+ * =============================================================================
+ */
+static inline ulong_t
+getTag (ulong_t hash)
+{
+    return (hash >> (NUM_HASH_BIT - 7));
+}
+
+
+/* =============================================================================
+ * isEqualKey
+ * =============================================================================
+ */
+static inline bool_t
+isEqualKey (oahashtable_t* hashtablePtr, void* keyPtr, void* entryKeyPtr)
+{
+    pair_t findPair;
+    pair_t entryPair;
+
+    if (hashtablePtr->comparePairs == NULL) {
+        return (keyPtr == entryKeyPtr);
+    }
+
+    findPair.firstPtr = keyPtr;
+    findPair.secondPtr = NULL;
+    entryPair.firstPtr = entryKeyPtr;
+    entryPair.secondPtr = NULL;
+
+    return (hashtablePtr->comparePairs(&findPair, &entryPair) == 0);
+}
+
+
+/* =============================================================================
+ * matchTag
+ * -- Returns the high bits of the control bytes equal to tag, plus possibly
+ *    a few of other full slots; callers compare keys anyway
+ * =============================================================================
+ */
+static inline ulong_t
+matchTag (ulong_t control, ulong_t tag)
+{
+    ulong_t x = control ^ (CONTROL_ONES * tag);
+
+    return ((x - CONTROL_ONES) & ~x & CONTROL_HIGHS);
+}
+
+
+/* =============================================================================
+ * matchEmpty
+ * =============================================================================
+ */
+static inline ulong_t
+matchEmpty (ulong_t control)
+{
+    return (control & ~(control << 6) & CONTROL_HIGHS);
+}
+
+
+/* =============================================================================
+ * matchFree
+ * -- Empty or deleted
+ * =============================================================================
+ */
+static inline ulong_t
+matchFree (ulong_t control)
+{
+    return (control & CONTROL_HIGHS);
+}
+
+
+/* =============================================================================
+ * getFirstSlot
+ * =============================================================================
+ */
+static inline long
+getFirstSlot (ulong_t match)
+{
+    return (long)(__builtin_ctzl(match) / 8);
+}
+
+
+/* =============================================================================
+ * setControl
+ * =============================================================================
+ */
+static inline ulong_t
+setControl (ulong_t control, long slot, ulong_t byte)
+{
+    long shift = 8 * slot;
+
+    return ((control & ~((ulong_t)0xFF << shift)) | (byte << shift));
+}
+
+
+/* =============================================================================
+ * countFull
+ * =============================================================================
+ */
+static long
+countFull (oahashtable_group_t* groups, long numGroup)
+{
+    long numFull = 0;
+    long g;
+
+    for (g = 0; g < numGroup; g++) {
+        numFull += __builtin_popcountl(~groups[g].control & CONTROL_HIGHS);
+    }
+
+    return numFull;
+}
+
+
+/* =============================================================================
+ * TMcountFull
+ * =============================================================================
+ */
+static long
+TMcountFull (TM_ARGDECL  oahashtable_group_t* groups, long numGroup)
+{
+    long numFull = 0;
+    long g;
+
+    for (g = 0; g < numGroup; g++) {
+        ulong_t control = (ulong_t)TM_SHARED_READ(groups[g].control);
+        numFull += __builtin_popcountl(~control & CONTROL_HIGHS);
+    }
+
+    return numFull;
+}
+
+
+/* =============================================================================
+ * getNewNumGroup
+ * -- Called when an insert probed too long or found no free slot
+ * -- Returns 0 if the table should be left as is
+ * =============================================================================
+ */
+static long
+getNewNumGroup (long numGroup, long numFull, bool_t isFree, bool_t isEmpty)
+{
+    if (!isFree || (numFull * 2 >= numGroup * OAHASHTABLE_GROUP_SIZE)) {
+        return (numGroup * 2);
+    }
+    if (!isEmpty) {
+        return numGroup; /* probe ran through deleted slots only */
+    }
+
+    return 0;
+}
+
+
+/* =============================================================================
+ * initGroups
+ * =============================================================================
+ */
+static void
+initGroups (oahashtable_group_t* groups, long numGroup)
+{
+    long g;
+
+    for (g = 0; g < numGroup; g++) {
+        groups[g].control = CONTROL_EMPTY * CONTROL_ONES;
+    }
+}
+
+
+/* =============================================================================
+ * placeEntry
+ * -- For rehashing into a private array; assumes key is not present
+ * =============================================================================
+ */
+static void
+placeEntry (oahashtable_group_t* groups, long numGroup,
+            ulong_t hash, void* keyPtr, void* dataPtr)
+{
+    long mask = numGroup - 1;
+    long g = (long)(hash & mask);
+    long i;
+
+    for (i = 0; i < numGroup; i++) {
+        oahashtable_group_t* groupPtr = &groups[g];
+        ulong_t match = matchFree(groupPtr->control);
+        if (match) {
+            long slot = getFirstSlot(match);
+            groupPtr->entries[slot].firstPtr = keyPtr;
+            groupPtr->entries[slot].secondPtr = dataPtr;
+            groupPtr->control =
+                setControl(groupPtr->control, slot, getTag(hash));
+            return;
+        }
+        g = (g + i + 1) & mask;
+    }
+
+    assert(0);
+}
+
+
+/* =============================================================================
+ * rehash
+ * -- Returns FALSE on failure
+ * =============================================================================
+ */
+static bool_t
+rehash (oahashtable_t* hashtablePtr, long newNumGroup)
+{
+    oahashtable_group_t* groups = hashtablePtr->groups;
+    long numGroup = hashtablePtr->numGroup;
+    oahashtable_group_t* newGroups;
+    long g;
+
+    newGroups = (oahashtable_group_t*)malloc(newNumGroup *
+                                             sizeof(oahashtable_group_t));
+    if (newGroups == NULL) {
+        return FALSE;
+    }
+    initGroups(newGroups, newNumGroup);
+
+    for (g = 0; g < numGroup; g++) {
+        oahashtable_group_t* groupPtr = &groups[g];
+        ulong_t match;
+        for (match = ~groupPtr->control & CONTROL_HIGHS;
+             match;
+             match &= match - 1)
+        {
+            pair_t* entryPtr = &groupPtr->entries[getFirstSlot(match)];
+            placeEntry(newGroups,
+                       newNumGroup,
+                       mixHash(hashtablePtr, entryPtr->firstPtr),
+                       entryPtr->firstPtr,
+                       entryPtr->secondPtr);
+        }
+    }
+
+    memory_free(groups);
+    hashtablePtr->groups = newGroups;
+    hashtablePtr->numGroup = newNumGroup;
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TMrehash
+ * -- The new array is private until published, so it is filled directly
+ * -- Returns FALSE on failure
+ * =============================================================================
+ */
+static bool_t
+TMrehash (TM_ARGDECL  oahashtable_t* hashtablePtr, long newNumGroup)
+{
+    oahashtable_group_t* groups =
+        (oahashtable_group_t*)TM_SHARED_READ_P(hashtablePtr->groups);
+    long numGroup = (long)TM_SHARED_READ(hashtablePtr->numGroup);
+    oahashtable_group_t* newGroups;
+    long g;
+
+    newGroups = (oahashtable_group_t*)TM_MALLOC(newNumGroup *
+                                                sizeof(oahashtable_group_t));
+    if (newGroups == NULL) {
+        return FALSE;
+    }
+    initGroups(newGroups, newNumGroup);
+
+    for (g = 0; g < numGroup; g++) {
+        oahashtable_group_t* groupPtr = &groups[g];
+        ulong_t control = (ulong_t)TM_SHARED_READ(groupPtr->control);
+        ulong_t match;
+        for (match = ~control & CONTROL_HIGHS; match; match &= match - 1) {
+            pair_t* entryPtr = &groupPtr->entries[getFirstSlot(match)];
+            void* keyPtr = TM_SHARED_READ_P(entryPtr->firstPtr);
+            placeEntry(newGroups,
+                       newNumGroup,
+                       mixHash(hashtablePtr, keyPtr),
+                       keyPtr,
+                       TM_SHARED_READ_P(entryPtr->secondPtr));
+        }
+    }
+
+    TM_SHARED_WRITE_P(hashtablePtr->groups, newGroups);
+    TM_SHARED_WRITE(hashtablePtr->numGroup, newNumGroup);
+    TM_FREE(groups);
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * findEntry
+ * -- Returns group of key and sets *slotPtr, or NULL if not found
+ * =============================================================================
+ */
+static oahashtable_group_t*
+findEntry (oahashtable_t* hashtablePtr, void* keyPtr, long* slotPtr)
+{
+    oahashtable_group_t* groups = hashtablePtr->groups;
+    long numGroup = hashtablePtr->numGroup;
+    ulong_t hash = mixHash(hashtablePtr, keyPtr);
+    ulong_t tag = getTag(hash);
+    long mask = numGroup - 1;
+    long g = (long)(hash & mask);
+    long i;
+
+    for (i = 0; i < numGroup; i++) {
+        oahashtable_group_t* groupPtr = &groups[g];
+        ulong_t control = groupPtr->control;
+        ulong_t match;
+        for (match = matchTag(control, tag); match; match &= match - 1) {
+            long slot = getFirstSlot(match);
+            if (isEqualKey(hashtablePtr,
+                           keyPtr,
+                           groupPtr->entries[slot].firstPtr))
+            {
+                *slotPtr = slot;
+                return groupPtr;
+            }
+        }
+        if (matchEmpty(control)) {
+            break;
+        }
+        g = (g + i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+
+/* =============================================================================
+ * TMfindEntry
+ * -- Returns group of key and sets *slotPtr, or NULL if not found
+ * =============================================================================
+ */
+static oahashtable_group_t*
+TMfindEntry (TM_ARGDECL
+             oahashtable_t* hashtablePtr, void* keyPtr, long* slotPtr)
+{
+    oahashtable_group_t* groups =
+        (oahashtable_group_t*)TM_SHARED_READ_P(hashtablePtr->groups);
+    long numGroup = (long)TM_SHARED_READ(hashtablePtr->numGroup);
+    ulong_t hash = mixHash(hashtablePtr, keyPtr);
+    ulong_t tag = getTag(hash);
+    long mask = numGroup - 1;
+    long g = (long)(hash & mask);
+    long i;
+
+    for (i = 0; i < numGroup; i++) {
+        oahashtable_group_t* groupPtr = &groups[g];
+        ulong_t control = (ulong_t)TM_SHARED_READ(groupPtr->control);
+        ulong_t match;
+        for (match = matchTag(control, tag); match; match &= match - 1) {
+            long slot = getFirstSlot(match);
+            if (isEqualKey(hashtablePtr,
+                           keyPtr,
+                           TM_SHARED_READ_P(groupPtr->entries[slot].firstPtr)))
+            {
+                *slotPtr = slot;
+                return groupPtr;
+            }
+        }
+        if (matchEmpty(control)) {
+            break;
+        }
+        g = (g + i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+
+/* =============================================================================
+ * oahashtable_iter_reset
+ * =============================================================================
+ */
+void
+oahashtable_iter_reset (oahashtable_iter_t* itPtr,
+                        oahashtable_t* hashtablePtr)
+{
+    oahashtable_iter_resetPart(itPtr, hashtablePtr, 0, 1);
+}
+
+
+/* =============================================================================
+ * oahashtable_iter_resetPart
+ * -- Iterates over part 'part' of 'numPart' disjoint parts of the table
+ * =============================================================================
+ */
+void
+oahashtable_iter_resetPart (oahashtable_iter_t* itPtr,
+                            oahashtable_t* hashtablePtr,
+                            long part,
+                            long numPart)
+{
+    long numSlot = hashtablePtr->numGroup * OAHASHTABLE_GROUP_SIZE;
+    long partSize = (numSlot + numPart - 1) / numPart;
+
+    itPtr->slot = MIN(numSlot, part * partSize);
+    itPtr->stopSlot = ((part == (numPart - 1)) ?
+                       numSlot : MIN(numSlot, itPtr->slot + partSize));
+}
+
+
+/* =============================================================================
+ * oahashtable_iter_hasNext
+ * -- Skips free slots
+ * =============================================================================
+ */
+bool_t
+oahashtable_iter_hasNext (oahashtable_iter_t* itPtr,
+                          oahashtable_t* hashtablePtr)
+{
+    long slot;
+
+    for (slot = itPtr->slot; slot < itPtr->stopSlot; slot++) {
+        ulong_t control =
+            hashtablePtr->groups[slot / OAHASHTABLE_GROUP_SIZE].control;
+        long shift = 8 * (slot % OAHASHTABLE_GROUP_SIZE);
+        if (!((control >> shift) & CONTROL_EMPTY)) {
+            break;
+        }
+    }
+    itPtr->slot = slot;
+
+    return ((slot < itPtr->stopSlot) ? TRUE : FALSE);
+}
+
+
+/* =============================================================================
+ * oahashtable_iter_next
+ * -- Returns the data of the next entry
+ * =============================================================================
+ */
+void*
+oahashtable_iter_next (oahashtable_iter_t* itPtr,
+                       oahashtable_t* hashtablePtr)
+{
+    long slot;
+
+    if (!oahashtable_iter_hasNext(itPtr, hashtablePtr)) {
+        return NULL;
+    }
+
+    slot = itPtr->slot++;
+
+    return hashtablePtr->groups[slot / OAHASHTABLE_GROUP_SIZE].entries[
+        slot % OAHASHTABLE_GROUP_SIZE].secondPtr;
+}
+
+
+/* =============================================================================
+ * oahashtable_alloc
+ * -- Sized for initNumEntry entries without growing
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+oahashtable_t*
+oahashtable_alloc (long initNumEntry,
+                   ulong_t (*hash)(const void*),
+                   long (*comparePairs)(const pair_t*, const pair_t*))
+{
+    oahashtable_t* hashtablePtr;
+    long numGroup = 1;
+
+    /* At most half full */
+    while ((numGroup * OAHASHTABLE_GROUP_SIZE) < (2 * initNumEntry)) {
+        numGroup *= 2;
+    }
+
+    hashtablePtr = (oahashtable_t*)malloc(sizeof(oahashtable_t));
+    if (hashtablePtr == NULL) {
+        return NULL;
+    }
+
+    hashtablePtr->groups =
+        (oahashtable_group_t*)malloc(numGroup * sizeof(oahashtable_group_t));
+    if (hashtablePtr->groups == NULL) {
+        memory_free(hashtablePtr);
+        return NULL;
+    }
+    initGroups(hashtablePtr->groups, numGroup);
+
+    hashtablePtr->numGroup = numGroup;
+    hashtablePtr->hash = hash;
+    hashtablePtr->comparePairs = comparePairs;
+
+    return hashtablePtr;
+}
+
+
+/* =============================================================================
+ * oahashtable_free
+ * =============================================================================
+ */
+void
+oahashtable_free (oahashtable_t* hashtablePtr)
+{
+    memory_free(hashtablePtr->groups);
+    memory_free(hashtablePtr);
+}
+
+
+/* =============================================================================
+ * oahashtable_getSize
+ * -- Returns number of entries; counts them
+ * =============================================================================
+ */
+long
+oahashtable_getSize (oahashtable_t* hashtablePtr)
+{
+    return countFull(hashtablePtr->groups, hashtablePtr->numGroup);
+}
+
+
+/* =============================================================================
+ * oahashtable_containsKey
+ * =============================================================================
+ */
+bool_t
+oahashtable_containsKey (oahashtable_t* hashtablePtr, void* keyPtr)
+{
+    long slot;
+
+    return ((findEntry(hashtablePtr, keyPtr, &slot) != NULL) ? TRUE : FALSE);
+}
+
+
+/* =============================================================================
+ * TMoahashtable_containsKey
+ * =============================================================================
+ */
+bool_t
+TMoahashtable_containsKey (TM_ARGDECL
+                           oahashtable_t* hashtablePtr, void* keyPtr)
+{
+    long slot;
+
+    return ((TMfindEntry(TM_ARG  hashtablePtr, keyPtr, &slot) != NULL) ?
+            TRUE : FALSE);
+}
+
+
+/* =============================================================================
+ * oahashtable_find
+ * -- Returns NULL on failure, else pointer to data associated with key
+ * =============================================================================
+ */
+void*
+oahashtable_find (oahashtable_t* hashtablePtr, void* keyPtr)
+{
+    long slot;
+    oahashtable_group_t* groupPtr = findEntry(hashtablePtr, keyPtr, &slot);
+
+    if (groupPtr == NULL) {
+        return NULL;
+    }
+
+    return groupPtr->entries[slot].secondPtr;
+}
+
+
+/* =============================================================================
+ * TMoahashtable_find
+ * -- Returns NULL on failure, else pointer to data associated with key
+ * =============================================================================
+ */
+void*
+TMoahashtable_find (TM_ARGDECL  oahashtable_t* hashtablePtr, void* keyPtr)
+{
+    long slot;
+    oahashtable_group_t* groupPtr =
+        TMfindEntry(TM_ARG  hashtablePtr, keyPtr, &slot);
+
+    if (groupPtr == NULL) {
+        return NULL;
+    }
+
+    return TM_SHARED_READ_P(groupPtr->entries[slot].secondPtr);
+}
+
+
+/* =============================================================================
+ * oahashtable_insert
+ * -- Returns FALSE if key is already present or on failure
+ * =============================================================================
+ */
+bool_t
+oahashtable_insert (oahashtable_t* hashtablePtr, void* keyPtr, void* dataPtr)
+{
+    ulong_t hash = mixHash(hashtablePtr, keyPtr);
+    ulong_t tag = getTag(hash);
+
+    while (TRUE) {
+        oahashtable_group_t* groups = hashtablePtr->groups;
+        long numGroup = hashtablePtr->numGroup;
+        long mask = numGroup - 1;
+        long g = (long)(hash & mask);
+        oahashtable_group_t* freeGroupPtr = NULL;
+        long freeSlot = 0;
+        bool_t isEmpty = FALSE;
+        long i;
+
+        for (i = 0; i < numGroup; i++) {
+            oahashtable_group_t* groupPtr = &groups[g];
+            ulong_t control = groupPtr->control;
+            ulong_t match;
+            for (match = matchTag(control, tag); match; match &= match - 1) {
+                if (isEqualKey(hashtablePtr,
+                               keyPtr,
+                               groupPtr->entries[getFirstSlot(match)].firstPtr))
+                {
+                    return FALSE;
+                }
+            }
+            match = matchFree(control);
+            if (freeGroupPtr == NULL && match) {
+                freeGroupPtr = groupPtr;
+                freeSlot = getFirstSlot(match);
+            }
+            if (matchEmpty(control)) {
+                isEmpty = TRUE;
+                break;
+            }
+            g = (g + i + 1) & mask;
+        }
+
+        if (freeGroupPtr == NULL || i >= OAHASHTABLE_MAX_PROBE) {
+            long newNumGroup =
+                getNewNumGroup(numGroup,
+                               countFull(groups, numGroup),
+                               (freeGroupPtr != NULL),
+                               isEmpty);
+            if (newNumGroup > 0) {
+                if (!rehash(hashtablePtr, newNumGroup)) {
+                    return FALSE;
+                }
+                continue;
+            }
+        }
+
+        freeGroupPtr->entries[freeSlot].firstPtr = keyPtr;
+        freeGroupPtr->entries[freeSlot].secondPtr = dataPtr;
+        freeGroupPtr->control = setControl(freeGroupPtr->control, freeSlot, tag);
+
+        return TRUE;
+    }
+}
+
+
+/* =============================================================================
+ * TMoahashtable_insert
+ * -- Returns FALSE if key is already present or on failure
+ * =============================================================================
+ */
+bool_t
+TMoahashtable_insert (TM_ARGDECL
+                      oahashtable_t* hashtablePtr, void* keyPtr, void* dataPtr)
+{
+    ulong_t hash = mixHash(hashtablePtr, keyPtr);
+    ulong_t tag = getTag(hash);
+
+    while (TRUE) {
+        oahashtable_group_t* groups =
+            (oahashtable_group_t*)TM_SHARED_READ_P(hashtablePtr->groups);
+        long numGroup = (long)TM_SHARED_READ(hashtablePtr->numGroup);
+        long mask = numGroup - 1;
+        long g = (long)(hash & mask);
+        oahashtable_group_t* freeGroupPtr = NULL;
+        ulong_t freeControl = 0;
+        long freeSlot = 0;
+        bool_t isEmpty = FALSE;
+        long i;
+
+        for (i = 0; i < numGroup; i++) {
+            oahashtable_group_t* groupPtr = &groups[g];
+            ulong_t control = (ulong_t)TM_SHARED_READ(groupPtr->control);
+            ulong_t match;
+            for (match = matchTag(control, tag); match; match &= match - 1) {
+                pair_t* entryPtr = &groupPtr->entries[getFirstSlot(match)];
+                if (isEqualKey(hashtablePtr,
+                               keyPtr,
+                               TM_SHARED_READ_P(entryPtr->firstPtr)))
+                {
+                    return FALSE;
+                }
+            }
+            match = matchFree(control);
+            if (freeGroupPtr == NULL && match) {
+                freeGroupPtr = groupPtr;
+                freeControl = control;
+                freeSlot = getFirstSlot(match);
+            }
+            if (matchEmpty(control)) {
+                isEmpty = TRUE;
+                break;
+            }
+            g = (g + i + 1) & mask;
+        }
+
+        if (freeGroupPtr == NULL || i >= OAHASHTABLE_MAX_PROBE) {
+            long newNumGroup =
+                getNewNumGroup(numGroup,
+                               TMcountFull(TM_ARG  groups, numGroup),
+                               (freeGroupPtr != NULL),
+                               isEmpty);
+            if (newNumGroup > 0) {
+                if (!TMrehash(TM_ARG  hashtablePtr, newNumGroup)) {
+                    return FALSE;
+                }
+                continue;
+            }
+        }
+
+        TM_SHARED_WRITE_P(freeGroupPtr->entries[freeSlot].firstPtr, keyPtr);
+        TM_SHARED_WRITE_P(freeGroupPtr->entries[freeSlot].secondPtr, dataPtr);
+        TM_SHARED_WRITE(freeGroupPtr->control,
+                        setControl(freeControl, freeSlot, tag));
+
+        return TRUE;
+    }
+}
+
+
+/* =============================================================================
+ * oahashtable_remove
+ * -- Returns TRUE if successful, else FALSE
+ * =============================================================================
+ */
+bool_t
+oahashtable_remove (oahashtable_t* hashtablePtr, void* keyPtr)
+{
+    long slot;
+    oahashtable_group_t* groupPtr = findEntry(hashtablePtr, keyPtr, &slot);
+    ulong_t control;
+
+    if (groupPtr == NULL) {
+        return FALSE;
+    }
+
+    /* No probe goes past a group with an empty slot, so none needs a marker */
+    control = groupPtr->control;
+    groupPtr->control =
+        setControl(control,
+                   slot,
+                   (matchEmpty(control) ? CONTROL_EMPTY : CONTROL_DELETED));
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TMoahashtable_remove
+ * -- Returns TRUE if successful, else FALSE
+ * =============================================================================
+ */
+bool_t
+TMoahashtable_remove (TM_ARGDECL  oahashtable_t* hashtablePtr, void* keyPtr)
+{
+    long slot;
+    oahashtable_group_t* groupPtr =
+        TMfindEntry(TM_ARG  hashtablePtr, keyPtr, &slot);
+    ulong_t control;
+
+    if (groupPtr == NULL) {
+        return FALSE;
+    }
+
+    control = (ulong_t)TM_SHARED_READ(groupPtr->control);
+    TM_SHARED_WRITE(groupPtr->control,
+                    setControl(control,
+                               slot,
+                               (matchEmpty(control) ?
+                                CONTROL_EMPTY : CONTROL_DELETED)));
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TEST_OAHASHTABLE
+ * =============================================================================
+ */
+#ifdef TEST_OAHASHTABLE
+
+
+#include <stdio.h>
+#include <string.h>
+#include "thread.h"
+
+#define NUM_KEY    (4096)
+#define NUM_THREAD (4)
+
+static char global_isPresent[NUM_KEY];
+static oahashtable_t* global_hashtablePtr;
+
+
+static ulong_t
+hashConstant (const void* keyPtr)
+{
+    return 42;
+}
+
+
+static long
+comparePairs (const pair_t* a, const pair_t* b)
+{
+    return (*(long*)(a->firstPtr) - *(long*)(b->firstPtr));
+}
+
+
+static void
+check (oahashtable_t* hashtablePtr, long* keys)
+{
+    oahashtable_iter_t it;
+    long numPresent = 0;
+    long numIter = 0;
+    long i;
+
+    for (i = 0; i < NUM_KEY; i++) {
+        void* keyPtr = ((keys != NULL) ? (void*)&keys[i] : (void*)i);
+        void* dataPtr = oahashtable_find(hashtablePtr, keyPtr);
+        if (global_isPresent[i]) {
+            assert(dataPtr == (void*)(i + 1));
+            numPresent++;
+        } else {
+            assert(dataPtr == NULL);
+        }
+    }
+    assert(oahashtable_getSize(hashtablePtr) == numPresent);
+
+    oahashtable_iter_reset(&it, hashtablePtr);
+    while (oahashtable_iter_hasNext(&it, hashtablePtr)) {
+        long i = (long)oahashtable_iter_next(&it, hashtablePtr) - 1;
+        assert(global_isPresent[i]);
+        numIter++;
+    }
+    assert(numIter == numPresent);
+}
+
+
+static void
+testSequential (ulong_t (*hash)(const void*), long numKey)
+{
+    static long keys[NUM_KEY];
+    oahashtable_t* hashtablePtr;
+    long round;
+    long i;
+
+    hashtablePtr = oahashtable_alloc(1, hash, ((hash != NULL) ?
+                                               &comparePairs : NULL));
+    assert(hashtablePtr);
+    memset(global_isPresent, 0, sizeof(global_isPresent));
+    for (i = 0; i < NUM_KEY; i++) {
+        keys[i] = i;
+    }
+
+    /* Random inserts and removes leave both free and deleted slots */
+    srand(0);
+    for (round = 0; round < 8; round++) {
+        for (i = 0; i < 4 * numKey; i++) {
+            long k = rand() % numKey;
+            void* keyPtr = ((hash != NULL) ? (void*)&keys[k] : (void*)k);
+            if (rand() % 3) {
+                bool_t status =
+                    oahashtable_insert(hashtablePtr, keyPtr, (void*)(k + 1));
+                assert(status == !global_isPresent[k]);
+                global_isPresent[k] = TRUE;
+            } else {
+                bool_t status = oahashtable_remove(hashtablePtr, keyPtr);
+                assert(status == global_isPresent[k]);
+                global_isPresent[k] = FALSE;
+            }
+        }
+        check(hashtablePtr, ((hash != NULL) ? keys : NULL));
+    }
+
+    oahashtable_free(hashtablePtr);
+}
+
+
+static void
+insertRemove (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    long i;
+
+    /* Starts from one group, so that transactions grow the table */
+    for (i = id; i < NUM_KEY; i += NUM_THREAD) {
+        bool_t status;
+        TM_BEGIN();
+        status = TMOAHASHTABLE_INSERT(global_hashtablePtr,
+                                      (void*)i,
+                                      (void*)(i + 1));
+        TM_END();
+        assert(status);
+    }
+
+    thread_barrier_wait();
+
+    for (i = id; i < NUM_KEY; i += NUM_THREAD) {
+        if (i % 3 == 0) {
+            bool_t status;
+            TM_BEGIN();
+            status = TMOAHASHTABLE_REMOVE(global_hashtablePtr, (void*)i);
+            TM_END();
+            assert(status);
+        } else {
+            void* dataPtr;
+            TM_BEGIN();
+            dataPtr = TMOAHASHTABLE_FIND(global_hashtablePtr, (void*)i);
+            TM_END();
+            assert(dataPtr == (void*)(i + 1));
+        }
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+int
+main ()
+{
+    long i;
+
+    puts("Starting...");
+
+    testSequential(NULL, NUM_KEY);
+    testSequential(&hashConstant, 200); /* every key collides */
+
+    global_hashtablePtr = oahashtable_alloc(1, NULL, NULL);
+    assert(global_hashtablePtr);
+    TM_STARTUP(NUM_THREAD);
+    thread_startup(NUM_THREAD);
+    thread_start(insertRemove, NULL);
+    thread_shutdown();
+    TM_SHUTDOWN();
+
+    for (i = 0; i < NUM_KEY; i++) {
+        global_isPresent[i] = (i % 3 != 0);
+    }
+    check(global_hashtablePtr, NULL);
+    oahashtable_free(global_hashtablePtr);
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_OAHASHTABLE */
+
+
+/* =============================================================================
+ *
+ * End of oahashtable.c
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,292 @@
+/* =============================================================================
+ *
+ * oahashtable.h
+ * -- Open-addressing hash table
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef OAHASHTABLE_H
+#define OAHASHTABLE_H 1
+
+
+#include "pair.h"
+#include "tm.h"
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Open-addressing hash table
+ *
+ * Entries are stored inline in groups of OAHASHTABLE_GROUP_SIZE slots, each
+ * group headed by one word that holds a control byte per slot: empty,
+ * deleted, or 7 bits of the entry's hash. A lookup reads the control word of
+ * a group, compares the keys of only those slots whose byte matches, and
+ * moves on to the next group of a quadratic probe sequence only if the group
+ * is full. Unlike the chained hashtable.h, there is no bucket pointer, list
+ * head, or node to chase, and a transactional insert reads one control word
+ * per group probed and writes one control word and one entry.
+ *
+ * The table doubles (in a transaction, the inserting transaction does the
+ * whole copy) when an insert has to probe more than OAHASHTABLE_MAX_PROBE
+ * groups while at least half of the slots are used, or when no slot is free.
+ *
+ * The hash function must agree with comparePairs, which only needs to return
+ * 0 for equal keys. If both are NULL, keys are compared and hashed by value
+ * (e.g., long keys cast to void*).
+ * =============================================================================
+ */
+
+enum oahashtable_config {
+    OAHASHTABLE_GROUP_SIZE = sizeof(ulong_t), /* one control byte per slot */
+    OAHASHTABLE_MAX_PROBE  = 8,
+};
+
+typedef struct oahashtable_group {
+    ulong_t control;
+    pair_t entries[OAHASHTABLE_GROUP_SIZE];
+} oahashtable_group_t;
+
+typedef struct oahashtable {
+    oahashtable_group_t* groups;
+    long numGroup; /* power of 2 */
+    ulong_t (*hash)(const void*);
+    long (*comparePairs)(const pair_t*, const pair_t*);
+} oahashtable_t;
+
+typedef struct oahashtable_iter {
+    long slot;
+    long stopSlot;
+} oahashtable_iter_t;
+
+
+/* =============================================================================
+ * oahashtable_iter_reset
+ * =============================================================================
+ */
+void
+oahashtable_iter_reset (oahashtable_iter_t* itPtr,
+                        oahashtable_t* hashtablePtr);
+
+
+/* =============================================================================
+ * oahashtable_iter_resetPart
+ * -- Iterates over part 'part' of 'numPart' disjoint parts of the table
+ * =============================================================================
+ */
+void
+oahashtable_iter_resetPart (oahashtable_iter_t* itPtr,
+                            oahashtable_t* hashtablePtr,
+                            long part,
+                            long numPart);
+
+
+/* =============================================================================
+ * oahashtable_iter_hasNext
+ * =============================================================================
+ */
+bool_t
+oahashtable_iter_hasNext (oahashtable_iter_t* itPtr,
+                          oahashtable_t* hashtablePtr);
+
+
+/* =============================================================================
+ * oahashtable_iter_next
+ * -- Returns the data of the next entry
+ * =============================================================================
+ */
+void*
+oahashtable_iter_next (oahashtable_iter_t* itPtr,
+                       oahashtable_t* hashtablePtr);
+
+
+/* =============================================================================
+ * oahashtable_alloc
+ * -- Sized for initNumEntry entries without growing
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+oahashtable_t*
+oahashtable_alloc (long initNumEntry,
+                   ulong_t (*hash)(const void*),
+                   long (*comparePairs)(const pair_t*, const pair_t*));
+
+
+/* =============================================================================
+ * oahashtable_free
+ * =============================================================================
+ */
+void
+oahashtable_free (oahashtable_t* hashtablePtr);
+
+
+/* =============================================================================
+ * oahashtable_getSize
+ * -- Returns number of entries; counts them
+ * =============================================================================
+ */
+long
+oahashtable_getSize (oahashtable_t* hashtablePtr);
+
+
+/* =============================================================================
+ * oahashtable_containsKey
+ * =============================================================================
+ */
+bool_t
+oahashtable_containsKey (oahashtable_t* hashtablePtr, void* keyPtr);
+
+
+/* =============================================================================
+ * TMoahashtable_containsKey
+ * =============================================================================
+ */
+bool_t
+TMoahashtable_containsKey (TM_ARGDECL
+                           oahashtable_t* hashtablePtr, void* keyPtr);
+
+
+/* =============================================================================
+ * oahashtable_find
+ * -- Returns NULL on failure, else pointer to data associated with key
+ * =============================================================================
+ */
+void*
+oahashtable_find (oahashtable_t* hashtablePtr, void* keyPtr);
+
+
+/* =============================================================================
+ * TMoahashtable_find
+ * -- Returns NULL on failure, else pointer to data associated with key
+ * =============================================================================
+ */
+void*
+TMoahashtable_find (TM_ARGDECL  oahashtable_t* hashtablePtr, void* keyPtr);
+
+
+/* =============================================================================
+ * oahashtable_insert
+ * -- Returns FALSE if key is already present or on failure
+ * =============================================================================
+ */
+bool_t
+oahashtable_insert (oahashtable_t* hashtablePtr, void* keyPtr, void* dataPtr);
+
+
+/* =============================================================================
+ * TMoahashtable_insert
+ * -- Returns FALSE if key is already present or on failure
+ * =============================================================================
+ */
+bool_t
+TMoahashtable_insert (TM_ARGDECL
+                      oahashtable_t* hashtablePtr, void* keyPtr, void* dataPtr);
+
+
+/* =============================================================================
+ * oahashtable_remove
+ * -- Returns TRUE if successful, else FALSE
+ * =============================================================================
+ */
+bool_t
+oahashtable_remove (oahashtable_t* hashtablePtr, void* keyPtr);
+
+
+/* =============================================================================
+ * TMoahashtable_remove
+ * -- Returns TRUE if successful, else FALSE
+ * =============================================================================
+ */
+bool_t
+TMoahashtable_remove (TM_ARGDECL  oahashtable_t* hashtablePtr, void* keyPtr);
+
+
+#define TMOAHASHTABLE_CONTAINSKEY(ht, k)  TMoahashtable_containsKey(TM_ARG  ht, k)
+#define TMOAHASHTABLE_FIND(ht, k)         TMoahashtable_find(TM_ARG  ht, k)
+#define TMOAHASHTABLE_INSERT(ht, k, d)    TMoahashtable_insert(TM_ARG  ht, k, d)
+#define TMOAHASHTABLE_REMOVE(ht, k)       TMoahashtable_remove(TM_ARG  ht, k)
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* OAHASHTABLE_H */
+
+
+/* =============================================================================
+ *
+ * End of oahashtable.h
+ *
+ * =============================================================================
+ */
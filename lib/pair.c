@@ -141,7 +141,7 @@ TMpair_alloc (TM_ARGDECL  void* firstPtr, void* secondPtr)
 void
 pair_free (pair_t* pairPtr)
 {
-    free(pairPtr);
+    memory_free(pairPtr);
 }
 
 
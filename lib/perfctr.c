@@ -0,0 +1,591 @@
+/* =============================================================================
+ *
+ * perfctr.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#endif
+#include "perfctr.h"
+#include "types.h"
+
+
+enum perfctr_tuning {
+    PERFCTR_CACHE_LINE_SIZE = 64,
+    PERFCTR_NUM_SOURCE      = 2, /* first choice and fallback */
+};
+
+typedef struct perfctr_source {
+    const char* name;
+    unsigned int type;
+    unsigned long long config;
+} perfctr_source_t;
+
+/* Each thread writes only its own record */
+typedef struct perfctr_thread {
+    int fds[PERFCTR_NUM_EVENT];
+    bool_t isOpen;
+    unsigned long long counts[PERFCTR_NUM_EVENT];
+    /* Not reset by PERF_EVENT_IOC_RESET, so kept from perfctr_begin */
+    unsigned long long beginEnabled[PERFCTR_NUM_EVENT];
+    unsigned long long beginRunning[PERFCTR_NUM_EVENT];
+} __attribute__ ((aligned (PERFCTR_CACHE_LINE_SIZE))) perfctr_thread_t;
+
+static bool_t           global_isEnabled = FALSE;
+static long             global_numThread = 0;
+static long             global_sourceIds[PERFCTR_NUM_EVENT]; /* -1 = none */
+static bool_t           global_excludeKernels[PERFCTR_NUM_EVENT];
+static perfctr_thread_t global_threads[PERFCTR_MAX_THREAD];
+
+#ifdef __linux__
+
+#  define CACHE_MISS(cache) \
+    ((cache) | \
+     (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const perfctr_source_t
+global_sources[PERFCTR_NUM_EVENT][PERFCTR_NUM_SOURCE] = {
+    [PERFCTR_CYCLES] = {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"task-clock-ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    },
+    [PERFCTR_INSTRUCTIONS] = {
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    },
+    [PERFCTR_LLC_MISSES] = {
+        {"llc-misses", PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_LL)},
+        {"llc-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    },
+    [PERFCTR_DTLB_MISSES] = {
+        {"dtlb-misses", PERF_TYPE_HW_CACHE, CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+    },
+    [PERFCTR_CONTEXT_SWITCHES] = {
+        {"context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    },
+    [PERFCTR_PAGE_FAULTS] = {
+        {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    },
+};
+
+
+/* =============================================================================
+ * openCounter
+ * -- Counts the calling thread on any CPU; starts disabled
+ * -- Returns file descriptor, or -1 on failure
+ * =============================================================================
+ */
+static int
+openCounter (const perfctr_source_t* sourcePtr, bool_t excludeKernel)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = sourcePtr->type;
+    attr.config         = sourcePtr->config;
+    attr.disabled       = 1;
+    attr.exclude_kernel = (excludeKernel ? 1 : 0);
+    attr.exclude_hv     = 1;
+    attr.read_format    = (PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING);
+
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+
+/* =============================================================================
+ * probeEvents
+ * =============================================================================
+ */
+static void
+probeEvents ()
+{
+    long e;
+
+    for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+        long s;
+        global_sourceIds[e] = -1;
+        for (s = 0; s < PERFCTR_NUM_SOURCE; s++) {
+            const perfctr_source_t* sourcePtr = &global_sources[e][s];
+            long k;
+            if (sourcePtr->name == NULL) {
+                break;
+            }
+            for (k = 0; k < 2; k++) {
+                int fd = openCounter(sourcePtr, (k == 1));
+                if (fd >= 0) {
+                    close(fd);
+                    global_sourceIds[e] = s;
+                    global_excludeKernels[e] = (k == 1);
+                    break;
+                }
+            }
+            if (global_sourceIds[e] >= 0) {
+                break;
+            }
+        }
+    }
+}
+
+
+/* =============================================================================
+ * openThread
+ * =============================================================================
+ */
+static void
+openThread (perfctr_thread_t* threadPtr)
+{
+    long e;
+
+    for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+        long s = global_sourceIds[e];
+        threadPtr->fds[e] =
+            ((s < 0) ?
+             -1 : openCounter(&global_sources[e][s], global_excludeKernels[e]));
+    }
+    threadPtr->isOpen = TRUE;
+}
+
+#endif /* __linux__ */
+
+
+/* =============================================================================
+ * perfctr_startup
+ * =============================================================================
+ */
+void
+perfctr_startup (long numThread)
+{
+    const char* spec = getenv("PERF_COUNTERS");
+    long t;
+    long e;
+
+    global_isEnabled = (spec != NULL && spec[0] != '\0' && strcmp(spec, "0"));
+    global_numThread = ((numThread < PERFCTR_MAX_THREAD) ?
+                        numThread : PERFCTR_MAX_THREAD);
+
+    for (t = 0; t < PERFCTR_MAX_THREAD; t++) {
+        perfctr_thread_t* threadPtr = &global_threads[t];
+        threadPtr->isOpen = FALSE;
+        for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+            threadPtr->fds[e] = -1;
+            threadPtr->counts[e] = 0;
+        }
+    }
+
+    for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+        global_sourceIds[e] = -1;
+    }
+    if (!global_isEnabled) {
+        return;
+    }
+
+#ifdef __linux__
+    probeEvents();
+#else
+    fprintf(stderr, "Performance counters are not supported here\n");
+#endif
+}
+
+
+/* =============================================================================
+ * perfctr_shutdown
+ * =============================================================================
+ */
+void
+perfctr_shutdown ()
+{
+    long t;
+
+    if (!global_isEnabled) {
+        return;
+    }
+
+    perfctr_print(stdout);
+
+    for (t = 0; t < global_numThread; t++) {
+        perfctr_thread_t* threadPtr = &global_threads[t];
+        long e;
+        for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+            if (threadPtr->fds[e] >= 0) {
+                close(threadPtr->fds[e]);
+                threadPtr->fds[e] = -1;
+            }
+        }
+        threadPtr->isOpen = FALSE;
+    }
+}
+
+
+/* =============================================================================
+ * perfctr_begin
+ * =============================================================================
+ */
+void
+perfctr_begin (long threadId)
+{
+#ifdef __linux__
+    perfctr_thread_t* threadPtr;
+    long e;
+
+    if (!global_isEnabled || threadId >= global_numThread) {
+        return;
+    }
+
+    threadPtr = &global_threads[threadId];
+    if (!threadPtr->isOpen) {
+        openThread(threadPtr);
+    }
+    for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+        int fd = threadPtr->fds[e];
+        unsigned long long values[3]; /* count, time enabled, time running */
+        if (fd < 0) {
+            continue;
+        }
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        if (read(fd, values, sizeof(values)) != sizeof(values)) {
+            values[1] = 0;
+            values[2] = 0;
+        }
+        threadPtr->beginEnabled[e] = values[1];
+        threadPtr->beginRunning[e] = values[2];
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+
+/* =============================================================================
+ * perfctr_end
+ * =============================================================================
+ */
+void
+perfctr_end (long threadId)
+{
+#ifdef __linux__
+    perfctr_thread_t* threadPtr;
+    long e;
+
+    if (!global_isEnabled || threadId >= global_numThread) {
+        return;
+    }
+
+    threadPtr = &global_threads[threadId];
+    for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+        int fd = threadPtr->fds[e];
+        unsigned long long values[3]; /* count, time enabled, time running */
+        unsigned long long enabled;
+        unsigned long long running;
+        if (fd < 0) {
+            continue;
+        }
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, values, sizeof(values)) != sizeof(values)) {
+            continue;
+        }
+        /* The times accumulate over the whole run; scale by this region's */
+        enabled = values[1] - threadPtr->beginEnabled[e];
+        running = values[2] - threadPtr->beginRunning[e];
+        if (running > 0 && running < enabled) {
+            /* Multiplexed: extrapolate to the whole region */
+            values[0] = (unsigned long long)
+                ((double)values[0] * (double)enabled / (double)running);
+        }
+        threadPtr->counts[e] += values[0];
+    }
+#endif
+}
+
+
+/* =============================================================================
+ * perfctr_isEnabled
+ * =============================================================================
+ */
+bool_t
+perfctr_isEnabled ()
+{
+    return global_isEnabled;
+}
+
+
+/* =============================================================================
+ * perfctr_getNumThread
+ * =============================================================================
+ */
+long
+perfctr_getNumThread ()
+{
+    return global_numThread;
+}
+
+
+/* =============================================================================
+ * perfctr_getEventName
+ * =============================================================================
+ */
+const char*
+perfctr_getEventName (long event)
+{
+#ifdef __linux__
+    long s = global_sourceIds[event];
+
+    if (s >= 0) {
+        return global_sources[event][s].name;
+    }
+#endif
+
+    return NULL;
+}
+
+
+/* =============================================================================
+ * perfctr_getCount
+ * =============================================================================
+ */
+unsigned long long
+perfctr_getCount (long threadId, long event)
+{
+    return global_threads[threadId].counts[event];
+}
+
+
+/* =============================================================================
+ * perfctr_print
+ * -- Adds IPC and LLC misses per 1000 instructions when those are counted
+ * =============================================================================
+ */
+void
+perfctr_print (FILE* stream)
+{
+    bool_t hasIpc = (perfctr_getEventName(PERFCTR_INSTRUCTIONS) != NULL &&
+                     global_sourceIds[PERFCTR_CYCLES] == 0);
+    bool_t hasMpki = (perfctr_getEventName(PERFCTR_INSTRUCTIONS) != NULL &&
+                      perfctr_getEventName(PERFCTR_LLC_MISSES) != NULL);
+    unsigned long long totals[PERFCTR_NUM_EVENT];
+    long t;
+    long e;
+
+    fprintf(stream, "Performance counters (parallel regions, per thread):\n");
+    fprintf(stream, "  %6s", "thread");
+    for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+        const char* name = perfctr_getEventName(e);
+        if (name != NULL) {
+            fprintf(stream, " %16s", name);
+        }
+        totals[e] = 0;
+    }
+    if (hasIpc) {
+        fprintf(stream, " %6s", "IPC");
+    }
+    if (hasMpki) {
+        fprintf(stream, " %9s", "LLC MPKI");
+    }
+    fputc('\n', stream);
+
+    for (t = 0; t <= global_numThread; t++) {
+        unsigned long long* counts;
+        if (t < global_numThread) {
+            counts = global_threads[t].counts;
+            fprintf(stream, "  %6li", t);
+            for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+                totals[e] += counts[e];
+            }
+        } else {
+            counts = totals;
+            fprintf(stream, "  %6s", "total");
+        }
+        for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+            if (perfctr_getEventName(e) != NULL) {
+                fprintf(stream, " %16llu", counts[e]);
+            }
+        }
+        if (hasIpc) {
+            fprintf(stream, " %6.2f",
+                    ((counts[PERFCTR_CYCLES] > 0) ?
+                     ((double)counts[PERFCTR_INSTRUCTIONS] /
+                      (double)counts[PERFCTR_CYCLES]) : 0.0));
+        }
+        if (hasMpki) {
+            fprintf(stream, " %9.3f",
+                    ((counts[PERFCTR_INSTRUCTIONS] > 0) ?
+                     (1000.0 * (double)counts[PERFCTR_LLC_MISSES] /
+                      (double)counts[PERFCTR_INSTRUCTIONS]) : 0.0));
+        }
+        fputc('\n', stream);
+    }
+
+    for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+        if (perfctr_getEventName(e) == NULL) {
+            break;
+        }
+    }
+    if (e < PERFCTR_NUM_EVENT) {
+        fprintf(stream, "  (events not listed could not be opened)\n");
+    }
+}
+
+
+/* =============================================================================
+ * TEST_PERFCTR
+ * =============================================================================
+ */
+#ifdef TEST_PERFCTR
+
+
+#include <sys/mman.h>
+#include "thread.h"
+
+#define NUM_THREAD (2)
+#define NUM_PAGE   (256)
+#define PAGE_SIZE  (4096)
+
+
+/* Fresh anonymous pages, so every call faults (malloc may reuse pages) */
+static void
+touchPages (void* argPtr)
+{
+    char* pages = (char*)mmap(NULL, NUM_PAGE * PAGE_SIZE,
+                              (PROT_READ | PROT_WRITE),
+                              (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+    long p;
+
+    assert(pages != MAP_FAILED);
+    for (p = 0; p < NUM_PAGE; p++) {
+        pages[p * PAGE_SIZE] = (char)p;
+    }
+    munmap(pages, NUM_PAGE * PAGE_SIZE);
+}
+
+
+int
+main ()
+{
+    long t;
+
+    puts("Starting...");
+
+    /* Disabled by default */
+    unsetenv("PERF_COUNTERS");
+    thread_startup(NUM_THREAD);
+    thread_start(touchPages, NULL);
+    assert(!perfctr_isEnabled());
+    for (t = 0; t < NUM_THREAD; t++) {
+        assert(perfctr_getCount(t, PERFCTR_PAGE_FAULTS) == 0);
+    }
+    thread_shutdown();
+
+    setenv("PERF_COUNTERS", "1", 1);
+    thread_startup(NUM_THREAD);
+    assert(perfctr_isEnabled());
+    assert(perfctr_getNumThread() == NUM_THREAD);
+    thread_start(touchPages, NULL);
+    thread_start(touchPages, NULL);
+    for (t = 0; t < NUM_THREAD; t++) {
+        if (perfctr_getEventName(PERFCTR_PAGE_FAULTS) != NULL) {
+            assert(perfctr_getCount(t, PERFCTR_PAGE_FAULTS) > 0);
+        }
+        if (perfctr_getEventName(PERFCTR_CYCLES) != NULL) {
+            assert(perfctr_getCount(t, PERFCTR_CYCLES) > 0);
+        }
+    }
+    thread_shutdown();
+
+    /* Totals survive shutdown for reporting */
+    for (t = 0; t < NUM_THREAD; t++) {
+        if (perfctr_getEventName(PERFCTR_CYCLES) != NULL) {
+            assert(perfctr_getCount(t, PERFCTR_CYCLES) > 0);
+        }
+    }
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_PERFCTR */
+
+
+/* =============================================================================
+ *
+ * End of perfctr.c
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,207 @@
+/* =============================================================================
+ *
+ * perfctr.h
+ * -- Per-thread performance counters around parallel regions
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef PERFCTR_H
+#define PERFCTR_H 1
+
+
+#include <stdio.h>
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Performance counters
+ *
+ * If the PERF_COUNTERS environment variable is set (to anything but "0"),
+ * every thread counts the events below with perf_event_open(2) while it runs
+ * the function passed to thread_start, and thread_shutdown prints the totals
+ * of each thread. Counts are scaled when the kernel multiplexes counters.
+ *
+ * Hardware events that cannot be opened (no PMU, as in most virtual
+ * machines, or perf_event_paranoid too high) are dropped; cycles fall back
+ * to the software task clock in nanoseconds. Kernel-mode counting is
+ * dropped first if that is what the kernel refuses.
+ * =============================================================================
+ */
+
+enum perfctr_event {
+    PERFCTR_CYCLES           = 0, /* or task clock (ns) */
+    PERFCTR_INSTRUCTIONS     = 1,
+    PERFCTR_LLC_MISSES       = 2,
+    PERFCTR_DTLB_MISSES      = 3,
+    PERFCTR_CONTEXT_SWITCHES = 4,
+    PERFCTR_PAGE_FAULTS      = 5,
+    PERFCTR_NUM_EVENT
+};
+
+enum perfctr_config {
+    PERFCTR_MAX_THREAD = 256,
+};
+
+
+/* =============================================================================
+ * perfctr_startup
+ * -- Called by thread_startup; probes which events can be counted
+ * =============================================================================
+ */
+void
+perfctr_startup (long numThread);
+
+
+/* =============================================================================
+ * perfctr_shutdown
+ * -- Called by thread_shutdown; prints per-thread totals and closes counters
+ * -- Totals stay readable until the next perfctr_startup
+ * =============================================================================
+ */
+void
+perfctr_shutdown ();
+
+
+/* =============================================================================
+ * perfctr_begin
+ * -- Called by each thread before its part of a parallel region
+ * =============================================================================
+ */
+void
+perfctr_begin (long threadId);
+
+
+/* =============================================================================
+ * perfctr_end
+ * =============================================================================
+ */
+void
+perfctr_end (long threadId);
+
+
+/* =============================================================================
+ * perfctr_isEnabled
+ * =============================================================================
+ */
+bool_t
+perfctr_isEnabled ();
+
+
+/* =============================================================================
+ * perfctr_getNumThread
+ * =============================================================================
+ */
+long
+perfctr_getNumThread ();
+
+
+/* =============================================================================
+ * perfctr_getEventName
+ * -- Returns NULL if the event could not be counted
+ * =============================================================================
+ */
+const char*
+perfctr_getEventName (long event);
+
+
+/* =============================================================================
+ * perfctr_getCount
+ * -- Sum over all parallel regions run by threadId
+ * =============================================================================
+ */
+unsigned long long
+perfctr_getCount (long threadId, long event);
+
+
+/* =============================================================================
+ * perfctr_print
+ * =============================================================================
+ */
+void
+perfctr_print (FILE* stream);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* PERFCTR_H */
+
+
+/* =============================================================================
+ *
+ * End of perfctr.h
+ *
+ * =============================================================================
+ */
@@ -72,6 +72,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include "memory.h"
 #include "random.h"
 #include "tm.h"
 #include "types.h"
@@ -103,7 +104,7 @@ queue_alloc (long initCapacity)
         long capacity = ((initCapacity < 2) ? 2 : initCapacity);
         queuePtr->elements = (void**)malloc(capacity * sizeof(void*));
         if (queuePtr->elements == NULL) {
-            free(queuePtr);
+            memory_free(queuePtr);
             return NULL;
         }
         queuePtr->pop      = capacity - 1;
@@ -128,7 +129,7 @@ Pqueue_alloc (long initCapacity)
         long capacity = ((initCapacity < 2) ? 2 : initCapacity);
         queuePtr->elements = (void**)P_MALLOC(capacity * sizeof(void*));
         if (queuePtr->elements == NULL) {
-            free(queuePtr);
+            P_FREE(queuePtr);
             return NULL;
         }
         queuePtr->pop      = capacity - 1;
@@ -153,7 +154,7 @@ TMqueue_alloc (TM_ARGDECL  long initCapacity)
         long capacity = ((initCapacity < 2) ? 2 : initCapacity);
         queuePtr->elements = (void**)TM_MALLOC(capacity * sizeof(void*));
         if (queuePtr->elements == NULL) {
-            free(queuePtr);
+            TM_FREE(queuePtr);
             return NULL;
         }
         queuePtr->pop      = capacity - 1;
@@ -172,8 +173,8 @@ TMqueue_alloc (TM_ARGDECL  long initCapacity)
 void
 queue_free (queue_t* queuePtr)
 {
-    free(queuePtr->elements);
-    free(queuePtr);
+    memory_free(queuePtr->elements);
+    memory_free(queuePtr);
 }
 
 
@@ -316,7 +317,7 @@ queue_push (queue_t* queuePtr, void* dataPtr)
             }
         }
 
-        free(elements);
+        memory_free(elements);
         queuePtr->elements = newElements;
         queuePtr->pop      = newCapacity - 1;
         queuePtr->capacity = newCapacity;
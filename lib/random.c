@@ -70,6 +70,7 @@
 
 
 #include <stdlib.h>
+#include "memory.h"
 #include "mt19937ar.h"
 #include "random.h"
 #include "tm.h"
@@ -118,7 +119,7 @@ Prandom_alloc (void)
 void
 random_free (random_t* randomPtr)
 {
-    free(randomPtr);
+    memory_free(randomPtr);
 }
 
 
@@ -104,6 +104,8 @@ struct rbtree {
     long (*compare)(const void*, const void*);   /* returns {-1,0,1}, 0 -> equal */
 };
 
+static memory_type_t global_nodeType = MEMORY_TYPE_INITIALIZER(sizeof(node_t));
+
 #define LDA(a)              *(a)
 #define STA(a,v)            *(a) = (v)
 #define LDV(a)              (a)
@@ -1305,7 +1307,7 @@ static void
 releaseNode (node_t* n)
 {
 #ifndef SIMULATOR
-    free(n);
+    memory_free(n);
 #endif    
 }
 
@@ -1359,7 +1361,7 @@ void
 rbtree_free (rbtree_t* r)
 {
     freeNode(r->root);
-    free(r);
+    memory_free(r);
 }
 
 
@@ -1382,7 +1384,7 @@ TMrbtree_free (TM_ARGDECL  rbtree_t* r)
 static node_t*
 getNode ()
 {
-    node_t* n = (node_t*)malloc(sizeof(*n));
+    node_t* n = (node_t*)memory_allocType(&global_nodeType);
     return n;
 }
 
@@ -1394,7 +1396,7 @@ getNode ()
 static node_t*
 TMgetNode (TM_ARGDECL_ALONE)
 {
-    node_t* n = (node_t*)TM_MALLOC(sizeof(*n));
+    node_t* n = (node_t*)TM_MALLOC_TYPE(&global_nodeType);
     return n;
 }
 
@@ -0,0 +1,605 @@
+/* =============================================================================
+ *
+ * report.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "perfctr.h"
+#include "report.h"
+#include "timer.h"
+#include "types.h"
+
+#if (defined(STM) && !defined(OTM)) || defined(LOCK)
+#  define REPORT_TMSTATS
+#  include "cm.h"
+#  include "tmstats.h"
+#  if defined(STM) || defined(LOCK_STRIPED)
+#    define REPORT_CM
+#  endif
+#endif
+
+#if defined(HTM)
+#  define REPORT_FLAVOR                 "htm"
+#elif defined(STM) && defined(OTM)
+#  define REPORT_FLAVOR                 "stm (OpenTM)"
+#elif defined(STM)
+#  define REPORT_FLAVOR                 "stm"
+#elif defined(LOCK_STRIPED)
+#  define REPORT_FLAVOR                 "lock (striped)"
+#elif defined(LOCK)
+#  define REPORT_FLAVOR                 "lock (global)"
+#else
+#  define REPORT_FLAVOR                 "seq"
+#endif
+
+
+enum report_tuning {
+    REPORT_MAX_NAME    = 64,
+    REPORT_MAX_STRING  = 256,
+    REPORT_MAX_COMMAND = 1024,
+};
+
+typedef struct report_entry {
+    char name[REPORT_MAX_NAME];
+    bool_t isString;
+    double value;
+    char string[REPORT_MAX_STRING];
+} report_entry_t;
+
+static char           global_benchmark[REPORT_MAX_NAME];
+static char           global_command[REPORT_MAX_COMMAND];
+static report_entry_t global_paramEntries[REPORT_MAX_ENTRY];
+static long           global_numParam = 0;
+static report_entry_t global_timeEntries[REPORT_MAX_ENTRY];
+static long           global_numTime = 0;
+static char           global_throughputUnit[REPORT_MAX_NAME];
+static double         global_throughputNumItem = 0.0;
+static double         global_throughputSeconds = 0.0;
+static long           global_verified = -1; /* -1 = unknown */
+
+
+/* =============================================================================
+ * copyString
+ * -- Truncates to size - 1 characters
+ * =============================================================================
+ */
+static void
+copyString (char* dst, const char* src, long size)
+{
+    strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+}
+
+
+/* =============================================================================
+ * writeString
+ * =============================================================================
+ */
+static void
+writeString (FILE* stream, const char* string)
+{
+    const unsigned char* c;
+
+    fputc('"', stream);
+    for (c = (const unsigned char*)string; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', stream);
+            fputc(*c, stream);
+        } else if (*c < 0x20) {
+            fprintf(stream, "\\u%04x", *c);
+        } else {
+            fputc(*c, stream);
+        }
+    }
+    fputc('"', stream);
+}
+
+
+/* =============================================================================
+ * writeNumber
+ * -- JSON has no NaN or infinity, so those become null
+ * =============================================================================
+ */
+static void
+writeNumber (FILE* stream, double value)
+{
+    if (isfinite(value)) {
+        fprintf(stream, "%.9g", value);
+    } else {
+        fputs("null", stream);
+    }
+}
+
+
+/* =============================================================================
+ * writeEntries
+ * =============================================================================
+ */
+static void
+writeEntries (FILE* stream, report_entry_t* entries, long numEntry)
+{
+    long e;
+
+    fputc('{', stream);
+    for (e = 0; e < numEntry; e++) {
+        fputs(((e == 0) ? "\n    " : ",\n    "), stream);
+        writeString(stream, entries[e].name);
+        fputs(": ", stream);
+        if (entries[e].isString) {
+            writeString(stream, entries[e].string);
+        } else {
+            writeNumber(stream, entries[e].value);
+        }
+    }
+    fputs(((numEntry == 0) ? "}" : "\n  }"), stream);
+}
+
+
+/* =============================================================================
+ * writePhases
+ * =============================================================================
+ */
+static void
+writePhases (FILE* stream)
+{
+    long numPhase = timer_getNumPhase();
+    long numWritten = 0;
+    long p;
+
+    fputc('[', stream);
+    for (p = 0; p < numPhase; p++) {
+        timer_summary_t summary;
+        timer_getPhaseSummary(p, &summary);
+        if (summary.numThread == 0) {
+            continue;
+        }
+        fputs(((numWritten == 0) ? "\n    {" : ",\n    {"), stream);
+        fputs("\"name\": ", stream);
+        writeString(stream, summary.name);
+        fprintf(stream, ", \"threads\": %li, \"calls\": %lu",
+                summary.numThread, summary.numCall);
+        fputs(", \"min_s\": ", stream);
+        writeNumber(stream, summary.minSeconds);
+        fputs(", \"max_s\": ", stream);
+        writeNumber(stream, summary.maxSeconds);
+        fputs(", \"mean_s\": ", stream);
+        writeNumber(stream, summary.meanSeconds);
+        fputc('}', stream);
+        numWritten++;
+    }
+    fputs(((numWritten == 0) ? "]" : "\n  ]"), stream);
+}
+
+
+/* =============================================================================
+ * writeThroughput
+ * =============================================================================
+ */
+static void
+writeThroughput (FILE* stream)
+{
+    char unit[REPORT_MAX_NAME + 2];
+
+    if (global_throughputUnit[0] == '\0') {
+        fputs("null", stream);
+        return;
+    }
+
+    sprintf(unit, "%s/s", global_throughputUnit);
+    fputs("{\"value\": ", stream);
+    writeNumber(stream, global_throughputNumItem / global_throughputSeconds);
+    fputs(", \"unit\": ", stream);
+    writeString(stream, unit);
+    fputs(", \"items\": ", stream);
+    writeNumber(stream, global_throughputNumItem);
+    fputs(", \"seconds\": ", stream);
+    writeNumber(stream, global_throughputSeconds);
+    fputc('}', stream);
+}
+
+
+/* =============================================================================
+ * writeCounters
+ * =============================================================================
+ */
+static void
+writeCounters (FILE* stream)
+{
+    long numThread = perfctr_getNumThread();
+    long numWritten = 0;
+    long e;
+
+    if (!perfctr_isEnabled()) {
+        fputs("null", stream);
+        return;
+    }
+
+    fputc('{', stream);
+    for (e = 0; e < PERFCTR_NUM_EVENT; e++) {
+        const char* name = perfctr_getEventName(e);
+        unsigned long long total = 0;
+        long t;
+        if (name == NULL) {
+            continue;
+        }
+        fputs(((numWritten == 0) ? "\n    " : ",\n    "), stream);
+        writeString(stream, name);
+        fputs(": {\"threads\": [", stream);
+        for (t = 0; t < numThread; t++) {
+            unsigned long long count = perfctr_getCount(t, e);
+            fprintf(stream, ((t == 0) ? "%llu" : ", %llu"), count);
+            total += count;
+        }
+        fprintf(stream, "], \"total\": %llu}", total);
+        numWritten++;
+    }
+    fputs(((numWritten == 0) ? "}" : "\n  }"), stream);
+}
+
+
+/* =============================================================================
+ * writeTmStats
+ * =============================================================================
+ */
+static void
+writeTmStats (FILE* stream)
+{
+#ifdef REPORT_TMSTATS
+    unsigned long numCommit;
+    unsigned long numAbort;
+
+    tmstats_getTotals(&numCommit, &numAbort);
+    fprintf(stream, "{\"commits\": %lu, \"aborts\": %lu, \"irrevocable\": %lu",
+            numCommit, numAbort, cm_getNumIrrevocable());
+#  ifdef REPORT_CM
+    fputs(", \"contention_manager\": ", stream);
+    writeString(stream, cm_getPolicyName());
+#  endif
+    fputc('}', stream);
+#else
+    fputs("null", stream);
+#endif
+}
+
+
+/* =============================================================================
+ * report_startup
+ * =============================================================================
+ */
+void
+report_startup (const char* benchmark, int argc, char** argv)
+{
+    long length = 0;
+    int i;
+
+    copyString(global_benchmark, benchmark, REPORT_MAX_NAME);
+
+    global_command[0] = '\0';
+    for (i = 0; i < argc; i++) {
+        long argLength = (long)strlen(argv[i]);
+        if (length + argLength + 2 > REPORT_MAX_COMMAND) {
+            break;
+        }
+        if (i > 0) {
+            global_command[length++] = ' ';
+        }
+        memcpy(&global_command[length], argv[i], argLength + 1);
+        length += argLength;
+    }
+
+    global_numParam = 0;
+    global_numTime = 0;
+    global_throughputUnit[0] = '\0';
+    global_throughputNumItem = 0.0;
+    global_throughputSeconds = 0.0;
+    global_verified = -1;
+}
+
+
+/* =============================================================================
+ * report_addParam
+ * =============================================================================
+ */
+void
+report_addParam (const char* name, double value)
+{
+    report_entry_t* entryPtr;
+
+    assert(global_numParam < REPORT_MAX_ENTRY);
+    entryPtr = &global_paramEntries[global_numParam++];
+    copyString(entryPtr->name, name, REPORT_MAX_NAME);
+    entryPtr->isString = FALSE;
+    entryPtr->value = value;
+}
+
+
+/* =============================================================================
+ * report_addParamString
+ * =============================================================================
+ */
+void
+report_addParamString (const char* name, const char* value)
+{
+    report_entry_t* entryPtr;
+
+    assert(global_numParam < REPORT_MAX_ENTRY);
+    entryPtr = &global_paramEntries[global_numParam++];
+    copyString(entryPtr->name, name, REPORT_MAX_NAME);
+    entryPtr->isString = TRUE;
+    copyString(entryPtr->string,
+               ((value != NULL) ? value : ""),
+               REPORT_MAX_STRING);
+}
+
+
+/* =============================================================================
+ * report_addTime
+ * =============================================================================
+ */
+void
+report_addTime (const char* name, double seconds)
+{
+    report_entry_t* entryPtr;
+
+    assert(global_numTime < REPORT_MAX_ENTRY);
+    entryPtr = &global_timeEntries[global_numTime++];
+    copyString(entryPtr->name, name, REPORT_MAX_NAME);
+    entryPtr->isString = FALSE;
+    entryPtr->value = seconds;
+}
+
+
+/* =============================================================================
+ * report_setThroughput
+ * =============================================================================
+ */
+void
+report_setThroughput (const char* unit, double numItem, double seconds)
+{
+    copyString(global_throughputUnit, unit, REPORT_MAX_NAME);
+    global_throughputNumItem = numItem;
+    global_throughputSeconds = seconds;
+}
+
+
+/* =============================================================================
+ * report_setVerified
+ * =============================================================================
+ */
+void
+report_setVerified (bool_t isVerified)
+{
+    global_verified = (isVerified ? 1 : 0);
+}
+
+
+/* =============================================================================
+ * report_write
+ * =============================================================================
+ */
+bool_t
+report_write ()
+{
+    const char* path = getenv("REPORT_JSON");
+    FILE* stream;
+
+    if (path == NULL || path[0] == '\0') {
+        return TRUE;
+    }
+
+    stream = fopen(path, "w");
+    if (stream == NULL) {
+        fprintf(stderr, "Cannot write results to %s\n", path);
+        return FALSE;
+    }
+
+    fputs("{\n  \"benchmark\": ", stream);
+    writeString(stream, global_benchmark);
+    fputs(",\n  \"flavor\": ", stream);
+    writeString(stream, REPORT_FLAVOR);
+    fputs(",\n  \"command\": ", stream);
+    writeString(stream, global_command);
+    fputs(",\n  \"params\": ", stream);
+    writeEntries(stream, global_paramEntries, global_numParam);
+    fputs(",\n  \"times_s\": ", stream);
+    writeEntries(stream, global_timeEntries, global_numTime);
+    fputs(",\n  \"phases\": ", stream);
+    writePhases(stream);
+    fputs(",\n  \"throughput\": ", stream);
+    writeThroughput(stream);
+    fputs(",\n  \"verified\": ", stream);
+    fputs(((global_verified < 0) ? "null" :
+           ((global_verified > 0) ? "true" : "false")), stream);
+    fputs(",\n  \"tm\": ", stream);
+    writeTmStats(stream);
+    fputs(",\n  \"counters\": ", stream);
+    writeCounters(stream);
+    fputs("\n}\n", stream);
+
+    if (fclose(stream) != 0) {
+        fprintf(stderr, "Cannot write results to %s\n", path);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TEST_REPORT
+ * =============================================================================
+ */
+#ifdef TEST_REPORT
+
+
+#include <unistd.h>
+#include "thread.h"
+
+
+static void
+timeOnePhase (void* argPtr)
+{
+    TIMER_PHASE_BEGIN("test phase");
+    TIMER_PHASE_END();
+}
+
+
+static char*
+readFile (const char* path)
+{
+    static char buffer[8192];
+    FILE* stream = fopen(path, "r");
+    size_t size;
+
+    assert(stream != NULL);
+    size = fread(buffer, 1, sizeof(buffer) - 1, stream);
+    buffer[size] = '\0';
+    fclose(stream);
+
+    return buffer;
+}
+
+
+int
+main ()
+{
+    char path[] = "/tmp/test_report.XXXXXX";
+    char* argv[] = {"./test", "-a1", "-i", "in\"put"};
+    char* json;
+    int fd;
+
+    puts("Starting...");
+
+    fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    thread_startup(2);
+    thread_start(timeOnePhase, NULL);
+    thread_shutdown();
+
+    /* Nothing is written without REPORT_JSON */
+    unsetenv("REPORT_JSON");
+    report_startup("test", 4, argv);
+    assert(report_write());
+    assert(readFile(path)[0] == '\0');
+
+    setenv("REPORT_JSON", path, 1);
+    report_startup("test", 4, argv);
+    report_addParam("threads", 2);
+    report_addParamString("input", "in\"put");
+    report_addTime("total", 0.5);
+    report_setThroughput("items", 100, 0.5);
+    assert(report_write());
+
+    json = readFile(path);
+    puts(json);
+    assert(strstr(json, "\"benchmark\": \"test\"") != NULL);
+    assert(strstr(json, "\"flavor\": \"seq\"") != NULL);
+    assert(strstr(json, "\"command\": \"./test -a1 -i in\\\"put\"") != NULL);
+    assert(strstr(json, "\"threads\": 2") != NULL);
+    assert(strstr(json, "\"input\": \"in\\\"put\"") != NULL);
+    assert(strstr(json, "\"total\": 0.5") != NULL);
+    assert(strstr(json, "{\"name\": \"test phase\", \"threads\": 2") != NULL);
+    assert(strstr(json, "\"value\": 200, \"unit\": \"items/s\"") != NULL);
+    assert(strstr(json, "\"verified\": null") != NULL);
+    assert(strstr(json, "\"tm\": null") != NULL);
+    assert(strstr(json, "\"counters\": null") != NULL);
+
+    report_setVerified(FALSE);
+    report_setThroughput("items", 100, 0.0);
+    assert(report_write());
+    json = readFile(path);
+    assert(strstr(json, "\"verified\": false") != NULL);
+    assert(strstr(json, "\"value\": null") != NULL);
+
+    setenv("REPORT_JSON", "/nonexistent/directory/file.json", 1);
+    assert(!report_write());
+
+    unlink(path);
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_REPORT */
+
+
+/* =============================================================================
+ *
+ * End of report.c
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,176 @@
+/* =============================================================================
+ *
+ * report.h
+ * -- Machine-readable benchmark results
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef REPORT_H
+#define REPORT_H 1
+
+
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Benchmark results
+ *
+ * Each MAIN records its parameters, the times it measures, its throughput
+ * in its own units (e.g., transactions per second), and whether its output
+ * was verified. If the REPORT_JSON environment variable names a file,
+ * report_write() writes these as one JSON object, together with the TM
+ * flavor, the command line, the commit and abort counts of the STM and lock
+ * flavors, the phase times from lib/timer.h, and the per-thread counts from
+ * lib/perfctr.h.
+ * =============================================================================
+ */
+
+enum report_config {
+    REPORT_MAX_ENTRY = 32, /* per kind: parameters, times */
+};
+
+
+/* =============================================================================
+ * report_startup
+ * =============================================================================
+ */
+void
+report_startup (const char* benchmark, int argc, char** argv);
+
+
+/* =============================================================================
+ * report_addParam
+ * =============================================================================
+ */
+void
+report_addParam (const char* name, double value);
+
+
+/* =============================================================================
+ * report_addParamString
+ * =============================================================================
+ */
+void
+report_addParamString (const char* name, const char* value);
+
+
+/* =============================================================================
+ * report_addTime
+ * =============================================================================
+ */
+void
+report_addTime (const char* name, double seconds);
+
+
+/* =============================================================================
+ * report_setThroughput
+ * -- Reported as numItem / seconds in unit per second
+ * =============================================================================
+ */
+void
+report_setThroughput (const char* unit, double numItem, double seconds);
+
+
+/* =============================================================================
+ * report_setVerified
+ * -- Reported as null if never called
+ * =============================================================================
+ */
+void
+report_setVerified (bool_t isVerified);
+
+
+/* =============================================================================
+ * report_write
+ * -- Call after TM_SHUTDOWN; does nothing unless REPORT_JSON is set
+ * -- Returns FALSE if the file could not be written
+ * =============================================================================
+ */
+bool_t
+report_write ();
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* REPORT_H */
+
+
+/* =============================================================================
+ *
+ * End of report.h
+ *
+ * =============================================================================
+ */
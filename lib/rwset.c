@@ -0,0 +1,579 @@
+/* =============================================================================
+ *
+ * rwset.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rwset.h"
+#include "timer.h"
+#include "types.h"
+
+
+enum rwset_metric {
+    RWSET_READS       = 0,
+    RWSET_WRITES      = 1,
+    RWSET_READ_LINES  = 2,
+    RWSET_WRITE_LINES = 3,
+    RWSET_NS          = 4,
+    RWSET_NUM_METRIC
+};
+
+enum rwset_tuning {
+    RWSET_NUM_BUCKET    = 64, /* 0, 1, 2-3, 4-7, ... */
+    RWSET_INIT_CAPACITY = 1024,
+};
+
+static const char* global_metricNames[RWSET_NUM_METRIC] = {
+    [RWSET_READS]       = "reads",
+    [RWSET_WRITES]      = "writes",
+    [RWSET_READ_LINES]  = "read lines",
+    [RWSET_WRITE_LINES] = "write lines",
+    [RWSET_NS]          = "time (ns)",
+};
+
+typedef struct rwset_stat {
+    unsigned long long sum;
+    unsigned long long max;
+    unsigned long buckets[RWSET_NUM_BUCKET];
+} rwset_stat_t;
+
+typedef struct rwset_count {
+    unsigned long numRegion;
+    rwset_stat_t stats[RWSET_NUM_METRIC];
+} rwset_count_t;
+
+/*
+ * Set of line addresses; a slot is in use if its stamp is the current one,
+ * so clearing is just a stamp increment
+ */
+typedef struct rwset_lines {
+    uintptr_t* lines;
+    unsigned long* stamps;
+    long capacity; /* power of 2 */
+    long size;
+    unsigned long stamp;
+} rwset_lines_t;
+
+static rwset_site_t*      global_sites[RWSET_MAX_SITE];
+static long               global_numSite = 0;
+static rwset_count_t      global_counts[RWSET_MAX_SITE];
+static rwset_site_t*      global_sitePtr = NULL; /* of current region */
+static long               global_depth = 0;
+static unsigned long long global_values[RWSET_NUM_METRIC];
+static unsigned long long global_startNs;
+static rwset_lines_t      global_readLines;
+static rwset_lines_t      global_writeLines;
+
+
+/* =============================================================================
+ * allocLines
+ * =============================================================================
+ */
+static void
+allocLines (rwset_lines_t* setPtr, long capacity)
+{
+    setPtr->lines = (uintptr_t*)malloc(capacity * sizeof(uintptr_t));
+    assert(setPtr->lines);
+    setPtr->stamps = (unsigned long*)calloc(capacity, sizeof(unsigned long));
+    assert(setPtr->stamps);
+    setPtr->capacity = capacity;
+    setPtr->size = 0;
+    setPtr->stamp = 1;
+}
+
+
+/* =============================================================================
+ * freeLines
+ * =============================================================================
+ */
+static void
+freeLines (rwset_lines_t* setPtr)
+{
+    free(setPtr->lines);
+    free(setPtr->stamps);
+    setPtr->lines = NULL;
+    setPtr->stamps = NULL;
+    setPtr->capacity = 0;
+}
+
+
+/* =============================================================================
+ * insertLine
+ * -- Returns TRUE if line was not already in the set
+ * =============================================================================
+ */
+static bool_t
+insertLine (rwset_lines_t* setPtr, uintptr_t line)
+{
+    unsigned long stamp;
+    long mask;
+    long i;
+
+    if (2 * (setPtr->size + 1) > setPtr->capacity) {
+        rwset_lines_t old = *setPtr;
+        long j;
+        allocLines(setPtr, 2 * old.capacity);
+        for (j = 0; j < old.capacity; j++) {
+            if (old.stamps[j] == old.stamp) {
+                insertLine(setPtr, old.lines[j]);
+            }
+        }
+        freeLines(&old);
+    }
+
+    stamp = setPtr->stamp;
+    mask = setPtr->capacity - 1;
+    i = (long)(((unsigned long long)line * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    while (setPtr->stamps[i] == stamp) {
+        if (setPtr->lines[i] == line) {
+            return FALSE;
+        }
+        i = (i + 1) & mask;
+    }
+    setPtr->lines[i] = line;
+    setPtr->stamps[i] = stamp;
+    setPtr->size++;
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * clearLines
+ * =============================================================================
+ */
+static void
+clearLines (rwset_lines_t* setPtr)
+{
+    setPtr->stamp++;
+    setPtr->size = 0;
+}
+
+
+/* =============================================================================
+ * addAccess
+ * =============================================================================
+ */
+static void
+addAccess (rwset_lines_t* setPtr, long lineMetric,
+           volatile void* addr, long size)
+{
+    uintptr_t first = (uintptr_t)addr / RWSET_LINE_SIZE;
+    uintptr_t last = ((uintptr_t)addr + size - 1) / RWSET_LINE_SIZE;
+    uintptr_t line;
+
+    for (line = first; line <= last; line++) {
+        if (insertLine(setPtr, line)) {
+            global_values[lineMetric]++;
+        }
+    }
+}
+
+
+/* =============================================================================
+ * getBucket
+ * -- 0 for 0, else 1 + floor(log2(value)), clamped to RWSET_NUM_BUCKET - 1
+ * =============================================================================
+ */
+static inline long
+getBucket (unsigned long long value)
+{
+    long bucket = ((value == 0) ? 0 : (64 - __builtin_clzll(value)));
+
+    return ((bucket < RWSET_NUM_BUCKET) ? bucket : (RWSET_NUM_BUCKET - 1));
+}
+
+
+/* =============================================================================
+ * getPercentile
+ * -- Upper bound of the bucket holding the given fraction of regions
+ * =============================================================================
+ */
+static unsigned long long
+getPercentile (rwset_stat_t* statPtr, unsigned long numRegion, double fraction)
+{
+    unsigned long rank = (unsigned long)(fraction * (double)numRegion + 0.999999);
+    unsigned long numSeen = 0;
+    long b;
+
+    for (b = 0; b < RWSET_NUM_BUCKET; b++) {
+        numSeen += statPtr->buckets[b];
+        if (numSeen >= rank && b < (RWSET_NUM_BUCKET - 1)) {
+            unsigned long long bound = ((b == 0) ? 0 : ((2ULL << (b - 1)) - 1));
+            return ((bound < statPtr->max) ? bound : statPtr->max);
+        }
+    }
+
+    return statPtr->max;
+}
+
+
+/* =============================================================================
+ * compareByRegions
+ * =============================================================================
+ */
+static int
+compareByRegions (const void* aPtr, const void* bPtr)
+{
+    unsigned long a = global_counts[*(const long*)aPtr].numRegion;
+    unsigned long b = global_counts[*(const long*)bPtr].numRegion;
+
+    return ((a < b) ? 1 : ((a > b) ? -1 : 0));
+}
+
+
+/* =============================================================================
+ * rwset_startup
+ * =============================================================================
+ */
+void
+rwset_startup ()
+{
+    long s;
+
+    for (s = 0; s < global_numSite; s++) {
+        global_sites[s]->id = -1;
+    }
+    global_numSite = 0;
+    global_sitePtr = NULL;
+    global_depth = 0;
+
+    allocLines(&global_readLines, RWSET_INIT_CAPACITY);
+    allocLines(&global_writeLines, RWSET_INIT_CAPACITY);
+}
+
+
+/* =============================================================================
+ * rwset_shutdown
+ * =============================================================================
+ */
+void
+rwset_shutdown ()
+{
+    rwset_print(stdout);
+    freeLines(&global_readLines);
+    freeLines(&global_writeLines);
+}
+
+
+/* =============================================================================
+ * rwset_begin
+ * =============================================================================
+ */
+void
+rwset_begin (rwset_site_t* sitePtr)
+{
+    long m;
+
+    if (global_depth++ > 0) {
+        return;
+    }
+
+    if (sitePtr->id < 0) {
+        long id = global_numSite;
+        if (id < RWSET_MAX_SITE) {
+            global_sites[id] = sitePtr;
+            memset(&global_counts[id], 0, sizeof(rwset_count_t));
+            global_numSite = id + 1;
+        } else {
+            id = RWSET_MAX_SITE - 1; /* overflow shares the last slot */
+        }
+        sitePtr->id = id;
+    }
+
+    global_sitePtr = sitePtr;
+    for (m = 0; m < RWSET_NUM_METRIC; m++) {
+        global_values[m] = 0;
+    }
+    clearLines(&global_readLines);
+    clearLines(&global_writeLines);
+    global_startNs = timer_getNanoseconds();
+}
+
+
+/* =============================================================================
+ * rwset_end
+ * =============================================================================
+ */
+void
+rwset_end ()
+{
+    rwset_count_t* countPtr;
+    long m;
+
+    assert(global_depth > 0);
+    if (--global_depth > 0) {
+        return;
+    }
+
+    global_values[RWSET_NS] = timer_getNanoseconds() - global_startNs;
+
+    countPtr = &global_counts[global_sitePtr->id];
+    countPtr->numRegion++;
+    for (m = 0; m < RWSET_NUM_METRIC; m++) {
+        rwset_stat_t* statPtr = &countPtr->stats[m];
+        unsigned long long value = global_values[m];
+        statPtr->sum += value;
+        if (value > statPtr->max) {
+            statPtr->max = value;
+        }
+        statPtr->buckets[getBucket(value)]++;
+    }
+
+    global_sitePtr = NULL;
+}
+
+
+/* =============================================================================
+ * rwset_read
+ * =============================================================================
+ */
+void
+rwset_read (volatile void* addr, long size)
+{
+    if (global_depth == 0) {
+        return;
+    }
+    global_values[RWSET_READS]++;
+    addAccess(&global_readLines, RWSET_READ_LINES, addr, size);
+}
+
+
+/* =============================================================================
+ * rwset_write
+ * =============================================================================
+ */
+void
+rwset_write (volatile void* addr, long size)
+{
+    if (global_depth == 0) {
+        return;
+    }
+    global_values[RWSET_WRITES]++;
+    addAccess(&global_writeLines, RWSET_WRITE_LINES, addr, size);
+}
+
+
+/* =============================================================================
+ * rwset_print
+ * -- Sites ordered by number of regions
+ * =============================================================================
+ */
+void
+rwset_print (FILE* stream)
+{
+    long order[RWSET_MAX_SITE];
+    long numSite = global_numSite;
+    long i;
+
+    if (numSite == 0) {
+        return;
+    }
+
+    for (i = 0; i < numSite; i++) {
+        order[i] = i;
+    }
+    qsort(order, numSite, sizeof(long), &compareByRegions);
+
+    fprintf(stream, "Read/write sets per atomic block (%i-byte lines;"
+            " percentiles are power-of-2 upper bounds):\n", RWSET_LINE_SIZE);
+    for (i = 0; i < numSite; i++) {
+        long id = order[i];
+        rwset_site_t* sitePtr = global_sites[id];
+        rwset_count_t* countPtr = &global_counts[id];
+        long m;
+        fprintf(stream, "  %s:%li%s, %lu regions\n",
+                sitePtr->file,
+                sitePtr->line,
+                (sitePtr->isReadOnly ? " (read-only)" : ""),
+                countPtr->numRegion);
+        fprintf(stream, "    %-12s %12s %12s %12s %12s %12s\n",
+                "", "mean", "p50", "p90", "p99", "max");
+        for (m = 0; m < RWSET_NUM_METRIC; m++) {
+            rwset_stat_t* statPtr = &countPtr->stats[m];
+            fprintf(stream, "    %-12s %12.1f %12llu %12llu %12llu %12llu\n",
+                    global_metricNames[m],
+                    ((double)statPtr->sum / (double)countPtr->numRegion),
+                    getPercentile(statPtr, countPtr->numRegion, 0.50),
+                    getPercentile(statPtr, countPtr->numRegion, 0.90),
+                    getPercentile(statPtr, countPtr->numRegion, 0.99),
+                    statPtr->max);
+        }
+    }
+}
+
+
+/* =============================================================================
+ * TEST_RWSET
+ * =============================================================================
+ */
+#ifdef TEST_RWSET
+
+
+#define NUM_ELEMENT (8192)
+
+static long global_array[NUM_ELEMENT]
+    __attribute__ ((aligned (RWSET_LINE_SIZE)));
+
+
+static void
+readRange (long start, long stop, bool_t isReadOnly)
+{
+    long sum = 0;
+    long i;
+
+    if (isReadOnly) {
+        RWSET_BEGIN(TRUE);
+        for (i = start; i < stop; i++) {
+            sum += RWSET_READ(global_array[i]);
+        }
+        RWSET_END();
+    } else {
+        RWSET_BEGIN(FALSE);
+        for (i = start; i < stop; i++) {
+            sum += RWSET_READ(global_array[i]);
+        }
+        RWSET_WRITE(global_array[0], sum);
+        RWSET_WRITE(global_array[1], sum);
+        RWSET_END();
+    }
+}
+
+
+int
+main ()
+{
+    long linePerElement = RWSET_LINE_SIZE / sizeof(long);
+    rwset_count_t* countPtr;
+
+    puts("Starting...");
+
+    rwset_startup();
+
+    /* Accesses outside regions are ignored */
+    RWSET_WRITE(global_array[0], 1);
+    assert(global_numSite == 0);
+
+    readRange(0, 2 * linePerElement, FALSE);
+    assert(global_numSite == 1);
+    countPtr = &global_counts[0];
+    assert(countPtr->numRegion == 1);
+    assert(countPtr->stats[RWSET_READS].sum == 2 * linePerElement);
+    assert(countPtr->stats[RWSET_READ_LINES].sum == 2);
+    assert(countPtr->stats[RWSET_WRITES].sum == 2);
+    assert(countPtr->stats[RWSET_WRITE_LINES].sum == 1);
+
+    /* Large enough to grow the line sets */
+    readRange(0, NUM_ELEMENT, FALSE);
+    assert(countPtr->numRegion == 2);
+    assert(countPtr->stats[RWSET_READ_LINES].max == NUM_ELEMENT / linePerElement);
+    assert(countPtr->stats[RWSET_WRITE_LINES].max == 1);
+
+    /* Same lines again count again in a new region */
+    readRange(0, NUM_ELEMENT, TRUE);
+    assert(global_numSite == 2);
+    assert(global_sites[1]->isReadOnly);
+    assert(global_counts[1].stats[RWSET_READ_LINES].sum ==
+           NUM_ELEMENT / linePerElement);
+    assert(global_counts[1].stats[RWSET_WRITES].sum == 0);
+
+    /* Nested regions fold into the outer one */
+    RWSET_BEGIN(FALSE);
+    readRange(0, linePerElement, TRUE);
+    (void)RWSET_READ(global_array[NUM_ELEMENT - 1]);
+    RWSET_END();
+    assert(global_numSite == 3);
+    assert(global_counts[1].numRegion == 1);
+    assert(global_counts[2].stats[RWSET_READ_LINES].sum == 2);
+
+    assert(getPercentile(&countPtr->stats[RWSET_WRITES], 2, 0.5) == 2);
+    assert(getPercentile(&countPtr->stats[RWSET_READ_LINES], 2, 0.99) ==
+           NUM_ELEMENT / linePerElement);
+
+    rwset_shutdown();
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_RWSET */
+
+
+/* =============================================================================
+ *
+ * End of rwset.c
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,209 @@
+/* =============================================================================
+ *
+ * rwset.h
+ * -- Read/write-set profiler for the sequential build
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef RWSET_H
+#define RWSET_H 1
+
+
+#include <stdio.h>
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Read/write-set profiler
+ *
+ * Building the sequential flavor with RWSET_PROFILE=yes turns every
+ * TM_BEGIN..TM_END into a profiled region: TM_SHARED_READ* and
+ * TM_SHARED_WRITE* count accesses and the distinct cache lines
+ * (RWSET_LINE_SIZE bytes) read and written, and the region is timed. At
+ * TM_SHUTDOWN, the distribution of each quantity is printed per TM_BEGIN
+ * site. These are the read-set and write-set sizes an HTM would have to
+ * buffer and an STM would have to log for a single-threaded run.
+ *
+ * Only one thread may run transactions (run the benchmark with 1 thread).
+ * =============================================================================
+ */
+
+#ifndef RWSET_LINE_SIZE
+#  define RWSET_LINE_SIZE               64
+#endif
+
+enum rwset_config {
+    RWSET_MAX_SITE = 256,
+};
+
+typedef struct rwset_site {
+    const char* file;
+    long line;
+    bool_t isReadOnly;
+    long id; /* -1 until first executed */
+} rwset_site_t;
+
+#define RWSET_SITE_INIT(isReadOnly)     { __FILE__, __LINE__, isReadOnly, -1 }
+
+#define RWSET_BEGIN(isReadOnly)         do { \
+                                            static rwset_site_t RWSET_SITE = \
+                                                RWSET_SITE_INIT(isReadOnly); \
+                                            rwset_begin(&RWSET_SITE)
+#define RWSET_END()                         rwset_end(); \
+                                        } while (0)
+
+#define RWSET_READ(var)                 (rwset_read((volatile void*)&(var), \
+                                                    sizeof(var)), \
+                                         (var))
+#define RWSET_WRITE(var, val)           ({ \
+                                            rwset_write((volatile void*)&(var), \
+                                                        sizeof(var)); \
+                                            var = val; \
+                                            var; \
+                                        })
+
+
+/* =============================================================================
+ * rwset_startup
+ * =============================================================================
+ */
+void
+rwset_startup ();
+
+
+/* =============================================================================
+ * rwset_shutdown
+ * -- Prints the per-site distributions to stdout
+ * =============================================================================
+ */
+void
+rwset_shutdown ();
+
+
+/* =============================================================================
+ * rwset_begin
+ * -- Nested regions are folded into the outermost one
+ * =============================================================================
+ */
+void
+rwset_begin (rwset_site_t* sitePtr);
+
+
+/* =============================================================================
+ * rwset_end
+ * =============================================================================
+ */
+void
+rwset_end ();
+
+
+/* =============================================================================
+ * rwset_read
+ * -- Ignored outside a region
+ * =============================================================================
+ */
+void
+rwset_read (volatile void* addr, long size);
+
+
+/* =============================================================================
+ * rwset_write
+ * -- Ignored outside a region
+ * =============================================================================
+ */
+void
+rwset_write (volatile void* addr, long size);
+
+
+/* =============================================================================
+ * rwset_print
+ * =============================================================================
+ */
+void
+rwset_print (FILE* stream);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* RWSET_H */
+
+
+/* =============================================================================
+ *
+ * End of rwset.h
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,991 @@
+/* =============================================================================
+ *
+ * skiplist.c
+ * -- Skip-list ordered map
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ *
+ * An insert links the new node after its predecessor on each of its levels,
+ * and a remove unlinks it there, so an update writes only a few links near
+ * its key instead of rebalancing a path up to the root. Node heights are
+ * derived from a hash of the key instead of a shared random number
+ * generator, whose state would be written by every insert.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+#include "memory.h"
+#include "pair.h"
+#include "skiplist.h"
+#include "tm.h"
+#include "types.h"
+
+
+typedef struct skiplist_node {
+    pair_t pair;                        /* key and data; fixed once linked */
+    long height;
+    struct skiplist_node* nextPtrs[1];  /* really [height] */
+} skiplist_node_t;
+
+struct skiplist {
+    skiplist_node_t* headPtr;           /* has SKIPLIST_MAX_LEVEL links */
+    long level;                         /* number of levels in use */
+    long (*comparePairs)(const pair_t*, const pair_t*);
+};
+
+#define NODE_SIZE(height) \
+    (sizeof(skiplist_node_t) + ((height) - 1) * sizeof(skiplist_node_t*))
+
+
+/* =============================================================================
+ * compareKeysDefault
+ * =============================================================================
+ */
+static long
+compareKeysDefault (const pair_t* a, const pair_t* b)
+{
+    long aKey = (long)a->firstPtr;
+    long bKey = (long)b->firstPtr;
+
+    return ((aKey < bKey) ? -1 : ((aKey > bKey) ? 1 : 0));
+}
+
+
+/* =============================================================================
+ * getHeight
+ * -- Each level is kept with probability 1/4, which halves the number of
+ *    levels (and links per node) of p = 1/2 for the same search cost
+ * =============================================================================
+ */
+static long
+getHeight (void* keyPtr)
+{
+    ulong_t bits = (ulong_t)keyPtr * (ulong_t)0x9E3779B97F4A7C15ULL;
+    long height = 1;
+
+    bits ^= (bits >> (sizeof(ulong_t) * 4));
+    while (((bits & 3) == 0) && (height < SKIPLIST_MAX_LEVEL)) {
+        height++;
+        bits >>= 2;
+    }
+
+    return height;
+}
+
+
+/* =============================================================================
+ * initNode
+ * =============================================================================
+ */
+static skiplist_node_t*
+initNode (skiplist_node_t* nodePtr, void* keyPtr, void* dataPtr, long height)
+{
+    long l;
+
+    if (nodePtr != NULL) {
+        nodePtr->pair.firstPtr = keyPtr;
+        nodePtr->pair.secondPtr = dataPtr;
+        nodePtr->height = height;
+        for (l = 0; l < height; l++) {
+            nodePtr->nextPtrs[l] = NULL;
+        }
+    }
+
+    return nodePtr;
+}
+
+
+/* =============================================================================
+ * findPreds
+ * -- Sets predPtrs[l] to the last node before key on each level in use
+ * -- Returns the node with key, or NULL if not found
+ * =============================================================================
+ */
+static skiplist_node_t*
+findPreds (skiplist_t* skiplistPtr, void* keyPtr, skiplist_node_t** predPtrs)
+{
+    skiplist_node_t* prevPtr = skiplistPtr->headPtr;
+    skiplist_node_t* currPtr = NULL;
+    skiplist_node_t* stopPtr = NULL;
+    pair_t findPair;
+    long l;
+
+    findPair.firstPtr = keyPtr;
+    findPair.secondPtr = NULL;
+
+    for (l = (skiplistPtr->level - 1); l >= 0; l--) {
+        currPtr = prevPtr->nextPtrs[l];
+        /* The node that ended the level above need not be compared again */
+        while ((currPtr != NULL) &&
+               (currPtr != stopPtr) &&
+               (skiplistPtr->comparePairs(&currPtr->pair, &findPair) < 0))
+        {
+            prevPtr = currPtr;
+            currPtr = currPtr->nextPtrs[l];
+        }
+        stopPtr = currPtr;
+        if (predPtrs != NULL) {
+            predPtrs[l] = prevPtr;
+        }
+    }
+
+    if ((currPtr != NULL) &&
+        (skiplistPtr->comparePairs(&currPtr->pair, &findPair) == 0))
+    {
+        return currPtr;
+    }
+
+    return NULL;
+}
+
+
+/* =============================================================================
+ * TMfindPreds
+ * -- Sets predPtrs[l] to the last node before key on each level in use
+ * -- Returns the node with key, or NULL if not found
+ * =============================================================================
+ */
+static skiplist_node_t*
+TMfindPreds (TM_ARGDECL
+             skiplist_t* skiplistPtr, void* keyPtr, skiplist_node_t** predPtrs)
+{
+    skiplist_node_t* prevPtr = skiplistPtr->headPtr;
+    skiplist_node_t* currPtr = NULL;
+    skiplist_node_t* stopPtr = NULL;
+    pair_t findPair;
+    long l;
+
+    findPair.firstPtr = keyPtr;
+    findPair.secondPtr = NULL;
+
+    for (l = ((long)TM_SHARED_READ(skiplistPtr->level) - 1); l >= 0; l--) {
+        currPtr = (skiplist_node_t*)TM_SHARED_READ_P(prevPtr->nextPtrs[l]);
+        /* The node that ended the level above need not be compared again */
+        while ((currPtr != NULL) &&
+               (currPtr != stopPtr) &&
+               (skiplistPtr->comparePairs(&currPtr->pair, &findPair) < 0))
+        {
+            prevPtr = currPtr;
+            currPtr = (skiplist_node_t*)TM_SHARED_READ_P(currPtr->nextPtrs[l]);
+        }
+        stopPtr = currPtr;
+        if (predPtrs != NULL) {
+            predPtrs[l] = prevPtr;
+        }
+    }
+
+    if ((currPtr != NULL) &&
+        (skiplistPtr->comparePairs(&currPtr->pair, &findPair) == 0))
+    {
+        return currPtr;
+    }
+
+    return NULL;
+}
+
+
+/* =============================================================================
+ * linkNode
+ * =============================================================================
+ */
+static void
+linkNode (skiplist_t* skiplistPtr,
+          skiplist_node_t* nodePtr, skiplist_node_t** predPtrs)
+{
+    long height = nodePtr->height;
+    long l;
+
+    for (l = skiplistPtr->level; l < height; l++) {
+        predPtrs[l] = skiplistPtr->headPtr;
+    }
+    if (height > skiplistPtr->level) {
+        skiplistPtr->level = height;
+    }
+
+    for (l = 0; l < height; l++) {
+        nodePtr->nextPtrs[l] = predPtrs[l]->nextPtrs[l];
+        predPtrs[l]->nextPtrs[l] = nodePtr;
+    }
+}
+
+
+/* =============================================================================
+ * TMlinkNode
+ * -- The new node is private until linked, so its own links are plain stores
+ * =============================================================================
+ */
+static void
+TMlinkNode (TM_ARGDECL
+            skiplist_t* skiplistPtr,
+            skiplist_node_t* nodePtr, skiplist_node_t** predPtrs)
+{
+    long height = nodePtr->height;
+    long level = (long)TM_SHARED_READ(skiplistPtr->level);
+    long l;
+
+    for (l = level; l < height; l++) {
+        predPtrs[l] = skiplistPtr->headPtr;
+    }
+    if (height > level) {
+        TM_SHARED_WRITE(skiplistPtr->level, height);
+    }
+
+    for (l = 0; l < height; l++) {
+        nodePtr->nextPtrs[l] =
+            (skiplist_node_t*)TM_SHARED_READ_P(predPtrs[l]->nextPtrs[l]);
+        TM_SHARED_WRITE_P(predPtrs[l]->nextPtrs[l], nodePtr);
+    }
+}
+
+
+/* =============================================================================
+ * unlinkNode
+ * =============================================================================
+ */
+static void
+unlinkNode (skiplist_node_t* nodePtr, skiplist_node_t** predPtrs)
+{
+    long l;
+
+    for (l = 0; l < nodePtr->height; l++) {
+        assert(predPtrs[l]->nextPtrs[l] == nodePtr);
+        predPtrs[l]->nextPtrs[l] = nodePtr->nextPtrs[l];
+    }
+}
+
+
+/* =============================================================================
+ * TMunlinkNode
+ * =============================================================================
+ */
+static void
+TMunlinkNode (TM_ARGDECL  skiplist_node_t* nodePtr, skiplist_node_t** predPtrs)
+{
+    long l;
+
+    for (l = 0; l < nodePtr->height; l++) {
+        TM_SHARED_WRITE_P(predPtrs[l]->nextPtrs[l],
+                          TM_SHARED_READ_P(nodePtr->nextPtrs[l]));
+    }
+}
+
+
+/* =============================================================================
+ * skiplist_alloc
+ * -- If NULL passed for 'comparePairs', keys are compared by value
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+skiplist_t*
+skiplist_alloc (long (*comparePairs)(const pair_t*, const pair_t*))
+{
+    skiplist_t* skiplistPtr = (skiplist_t*)malloc(sizeof(skiplist_t));
+    if (skiplistPtr == NULL) {
+        return NULL;
+    }
+
+    skiplistPtr->headPtr =
+        initNode((skiplist_node_t*)malloc(NODE_SIZE(SKIPLIST_MAX_LEVEL)),
+                 NULL, NULL, SKIPLIST_MAX_LEVEL);
+    if (skiplistPtr->headPtr == NULL) {
+        memory_free(skiplistPtr);
+        return NULL;
+    }
+    skiplistPtr->level = 1;
+    skiplistPtr->comparePairs = ((comparePairs != NULL) ?
+                                 comparePairs : &compareKeysDefault);
+
+    return skiplistPtr;
+}
+
+
+/* =============================================================================
+ * Pskiplist_alloc
+ * -- If NULL passed for 'comparePairs', keys are compared by value
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+skiplist_t*
+Pskiplist_alloc (long (*comparePairs)(const pair_t*, const pair_t*))
+{
+    skiplist_t* skiplistPtr = (skiplist_t*)P_MALLOC(sizeof(skiplist_t));
+    if (skiplistPtr == NULL) {
+        return NULL;
+    }
+
+    skiplistPtr->headPtr =
+        initNode((skiplist_node_t*)P_MALLOC(NODE_SIZE(SKIPLIST_MAX_LEVEL)),
+                 NULL, NULL, SKIPLIST_MAX_LEVEL);
+    if (skiplistPtr->headPtr == NULL) {
+        P_FREE(skiplistPtr);
+        return NULL;
+    }
+    skiplistPtr->level = 1;
+    skiplistPtr->comparePairs = ((comparePairs != NULL) ?
+                                 comparePairs : &compareKeysDefault);
+
+    return skiplistPtr;
+}
+
+
+/* =============================================================================
+ * TMskiplist_alloc
+ * -- If NULL passed for 'comparePairs', keys are compared by value
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+skiplist_t*
+TMskiplist_alloc (TM_ARGDECL
+                  long (*comparePairs)(const pair_t*, const pair_t*))
+{
+    skiplist_t* skiplistPtr = (skiplist_t*)TM_MALLOC(sizeof(skiplist_t));
+    if (skiplistPtr == NULL) {
+        return NULL;
+    }
+
+    skiplistPtr->headPtr =
+        initNode((skiplist_node_t*)TM_MALLOC(NODE_SIZE(SKIPLIST_MAX_LEVEL)),
+                 NULL, NULL, SKIPLIST_MAX_LEVEL);
+    if (skiplistPtr->headPtr == NULL) {
+        TM_FREE(skiplistPtr);
+        return NULL;
+    }
+    skiplistPtr->level = 1;
+    skiplistPtr->comparePairs = ((comparePairs != NULL) ?
+                                 comparePairs : &compareKeysDefault);
+
+    return skiplistPtr;
+}
+
+
+/* =============================================================================
+ * skiplist_free
+ * =============================================================================
+ */
+void
+skiplist_free (skiplist_t* skiplistPtr)
+{
+    skiplist_node_t* nodePtr = skiplistPtr->headPtr;
+
+    while (nodePtr != NULL) {
+        skiplist_node_t* nextPtr = nodePtr->nextPtrs[0];
+        memory_free(nodePtr);
+        nodePtr = nextPtr;
+    }
+
+    memory_free(skiplistPtr);
+}
+
+
+/* =============================================================================
+ * Pskiplist_free
+ * =============================================================================
+ */
+void
+Pskiplist_free (skiplist_t* skiplistPtr)
+{
+    skiplist_node_t* nodePtr = skiplistPtr->headPtr;
+
+    while (nodePtr != NULL) {
+        skiplist_node_t* nextPtr = nodePtr->nextPtrs[0];
+        P_FREE(nodePtr);
+        nodePtr = nextPtr;
+    }
+
+    P_FREE(skiplistPtr);
+}
+
+
+/* =============================================================================
+ * TMskiplist_free
+ * =============================================================================
+ */
+void
+TMskiplist_free (TM_ARGDECL  skiplist_t* skiplistPtr)
+{
+    skiplist_node_t* nodePtr = skiplistPtr->headPtr;
+
+    while (nodePtr != NULL) {
+        skiplist_node_t* nextPtr =
+            (skiplist_node_t*)TM_SHARED_READ_P(nodePtr->nextPtrs[0]);
+        TM_FREE(nodePtr);
+        nodePtr = nextPtr;
+    }
+
+    TM_FREE(skiplistPtr);
+}
+
+
+/* =============================================================================
+ * skiplist_contains
+ * =============================================================================
+ */
+bool_t
+skiplist_contains (skiplist_t* skiplistPtr, void* keyPtr)
+{
+    return ((findPreds(skiplistPtr, keyPtr, NULL) != NULL) ? TRUE : FALSE);
+}
+
+
+/* =============================================================================
+ * TMskiplist_contains
+ * =============================================================================
+ */
+bool_t
+TMskiplist_contains (TM_ARGDECL  skiplist_t* skiplistPtr, void* keyPtr)
+{
+    skiplist_node_t* nodePtr = TMfindPreds(TM_ARG  skiplistPtr, keyPtr, NULL);
+
+    return ((nodePtr != NULL) ? TRUE : FALSE);
+}
+
+
+/* =============================================================================
+ * skiplist_find
+ * -- Returns NULL on failure, else pointer to data associated with key
+ * =============================================================================
+ */
+void*
+skiplist_find (skiplist_t* skiplistPtr, void* keyPtr)
+{
+    skiplist_node_t* nodePtr = findPreds(skiplistPtr, keyPtr, NULL);
+
+    return ((nodePtr != NULL) ? nodePtr->pair.secondPtr : NULL);
+}
+
+
+/* =============================================================================
+ * TMskiplist_find
+ * -- Returns NULL on failure, else pointer to data associated with key
+ * =============================================================================
+ */
+void*
+TMskiplist_find (TM_ARGDECL  skiplist_t* skiplistPtr, void* keyPtr)
+{
+    skiplist_node_t* nodePtr = TMfindPreds(TM_ARG  skiplistPtr, keyPtr, NULL);
+
+    return ((nodePtr != NULL) ? nodePtr->pair.secondPtr : NULL);
+}
+
+
+/* =============================================================================
+ * skiplist_insert
+ * -- Returns TRUE on success, FALSE if key is already present
+ * =============================================================================
+ */
+bool_t
+skiplist_insert (skiplist_t* skiplistPtr, void* keyPtr, void* dataPtr)
+{
+    skiplist_node_t* predPtrs[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t* nodePtr;
+    long height;
+
+    if (findPreds(skiplistPtr, keyPtr, predPtrs) != NULL) {
+        return FALSE;
+    }
+
+    height = getHeight(keyPtr);
+    nodePtr = initNode((skiplist_node_t*)malloc(NODE_SIZE(height)),
+                       keyPtr, dataPtr, height);
+    if (nodePtr == NULL) {
+        return FALSE;
+    }
+    linkNode(skiplistPtr, nodePtr, predPtrs);
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * Pskiplist_insert
+ * -- Returns TRUE on success, FALSE if key is already present
+ * =============================================================================
+ */
+bool_t
+Pskiplist_insert (skiplist_t* skiplistPtr, void* keyPtr, void* dataPtr)
+{
+    skiplist_node_t* predPtrs[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t* nodePtr;
+    long height;
+
+    if (findPreds(skiplistPtr, keyPtr, predPtrs) != NULL) {
+        return FALSE;
+    }
+
+    height = getHeight(keyPtr);
+    nodePtr = initNode((skiplist_node_t*)P_MALLOC(NODE_SIZE(height)),
+                       keyPtr, dataPtr, height);
+    if (nodePtr == NULL) {
+        return FALSE;
+    }
+    linkNode(skiplistPtr, nodePtr, predPtrs);
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TMskiplist_insert
+ * -- Returns TRUE on success, FALSE if key is already present
+ * =============================================================================
+ */
+bool_t
+TMskiplist_insert (TM_ARGDECL
+                   skiplist_t* skiplistPtr, void* keyPtr, void* dataPtr)
+{
+    skiplist_node_t* predPtrs[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t* nodePtr;
+    long height;
+
+    if (TMfindPreds(TM_ARG  skiplistPtr, keyPtr, predPtrs) != NULL) {
+        return FALSE;
+    }
+
+    height = getHeight(keyPtr);
+    nodePtr = initNode((skiplist_node_t*)TM_MALLOC(NODE_SIZE(height)),
+                       keyPtr, dataPtr, height);
+    if (nodePtr == NULL) {
+        return FALSE;
+    }
+    TMlinkNode(TM_ARG  skiplistPtr, nodePtr, predPtrs);
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * skiplist_remove
+ * -- Returns TRUE if successful, else FALSE
+ * =============================================================================
+ */
+bool_t
+skiplist_remove (skiplist_t* skiplistPtr, void* keyPtr)
+{
+    skiplist_node_t* predPtrs[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t* nodePtr = findPreds(skiplistPtr, keyPtr, predPtrs);
+
+    if (nodePtr == NULL) {
+        return FALSE;
+    }
+
+    unlinkNode(nodePtr, predPtrs);
+    memory_free(nodePtr);
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * Pskiplist_remove
+ * -- Returns TRUE if successful, else FALSE
+ * =============================================================================
+ */
+bool_t
+Pskiplist_remove (skiplist_t* skiplistPtr, void* keyPtr)
+{
+    skiplist_node_t* predPtrs[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t* nodePtr = findPreds(skiplistPtr, keyPtr, predPtrs);
+
+    if (nodePtr == NULL) {
+        return FALSE;
+    }
+
+    unlinkNode(nodePtr, predPtrs);
+    P_FREE(nodePtr);
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TMskiplist_remove
+ * -- Returns TRUE if successful, else FALSE
+ * =============================================================================
+ */
+bool_t
+TMskiplist_remove (TM_ARGDECL  skiplist_t* skiplistPtr, void* keyPtr)
+{
+    skiplist_node_t* predPtrs[SKIPLIST_MAX_LEVEL];
+    skiplist_node_t* nodePtr =
+        TMfindPreds(TM_ARG  skiplistPtr, keyPtr, predPtrs);
+
+    if (nodePtr == NULL) {
+        return FALSE;
+    }
+
+    TMunlinkNode(TM_ARG  nodePtr, predPtrs);
+    TM_FREE(nodePtr);
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * TEST_SKIPLIST
+ * =============================================================================
+ */
+#ifdef TEST_SKIPLIST
+
+
+#include <sched.h>
+#include <stdio.h>
+#include "thread.h"
+
+#define NUM_SEQ_KEY    (4096)
+#define NUM_SHARED_KEY (128)  /* few keys, so threads share predecessors */
+#define NUM_OP         (8192) /* per thread */
+#define NUM_THREAD     (4)
+
+static skiplist_t* global_skiplistPtr;
+static long global_numInsert[NUM_THREAD][NUM_SHARED_KEY];
+static long global_numRemove[NUM_THREAD][NUM_SHARED_KEY];
+
+
+static long
+comparePairs (const pair_t* a, const pair_t* b)
+{
+    return (*(long*)(a->firstPtr) - *(long*)(b->firstPtr));
+}
+
+
+/* =============================================================================
+ * checkLevels
+ * -- Every level must be sorted, hold exactly the nodes at least that high,
+ *    and end the list of levels in use; heights must follow the key hash
+ * -- Returns number of nodes
+ * =============================================================================
+ */
+static long
+checkLevels (skiplist_t* skiplistPtr)
+{
+    long numTaller[SKIPLIST_MAX_LEVEL] = {0};
+    skiplist_node_t* nodePtr;
+    long numNode = 0;
+    long l;
+
+    assert(skiplistPtr->level >= 1 && skiplistPtr->level <= SKIPLIST_MAX_LEVEL);
+
+    for (nodePtr = skiplistPtr->headPtr->nextPtrs[0];
+         nodePtr != NULL;
+         nodePtr = nodePtr->nextPtrs[0])
+    {
+        assert(nodePtr->height == getHeight(nodePtr->pair.firstPtr));
+        assert(nodePtr->height <= skiplistPtr->level);
+        for (l = 0; l < nodePtr->height; l++) {
+            numTaller[l]++;
+        }
+        numNode++;
+    }
+
+    for (l = 0; l < SKIPLIST_MAX_LEVEL; l++) {
+        skiplist_node_t* prevPtr = NULL;
+        long numLinked = 0;
+        if (l >= skiplistPtr->level) {
+            assert(skiplistPtr->headPtr->nextPtrs[l] == NULL);
+            continue;
+        }
+        for (nodePtr = skiplistPtr->headPtr->nextPtrs[l];
+             nodePtr != NULL;
+             nodePtr = nodePtr->nextPtrs[l])
+        {
+            assert(nodePtr->height > l);
+            if (prevPtr != NULL) {
+                assert(skiplistPtr->comparePairs(&prevPtr->pair,
+                                                 &nodePtr->pair) < 0);
+            }
+            prevPtr = nodePtr;
+            numLinked++;
+        }
+        assert(numLinked == numTaller[l]);
+    }
+
+    return numNode;
+}
+
+
+/* =============================================================================
+ * testRandom
+ * -- Random inserts and removes, mostly inserts in the first rounds
+ * =============================================================================
+ */
+static void
+testRandom (long (*compareFunc)(const pair_t*, const pair_t*))
+{
+    static long keys[NUM_SEQ_KEY];
+    static bool_t isPresent[NUM_SEQ_KEY];
+    skiplist_t* skiplistPtr = skiplist_alloc(compareFunc);
+    long round;
+    long i;
+
+    assert(skiplistPtr);
+    for (i = 0; i < NUM_SEQ_KEY; i++) {
+        keys[i] = i;
+        isPresent[i] = FALSE;
+    }
+
+    srand(0);
+    for (round = 0; round < 8; round++) {
+        long percentInsert = ((round < 4) ? 70 : 30);
+        long numPresent = 0;
+        for (i = 0; i < NUM_SEQ_KEY; i++) {
+            long k = rand() % NUM_SEQ_KEY;
+            void* keyPtr = ((compareFunc != NULL) ? (void*)&keys[k] : (void*)k);
+            bool_t status;
+            if ((rand() % 100) < percentInsert) {
+                status = skiplist_insert(skiplistPtr, keyPtr, (void*)(k + 1));
+                assert(status == !isPresent[k]);
+                isPresent[k] = TRUE;
+            } else {
+                status = skiplist_remove(skiplistPtr, keyPtr);
+                assert(status == isPresent[k]);
+                isPresent[k] = FALSE;
+            }
+        }
+        for (i = 0; i < NUM_SEQ_KEY; i++) {
+            void* keyPtr = ((compareFunc != NULL) ? (void*)&keys[i] : (void*)i);
+            void* dataPtr = skiplist_find(skiplistPtr, keyPtr);
+            assert(dataPtr == (isPresent[i] ? (void*)(i + 1) : NULL));
+            numPresent += isPresent[i];
+        }
+        assert(checkLevels(skiplistPtr) == numPresent);
+    }
+
+    skiplist_free(skiplistPtr);
+}
+
+
+/* xorshift; the low bits of consecutive values are correlated, use the high */
+static ulong_t
+nextRandom (ulong_t* seedPtr)
+{
+    ulong_t x = *seedPtr;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *seedPtr = x;
+
+    return x;
+}
+
+
+/* =============================================================================
+ * updateShared
+ * -- All threads insert and remove random keys of one small range, so their
+ *    updates keep relinking the same predecessors
+ * -- Every 4th transaction also updates the key just below, whose node is
+ *    the first one's predecessor on its lowest level, after yielding
+ * =============================================================================
+ */
+static void
+updateShared (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    ulong_t seed = id + 1;
+    long op;
+
+    for (op = 0; op < NUM_OP; op++) {
+        long k = (nextRandom(&seed) >> 32) % NUM_SHARED_KEY;
+        long prev = (k + NUM_SHARED_KEY - 1) % NUM_SHARED_KEY;
+        bool_t isInsert = ((nextRandom(&seed) >> 32) & 1);
+        bool_t isPair = ((op % 4) == (id % 4));
+        bool_t status;
+        bool_t prevStatus;
+
+        TM_BEGIN();
+        prevStatus = FALSE;
+        if (isInsert) {
+            status = TMSKIPLIST_INSERT(global_skiplistPtr,
+                                       (void*)k,
+                                       (void*)(k + 1));
+            assert(TMSKIPLIST_FIND(global_skiplistPtr, (void*)k) ==
+                   (void*)(k + 1));
+        } else {
+            status = TMSKIPLIST_REMOVE(global_skiplistPtr, (void*)k);
+            assert(!TMSKIPLIST_CONTAINS(global_skiplistPtr, (void*)k));
+        }
+        if (isPair) {
+            sched_yield();
+            if (isInsert) {
+                prevStatus = TMSKIPLIST_REMOVE(global_skiplistPtr, (void*)prev);
+            } else {
+                prevStatus = TMSKIPLIST_INSERT(global_skiplistPtr,
+                                               (void*)prev,
+                                               (void*)(prev + 1));
+            }
+        }
+        TM_END();
+
+        if (status) {
+            (isInsert ? global_numInsert : global_numRemove)[id][k]++;
+        }
+        if (prevStatus) {
+            (isInsert ? global_numRemove : global_numInsert)[id][prev]++;
+        }
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+/* =============================================================================
+ * copyShared
+ * -- Each thread copies its share of the surviving keys to a private list
+ * =============================================================================
+ */
+static void
+copyShared (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    long* numCopyPtr = (long*)argPtr;
+    skiplist_t* privateSkiplistPtr = Pskiplist_alloc(NULL);
+    long numCopy = 0;
+    long k;
+
+    assert(privateSkiplistPtr);
+    for (k = id; k < NUM_SHARED_KEY; k += NUM_THREAD) {
+        void* dataPtr;
+        TM_BEGIN();
+        dataPtr = TMSKIPLIST_FIND(global_skiplistPtr, (void*)k);
+        TM_END();
+        if (dataPtr != NULL) {
+            bool_t status =
+                PSKIPLIST_INSERT(privateSkiplistPtr, (void*)k, dataPtr);
+            assert(status);
+            numCopy++;
+        }
+    }
+    assert(checkLevels(privateSkiplistPtr) == numCopy);
+    PSKIPLIST_FREE(privateSkiplistPtr);
+    numCopyPtr[id] = numCopy;
+
+    TM_THREAD_EXIT();
+}
+
+
+int
+main ()
+{
+    long numCopy[NUM_THREAD];
+    long numPresent = 0;
+    long k;
+
+    puts("Starting...");
+
+    testRandom(NULL);
+    testRandom(&comparePairs);
+
+    global_skiplistPtr = skiplist_alloc(NULL);
+    assert(global_skiplistPtr);
+    TM_STARTUP(NUM_THREAD);
+    thread_startup(NUM_THREAD);
+    thread_start(updateShared, NULL);
+    thread_start(copyShared, (void*)numCopy);
+    thread_shutdown();
+    TM_SHUTDOWN();
+
+    /* A key is present iff it was inserted once more than it was removed */
+    for (k = 0; k < NUM_SHARED_KEY; k++) {
+        long net = 0;
+        long t;
+        for (t = 0; t < NUM_THREAD; t++) {
+            net += global_numInsert[t][k] - global_numRemove[t][k];
+        }
+        assert(net == 0 || net == 1);
+        assert(skiplist_find(global_skiplistPtr, (void*)k) ==
+               ((net == 1) ? (void*)(k + 1) : NULL));
+        numPresent += net;
+    }
+    assert(checkLevels(global_skiplistPtr) == numPresent);
+    for (k = 0; k < NUM_THREAD; k++) {
+        numPresent -= numCopy[k];
+    }
+    assert(numPresent == 0);
+    printf("Levels in use: %li\n", global_skiplistPtr->level);
+    skiplist_free(global_skiplistPtr);
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_SKIPLIST */
+
+
+/* =============================================================================
+ *
+ * End of skiplist.c
+ *
+ * =============================================================================
+ */
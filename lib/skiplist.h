@@ -0,0 +1,264 @@
+/* =============================================================================
+ *
+ * skiplist.h
+ * -- Skip-list ordered map
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef SKIPLIST_H
+#define SKIPLIST_H 1
+
+
+#include "pair.h"
+#include "tm.h"
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+enum skiplist_config {
+    SKIPLIST_MAX_LEVEL = 32
+};
+
+typedef struct skiplist skiplist_t;
+
+
+/* =============================================================================
+ * skiplist_alloc
+ * -- If NULL passed for 'comparePairs', keys are compared by value
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+skiplist_t*
+skiplist_alloc (long (*comparePairs)(const pair_t*, const pair_t*));
+
+
+/* =============================================================================
+ * Pskiplist_alloc
+ * -- If NULL passed for 'comparePairs', keys are compared by value
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+skiplist_t*
+Pskiplist_alloc (long (*comparePairs)(const pair_t*, const pair_t*));
+
+
+/* =============================================================================
+ * TMskiplist_alloc
+ * -- If NULL passed for 'comparePairs', keys are compared by value
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+skiplist_t*
+TMskiplist_alloc (TM_ARGDECL
+                  long (*comparePairs)(const pair_t*, const pair_t*));
+
+
+/* =============================================================================
+ * skiplist_free
+ * =============================================================================
+ */
+void
+skiplist_free (skiplist_t* skiplistPtr);
+
+
+/* =============================================================================
+ * Pskiplist_free
+ * =============================================================================
+ */
+void
+Pskiplist_free (skiplist_t* skiplistPtr);
+
+
+/* =============================================================================
+ * TMskiplist_free
+ * =============================================================================
+ */
+void
+TMskiplist_free (TM_ARGDECL  skiplist_t* skiplistPtr);
+
+
+/* =============================================================================
+ * skiplist_contains
+ * =============================================================================
+ */
+bool_t
+skiplist_contains (skiplist_t* skiplistPtr, void* keyPtr);
+
+
+/* =============================================================================
+ * TMskiplist_contains
+ * =============================================================================
+ */
+bool_t
+TMskiplist_contains (TM_ARGDECL  skiplist_t* skiplistPtr, void* keyPtr);
+
+
+/* =============================================================================
+ * skiplist_find
+ * -- Returns NULL on failure, else pointer to data associated with key
+ * =============================================================================
+ */
+void*
+skiplist_find (skiplist_t* skiplistPtr, void* keyPtr);
+
+
+/* =============================================================================
+ * TMskiplist_find
+ * -- Returns NULL on failure, else pointer to data associated with key
+ * =============================================================================
+ */
+void*
+TMskiplist_find (TM_ARGDECL  skiplist_t* skiplistPtr, void* keyPtr);
+
+
+/* =============================================================================
+ * skiplist_insert
+ * -- Returns TRUE on success, FALSE if key is already present
+ * =============================================================================
+ */
+bool_t
+skiplist_insert (skiplist_t* skiplistPtr, void* keyPtr, void* dataPtr);
+
+
+/* =============================================================================
+ * Pskiplist_insert
+ * -- Returns TRUE on success, FALSE if key is already present
+ * =============================================================================
+ */
+bool_t
+Pskiplist_insert (skiplist_t* skiplistPtr, void* keyPtr, void* dataPtr);
+
+
+/* =============================================================================
+ * TMskiplist_insert
+ * -- Returns TRUE on success, FALSE if key is already present
+ * =============================================================================
+ */
+bool_t
+TMskiplist_insert (TM_ARGDECL
+                   skiplist_t* skiplistPtr, void* keyPtr, void* dataPtr);
+
+
+/* =============================================================================
+ * skiplist_remove
+ * -- Returns TRUE if successful, else FALSE
+ * =============================================================================
+ */
+bool_t
+skiplist_remove (skiplist_t* skiplistPtr, void* keyPtr);
+
+
+/* =============================================================================
+ * Pskiplist_remove
+ * -- Returns TRUE if successful, else FALSE
+ * =============================================================================
+ */
+bool_t
+Pskiplist_remove (skiplist_t* skiplistPtr, void* keyPtr);
+
+
+/* =============================================================================
+ * TMskiplist_remove
+ * -- Returns TRUE if successful, else FALSE
+ * =============================================================================
+ */
+bool_t
+TMskiplist_remove (TM_ARGDECL  skiplist_t* skiplistPtr, void* keyPtr);
+
+
+#define PSKIPLIST_ALLOC(c)              Pskiplist_alloc(c)
+#define PSKIPLIST_FREE(s)               Pskiplist_free(s)
+#define PSKIPLIST_INSERT(s, k, d)       Pskiplist_insert(s, k, d)
+#define PSKIPLIST_REMOVE(s, k)          Pskiplist_remove(s, k)
+
+#define TMSKIPLIST_ALLOC(c)             TMskiplist_alloc(TM_ARG  c)
+#define TMSKIPLIST_FREE(s)              TMskiplist_free(TM_ARG  s)
+#define TMSKIPLIST_CONTAINS(s, k)       TMskiplist_contains(TM_ARG  s, k)
+#define TMSKIPLIST_FIND(s, k)           TMskiplist_find(TM_ARG  s, k)
+#define TMSKIPLIST_INSERT(s, k, d)      TMskiplist_insert(TM_ARG  s, k, d)
+#define TMSKIPLIST_REMOVE(s, k)         TMskiplist_remove(TM_ARG  s, k)
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* SKIPLIST_H */
+
+
+/* =============================================================================
+ *
+ * End of skiplist.h
+ *
+ * =============================================================================
+ */
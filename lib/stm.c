@@ -0,0 +1,2199 @@
+/* =============================================================================
+ *
+ * stm.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cm.h"
+#include "epoch.h"
+#include "memory.h"
+#include "stm.h"
+#include "tmstats.h"
+#include "types.h"
+
+
+enum stm_config {
+    STM_LOCK_TABLE_LOG2   = 20,
+    STM_LOCK_SHIFT        = 3, /* one lock per 8-byte word */
+    STM_INIT_LOG_CAPACITY = 64,
+    STM_CACHE_LINE_SIZE   = 64,
+    STM_MAX_VERSION       = 64, /* old versions kept per stripe */
+    STM_MAX_NESTED_RETRY  = 8,  /* partial aborts before a full one */
+};
+
+#define STM_LOCK_TABLE_SIZE             (1L << STM_LOCK_TABLE_LOG2)
+#define STM_LOCK_TABLE_MASK             (STM_LOCK_TABLE_SIZE - 1)
+
+#define LOCK_IS_OWNED(l)                ((l) & 1UL)
+#define LOCK_GET_VERSION(l)             ((l) >> 1)
+#define LOCK_MAKE_VERSION(v)            ((v) << 1)
+
+/* Owned: write-set index of the acquiring entry, owner's CM slot, 1 */
+#define LOCK_MAKE_OWNED(slot, index) \
+    (((unsigned long)(index) << (CM_SLOT_BITS + 1)) | \
+     ((unsigned long)(slot) << 1) | 1UL)
+#define LOCK_GET_SLOT(l)                ((long)(((l) >> 1) & (CM_MAX_THREAD - 1)))
+#define LOCK_GET_INDEX(l)               ((long)((l) >> (CM_SLOT_BITS + 1)))
+
+#define GET_LOCK(addr) \
+    (&global_locks[((unsigned long)(addr) >> STM_LOCK_SHIFT) & \
+                   STM_LOCK_TABLE_MASK])
+
+typedef volatile unsigned long stm_lock_t;
+
+typedef struct stm_entry {
+    volatile void* addr;
+    long value;
+    long numByte; /* 0 if only the lock is needed (freed memory) */
+    stm_lock_t* lockPtr;
+    unsigned long prevLock;
+    bool_t isAcquired;
+} stm_entry_t;
+
+/* The value a write replaced, valid for snapshots in [from, until) */
+typedef struct stm_version {
+    volatile void* addr;
+    long value;
+    long numByte; /* 0 if the commit only bumped the lock */
+    unsigned long from;
+    unsigned long until;
+} stm_version_t;
+
+/* Ring of the last global_numVersion writes to one stripe */
+typedef struct stm_history {
+    unsigned long numAppended;
+    stm_version_t versions[];
+} stm_history_t;
+
+/* Checkpoint taken when a closed nested transaction begins */
+typedef struct stm_nest {
+    sigjmp_buf* envPtr;
+    long numRead;
+    long numWrite;
+    long numShadow;
+    long numUndo;
+    long numAlloc;
+    long numFree;
+    long numCompensation;
+} stm_nest_t;
+
+/* A parent's write-set entry as it was before a nested child changed it */
+typedef struct stm_shadow {
+    long position;
+    long value;
+    long numByte;
+} stm_shadow_t;
+
+typedef struct stm_compensation {
+    stm_compensation_handler_t handler;
+    void* argPtr;
+} stm_compensation_t;
+
+typedef struct stm_log {
+    void* elements;
+    long size;
+    long capacity;
+} stm_log_t;
+
+struct stm_thread {
+    long id;
+    long slot;           /* contention manager */
+    long epochSlot;      /* deferred reclamation */
+    sigjmp_buf* envPtr;
+    bool_t isInTx;
+    bool_t isRetry;
+    bool_t isReadOnly;
+    bool_t isRetryWriter;
+    bool_t isIrrevocable;   /* running alone; accesses are in place */
+    unsigned long readVersion;
+    long numAccess;      /* work done by this attempt */
+    bool_t hasNarrowWrite;  /* wrote fewer bytes than a word (see stm_write) */
+    stm_log_t readSet;   /* stm_lock_t* */
+    stm_log_t writeSet;  /* stm_entry_t */
+    stm_log_t undoLog;   /* stm_entry_t */
+    stm_log_t allocLog;  /* void* */
+    stm_log_t freeLog;   /* void* */
+    long* writeIndex;    /* open-addressed: writeSet position + 1 */
+    long writeIndexCapacity;
+    stm_log_t nestLog;   /* stm_nest_t: closed children that have begun */
+    stm_log_t shadowLog; /* stm_shadow_t */
+    stm_log_t compensationLog; /* stm_compensation_t: committed open children */
+    long numNestedRetry;
+    bool_t isCompensating;
+    stm_thread_t* parentPtr; /* open child: enclosing transaction */
+    stm_thread_t* openPtr;   /* runs our open children; created on demand */
+    tmstats_thread_t* statsPtr;
+};
+
+static struct {
+    char padding1[STM_CACHE_LINE_SIZE];
+    volatile unsigned long clock;
+    char padding2[STM_CACHE_LINE_SIZE];
+} global_version;
+
+static stm_lock_t     global_locks[STM_LOCK_TABLE_SIZE];
+static stm_thread_t** global_threads    = NULL;
+
+static unsigned long  global_numPartialAbort = 0;
+static unsigned long  global_numOpenCommit   = 0;
+static unsigned long  global_numCompensation = 0;
+
+/* Multi-version read-only transactions; off if global_numVersion is 0 */
+static long                    global_numVersion = 0;
+static stm_history_t* volatile* global_histories = NULL; /* one per stripe */
+
+
+/* =============================================================================
+ * log_init
+ * =============================================================================
+ */
+static void
+log_init (stm_log_t* logPtr, size_t elementSize)
+{
+    logPtr->size = 0;
+    logPtr->capacity = STM_INIT_LOG_CAPACITY;
+    logPtr->elements = malloc(logPtr->capacity * elementSize);
+    assert(logPtr->elements);
+}
+
+
+/* =============================================================================
+ * log_append
+ * -- Returns pointer to new (uninitialized) element
+ * =============================================================================
+ */
+static inline void*
+log_append (stm_log_t* logPtr, size_t elementSize)
+{
+    if (logPtr->size == logPtr->capacity) {
+        logPtr->capacity *= 2;
+        logPtr->elements = realloc(logPtr->elements,
+                                   logPtr->capacity * elementSize);
+        assert(logPtr->elements);
+    }
+
+    return (void*)((char*)logPtr->elements + elementSize * logPtr->size++);
+}
+
+
+/* =============================================================================
+ * loadValue
+ * =============================================================================
+ */
+static inline long
+loadValue (volatile void* addr, size_t numByte)
+{
+    switch (numByte) {
+        case 1: return (long)*(volatile char*)addr;
+        case 2: return (long)*(volatile short*)addr;
+        case 4: return (long)*(volatile int*)addr;
+        case 8: return (long)*(volatile long long*)addr;
+        default: assert(0);
+    }
+
+    return 0;
+}
+
+
+/* =============================================================================
+ * storeValue
+ * =============================================================================
+ */
+static inline void
+storeValue (volatile void* addr, long value, size_t numByte)
+{
+    switch (numByte) {
+        case 0: break;
+        case 1: *(volatile char*)addr = (char)value; break;
+        case 2: *(volatile short*)addr = (short)value; break;
+        case 4: *(volatile int*)addr = (int)value; break;
+        case 8: *(volatile long long*)addr = (long long)value; break;
+        default: assert(0);
+    }
+}
+
+
+/* =============================================================================
+ * hashAddress
+ * =============================================================================
+ */
+static inline unsigned long
+hashAddress (volatile void* addr)
+{
+    unsigned long a = (unsigned long)addr >> 2;
+
+    return a ^ (a >> 9) ^ (a >> 17);
+}
+
+
+/* =============================================================================
+ * findEntry
+ * -- Returns NULL if addr has not been written in this transaction
+ * =============================================================================
+ */
+static inline stm_entry_t*
+findEntry (stm_thread_t* threadPtr, volatile void* addr)
+{
+    stm_entry_t* entries = (stm_entry_t*)threadPtr->writeSet.elements;
+    long* index = threadPtr->writeIndex;
+    unsigned long mask = threadPtr->writeIndexCapacity - 1;
+    unsigned long i = hashAddress(addr) & mask;
+
+    if (threadPtr->writeSet.size == 0) {
+        return NULL;
+    }
+
+    while (index[i] != 0) {
+        stm_entry_t* entryPtr = &entries[index[i] - 1];
+        if (entryPtr->addr == addr) {
+            return entryPtr;
+        }
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+
+/* =============================================================================
+ * insertIndex
+ * =============================================================================
+ */
+static inline void
+insertIndex (long* index, long capacity, volatile void* addr, long position)
+{
+    unsigned long mask = capacity - 1;
+    unsigned long i = hashAddress(addr) & mask;
+
+    while (index[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    index[i] = position + 1;
+}
+
+
+/* =============================================================================
+ * clearIndex
+ * =============================================================================
+ */
+static void
+clearIndex (stm_thread_t* threadPtr)
+{
+    long numEntry = threadPtr->writeSet.size;
+    long capacity = threadPtr->writeIndexCapacity;
+
+    if (numEntry * 8 < capacity) {
+        stm_entry_t* entries = (stm_entry_t*)threadPtr->writeSet.elements;
+        long* index = threadPtr->writeIndex;
+        unsigned long mask = capacity - 1;
+        long e;
+        for (e = 0; e < numEntry; e++) {
+            unsigned long i = hashAddress(entries[e].addr) & mask;
+            while (index[i] != e + 1) {
+                i = (i + 1) & mask;
+            }
+            index[i] = 0;
+        }
+    } else {
+        memset(threadPtr->writeIndex, 0, capacity * sizeof(long));
+    }
+}
+
+
+/* =============================================================================
+ * appendEntry
+ * =============================================================================
+ */
+static stm_entry_t*
+appendEntry (stm_thread_t* threadPtr,
+             volatile void* addr, long value, size_t numByte)
+{
+    stm_entry_t* entryPtr;
+    long position = threadPtr->writeSet.size;
+
+    if ((position + 1) * 2 > threadPtr->writeIndexCapacity) {
+        long capacity = threadPtr->writeIndexCapacity * 2;
+        long* index = (long*)calloc(capacity, sizeof(long));
+        stm_entry_t* entries = (stm_entry_t*)threadPtr->writeSet.elements;
+        long e;
+        assert(index);
+        for (e = 0; e < position; e++) {
+            insertIndex(index, capacity, entries[e].addr, e);
+        }
+        free(threadPtr->writeIndex);
+        threadPtr->writeIndex = index;
+        threadPtr->writeIndexCapacity = capacity;
+    }
+
+    entryPtr = (stm_entry_t*)log_append(&threadPtr->writeSet,
+                                        sizeof(stm_entry_t));
+    entryPtr->addr       = addr;
+    entryPtr->value      = value;
+    entryPtr->numByte    = numByte;
+    entryPtr->lockPtr    = GET_LOCK(addr);
+    entryPtr->isAcquired = FALSE;
+    insertIndex(threadPtr->writeIndex, threadPtr->writeIndexCapacity,
+                addr, position);
+
+    return entryPtr;
+}
+
+
+/* =============================================================================
+ * isOwner
+ * =============================================================================
+ */
+static inline bool_t
+isOwner (stm_thread_t* threadPtr, unsigned long l)
+{
+    return (LOCK_GET_SLOT(l) == threadPtr->slot);
+}
+
+
+/* =============================================================================
+ * validateRange
+ * -- Returns TRUE if none of the first numRead locations read has been
+ *    committed to since readVersion
+ * =============================================================================
+ */
+static bool_t
+validateRange (stm_thread_t* threadPtr, long numRead)
+{
+    stm_lock_t** locks = (stm_lock_t**)threadPtr->readSet.elements;
+    unsigned long readVersion = threadPtr->readVersion;
+    long r;
+
+    for (r = 0; r < numRead; r++) {
+        unsigned long l = __atomic_load_n(locks[r], __ATOMIC_ACQUIRE);
+        if (LOCK_IS_OWNED(l)) {
+            if (!isOwner(threadPtr, l)) {
+                return FALSE;
+            }
+            l = ((stm_entry_t*)threadPtr->writeSet.elements)
+                [LOCK_GET_INDEX(l)].prevLock;
+        }
+        if (LOCK_GET_VERSION(l) > readVersion) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * validate
+ * -- Returns TRUE if no location read has been committed to since readVersion
+ * =============================================================================
+ */
+static inline bool_t
+validate (stm_thread_t* threadPtr)
+{
+    return validateRange(threadPtr, threadPtr->readSet.size);
+}
+
+
+/* =============================================================================
+ * extend
+ * -- Moves the snapshot forward if everything read so far is still current
+ * =============================================================================
+ */
+static bool_t
+extend (stm_thread_t* threadPtr)
+{
+    unsigned long now = __atomic_load_n(&global_version.clock, __ATOMIC_ACQUIRE);
+
+    if (!validate(threadPtr)) {
+        return FALSE;
+    }
+    threadPtr->readVersion = now;
+
+    return TRUE;
+}
+
+
+static void abortCompensations (stm_thread_t* threadPtr, long numKeep);
+
+
+/* =============================================================================
+ * rollback
+ * -- Undoes all effects of the current attempt but does not jump
+ * =============================================================================
+ */
+static void
+rollback (stm_thread_t* threadPtr)
+{
+    stm_entry_t* entries = (stm_entry_t*)threadPtr->writeSet.elements;
+    stm_entry_t* undos = (stm_entry_t*)threadPtr->undoLog.elements;
+    void** allocs = (void**)threadPtr->allocLog.elements;
+    long i;
+
+    for (i = 0; i < threadPtr->writeSet.size; i++) {
+        if (entries[i].isAcquired) {
+            __atomic_store_n(entries[i].lockPtr, entries[i].prevLock,
+                             __ATOMIC_RELEASE);
+        }
+    }
+
+    for (i = threadPtr->undoLog.size - 1; i >= 0; i--) {
+        storeValue(undos[i].addr, undos[i].value, undos[i].numByte);
+    }
+
+    for (i = 0; i < threadPtr->allocLog.size; i++) {
+        memory_free(allocs[i]);
+    }
+
+    /* Open children have committed; undo them while we are still in */
+    abortCompensations(threadPtr, 0);
+
+    clearIndex(threadPtr);
+    threadPtr->isInTx = FALSE;
+    if (threadPtr->parentPtr == NULL) {
+        epoch_exit(threadPtr->epochSlot);
+        tmstats_abort(threadPtr->statsPtr);
+    }
+}
+
+
+/* =============================================================================
+ * abortTx
+ * =============================================================================
+ */
+static void
+abortTx (stm_thread_t* threadPtr)
+{
+    rollback(threadPtr);
+
+    if (threadPtr->parentPtr != NULL) {
+        /*
+         * Open child: retry just the child, unless it was killed (the
+         * contention manager only knows our shared slot) or keeps failing.
+         * Compensations must run to completion, so they always retry.
+         */
+        if (cm_isKilled(threadPtr->slot) ||
+            threadPtr->numNestedRetry >= STM_MAX_NESTED_RETRY)
+        {
+            if (!threadPtr->isCompensating) {
+                threadPtr->isRetry = FALSE;
+                abortTx(threadPtr->parentPtr);
+            }
+            cm_reactivate(threadPtr->slot);
+        }
+        threadPtr->isRetry = TRUE;
+        __atomic_add_fetch(&global_numPartialAbort, 1, __ATOMIC_RELAXED);
+        cm_wait(threadPtr->slot, threadPtr->numNestedRetry++);
+        siglongjmp(*threadPtr->envPtr, 1);
+    }
+
+    threadPtr->isRetry = TRUE;
+    cm_onAbort(threadPtr->slot, threadPtr->numAccess);
+    siglongjmp(*threadPtr->envPtr, 1);
+}
+
+
+/* =============================================================================
+ * rollbackNested
+ * -- Undoes the effects of the innermost closed child, keeping its parent's
+ * =============================================================================
+ */
+static void
+rollbackNested (stm_thread_t* threadPtr, stm_nest_t* nestPtr)
+{
+    stm_entry_t* entries = (stm_entry_t*)threadPtr->writeSet.elements;
+    stm_shadow_t* shadows = (stm_shadow_t*)threadPtr->shadowLog.elements;
+    stm_entry_t* undos = (stm_entry_t*)threadPtr->undoLog.elements;
+    void** allocs = (void**)threadPtr->allocLog.elements;
+    long i;
+
+    for (i = threadPtr->shadowLog.size - 1; i >= nestPtr->numShadow; i--) {
+        entries[shadows[i].position].value   = shadows[i].value;
+        entries[shadows[i].position].numByte = shadows[i].numByte;
+    }
+    threadPtr->shadowLog.size = nestPtr->numShadow;
+
+    clearIndex(threadPtr);
+    threadPtr->writeSet.size = nestPtr->numWrite;
+    for (i = 0; i < nestPtr->numWrite; i++) {
+        insertIndex(threadPtr->writeIndex, threadPtr->writeIndexCapacity,
+                    entries[i].addr, i);
+    }
+
+    for (i = threadPtr->undoLog.size - 1; i >= nestPtr->numUndo; i--) {
+        storeValue(undos[i].addr, undos[i].value, undos[i].numByte);
+    }
+    threadPtr->undoLog.size = nestPtr->numUndo;
+
+    for (i = nestPtr->numAlloc; i < threadPtr->allocLog.size; i++) {
+        memory_free(allocs[i]);
+    }
+    threadPtr->allocLog.size = nestPtr->numAlloc;
+
+    threadPtr->freeLog.size = nestPtr->numFree;
+    abortCompensations(threadPtr, nestPtr->numCompensation);
+    threadPtr->readSet.size = nestPtr->numRead;
+}
+
+
+/* =============================================================================
+ * abortNested
+ * -- Restarts only the innermost closed child if what its parent read is
+ *    still valid; otherwise aborts the whole transaction
+ * =============================================================================
+ */
+static void
+abortNested (stm_thread_t* threadPtr)
+{
+    long numNest = threadPtr->nestLog.size;
+
+    if (numNest > 0 &&
+        !threadPtr->isReadOnly &&
+        threadPtr->numNestedRetry < STM_MAX_NESTED_RETRY)
+    {
+        stm_nest_t* nestPtr =
+            &((stm_nest_t*)threadPtr->nestLog.elements)[numNest - 1];
+        unsigned long now = __atomic_load_n(&global_version.clock,
+                                            __ATOMIC_ACQUIRE);
+        if (validateRange(threadPtr, nestPtr->numRead)) {
+            sigjmp_buf* envPtr = nestPtr->envPtr;
+            rollbackNested(threadPtr, nestPtr);
+            threadPtr->nestLog.size--; /* pushed again by stm_beginNested */
+            threadPtr->readVersion = now;
+            __atomic_add_fetch(&global_numPartialAbort, 1, __ATOMIC_RELAXED);
+            cm_wait(threadPtr->slot, threadPtr->numNestedRetry++);
+            siglongjmp(*envPtr, 1);
+        }
+    }
+
+    abortTx(threadPtr);
+}
+
+
+/* =============================================================================
+ * resolveConflict
+ * -- Called while lock word l, owned by another transaction, blocks us
+ * -- Returns when the caller should look at the lock again
+ * =============================================================================
+ */
+static void
+resolveConflict (stm_thread_t* threadPtr, unsigned long l, long numTry)
+{
+    long slot = threadPtr->slot;
+    long enemySlot = LOCK_GET_SLOT(l);
+
+    if (cm_isKilled(slot)) {
+        abortTx(threadPtr);
+    }
+
+    switch (cm_onConflict(slot, enemySlot, numTry, threadPtr->numAccess)) {
+        case CM_ABORT_SELF:
+            abortNested(threadPtr);
+            break;
+        case CM_ABORT_ENEMY:
+            cm_kill(enemySlot);
+            /* Wait for it to notice and release */
+            cm_wait(slot, numTry);
+            break;
+        case CM_WAIT:
+            cm_wait(slot, numTry);
+            break;
+        default:
+            assert(0);
+    }
+}
+
+
+/* =============================================================================
+ * freeHistories
+ * =============================================================================
+ */
+static void
+freeHistories ()
+{
+    long i;
+
+    if (global_histories == NULL) {
+        return;
+    }
+
+    for (i = 0; i < STM_LOCK_TABLE_SIZE; i++) {
+        free(global_histories[i]);
+    }
+    free((void*)global_histories);
+    global_histories = NULL;
+}
+
+
+/* =============================================================================
+ * recordVersions
+ * -- Called at commit with all locks held, before the new values are stored
+ * =============================================================================
+ */
+static void
+recordVersions (stm_thread_t* threadPtr, unsigned long writeVersion)
+{
+    stm_entry_t* entries = (stm_entry_t*)threadPtr->writeSet.elements;
+    long numEntry = threadPtr->writeSet.size;
+    long e;
+
+    for (e = 0; e < numEntry; e++) {
+        stm_entry_t* entryPtr = &entries[e];
+        long stripe = entryPtr->lockPtr - global_locks;
+        stm_history_t* historyPtr = global_histories[stripe];
+        stm_version_t* versionPtr;
+        unsigned long prevLock =
+            entries[LOCK_GET_INDEX(*entryPtr->lockPtr)].prevLock;
+
+        if (historyPtr == NULL) {
+            /* We own the stripe, so nobody else can be allocating it */
+            historyPtr = (stm_history_t*)calloc(1, (sizeof(stm_history_t) +
+                                                    global_numVersion *
+                                                    sizeof(stm_version_t)));
+            assert(historyPtr);
+            __atomic_store_n(&global_histories[stripe], historyPtr,
+                             __ATOMIC_RELEASE);
+        }
+
+        versionPtr = &historyPtr->versions[historyPtr->numAppended %
+                                           global_numVersion];
+        versionPtr->addr    = entryPtr->addr;
+        versionPtr->value   = ((entryPtr->numByte > 0) ?
+                               loadValue(entryPtr->addr, entryPtr->numByte) :
+                               0);
+        versionPtr->numByte = entryPtr->numByte;
+        versionPtr->from    = LOCK_GET_VERSION(prevLock);
+        versionPtr->until   = writeVersion;
+        historyPtr->numAppended++;
+    }
+}
+
+
+/* =============================================================================
+ * findVersion
+ * -- Replaces *valuePtr, the current value of addr, by its value at
+ *    readVersion
+ * -- Returns FALSE if that value is no longer in the history of the stripe
+ * -- The caller re-checks the lock afterwards, since writers may be appending
+ * =============================================================================
+ */
+static bool_t
+findVersion (stm_lock_t* lockPtr,
+             volatile void* addr,
+             size_t numByte,
+             unsigned long readVersion,
+             long* valuePtr)
+{
+    const volatile stm_history_t* historyPtr =
+        __atomic_load_n(&global_histories[lockPtr - global_locks],
+                        __ATOMIC_ACQUIRE);
+    unsigned long numAppended;
+    unsigned long numKept;
+    unsigned long k;
+    char* begin = (char*)addr;
+    char* end = begin + numByte;
+
+    if (historyPtr == NULL) {
+        return FALSE;
+    }
+
+    numAppended = historyPtr->numAppended;
+    numKept = ((numAppended < (unsigned long)global_numVersion) ?
+               numAppended : (unsigned long)global_numVersion);
+
+    /* Newest to oldest, so the last match is the oldest overwrite */
+    for (k = 1; k <= numKept; k++) {
+        const volatile stm_version_t* versionPtr =
+            &historyPtr->versions[(numAppended - k) % global_numVersion];
+        char* first = (char*)versionPtr->addr;
+        if (versionPtr->until <= readVersion) {
+            return TRUE;
+        }
+        if (first < end && begin < first + versionPtr->numByte) {
+            if (first != begin || versionPtr->numByte != (long)numByte) {
+                return FALSE; /* overlaps but is not the same field */
+            }
+            *valuePtr = versionPtr->value;
+        }
+        if (k == numAppended) {
+            /* Oldest commit to the stripe ever */
+            return (versionPtr->from <= readVersion);
+        }
+    }
+
+    return FALSE; /* the ring has wrapped past readVersion */
+}
+
+
+/* =============================================================================
+ * stm_startup
+ * =============================================================================
+ */
+void
+stm_startup ()
+{
+    const char* numVersionString = getenv("TM_RO_VERSIONS");
+
+    global_version.clock = 0;
+    memset((void*)global_locks, 0, sizeof(global_locks));
+    global_numPartialAbort = 0;
+    global_numOpenCommit   = 0;
+    global_numCompensation = 0;
+
+    freeHistories();
+    global_numVersion = 0;
+    if (numVersionString != NULL && numVersionString[0] != '\0') {
+        char* end;
+        long value = strtol(numVersionString, &end, 10);
+        if (*end != '\0' || value < 0) {
+            fprintf(stderr, "Bad TM_RO_VERSIONS=%s; using 0\n",
+                    numVersionString);
+        } else if (value > STM_MAX_VERSION) {
+            fprintf(stderr, "TM_RO_VERSIONS=%s is too large; using %d\n",
+                    numVersionString, STM_MAX_VERSION);
+            global_numVersion = STM_MAX_VERSION;
+        } else {
+            global_numVersion = value;
+        }
+    }
+    if (global_numVersion > 0) {
+        global_histories = (stm_history_t* volatile*)
+            calloc(STM_LOCK_TABLE_SIZE, sizeof(stm_history_t*));
+        assert(global_histories);
+    }
+
+    tmstats_reset();
+    cm_startup();
+    epoch_startup();
+}
+
+
+/* =============================================================================
+ * stm_shutdown
+ * =============================================================================
+ */
+void
+stm_shutdown ()
+{
+    unsigned long numCommit;
+    unsigned long numAbort;
+
+    tmstats_getTotals(&numCommit, &numAbort);
+    printf("STM: commits = %lu, aborts = %lu, irrevocable = %lu"
+           " (contention manager: %s)\n",
+           numCommit, numAbort, cm_getNumIrrevocable(), cm_getPolicyName());
+    if (global_numVersion > 0) {
+        printf("STM: read-only transactions use up to %ld old versions"
+               " per stripe\n", global_numVersion);
+    }
+    if (global_numPartialAbort + global_numOpenCommit > 0) {
+        printf("STM: nested: partial aborts = %lu, open commits = %lu,"
+               " compensations = %lu\n",
+               global_numPartialAbort, global_numOpenCommit,
+               global_numCompensation);
+    }
+    tmstats_print(stdout);
+    epoch_shutdown();
+    freeHistories();
+
+    if (global_threads != NULL) {
+        free(global_threads);
+        global_threads = NULL;
+    }
+}
+
+
+/* =============================================================================
+ * initDescriptor
+ * -- Everything but the id, slots, and statistics
+ * =============================================================================
+ */
+static void
+initDescriptor (stm_thread_t* threadPtr)
+{
+    threadPtr->envPtr         = NULL;
+    threadPtr->isInTx         = FALSE;
+    threadPtr->isRetry        = FALSE;
+    threadPtr->isReadOnly     = FALSE;
+    threadPtr->isRetryWriter  = FALSE;
+    threadPtr->isIrrevocable  = FALSE;
+    threadPtr->readVersion    = 0;
+    threadPtr->numAccess      = 0;
+    log_init(&threadPtr->readSet, sizeof(stm_lock_t*));
+    log_init(&threadPtr->writeSet, sizeof(stm_entry_t));
+    log_init(&threadPtr->undoLog, sizeof(stm_entry_t));
+    log_init(&threadPtr->allocLog, sizeof(void*));
+    log_init(&threadPtr->freeLog, sizeof(void*));
+    threadPtr->writeIndexCapacity = 2 * STM_INIT_LOG_CAPACITY;
+    threadPtr->writeIndex =
+        (long*)calloc(threadPtr->writeIndexCapacity, sizeof(long));
+    assert(threadPtr->writeIndex);
+    log_init(&threadPtr->nestLog, sizeof(stm_nest_t));
+    log_init(&threadPtr->shadowLog, sizeof(stm_shadow_t));
+    log_init(&threadPtr->compensationLog, sizeof(stm_compensation_t));
+    threadPtr->numNestedRetry = 0;
+    threadPtr->isCompensating = FALSE;
+    threadPtr->parentPtr      = NULL;
+    threadPtr->openPtr        = NULL;
+}
+
+
+/* =============================================================================
+ * freeDescriptor
+ * -- Also frees the descriptors of open children
+ * =============================================================================
+ */
+static void
+freeDescriptor (stm_thread_t* threadPtr)
+{
+    if (threadPtr->openPtr != NULL) {
+        freeDescriptor(threadPtr->openPtr);
+    }
+    free(threadPtr->readSet.elements);
+    free(threadPtr->writeSet.elements);
+    free(threadPtr->undoLog.elements);
+    free(threadPtr->allocLog.elements);
+    free(threadPtr->freeLog.elements);
+    free(threadPtr->writeIndex);
+    free(threadPtr->nestLog.elements);
+    free(threadPtr->shadowLog.elements);
+    free(threadPtr->compensationLog.elements);
+    free(threadPtr);
+}
+
+
+/* =============================================================================
+ * stm_newThread
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+stm_thread_t*
+stm_newThread ()
+{
+    stm_thread_t* threadPtr;
+
+    /* Keep descriptors of different threads on different cache lines */
+    if (posix_memalign((void**)&threadPtr,
+                       STM_CACHE_LINE_SIZE,
+                       sizeof(stm_thread_t)) != 0)
+    {
+        return NULL;
+    }
+
+    threadPtr->id            = -1;
+    threadPtr->slot          = cm_newThread();
+    if (threadPtr->slot < 0) {
+        free(threadPtr);
+        return NULL;
+    }
+    threadPtr->epochSlot     = epoch_newThread();
+    if (threadPtr->epochSlot < 0) {
+        cm_freeThread(threadPtr->slot);
+        free(threadPtr);
+        return NULL;
+    }
+    threadPtr->statsPtr = tmstats_newThread();
+    assert(threadPtr->statsPtr);
+    initDescriptor(threadPtr);
+
+    return threadPtr;
+}
+
+
+/* =============================================================================
+ * stm_initThread
+ * =============================================================================
+ */
+void
+stm_initThread (stm_thread_t* threadPtr, long id)
+{
+    threadPtr->id = id;
+}
+
+
+/* =============================================================================
+ * stm_freeThread
+ * =============================================================================
+ */
+void
+stm_freeThread (stm_thread_t* threadPtr)
+{
+    tmstats_freeThread(threadPtr->statsPtr);
+    cm_freeThread(threadPtr->slot);
+    epoch_freeThread(threadPtr->epochSlot);
+    freeDescriptor(threadPtr);
+}
+
+
+/* =============================================================================
+ * stm_newThreads
+ * =============================================================================
+ */
+void
+stm_newThreads (long numThread)
+{
+    long i;
+
+    assert(global_threads == NULL);
+    global_threads = (stm_thread_t**)malloc(numThread * sizeof(stm_thread_t*));
+    assert(global_threads);
+    for (i = 0; i < numThread; i++) {
+        global_threads[i] = stm_newThread();
+        assert(global_threads[i]);
+        stm_initThread(global_threads[i], i);
+    }
+}
+
+
+/* =============================================================================
+ * stm_getThread
+ * =============================================================================
+ */
+stm_thread_t*
+stm_getThread (long id)
+{
+    return global_threads[id];
+}
+
+
+/* =============================================================================
+ * stm_start
+ * =============================================================================
+ */
+void
+stm_start (stm_thread_t* threadPtr,
+           sigjmp_buf* envPtr,
+           bool_t isReadOnly,
+           bool_t isIrrevocable,
+           tmstats_site_t* sitePtr)
+{
+    tmstats_begin(threadPtr->statsPtr, sitePtr);
+    threadPtr->isIrrevocable =
+        cm_begin(threadPtr->slot, threadPtr->isRetry, isIrrevocable);
+    epoch_enter(threadPtr->epochSlot);
+
+    threadPtr->envPtr        = envPtr;
+    threadPtr->isInTx        = TRUE;
+    threadPtr->isReadOnly    = (isReadOnly &&
+                                !threadPtr->isRetryWriter &&
+                                !threadPtr->isIrrevocable);
+    threadPtr->numAccess     = 0;
+    threadPtr->hasNarrowWrite = FALSE;
+    threadPtr->readSet.size  = 0;
+    threadPtr->writeSet.size = 0;
+    threadPtr->undoLog.size  = 0;
+    threadPtr->allocLog.size = 0;
+    threadPtr->freeLog.size  = 0;
+    threadPtr->nestLog.size  = 0;
+    threadPtr->shadowLog.size = 0;
+    threadPtr->compensationLog.size = 0;
+    threadPtr->numNestedRetry = 0;
+    threadPtr->readVersion   =
+        __atomic_load_n(&global_version.clock, __ATOMIC_ACQUIRE);
+}
+
+
+/* =============================================================================
+ * acquireLocks
+ * -- Conflicts with other committers are settled by the contention manager
+ * =============================================================================
+ */
+static void
+acquireLocks (stm_thread_t* threadPtr)
+{
+    stm_entry_t* entries = (stm_entry_t*)threadPtr->writeSet.elements;
+    long numEntry = threadPtr->writeSet.size;
+    long e;
+
+    for (e = 0; e < numEntry; e++) {
+        stm_entry_t* entryPtr = &entries[e];
+        stm_lock_t* lockPtr = entryPtr->lockPtr;
+        long numTry = 0;
+        while (1) {
+            unsigned long l = __atomic_load_n(lockPtr, __ATOMIC_ACQUIRE);
+            if (LOCK_IS_OWNED(l)) {
+                if (isOwner(threadPtr, l)) {
+                    break; /* another entry in this stripe took it */
+                }
+                resolveConflict(threadPtr, l, numTry++);
+                continue;
+            }
+            if (__atomic_compare_exchange_n(lockPtr,
+                                            &l,
+                                            LOCK_MAKE_OWNED(threadPtr->slot, e),
+                                            FALSE,
+                                            __ATOMIC_ACQ_REL,
+                                            __ATOMIC_RELAXED))
+            {
+                entryPtr->prevLock = l;
+                entryPtr->isAcquired = TRUE;
+                break;
+            }
+        }
+    }
+}
+
+
+/* =============================================================================
+ * commitWrites
+ * -- Makes the write set visible; returns only on success
+ * =============================================================================
+ */
+static void
+commitWrites (stm_thread_t* threadPtr)
+{
+    stm_entry_t* entries = (stm_entry_t*)threadPtr->writeSet.elements;
+    long numEntry = threadPtr->writeSet.size;
+    unsigned long writeVersion;
+    long i;
+
+    if (numEntry > 0) {
+        acquireLocks(threadPtr);
+
+        /* Past this point enemies can no longer kill us */
+        if (!cm_tryCommit(threadPtr->slot)) {
+            abortTx(threadPtr);
+        }
+
+        writeVersion =
+            __atomic_add_fetch(&global_version.clock, 1, __ATOMIC_ACQ_REL);
+
+        /* If nobody else committed since we started, the reads are current */
+        if (writeVersion != threadPtr->readVersion + 1) {
+            if (!validate(threadPtr)) {
+                abortTx(threadPtr);
+            }
+        }
+
+        if (global_numVersion > 0) {
+            recordVersions(threadPtr, writeVersion);
+        }
+
+        for (i = 0; i < numEntry; i++) {
+            storeValue(entries[i].addr, entries[i].value, entries[i].numByte);
+        }
+
+        for (i = 0; i < numEntry; i++) {
+            if (entries[i].isAcquired) {
+                __atomic_store_n(entries[i].lockPtr,
+                                 LOCK_MAKE_VERSION(writeVersion),
+                                 __ATOMIC_RELEASE);
+            }
+        }
+
+        clearIndex(threadPtr);
+    }
+}
+
+
+/* =============================================================================
+ * stm_commit
+ * =============================================================================
+ */
+void
+stm_commit (stm_thread_t* threadPtr)
+{
+    void** frees = (void**)threadPtr->freeLog.elements;
+    long i;
+
+    commitWrites(threadPtr);
+
+    epoch_exit(threadPtr->epochSlot);
+
+    /* Doomed readers may still hold pointers into freed memory */
+    for (i = 0; i < threadPtr->freeLog.size; i++) {
+        epoch_retire(threadPtr->epochSlot, frees[i]);
+    }
+
+    threadPtr->isInTx = FALSE;
+    threadPtr->isRetry = FALSE;
+    threadPtr->isRetryWriter = FALSE;
+    threadPtr->isIrrevocable = FALSE;
+    cm_onCommit(threadPtr->slot);
+    tmstats_commit(threadPtr->statsPtr);
+}
+
+
+/* =============================================================================
+ * stm_restart
+ * =============================================================================
+ */
+void
+stm_restart (stm_thread_t* threadPtr)
+{
+    assert(!threadPtr->isIrrevocable);
+    abortTx(threadPtr);
+}
+
+
+/* =============================================================================
+ * stm_beginNested
+ * =============================================================================
+ */
+void
+stm_beginNested (stm_thread_t* threadPtr, sigjmp_buf* envPtr)
+{
+    stm_nest_t* nestPtr;
+
+    if (!threadPtr->isInTx) {
+        return;
+    }
+
+    nestPtr = (stm_nest_t*)log_append(&threadPtr->nestLog, sizeof(stm_nest_t));
+    nestPtr->envPtr          = envPtr;
+    nestPtr->numRead         = threadPtr->readSet.size;
+    nestPtr->numWrite        = threadPtr->writeSet.size;
+    nestPtr->numShadow       = threadPtr->shadowLog.size;
+    nestPtr->numUndo         = threadPtr->undoLog.size;
+    nestPtr->numAlloc        = threadPtr->allocLog.size;
+    nestPtr->numFree         = threadPtr->freeLog.size;
+    nestPtr->numCompensation = threadPtr->compensationLog.size;
+}
+
+
+/* =============================================================================
+ * stm_endNested
+ * -- The child's effects now belong to its parent
+ * =============================================================================
+ */
+void
+stm_endNested (stm_thread_t* threadPtr)
+{
+    if (!threadPtr->isInTx) {
+        return;
+    }
+
+    assert(threadPtr->nestLog.size > 0);
+    threadPtr->nestLog.size--;
+    if (threadPtr->nestLog.size == 0) {
+        threadPtr->shadowLog.size = 0;
+    }
+    threadPtr->numNestedRetry = 0;
+}
+
+
+/* =============================================================================
+ * stm_getOpen
+ * =============================================================================
+ */
+stm_thread_t*
+stm_getOpen (stm_thread_t* threadPtr)
+{
+    stm_thread_t* openPtr;
+
+    if (!threadPtr->isInTx || threadPtr->isIrrevocable) {
+        return threadPtr; /* nothing to stay open from */
+    }
+
+    if (threadPtr->openPtr != NULL) {
+        return threadPtr->openPtr;
+    }
+
+    /* Shares the slots of the thread, which stays in its transaction */
+    if (posix_memalign((void**)&openPtr,
+                       STM_CACHE_LINE_SIZE,
+                       sizeof(stm_thread_t)) != 0)
+    {
+        assert(0);
+    }
+    openPtr->id        = threadPtr->id;
+    openPtr->slot      = threadPtr->slot;
+    openPtr->epochSlot = threadPtr->epochSlot;
+    openPtr->statsPtr  = threadPtr->statsPtr;
+    initDescriptor(openPtr);
+    openPtr->parentPtr = threadPtr;
+    threadPtr->openPtr = openPtr;
+
+    return openPtr;
+}
+
+
+/* =============================================================================
+ * stm_beginOpen
+ * =============================================================================
+ */
+void
+stm_beginOpen (stm_thread_t* threadPtr, sigjmp_buf* envPtr)
+{
+    if (threadPtr->parentPtr == NULL) {
+        return; /* stm_getOpen returned the thread itself */
+    }
+
+    if (!threadPtr->isRetry) {
+        threadPtr->numNestedRetry = 0;
+    }
+    threadPtr->envPtr        = envPtr;
+    threadPtr->isInTx        = TRUE;
+    threadPtr->numAccess     = 0;
+    threadPtr->hasNarrowWrite = FALSE;
+    threadPtr->readSet.size  = 0;
+    threadPtr->writeSet.size = 0;
+    threadPtr->undoLog.size  = 0;
+    threadPtr->allocLog.size = 0;
+    threadPtr->freeLog.size  = 0;
+    threadPtr->nestLog.size  = 0;
+    threadPtr->shadowLog.size = 0;
+    threadPtr->compensationLog.size = 0;
+    threadPtr->readVersion   =
+        __atomic_load_n(&global_version.clock, __ATOMIC_ACQUIRE);
+}
+
+
+/* =============================================================================
+ * stm_endOpen
+ * =============================================================================
+ */
+void
+stm_endOpen (stm_thread_t* threadPtr)
+{
+    stm_thread_t* parentPtr = threadPtr->parentPtr;
+    stm_compensation_t* compensations;
+    void** frees;
+    long i;
+
+    if (parentPtr == NULL) {
+        return;
+    }
+
+    commitWrites(threadPtr);
+    if (threadPtr->writeSet.size > 0) {
+        cm_reactivate(threadPtr->slot); /* the parent goes on */
+    }
+
+    frees = (void**)threadPtr->freeLog.elements;
+    for (i = 0; i < threadPtr->freeLog.size; i++) {
+        epoch_retire(threadPtr->epochSlot, frees[i]);
+    }
+
+    /* Compensations of a compensation are not needed */
+    compensations = (stm_compensation_t*)threadPtr->compensationLog.elements;
+    if (!threadPtr->isCompensating) {
+        for (i = 0; i < threadPtr->compensationLog.size; i++) {
+            *(stm_compensation_t*)log_append(&parentPtr->compensationLog,
+                                             sizeof(stm_compensation_t)) =
+                compensations[i];
+        }
+    }
+
+    threadPtr->isInTx = FALSE;
+    threadPtr->isRetry = FALSE;
+    __atomic_add_fetch(&global_numOpenCommit, 1, __ATOMIC_RELAXED);
+}
+
+
+/* =============================================================================
+ * stm_compensate
+ * =============================================================================
+ */
+void
+stm_compensate (stm_thread_t* threadPtr,
+                stm_compensation_handler_t handler,
+                void* argPtr)
+{
+    stm_compensation_t* compensationPtr;
+
+    if (threadPtr->parentPtr == NULL || !threadPtr->isInTx) {
+        return; /* not in an open child; the effects are rolled back anyway */
+    }
+
+    compensationPtr =
+        (stm_compensation_t*)log_append(&threadPtr->compensationLog,
+                                        sizeof(stm_compensation_t));
+    compensationPtr->handler = handler;
+    compensationPtr->argPtr  = argPtr;
+}
+
+
+/* =============================================================================
+ * runCompensation
+ * -- Runs handler as an open child of threadPtr until it commits
+ * =============================================================================
+ */
+static void
+runCompensation (stm_thread_t* threadPtr,
+                 stm_compensation_handler_t handler,
+                 void* argPtr)
+{
+    stm_thread_t* openPtr = stm_getOpen(threadPtr);
+    sigjmp_buf env;
+
+    openPtr->isCompensating = TRUE;
+    sigsetjmp(env, 0);
+    stm_beginOpen(openPtr, &env);
+    handler(openPtr, argPtr);
+    stm_endOpen(openPtr);
+    openPtr->isCompensating = FALSE;
+    __atomic_add_fetch(&global_numCompensation, 1, __ATOMIC_RELAXED);
+}
+
+
+/* =============================================================================
+ * runCompensations
+ * -- Runs the compensations past the first numKeep, newest first
+ * =============================================================================
+ */
+static void
+runCompensations (stm_thread_t* threadPtr, long numKeep)
+{
+    while (threadPtr->compensationLog.size > numKeep) {
+        stm_compensation_t compensation =
+            ((stm_compensation_t*)threadPtr->compensationLog.elements)
+            [--threadPtr->compensationLog.size];
+        runCompensation(threadPtr, compensation.handler, compensation.argPtr);
+    }
+}
+
+
+/* =============================================================================
+ * abortCompensations
+ * -- Settles the compensations past the first numKeep of an aborting attempt
+ * -- Only a top-level transaction runs them: an open child's log holds what
+ *    it registered itself, which stm_endOpen has not handed to the parent
+ *    because the child never committed
+ * =============================================================================
+ */
+static void
+abortCompensations (stm_thread_t* threadPtr, long numKeep)
+{
+    if (threadPtr->parentPtr == NULL) {
+        runCompensations(threadPtr, numKeep);
+    } else {
+        threadPtr->compensationLog.size = numKeep;
+    }
+}
+
+
+/* =============================================================================
+ * readSnapshot
+ * -- Read-only transactions with old versions: reads at readVersion never
+ *    look at newer commits, so the snapshot stays consistent without logging
+ * -- Never kills the owner of a lock; write-back is short, so just wait
+ * =============================================================================
+ */
+static long
+readSnapshot (stm_thread_t* threadPtr, volatile void* addr, size_t numByte)
+{
+    stm_lock_t* lockPtr = GET_LOCK(addr);
+    long numTry = 0;
+
+    while (1) {
+        unsigned long l1 = __atomic_load_n(lockPtr, __ATOMIC_ACQUIRE);
+        unsigned long l2;
+        long value;
+        bool_t isFound = TRUE;
+        if (LOCK_IS_OWNED(l1)) {
+            cm_wait(threadPtr->slot, numTry++);
+            continue;
+        }
+        value = loadValue(addr, numByte);
+        if (LOCK_GET_VERSION(l1) > threadPtr->readVersion) {
+            isFound = findVersion(lockPtr, addr, numByte,
+                                  threadPtr->readVersion, &value);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        l2 = __atomic_load_n(lockPtr, __ATOMIC_RELAXED);
+        if (l1 != l2) {
+            continue;
+        }
+        if (!isFound) {
+            abortTx(threadPtr);
+        }
+        return value;
+    }
+}
+
+
+/* =============================================================================
+ * findOverlaps
+ * -- Sets overlaps[] to the write-set entries holding bytes of the naturally
+ *    aligned access [addr, addr + numByte), which all start in its word
+ * -- Returns their number; they never overlap each other (see stm_write)
+ * =============================================================================
+ */
+static long
+findOverlaps (stm_thread_t* threadPtr,
+              volatile void* addr,
+              size_t numByte,
+              stm_entry_t** overlaps)
+{
+    char* begin = (char*)addr;
+    char* end = begin + numByte;
+    char* a = (char*)((unsigned long)addr & ~(sizeof(long) - 1));
+    long numOverlap = 0;
+
+    assert(((unsigned long)addr & (numByte - 1)) == 0);
+
+    for (; a < end; a++) {
+        stm_entry_t* entryPtr = findEntry(threadPtr, (volatile void*)a);
+        if (entryPtr != NULL &&
+            entryPtr->numByte > 0 &&
+            begin < (a + entryPtr->numByte))
+        {
+            overlaps[numOverlap++] = entryPtr;
+        }
+    }
+
+    return numOverlap;
+}
+
+
+/* =============================================================================
+ * overlay
+ * -- Returns value, read from addr, with the bytes of overlaps[] laid over it
+ * =============================================================================
+ */
+static long
+overlay (volatile void* addr, size_t numByte, long value,
+         stm_entry_t** overlaps, long numOverlap)
+{
+    unsigned long word = (unsigned long)addr & ~(sizeof(long) - 1);
+    long buffer;
+    char* bytes = (char*)&buffer;
+    long i;
+
+    storeValue(bytes + ((unsigned long)addr - word), value, numByte);
+    for (i = 0; i < numOverlap; i++) {
+        storeValue(bytes + ((unsigned long)overlaps[i]->addr - word),
+                   overlaps[i]->value,
+                   overlaps[i]->numByte);
+    }
+
+    return loadValue(bytes + ((unsigned long)addr - word), numByte);
+}
+
+
+/* =============================================================================
+ * readShared
+ * -- Reads addr from memory and logs its lock
+ * =============================================================================
+ */
+static long
+readShared (stm_thread_t* threadPtr, volatile void* addr, size_t numByte)
+{
+    stm_lock_t* lockPtr = GET_LOCK(addr);
+    long numTry = 0;
+
+    threadPtr->numAccess++;
+
+    while (1) {
+        unsigned long l1 = __atomic_load_n(lockPtr, __ATOMIC_ACQUIRE);
+        unsigned long l2;
+        long value;
+        if (LOCK_IS_OWNED(l1)) {
+            resolveConflict(threadPtr, l1, numTry++);
+            continue;
+        }
+        value = loadValue(addr, numByte);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        l2 = __atomic_load_n(lockPtr, __ATOMIC_RELAXED);
+        if (l1 != l2) {
+            continue;
+        }
+        if (LOCK_GET_VERSION(l1) > threadPtr->readVersion) {
+            if (threadPtr->isReadOnly) {
+                abortTx(threadPtr);
+            }
+            if (!extend(threadPtr)) {
+                abortNested(threadPtr);
+            }
+            continue;
+        }
+        if (!threadPtr->isReadOnly) {
+            *(stm_lock_t**)log_append(&threadPtr->readSet,
+                                      sizeof(stm_lock_t*)) = lockPtr;
+        }
+        return value;
+    }
+}
+
+
+/* =============================================================================
+ * stm_read
+ * -- Words without narrow writes (the common case) are looked up directly;
+ *    otherwise every buffered write overlapping the access is laid over it
+ * =============================================================================
+ */
+long
+stm_read (stm_thread_t* threadPtr, volatile void* addr, size_t numByte)
+{
+    if (!threadPtr->isInTx || threadPtr->isIrrevocable) {
+        return loadValue(addr, numByte);
+    }
+
+    if (threadPtr->isReadOnly && global_numVersion > 0) {
+        threadPtr->numAccess++;
+        return readSnapshot(threadPtr, addr, numByte);
+    }
+
+    if (threadPtr->isReadOnly) {
+        return readShared(threadPtr, addr, numByte);
+    }
+
+    if (numByte == sizeof(long) && !threadPtr->hasNarrowWrite) {
+        stm_entry_t* entryPtr = findEntry(threadPtr, addr);
+        if (entryPtr != NULL && entryPtr->numByte == (long)numByte) {
+            return entryPtr->value;
+        }
+    } else {
+        stm_entry_t* overlaps[sizeof(long)];
+        long numOverlap = findOverlaps(threadPtr, addr, numByte, overlaps);
+        if (numOverlap == 1 &&
+            overlaps[0]->addr == addr &&
+            overlaps[0]->numByte == (long)numByte)
+        {
+            return overlaps[0]->value;
+        }
+        if (numOverlap > 0) {
+            return overlay(addr, numByte,
+                           readShared(threadPtr, addr, numByte),
+                           overlaps, numOverlap);
+        }
+    }
+
+    return readShared(threadPtr, addr, numByte);
+}
+
+
+/* =============================================================================
+ * stm_readFloat
+ * =============================================================================
+ */
+float
+stm_readFloat (stm_thread_t* threadPtr, volatile float* addr)
+{
+    union {
+        int i;
+        float f;
+    } convert;
+
+    convert.i = (int)stm_read(threadPtr, (volatile void*)addr, sizeof(float));
+
+    return convert.f;
+}
+
+
+/* =============================================================================
+ * shadowEntry
+ * -- Saves an entry of the parent before the running closed child changes it
+ * =============================================================================
+ */
+static void
+shadowEntry (stm_thread_t* threadPtr, stm_entry_t* entryPtr)
+{
+    long numNest = threadPtr->nestLog.size;
+    long position = entryPtr - (stm_entry_t*)threadPtr->writeSet.elements;
+
+    if (numNest > 0 &&
+        position <
+        ((stm_nest_t*)threadPtr->nestLog.elements)[numNest - 1].numWrite)
+    {
+        stm_shadow_t* shadowPtr =
+            (stm_shadow_t*)log_append(&threadPtr->shadowLog,
+                                      sizeof(stm_shadow_t));
+        shadowPtr->position = position;
+        shadowPtr->value    = entryPtr->value;
+        shadowPtr->numByte  = entryPtr->numByte;
+    }
+}
+
+
+/* =============================================================================
+ * setEntry
+ * -- Buffers value in the entry of addr, creating it if needed
+ * =============================================================================
+ */
+static void
+setEntry (stm_thread_t* threadPtr,
+          volatile void* addr, long value, size_t numByte)
+{
+    stm_entry_t* entryPtr = findEntry(threadPtr, addr);
+
+    if (entryPtr != NULL) {
+        shadowEntry(threadPtr, entryPtr);
+        entryPtr->value = value;
+        entryPtr->numByte = numByte;
+    } else {
+        appendEntry(threadPtr, addr, value, numByte);
+    }
+}
+
+
+/* =============================================================================
+ * mergeWrite
+ * -- Replaces the entries overlapping a write by one entry for its whole
+ *    word, so that no buffered bytes are lost or written back out of order
+ * -- Bytes of the word that were not written are read, so a commit that
+ *    changes them in the meantime makes this transaction abort
+ * =============================================================================
+ */
+static void
+mergeWrite (stm_thread_t* threadPtr,
+            volatile void* addr, long value, size_t numByte)
+{
+    unsigned long word = (unsigned long)addr & ~(sizeof(long) - 1);
+    stm_entry_t* overlaps[sizeof(long)];
+    long numOverlap;
+    long wordValue;
+    long i;
+
+    numOverlap = findOverlaps(threadPtr, (volatile void*)word, sizeof(long),
+                              overlaps);
+    wordValue = overlay((volatile void*)word, sizeof(long),
+                        readShared(threadPtr, (volatile void*)word,
+                                   sizeof(long)),
+                        overlaps, numOverlap);
+    storeValue((char*)&wordValue + ((unsigned long)addr - word),
+               value, numByte);
+
+    for (i = 0; i < numOverlap; i++) {
+        if (overlaps[i]->addr != (volatile void*)word) {
+            shadowEntry(threadPtr, overlaps[i]);
+            overlaps[i]->numByte = 0; /* keeps only the lock */
+        }
+    }
+
+    setEntry(threadPtr, (volatile void*)word, wordValue, sizeof(long));
+}
+
+
+/* =============================================================================
+ * stm_write
+ * -- Write-set entries never overlap: once a transaction writes fewer bytes
+ *    than a word, writes that overlap a differently placed or sized entry
+ *    are merged into one entry for the word (see mergeWrite)
+ * =============================================================================
+ */
+void
+stm_write (stm_thread_t* threadPtr,
+           volatile void* addr, long value, size_t numByte)
+{
+    if (!threadPtr->isInTx || threadPtr->isIrrevocable) {
+        storeValue(addr, value, numByte);
+        return;
+    }
+
+    if (threadPtr->isReadOnly) {
+        threadPtr->isRetryWriter = TRUE;
+        abortTx(threadPtr);
+    }
+
+    threadPtr->numAccess++;
+    if (numByte < sizeof(long)) {
+        threadPtr->hasNarrowWrite = TRUE;
+    }
+
+    if (threadPtr->hasNarrowWrite) {
+        stm_entry_t* overlaps[sizeof(long)];
+        long numOverlap = findOverlaps(threadPtr, addr, numByte, overlaps);
+        if (numOverlap > 1 ||
+            (numOverlap == 1 &&
+             (overlaps[0]->addr != addr ||
+              overlaps[0]->numByte != (long)numByte)))
+        {
+            mergeWrite(threadPtr, addr, value, numByte);
+            return;
+        }
+    }
+
+    setEntry(threadPtr, addr, value, numByte);
+}
+
+
+/* =============================================================================
+ * stm_writeFloat
+ * =============================================================================
+ */
+void
+stm_writeFloat (stm_thread_t* threadPtr, volatile float* addr, float value)
+{
+    union {
+        int i;
+        float f;
+    } convert;
+
+    convert.f = value;
+    stm_write(threadPtr, (volatile void*)addr, (long)convert.i, sizeof(float));
+}
+
+
+/* =============================================================================
+ * stm_writeLocal
+ * =============================================================================
+ */
+void
+stm_writeLocal (stm_thread_t* threadPtr,
+                volatile void* addr, long value, size_t numByte)
+{
+    if (threadPtr->isInTx && !threadPtr->isIrrevocable) {
+        stm_entry_t* undoPtr =
+            (stm_entry_t*)log_append(&threadPtr->undoLog, sizeof(stm_entry_t));
+        undoPtr->addr    = addr;
+        undoPtr->value   = loadValue(addr, numByte);
+        undoPtr->numByte = numByte;
+    }
+
+    storeValue(addr, value, numByte);
+}
+
+
+/* =============================================================================
+ * stm_writeLocalFloat
+ * =============================================================================
+ */
+void
+stm_writeLocalFloat (stm_thread_t* threadPtr, volatile float* addr, float value)
+{
+    union {
+        int i;
+        float f;
+    } convert;
+
+    convert.f = value;
+    stm_writeLocal(threadPtr, (volatile void*)addr, (long)convert.i, sizeof(float));
+}
+
+
+/* =============================================================================
+ * stm_alloc
+ * =============================================================================
+ */
+void*
+stm_alloc (stm_thread_t* threadPtr, size_t numByte)
+{
+    void* ptr = memory_alloc(numByte);
+
+    if (ptr != NULL && threadPtr->isInTx && !threadPtr->isIrrevocable) {
+        *(void**)log_append(&threadPtr->allocLog, sizeof(void*)) = ptr;
+    }
+
+    return ptr;
+}
+
+
+/* =============================================================================
+ * stm_allocType
+ * =============================================================================
+ */
+void*
+stm_allocType (stm_thread_t* threadPtr, memory_type_t* typePtr)
+{
+    void* ptr = memory_allocType(typePtr);
+
+    if (ptr != NULL && threadPtr->isInTx && !threadPtr->isIrrevocable) {
+        *(void**)log_append(&threadPtr->allocLog, sizeof(void*)) = ptr;
+    }
+
+    return ptr;
+}
+
+
+/* =============================================================================
+ * stm_free
+ * =============================================================================
+ */
+void
+stm_free (stm_thread_t* threadPtr, void* ptr)
+{
+    char* addr;
+    char* last;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    /* Irrevocable: no other transaction can hold a pointer into the block */
+    if (!threadPtr->isInTx || threadPtr->isIrrevocable) {
+        memory_free(ptr);
+        return;
+    }
+
+    if (threadPtr->isReadOnly) {
+        threadPtr->isRetryWriter = TRUE;
+        abortTx(threadPtr);
+    }
+
+    *(void**)log_append(&threadPtr->freeLog, sizeof(void*)) = ptr;
+
+    /*
+     * Bump the version of every stripe covering the block so that
+     * transactions still holding a pointer into it abort early; the memory
+     * itself is not reused until they have finished (see epoch.h).
+     */
+    last = (char*)ptr + memory_usableSize(ptr);
+    for (addr = (char*)ptr; addr < last; addr += (1L << STM_LOCK_SHIFT)) {
+        if (findEntry(threadPtr, (volatile void*)addr) == NULL) {
+            appendEntry(threadPtr, (volatile void*)addr, 0, 0);
+        }
+    }
+}
+
+
+/* =============================================================================
+ * TEST_STM
+ * =============================================================================
+ */
+#ifdef TEST_STM
+
+
+#include <sched.h>
+#include "thread.h"
+#include "tm.h"
+
+#define NUM_THREAD     (4)
+#define NUM_ACCOUNT    (64)
+#define NUM_TRANSFER   (100000)
+#define INIT_BALANCE   (1000)
+#define AUDIT_PERIOD   (1000)
+
+#define NUM_NEST       (20000)
+
+long global_accounts[NUM_ACCOUNT];
+int global_counters[2];
+float global_total;
+long global_private[NUM_THREAD];
+long global_hot[2];
+long global_numOpen;
+long global_openCounter;
+
+typedef union mixed {
+    long word;
+    int halves[2];
+    char bytes[sizeof(long)];
+} mixed_t;
+
+mixed_t global_mixedPrivate[NUM_THREAD];
+mixed_t global_mixedShared;
+
+
+static void
+transfer (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    unsigned long seed = (unsigned long)id + 1;
+    long i;
+
+    for (i = 0; i < NUM_TRANSFER; i++) {
+        long from;
+        long to;
+        seed = seed * 1103515245 + 12345;
+        from = (seed >> 8) % NUM_ACCOUNT;
+        to = (seed >> 20) % NUM_ACCOUNT;
+        if (i % AUDIT_PERIOD == 0) {
+            /* Runs alone, so it always sees a consistent total */
+            long total = 0;
+            long a;
+            TM_BEGIN_IRREVOCABLE();
+            for (a = 0; a < NUM_ACCOUNT; a++) {
+                total += (long)TM_SHARED_READ(global_accounts[a]);
+            }
+            TM_END();
+            assert(total == NUM_ACCOUNT * INIT_BALANCE);
+        }
+        if (i % AUDIT_PERIOD == AUDIT_PERIOD / 2) {
+            /* Aborts or reads old versions; never sees half a transfer */
+            long total;
+            long a;
+            TM_BEGIN_RO();
+            total = 0;
+            for (a = 0; a < NUM_ACCOUNT; a++) {
+                if (a % 16 == 0) {
+                    sched_yield(); /* let writers commit mid-scan */
+                }
+                total += (long)TM_SHARED_READ(global_accounts[a]);
+            }
+            TM_END();
+            assert(total == NUM_ACCOUNT * INIT_BALANCE);
+        }
+        TM_BEGIN();
+        long balance = (long)TM_SHARED_READ(global_accounts[from]);
+        TM_SHARED_WRITE(global_accounts[from], balance - 1);
+        balance = (long)TM_SHARED_READ(global_accounts[to]);
+        TM_SHARED_WRITE(global_accounts[to], balance + 1);
+        /* adjacent 4-byte fields must not clobber each other */
+        TM_SHARED_WRITE(global_counters[id % 2],
+                        TM_SHARED_READ(global_counters[id % 2]) + 1);
+        TM_SHARED_WRITE_F(global_total, TM_SHARED_READ_F(global_total) + 1.0);
+        TM_END();
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+static void
+uncount (TM_ARGDECL  void* argPtr)
+{
+    TM_SHARED_WRITE(global_numOpen, TM_SHARED_READ(global_numOpen) - 1);
+}
+
+
+static void
+nest (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    long i;
+
+    for (i = 0; i < NUM_NEST; i++) {
+        TM_BEGIN();
+        /* Only we write this, so a child's conflict never invalidates it */
+        TM_SHARED_WRITE(global_private[id],
+                        TM_SHARED_READ(global_private[id]) + 1);
+        TM_BEGIN_NESTED();
+        long hot = (long)TM_SHARED_READ(global_hot[0]);
+        if (i % 64 == id) {
+            sched_yield(); /* let others commit, so that the next read fails */
+        }
+        TM_SHARED_WRITE(global_hot[1], TM_SHARED_READ(global_hot[1]) + 1);
+        TM_SHARED_WRITE(global_hot[0], hot + 1);
+        /* Overwrites the parent's entry; undone if the child restarts */
+        TM_SHARED_WRITE(global_private[id],
+                        TM_SHARED_READ(global_private[id]) + 1);
+        TM_END_NESTED();
+        /* Visible at once; taken back if the transaction aborts */
+        TM_BEGIN_OPEN();
+        TM_SHARED_WRITE(global_numOpen, TM_SHARED_READ(global_numOpen) + 1);
+        TM_COMPENSATE(uncount, NULL);
+        TM_END_OPEN();
+        if (i % 64 == 32 + id) {
+            sched_yield(); /* let others commit, so that the commit fails */
+        }
+        TM_END();
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+static void
+undoIncrement (TM_ARGDECL  void* argPtr)
+{
+    TM_SHARED_WRITE(global_openCounter,
+                    TM_SHARED_READ(global_openCounter) - 1);
+}
+
+
+/* Open children that fail to commit must not run their compensations */
+static void
+openIncrement (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    long i;
+
+    for (i = 0; i < NUM_NEST; i++) {
+        TM_BEGIN();
+        TM_SHARED_WRITE(global_private[id],
+                        TM_SHARED_READ(global_private[id]) + 1);
+        TM_BEGIN_OPEN();
+        long counter = (long)TM_SHARED_READ(global_openCounter);
+        TM_SHARED_WRITE(global_openCounter, counter + 1);
+        TM_COMPENSATE(undoIncrement, NULL);
+        if (i % 8 == id) {
+            sched_yield(); /* let others commit, so that the child's fails */
+        }
+        TM_END_OPEN();
+        TM_END();
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+/* Buffered writes of one size must be seen by reads of another */
+static void
+mixedSize (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    mixed_t* privatePtr = &global_mixedPrivate[id];
+    mixed_t expected;
+    int i;
+
+    for (i = 0; i < NUM_NEST; i++) {
+        expected.word = 0;
+        expected.halves[1] = i;
+        expected.bytes[0] = 7;
+
+        TM_BEGIN();
+        TM_SHARED_WRITE(privatePtr->word, 0);
+        TM_SHARED_WRITE(privatePtr->halves[1], i);
+        assert(TM_SHARED_READ(privatePtr->halves[0]) == 0);
+        assert(TM_SHARED_READ(privatePtr->halves[1]) == i);
+        TM_SHARED_WRITE(privatePtr->bytes[0], 7);
+        assert(TM_SHARED_READ(privatePtr->bytes[0]) == 7);
+        assert(TM_SHARED_READ(privatePtr->word) == expected.word);
+        /* Each thread counts in one half; merging reads the other */
+        TM_SHARED_WRITE(global_mixedShared.halves[id % 2],
+                        TM_SHARED_READ(global_mixedShared.halves[id % 2]) + 1);
+        TM_SHARED_WRITE(global_mixedShared.bytes[sizeof(long) - 1],
+                        TM_SHARED_READ(global_mixedShared.bytes[sizeof(long) - 1]));
+        if ((i % 64) == id) {
+            sched_yield();
+        }
+        TM_END();
+
+        assert(privatePtr->word == expected.word);
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+int
+main ()
+{
+    long i;
+    long sum = 0;
+
+    puts("Starting...");
+
+    for (i = 0; i < NUM_ACCOUNT; i++) {
+        global_accounts[i] = INIT_BALANCE;
+    }
+
+    /* Only the audits run irrevocably */
+    setenv("TM_IRREVOCABLE_AFTER", "0", 1);
+    TM_STARTUP(NUM_THREAD);
+    thread_startup(NUM_THREAD);
+    thread_start(transfer, NULL);
+    assert(cm_getNumIrrevocable() == NUM_THREAD * (NUM_TRANSFER / AUDIT_PERIOD));
+
+    /* Escalate at the first abort */
+    setenv("TM_IRREVOCABLE_AFTER", "1", 1);
+    cm_startup();
+    thread_start(transfer, NULL);
+    assert(cm_getNumIrrevocable() >= NUM_THREAD * (NUM_TRANSFER / AUDIT_PERIOD));
+    TM_SHUTDOWN();
+
+    /* Read-only transactions read from old versions */
+    unsetenv("TM_IRREVOCABLE_AFTER");
+    setenv("TM_RO_VERSIONS", "4", 1);
+    TM_STARTUP(NUM_THREAD);
+    thread_start(transfer, NULL);
+    thread_start(nest, NULL);
+    thread_shutdown();
+    TM_SHUTDOWN();
+
+    for (i = 0; i < NUM_THREAD; i++) {
+        assert(global_private[i] == 2 * NUM_NEST);
+    }
+    assert(global_hot[0] == NUM_THREAD * NUM_NEST);
+    assert(global_hot[1] == NUM_THREAD * NUM_NEST);
+    assert(global_numOpen == NUM_THREAD * NUM_NEST);
+
+    /* Every child commit that fails is retried in place, never escalated */
+    setenv("TM_IRREVOCABLE_AFTER", "0", 1);
+    unsetenv("TM_RO_VERSIONS");
+    TM_STARTUP(NUM_THREAD);
+    thread_startup(NUM_THREAD);
+    thread_start(openIncrement, NULL);
+    thread_shutdown();
+    printf("Open child aborts: %lu\n", global_numPartialAbort);
+    TM_SHUTDOWN();
+    assert(global_openCounter == NUM_THREAD * NUM_NEST);
+
+    unsetenv("TM_IRREVOCABLE_AFTER");
+    TM_STARTUP(NUM_THREAD);
+    thread_startup(NUM_THREAD);
+    thread_start(mixedSize, NULL);
+    thread_shutdown();
+    TM_SHUTDOWN();
+    assert(global_mixedShared.halves[0] == (NUM_THREAD / 2) * NUM_NEST);
+    assert(global_mixedShared.halves[1] == (NUM_THREAD / 2) * NUM_NEST);
+
+    for (i = 0; i < NUM_ACCOUNT; i++) {
+        sum += global_accounts[i];
+    }
+    assert(sum == NUM_ACCOUNT * INIT_BALANCE);
+    assert(global_counters[0] + global_counters[1] == 3 * NUM_THREAD * NUM_TRANSFER);
+    assert(global_total == (float)(3 * NUM_THREAD * NUM_TRANSFER));
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_STM */
+
+
+/* =============================================================================
+ *
+ * End of stm.c
+ *
+ * =============================================================================
+ */
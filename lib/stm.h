@@ -0,0 +1,482 @@
+/* =============================================================================
+ *
+ * stm.h
+ * -- Word-based software transactional memory
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef STM_H
+#define STM_H 1
+
+
+#include <setjmp.h>
+#include <stddef.h>
+#include "memory.h"
+#include "tmstats.h"
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * In-tree STM
+ *
+ * Follows the design of TL2 [Dice, Shalev, and Shavit, DISC 2006]:
+ *
+ * - A global version clock is sampled when a transaction begins
+ * - Addresses hash onto a table of striped ownership records (locks) that
+ *   hold either the version of the last commit or a pointer to the owner
+ * - Writes are buffered in a per-thread write set and applied at commit
+ * - Reads are logged and re-validated when the clock has moved on
+ *
+ * Read-only transactions (STM_BEGIN_RD) do not log reads. If one writes,
+ * it is restarted as an update transaction. If TM_RO_VERSIONS is set to N > 0
+ * at startup (up to 64), each commit also keeps the values it overwrites in a
+ * ring of the last N writes to each stripe; read-only transactions then read
+ * the version that was current when they began instead of aborting, and wait
+ * for committing writers instead of killing them. They only abort when more
+ * than N commits to one stripe have happened since they began.
+ *
+ * Irrevocable transactions (STM_BEGIN_IRREVOCABLE, or any transaction that
+ * the contention manager escalates after repeated aborts; see cm.h) run
+ * alone and access memory in place, without logging; they never abort, so
+ * STM_RESTART is not allowed in them.
+ *
+ * Closed nested transactions (STM_BEGIN_NESTED..STM_END_NESTED) checkpoint
+ * the logs. When a conflict inside one is found while reading, and what the
+ * enclosing transaction read before the child began is still valid, only the
+ * child is rolled back and re-executed (up to STM_MAX_NESTED_RETRY times in
+ * a row). At STM_END_NESTED its effects become part of the parent.
+ *
+ * Open nested transactions (STM_BEGIN_OPEN..STM_END_OPEN) run on a second
+ * descriptor and commit at STM_END_OPEN, so other threads see their writes
+ * while the enclosing transaction goes on. They must not access data that
+ * the enclosing transaction reads or writes: the child's commit makes the
+ * parent's reads of it stale, so the parent would abort. Handlers registered
+ * in them with STM_COMPENSATE run, each as an open transaction of its own, if
+ * the enclosing transaction (or closed child) later aborts. An open child
+ * that keeps aborting or is killed aborts its parent.
+ *
+ * Accesses use the size of the accessed variable, so sub-word fields (int,
+ * float, char) are not widened into their neighbors. A transaction may read
+ * and write the same bytes with different sizes (e.g., through a union);
+ * overlapping writes are then merged into one write of the whole word, which
+ * also reads the bytes of the word that were not written.
+ * =============================================================================
+ */
+
+typedef struct stm_thread stm_thread_t;
+
+typedef void (*stm_compensation_handler_t)(stm_thread_t* threadPtr,
+                                           void* argPtr);
+
+#define STM_THREAD_T                    stm_thread_t
+#define STM_SELF                        stmSelf
+#define STM_JMPBUF_T                    sigjmp_buf
+
+#define STM_STARTUP()                   stm_startup()
+#define STM_SHUTDOWN()                  stm_shutdown()
+
+#define STM_NEW_THREAD()                stm_newThread()
+#define STM_INIT_THREAD(t, id)          stm_initThread(t, id)
+#define STM_FREE_THREAD(t)              stm_freeThread(t)
+
+#define STM_NEW_THREADS(numThread)      stm_newThreads(numThread)
+#define STM_GET_THREAD(id)              stm_getThread(id)
+#define STM_SET_SELF(t)                 /* nothing */
+
+#define STM_BEGIN(isReadOnly, isIrrevocable) \
+                                        do { \
+                                            static tmstats_site_t STM_SITE = \
+                                                TMSTATS_SITE_INIT; \
+                                            STM_JMPBUF_T STM_JMPBUF; \
+                                            sigsetjmp(STM_JMPBUF, 0); \
+                                            stm_start(STM_SELF, \
+                                                      &STM_JMPBUF, \
+                                                      isReadOnly, \
+                                                      isIrrevocable, \
+                                                      &STM_SITE)
+#define STM_BEGIN_RD()                  STM_BEGIN(TRUE, FALSE)
+#define STM_BEGIN_WR()                  STM_BEGIN(FALSE, FALSE)
+#define STM_BEGIN_IRREVOCABLE()         STM_BEGIN(FALSE, TRUE)
+#define STM_END()                       stm_commit(STM_SELF); \
+                                        } while (0)
+#define STM_RESTART()                   stm_restart(STM_SELF)
+
+#define STM_BEGIN_NESTED()              do { \
+                                            STM_JMPBUF_T STM_NESTED_JMPBUF; \
+                                            sigsetjmp(STM_NESTED_JMPBUF, 0); \
+                                            stm_beginNested(STM_SELF, \
+                                                            &STM_NESTED_JMPBUF)
+#define STM_END_NESTED()                stm_endNested(STM_SELF); \
+                                        } while (0)
+
+/* STM_SELF is the open child's descriptor inside the block */
+#define STM_BEGIN_OPEN()                do { \
+                                            STM_JMPBUF_T STM_OPEN_JMPBUF; \
+                                            STM_THREAD_T* STM_OPEN_SELF = \
+                                                stm_getOpen(STM_SELF); \
+                                            sigsetjmp(STM_OPEN_JMPBUF, 0); \
+                                            stm_beginOpen(STM_OPEN_SELF, \
+                                                          &STM_OPEN_JMPBUF); \
+                                            { \
+                                                STM_THREAD_T* STM_SELF = \
+                                                    STM_OPEN_SELF; \
+                                                (void)STM_SELF
+#define STM_END_OPEN()                      } \
+                                            stm_endOpen(STM_OPEN_SELF); \
+                                        } while (0)
+#define STM_COMPENSATE(handler, argPtr) stm_compensate(STM_SELF, \
+                                                       (handler), \
+                                                       (argPtr))
+
+#define STM_READ(var)                   stm_read(STM_SELF, \
+                                                 (volatile void*)&(var), \
+                                                 sizeof(var))
+#define STM_READ_P(var)                 ((void*)stm_read(STM_SELF, \
+                                                         (volatile void*)&(var), \
+                                                         sizeof(var)))
+#define STM_READ_F(var)                 stm_readFloat(STM_SELF, \
+                                                      (volatile float*)&(var))
+
+#define STM_WRITE(var, val)             stm_write(STM_SELF, \
+                                                  (volatile void*)&(var), \
+                                                  (long)(val), \
+                                                  sizeof(var))
+#define STM_WRITE_P(var, val)           stm_write(STM_SELF, \
+                                                  (volatile void*)&(var), \
+                                                  (long)(void*)(val), \
+                                                  sizeof(var))
+#define STM_WRITE_F(var, val)           stm_writeFloat(STM_SELF, \
+                                                       (volatile float*)&(var), \
+                                                       (float)(val))
+
+#define STM_LOCAL_WRITE(var, val)       stm_writeLocal(STM_SELF, \
+                                                       (volatile void*)&(var), \
+                                                       (long)(val), \
+                                                       sizeof(var))
+#define STM_LOCAL_WRITE_P(var, val)     stm_writeLocal(STM_SELF, \
+                                                       (volatile void*)&(var), \
+                                                       (long)(void*)(val), \
+                                                       sizeof(var))
+#define STM_LOCAL_WRITE_F(var, val)     stm_writeLocalFloat(STM_SELF, \
+                                                            (volatile float*)&(var), \
+                                                            (float)(val))
+
+#define STM_MALLOC(size)                stm_alloc(STM_SELF, size)
+#define STM_MALLOC_TYPE(typePtr)        stm_allocType(STM_SELF, typePtr)
+#define STM_FREE(ptr)                   stm_free(STM_SELF, ptr)
+
+
+/* =============================================================================
+ * stm_startup
+ * -- Call once before any other STM call
+ * =============================================================================
+ */
+void
+stm_startup ();
+
+
+/* =============================================================================
+ * stm_shutdown
+ * -- Prints commit/abort totals and per-site statistics
+ * =============================================================================
+ */
+void
+stm_shutdown ();
+
+
+/* =============================================================================
+ * stm_newThread
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+stm_thread_t*
+stm_newThread ();
+
+
+/* =============================================================================
+ * stm_initThread
+ * =============================================================================
+ */
+void
+stm_initThread (stm_thread_t* threadPtr, long id);
+
+
+/* =============================================================================
+ * stm_freeThread
+ * =============================================================================
+ */
+void
+stm_freeThread (stm_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * stm_newThreads
+ * -- Preallocates descriptors for simulator runs; see stm_getThread
+ * =============================================================================
+ */
+void
+stm_newThreads (long numThread);
+
+
+/* =============================================================================
+ * stm_getThread
+ * =============================================================================
+ */
+stm_thread_t*
+stm_getThread (long id);
+
+
+/* =============================================================================
+ * stm_start
+ * -- Called by STM_BEGIN after every sigsetjmp, so also on each retry
+ * =============================================================================
+ */
+void
+stm_start (stm_thread_t* threadPtr,
+           sigjmp_buf* envPtr,
+           bool_t isReadOnly,
+           bool_t isIrrevocable,
+           tmstats_site_t* sitePtr);
+
+
+/* =============================================================================
+ * stm_commit
+ * -- On conflict, rolls back and jumps to the matching stm_start
+ * =============================================================================
+ */
+void
+stm_commit (stm_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * stm_restart
+ * -- Rolls back and re-executes the current transaction
+ * =============================================================================
+ */
+void
+stm_restart (stm_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * stm_beginNested
+ * -- Called by STM_BEGIN_NESTED after every sigsetjmp; ignored outside a
+ *    transaction
+ * =============================================================================
+ */
+void
+stm_beginNested (stm_thread_t* threadPtr, sigjmp_buf* envPtr);
+
+
+/* =============================================================================
+ * stm_endNested
+ * =============================================================================
+ */
+void
+stm_endNested (stm_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * stm_getOpen
+ * -- Returns the descriptor that runs open children of threadPtr's
+ *    transaction, or threadPtr itself if there is nothing to stay open from
+ *    (no transaction, or an irrevocable one)
+ * =============================================================================
+ */
+stm_thread_t*
+stm_getOpen (stm_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * stm_beginOpen
+ * -- Called by STM_BEGIN_OPEN after every sigsetjmp
+ * =============================================================================
+ */
+void
+stm_beginOpen (stm_thread_t* threadPtr, sigjmp_buf* envPtr);
+
+
+/* =============================================================================
+ * stm_endOpen
+ * -- Commits the open child
+ * =============================================================================
+ */
+void
+stm_endOpen (stm_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * stm_compensate
+ * -- Inside an open child: run handler if the enclosing transaction aborts
+ *    after the child has committed. Elsewhere, does nothing.
+ * =============================================================================
+ */
+void
+stm_compensate (stm_thread_t* threadPtr,
+                stm_compensation_handler_t handler,
+                void* argPtr);
+
+
+/* =============================================================================
+ * stm_read
+ * -- numByte is 1, 2, 4, or 8, and addr is a multiple of numByte
+ * =============================================================================
+ */
+long
+stm_read (stm_thread_t* threadPtr, volatile void* addr, size_t numByte);
+
+
+/* =============================================================================
+ * stm_readFloat
+ * =============================================================================
+ */
+float
+stm_readFloat (stm_thread_t* threadPtr, volatile float* addr);
+
+
+/* =============================================================================
+ * stm_write
+ * -- numByte is 1, 2, 4, or 8, and addr is a multiple of numByte
+ * =============================================================================
+ */
+void
+stm_write (stm_thread_t* threadPtr,
+           volatile void* addr, long value, size_t numByte);
+
+
+/* =============================================================================
+ * stm_writeFloat
+ * =============================================================================
+ */
+void
+stm_writeFloat (stm_thread_t* threadPtr, volatile float* addr, float value);
+
+
+/* =============================================================================
+ * stm_writeLocal
+ * -- For thread-private data: writes in place, restores old value on abort
+ * =============================================================================
+ */
+void
+stm_writeLocal (stm_thread_t* threadPtr,
+                volatile void* addr, long value, size_t numByte);
+
+
+/* =============================================================================
+ * stm_writeLocalFloat
+ * =============================================================================
+ */
+void
+stm_writeLocalFloat (stm_thread_t* threadPtr, volatile float* addr, float value);
+
+
+/* =============================================================================
+ * stm_alloc
+ * -- Allocation is undone if the transaction aborts
+ * =============================================================================
+ */
+void*
+stm_alloc (stm_thread_t* threadPtr, size_t numByte);
+
+
+/* =============================================================================
+ * stm_allocType
+ * -- Like stm_alloc, but from the type's own spans (see memory.h)
+ * =============================================================================
+ */
+void*
+stm_allocType (stm_thread_t* threadPtr, memory_type_t* typePtr);
+
+
+/* =============================================================================
+ * stm_free
+ * -- Deallocation is deferred until the transaction commits
+ * =============================================================================
+ */
+void
+stm_free (stm_thread_t* threadPtr, void* ptr);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* STM_H */
+
+
+/* =============================================================================
+ *
+ * End of stm.h
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,609 @@
+/* =============================================================================
+ *
+ * task.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <sched.h>
+#include <stdlib.h>
+#include "task.h"
+#include "thread.h"
+#include "types.h"
+
+
+#if defined(__i386__) || defined(__x86_64__)
+#  define TASK_PAUSE()                      __asm__ __volatile__ ("pause" ::: "memory")
+#else
+#  define TASK_PAUSE()                      __asm__ __volatile__ ("" ::: "memory")
+#endif
+
+enum task_config {
+    TASK_DEQUE_LOG2      = 12,
+    TASK_CACHE_LINE_SIZE = 64,
+    TASK_IDLE_SPIN       = 64, /* failed steals before yielding the CPU */
+};
+
+#define TASK_DEQUE_CAPACITY             (1L << TASK_DEQUE_LOG2)
+#define TASK_DEQUE_MASK                 (TASK_DEQUE_CAPACITY - 1)
+
+typedef struct task {
+    void (*funcPtr)(void*);
+    void (*rangeFuncPtr)(void*, long, long); /* NULL for plain tasks */
+    void* argPtr;
+    long start;
+    long stop;
+    long grain;
+    task_group_t* groupPtr;
+} task_t;
+
+typedef struct task_deque {
+    volatile long top;    /* thieves */
+    char padding1[TASK_CACHE_LINE_SIZE - sizeof(long)];
+    volatile long bottom; /* owner */
+    unsigned long seed;   /* victim selection */
+    char padding2[TASK_CACHE_LINE_SIZE - sizeof(long) - sizeof(unsigned long)];
+    task_t tasks[TASK_DEQUE_CAPACITY];
+} task_deque_t;
+
+static task_deque_t**  global_deques          = NULL;
+static long            global_numThread       = 0;
+static volatile bool_t global_isRunning       = FALSE;
+static volatile bool_t global_isDone          = FALSE;
+static void          (*global_funcPtr)(void*) = NULL;
+static void*           global_argPtr          = NULL;
+
+
+/* =============================================================================
+ * pushTask
+ * -- Returns FALSE if the deque is full
+ * =============================================================================
+ */
+static bool_t
+pushTask (task_deque_t* dequePtr, task_t* taskPtr)
+{
+    long b = __atomic_load_n(&dequePtr->bottom, __ATOMIC_RELAXED);
+    long t = __atomic_load_n(&dequePtr->top, __ATOMIC_ACQUIRE);
+
+    if (b - t >= TASK_DEQUE_CAPACITY) {
+        return FALSE;
+    }
+
+    dequePtr->tasks[b & TASK_DEQUE_MASK] = *taskPtr;
+    __atomic_store_n(&dequePtr->bottom, b + 1, __ATOMIC_RELEASE);
+
+    return TRUE;
+}
+
+
+/* =============================================================================
+ * popTask
+ * -- Owner only; returns FALSE if empty
+ * =============================================================================
+ */
+static bool_t
+popTask (task_deque_t* dequePtr, task_t* taskPtr)
+{
+    long b = __atomic_load_n(&dequePtr->bottom, __ATOMIC_RELAXED) - 1;
+    long t;
+    bool_t isFound = TRUE;
+
+    __atomic_store_n(&dequePtr->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    t = __atomic_load_n(&dequePtr->top, __ATOMIC_RELAXED);
+
+    if (t > b) {
+        __atomic_store_n(&dequePtr->bottom, b + 1, __ATOMIC_RELAXED);
+        return FALSE;
+    }
+
+    *taskPtr = dequePtr->tasks[b & TASK_DEQUE_MASK];
+    if (t == b) {
+        /* Last task: race thieves for it */
+        isFound = __atomic_compare_exchange_n(&dequePtr->top,
+                                              &t,
+                                              t + 1,
+                                              FALSE,
+                                              __ATOMIC_SEQ_CST,
+                                              __ATOMIC_RELAXED);
+        __atomic_store_n(&dequePtr->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+
+    return isFound;
+}
+
+
+/* =============================================================================
+ * stealTask
+ * -- Returns FALSE if empty or another thread won the race
+ * =============================================================================
+ */
+static bool_t
+stealTask (task_deque_t* dequePtr, task_t* taskPtr)
+{
+    long t = __atomic_load_n(&dequePtr->top, __ATOMIC_ACQUIRE);
+    long b;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    b = __atomic_load_n(&dequePtr->bottom, __ATOMIC_ACQUIRE);
+
+    if (t >= b) {
+        return FALSE;
+    }
+
+    /* May be stale if top moved; then the CAS fails and the copy is dropped */
+    *taskPtr = dequePtr->tasks[t & TASK_DEQUE_MASK];
+
+    return __atomic_compare_exchange_n(&dequePtr->top,
+                                       &t,
+                                       t + 1,
+                                       FALSE,
+                                       __ATOMIC_SEQ_CST,
+                                       __ATOMIC_RELAXED);
+}
+
+
+/* =============================================================================
+ * stealAny
+ * -- Tries every other thread once, starting from a random victim
+ * =============================================================================
+ */
+static bool_t
+stealAny (long threadId, task_t* taskPtr)
+{
+    task_deque_t* dequePtr = global_deques[threadId];
+    long numThread = global_numThread;
+    long v;
+    long i;
+
+    if (numThread < 2) {
+        return FALSE;
+    }
+
+    /* xorshift */
+    dequePtr->seed ^= dequePtr->seed << 13;
+    dequePtr->seed ^= dequePtr->seed >> 7;
+    dequePtr->seed ^= dequePtr->seed << 17;
+    v = (long)(dequePtr->seed % (unsigned long)numThread);
+
+    for (i = 0; i < numThread; i++) {
+        if (v != threadId && stealTask(global_deques[v], taskPtr)) {
+            return TRUE;
+        }
+        v = ((v + 1 == numThread) ? 0 : (v + 1));
+    }
+
+    return FALSE;
+}
+
+
+/* =============================================================================
+ * idle
+ * =============================================================================
+ */
+static void
+idle (long numFail)
+{
+    if (numFail < TASK_IDLE_SPIN) {
+        TASK_PAUSE();
+    } else {
+        sched_yield();
+    }
+}
+
+
+/* =============================================================================
+ * spawnTask
+ * =============================================================================
+ */
+static void executeTask (task_t* taskPtr);
+
+static void
+spawnTask (task_t* taskPtr)
+{
+    __atomic_add_fetch(&taskPtr->groupPtr->numPending, 1, __ATOMIC_RELAXED);
+
+    if (!global_isRunning ||
+        !pushTask(global_deques[thread_getId()], taskPtr))
+    {
+        executeTask(taskPtr); /* no runtime, or deque full */
+    }
+}
+
+
+/* =============================================================================
+ * executeTask
+ * =============================================================================
+ */
+static void
+executeTask (task_t* taskPtr)
+{
+    task_group_t* groupPtr = taskPtr->groupPtr;
+
+    if (taskPtr->rangeFuncPtr != NULL) {
+        long start = taskPtr->start;
+        long stop = taskPtr->stop;
+        /* Leave the upper halves for thieves, keep the lowest piece */
+        while (stop - start > taskPtr->grain) {
+            task_t half = *taskPtr;
+            long middle = start + (stop - start) / 2;
+            half.start = middle;
+            half.stop = stop;
+            spawnTask(&half);
+            stop = middle;
+        }
+        taskPtr->rangeFuncPtr(taskPtr->argPtr, start, stop);
+    } else {
+        taskPtr->funcPtr(taskPtr->argPtr);
+    }
+
+    __atomic_sub_fetch(&groupPtr->numPending, 1, __ATOMIC_RELEASE);
+}
+
+
+/* =============================================================================
+ * workerMain
+ * =============================================================================
+ */
+static void
+workerMain (void* argPtr)
+{
+    long threadId = thread_getId();
+    long numFail = 0;
+
+    if (threadId == 0) {
+        global_funcPtr(global_argPtr);
+        __atomic_store_n(&global_isDone, TRUE, __ATOMIC_RELEASE);
+        return;
+    }
+
+    while (!__atomic_load_n(&global_isDone, __ATOMIC_ACQUIRE)) {
+        task_t task;
+        if (popTask(global_deques[threadId], &task) ||
+            stealAny(threadId, &task))
+        {
+            executeTask(&task);
+            numFail = 0;
+        } else {
+            idle(numFail++);
+        }
+    }
+}
+
+
+/* =============================================================================
+ * task_start
+ * -- Should only be called by primary thread, between thread_startup and
+ *    thread_shutdown
+ * -- Returns after funcPtr returns; tasks it spawned must have been synced
+ * =============================================================================
+ */
+void
+task_start (void (*funcPtr)(void*), void* argPtr)
+{
+    long numThread = thread_getNumThread();
+    long i;
+
+    assert(!global_isRunning);
+
+    global_deques = (task_deque_t**)malloc(numThread * sizeof(task_deque_t*));
+    assert(global_deques);
+    for (i = 0; i < numThread; i++) {
+        task_deque_t* dequePtr;
+        if (posix_memalign((void**)&dequePtr,
+                           TASK_CACHE_LINE_SIZE,
+                           sizeof(task_deque_t)) != 0)
+        {
+            assert(0);
+        }
+        dequePtr->top = 0;
+        dequePtr->bottom = 0;
+        dequePtr->seed = (unsigned long)i * 2654435761UL + 1;
+        global_deques[i] = dequePtr;
+    }
+
+    global_numThread = numThread;
+    global_funcPtr = funcPtr;
+    global_argPtr = argPtr;
+    global_isDone = FALSE;
+    global_isRunning = TRUE;
+
+    thread_start(workerMain, NULL);
+
+    global_isRunning = FALSE;
+    for (i = 0; i < numThread; i++) {
+        assert(global_deques[i]->top == global_deques[i]->bottom);
+        free(global_deques[i]);
+    }
+    free(global_deques);
+    global_deques = NULL;
+}
+
+
+/* =============================================================================
+ * task_group_init
+ * =============================================================================
+ */
+void
+task_group_init (task_group_t* groupPtr)
+{
+    groupPtr->numPending = 0;
+}
+
+
+/* =============================================================================
+ * task_spawn
+ * -- funcPtr(argPtr) runs later on this or another thread
+ * =============================================================================
+ */
+void
+task_spawn (task_group_t* groupPtr, void (*funcPtr)(void*), void* argPtr)
+{
+    task_t task;
+
+    task.funcPtr      = funcPtr;
+    task.rangeFuncPtr = NULL;
+    task.argPtr       = argPtr;
+    task.start        = 0;
+    task.stop         = 0;
+    task.grain        = 0;
+    task.groupPtr     = groupPtr;
+
+    spawnTask(&task);
+}
+
+
+/* =============================================================================
+ * task_sync
+ * -- Returns once every task spawned in groupPtr has finished
+ * =============================================================================
+ */
+void
+task_sync (task_group_t* groupPtr)
+{
+    long threadId;
+    long numFail = 0;
+
+    if (!global_isRunning) {
+        assert(groupPtr->numPending == 0);
+        return;
+    }
+
+    threadId = thread_getId();
+
+    while (__atomic_load_n(&groupPtr->numPending, __ATOMIC_ACQUIRE) > 0) {
+        task_t task;
+        if (popTask(global_deques[threadId], &task) ||
+            stealAny(threadId, &task))
+        {
+            executeTask(&task);
+            numFail = 0;
+        } else {
+            idle(numFail++);
+        }
+    }
+}
+
+
+/* =============================================================================
+ * task_parallelFor
+ * -- Calls funcPtr(argPtr, i, j) on disjoint subranges covering [start, stop)
+ * -- Ranges are halved until at most grain long; grain < 1 means 1
+ * -- Returns when all subranges are done
+ * =============================================================================
+ */
+void
+task_parallelFor (long start,
+                  long stop,
+                  long grain,
+                  void (*funcPtr)(void*, long, long),
+                  void* argPtr)
+{
+    task_group_t group;
+    task_t task;
+
+    if (start >= stop) {
+        return;
+    }
+
+    task_group_init(&group);
+
+    task.funcPtr      = NULL;
+    task.rangeFuncPtr = funcPtr;
+    task.argPtr       = argPtr;
+    task.start        = start;
+    task.stop         = stop;
+    task.grain        = ((grain < 1) ? 1 : grain);
+    task.groupPtr     = &group;
+
+    /* Run the first piece here; the rest is spawned as it splits */
+    __atomic_add_fetch(&group.numPending, 1, __ATOMIC_RELAXED);
+    executeTask(&task);
+
+    task_sync(&group);
+}
+
+
+/* =============================================================================
+ * TEST_TASK
+ * =============================================================================
+ */
+#ifdef TEST_TASK
+
+
+#include <stdio.h>
+
+
+#define NUM_THREAD  (5)
+#define NUM_ELEMENT (1000003)
+#define FIB_N       (24)
+
+
+long* global_counts;
+long global_numFib = 0;
+
+
+static void
+countRange (void* argPtr, long start, long stop)
+{
+    long i;
+
+    for (i = start; i < stop; i++) {
+        global_counts[i]++;
+    }
+}
+
+
+typedef struct fib {
+    long n;
+    long result;
+} fib_t;
+
+
+static void
+fib (void* argPtr)
+{
+    fib_t* fibPtr = (fib_t*)argPtr;
+    fib_t a;
+    fib_t b;
+    task_group_t group;
+
+    if (fibPtr->n < 2) {
+        fibPtr->result = fibPtr->n;
+        return;
+    }
+
+    a.n = fibPtr->n - 1;
+    b.n = fibPtr->n - 2;
+    task_group_init(&group);
+    task_spawn(&group, &fib, &a);
+    fib(&b);
+    task_sync(&group);
+    fibPtr->result = a.result + b.result;
+}
+
+
+static void
+root (void* argPtr)
+{
+    fib_t f;
+
+    task_parallelFor(0, NUM_ELEMENT, 1000, &countRange, NULL);
+    task_parallelFor(0, NUM_ELEMENT, 1, &countRange, NULL);
+
+    f.n = FIB_N;
+    fib(&f);
+    global_numFib = f.result;
+}
+
+
+int
+main ()
+{
+    long i;
+    fib_t f;
+
+    puts("Starting...");
+
+    global_counts = (long*)calloc(NUM_ELEMENT, sizeof(long));
+    assert(global_counts);
+
+    thread_startup(NUM_THREAD);
+    task_start(&root, NULL);
+    task_start(&root, NULL);
+    thread_shutdown();
+
+    for (i = 0; i < NUM_ELEMENT; i++) {
+        assert(global_counts[i] == 4);
+    }
+    assert(global_numFib == 46368);
+
+    /* Without the runtime everything runs inline */
+    f.n = 10;
+    fib(&f);
+    assert(f.result == 55);
+    task_parallelFor(0, NUM_ELEMENT, 100, &countRange, NULL);
+    assert(global_counts[NUM_ELEMENT - 1] == 5);
+
+    free(global_counts);
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_TASK */
+
+
+/* =============================================================================
+ *
+ * End of task.c
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,175 @@
+/* =============================================================================
+ *
+ * task.h
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef TASK_H
+#define TASK_H 1
+
+
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Work-stealing tasks
+ *
+ * task_start runs funcPtr(argPtr) on the primary thread while every other
+ * thread of the pool (see thread_startup) steals spawned tasks. Each thread
+ * owns a Chase-Lev deque: it pushes and pops at the bottom, thieves take from
+ * the top. A task_sync executes local or stolen tasks until its group is
+ * done, so waiting threads keep working.
+ *
+ *     task_group_t group;
+ *     task_group_init(&group);
+ *     task_spawn(&group, work, argPtr);
+ *     ...
+ *     task_sync(&group);
+ *
+ * Tasks may spawn and sync further tasks, and may run transactions; use
+ * thread_getId() inside a task for per-thread state only, not partitioning.
+ * Outside task_start, spawned tasks run immediately on the calling thread.
+ * =============================================================================
+ */
+
+typedef struct task_group {
+    volatile long numPending;
+} task_group_t;
+
+
+/* =============================================================================
+ * task_start
+ * -- Should only be called by primary thread, between thread_startup and
+ *    thread_shutdown
+ * -- Returns after funcPtr returns; tasks it spawned must have been synced
+ * =============================================================================
+ */
+void
+task_start (void (*funcPtr)(void*), void* argPtr);
+
+
+/* =============================================================================
+ * task_group_init
+ * =============================================================================
+ */
+void
+task_group_init (task_group_t* groupPtr);
+
+
+/* =============================================================================
+ * task_spawn
+ * -- funcPtr(argPtr) runs later on this or another thread
+ * =============================================================================
+ */
+void
+task_spawn (task_group_t* groupPtr, void (*funcPtr)(void*), void* argPtr);
+
+
+/* =============================================================================
+ * task_sync
+ * -- Returns once every task spawned in groupPtr has finished
+ * =============================================================================
+ */
+void
+task_sync (task_group_t* groupPtr);
+
+
+/* =============================================================================
+ * task_parallelFor
+ * -- Calls funcPtr(argPtr, i, j) on disjoint subranges covering [start, stop)
+ * -- Ranges are halved until at most grain long; grain < 1 means 1
+ * -- Returns when all subranges are done
+ * =============================================================================
+ */
+void
+task_parallelFor (long start,
+                  long stop,
+                  long grain,
+                  void (*funcPtr)(void*, long, long),
+                  void* argPtr);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* TASK_H */
+
+
+/* =============================================================================
+ *
+ * End of task.h
+ *
+ * =============================================================================
+ */
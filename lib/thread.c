@@ -69,8 +69,21 @@
  */
 
 
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE /* CPU affinity */
+#endif
 #include <assert.h>
+#include <sched.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#endif
+#include "linetrace.h"
+#include "perfctr.h"
 #include "thread.h"
 #include "types.h"
 
@@ -83,6 +96,30 @@ static THREAD_T*         global_threads         = NULL;
 static void            (*global_funcPtr)(void*) = NULL;
 static void*             global_argPtr          = NULL;
 static volatile bool_t   global_doShutdown      = FALSE;
+static const char*       global_placementSpec   = NULL;
+static long*             global_placementCpus   = NULL; /* per thread */
+static volatile long*    global_threadCpus      = NULL; /* last CPU seen */
+#ifdef __linux__
+static cpu_set_t         global_primaryCpuSet;
+#endif
+
+enum thread_config {
+    THREAD_BARRIER_SPIN_LIMIT = 4096, /* polls before sleeping */
+};
+
+#if defined(__i386__) || defined(__x86_64__)
+#  define THREAD_PAUSE()                    __asm__ __volatile__ ("pause" ::: "memory")
+#else
+#  define THREAD_PAUSE()                    __asm__ __volatile__ ("" ::: "memory")
+#endif
+
+typedef struct thread_cpu {
+    long cpu;
+    long package;
+    long core;
+    long coreRank; /* among distinct cores of the package */
+    long smt;      /* among hardware threads of the core */
+} thread_cpu_t;
 
 
 /* =============================================================================
@@ -102,7 +139,18 @@ threadWait (void* argPtr)
         if (global_doShutdown) {
             break;
         }
+        perfctr_begin(threadId);
+#ifdef LINE_TRACE
+        linetrace_begin(threadId);
+#endif
         global_funcPtr(global_argPtr);
+#ifdef LINE_TRACE
+        linetrace_end(threadId);
+#endif
+        perfctr_end(threadId);
+#ifdef __linux__
+        global_threadCpus[threadId] = sched_getcpu();
+#endif
         THREAD_BARRIER(global_barrierPtr, threadId); /* wait for end parallel */
         if (threadId == 0) {
             break;
@@ -111,6 +159,318 @@ threadWait (void* argPtr)
 }
 
 
+#ifdef __linux__
+
+
+/* =============================================================================
+ * readTopology
+ * -- Returns -1 if the sysfs entry is missing
+ * =============================================================================
+ */
+static long
+readTopology (long cpu, const char* name)
+{
+    char path[128];
+    FILE* file;
+    long value = -1;
+
+    sprintf(path, "/sys/devices/system/cpu/cpu%li/topology/%s", cpu, name);
+    file = fopen(path, "r");
+    if (file != NULL) {
+        if (fscanf(file, "%li", &value) != 1) {
+            value = -1;
+        }
+        fclose(file);
+    }
+
+    return value;
+}
+
+
+/* =============================================================================
+ * compareCore
+ * -- Groups the hardware threads of each core, so getTopology can rank them
+ * =============================================================================
+ */
+static int
+compareCore (const void* aPtr, const void* bPtr)
+{
+    const thread_cpu_t* a = (const thread_cpu_t*)aPtr;
+    const thread_cpu_t* b = (const thread_cpu_t*)bPtr;
+
+    if (a->package != b->package) {
+        return ((a->package < b->package) ? -1 : 1);
+    }
+    if (a->core != b->core) {
+        return ((a->core < b->core) ? -1 : 1);
+    }
+    return ((a->cpu < b->cpu) ? -1 : (a->cpu > b->cpu));
+}
+
+
+/* =============================================================================
+ * compareCompact
+ * -- Fill a package's physical cores, then their SMT siblings, then the next
+ * =============================================================================
+ */
+static int
+compareCompact (const void* aPtr, const void* bPtr)
+{
+    const thread_cpu_t* a = (const thread_cpu_t*)aPtr;
+    const thread_cpu_t* b = (const thread_cpu_t*)bPtr;
+
+    if (a->package != b->package) {
+        return ((a->package < b->package) ? -1 : 1);
+    }
+    if (a->smt != b->smt) {
+        return ((a->smt < b->smt) ? -1 : 1);
+    }
+    return ((a->coreRank < b->coreRank) ? -1 : (a->coreRank > b->coreRank));
+}
+
+
+/* =============================================================================
+ * compareScatter
+ * -- Round-robin over packages; fill physical cores before SMT siblings
+ * =============================================================================
+ */
+static int
+compareScatter (const void* aPtr, const void* bPtr)
+{
+    const thread_cpu_t* a = (const thread_cpu_t*)aPtr;
+    const thread_cpu_t* b = (const thread_cpu_t*)bPtr;
+
+    if (a->smt != b->smt) {
+        return ((a->smt < b->smt) ? -1 : 1);
+    }
+    if (a->coreRank != b->coreRank) {
+        return ((a->coreRank < b->coreRank) ? -1 : 1);
+    }
+    return ((a->package < b->package) ? -1 : (a->package > b->package));
+}
+
+
+/* =============================================================================
+ * getTopology
+ * -- Returns number of CPUs this process may run on, grouped by core
+ * =============================================================================
+ */
+static long
+getTopology (thread_cpu_t* cpus)
+{
+    cpu_set_t allowed;
+    long numCpu = 0;
+    long c;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return 0;
+    }
+
+    for (c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &allowed)) {
+            thread_cpu_t* cpuPtr = &cpus[numCpu++];
+            cpuPtr->cpu = c;
+            cpuPtr->package = readTopology(c, "physical_package_id");
+            cpuPtr->core = readTopology(c, "core_id");
+            if (cpuPtr->package < 0) {
+                cpuPtr->package = 0;
+            }
+            if (cpuPtr->core < 0) {
+                cpuPtr->core = c;
+            }
+        }
+    }
+
+    qsort(cpus, numCpu, sizeof(thread_cpu_t), &compareCore);
+    for (c = 0; c < numCpu; c++) {
+        if (c > 0 && cpus[c].package == cpus[c-1].package) {
+            bool_t isSameCore = (cpus[c].core == cpus[c-1].core);
+            cpus[c].coreRank = cpus[c-1].coreRank + (isSameCore ? 0 : 1);
+            cpus[c].smt = (isSameCore ? (cpus[c-1].smt + 1) : 0);
+        } else {
+            cpus[c].coreRank = 0;
+            cpus[c].smt = 0;
+        }
+    }
+
+    return numCpu;
+}
+
+
+/* =============================================================================
+ * parseCpuList
+ * -- Accepts e.g. "0,2,4-7"; returns number of CPUs, or -1 on syntax error
+ * =============================================================================
+ */
+static long
+parseCpuList (const char* spec, long* list, long maxCpu)
+{
+    const char* p = spec;
+    long numCpu = 0;
+
+    while (*p != '\0') {
+        char* end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        long c;
+        if (end == p || first < 0) {
+            return -1;
+        }
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first) {
+                return -1;
+            }
+            p = end;
+        }
+        for (c = first; c <= last; c++) {
+            if (c >= CPU_SETSIZE || numCpu == maxCpu) {
+                return -1;
+            }
+            list[numCpu++] = c;
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+
+    return numCpu;
+}
+
+
+/* =============================================================================
+ * computePlacement
+ * -- Returns CPU for each thread, or NULL if spec is invalid
+ * =============================================================================
+ */
+static long*
+computePlacement (const char* spec, long numThread)
+{
+    long* placement;
+    long* list;
+    long numCpu;
+    long i;
+
+    list = (long*)malloc(CPU_SETSIZE * sizeof(long));
+    assert(list);
+
+    if (strcmp(spec, "compact") == 0 || strcmp(spec, "scatter") == 0) {
+        thread_cpu_t* cpus =
+            (thread_cpu_t*)malloc(CPU_SETSIZE * sizeof(thread_cpu_t));
+        assert(cpus);
+        numCpu = getTopology(cpus);
+        qsort(cpus, numCpu, sizeof(thread_cpu_t),
+              ((spec[0] == 's') ? &compareScatter : &compareCompact));
+        for (i = 0; i < numCpu; i++) {
+            list[i] = cpus[i].cpu;
+        }
+        free(cpus);
+    } else {
+        cpu_set_t allowed;
+        numCpu = parseCpuList(spec, list, CPU_SETSIZE);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            numCpu = -1;
+        }
+        for (i = 0; i < numCpu; i++) {
+            if (!CPU_ISSET(list[i], &allowed)) {
+                numCpu = -1; /* pthread_create would fail */
+            }
+        }
+    }
+
+    if (numCpu <= 0) {
+        free(list);
+        return NULL;
+    }
+
+    placement = (long*)malloc(numThread * sizeof(long));
+    assert(placement);
+    for (i = 0; i < numThread; i++) {
+        placement[i] = list[i % numCpu]; /* oversubscribe in the same order */
+    }
+    free(list);
+
+    return placement;
+}
+
+
+#endif /* __linux__ */
+
+
+/* =============================================================================
+ * thread_attrSetCpu
+ * =============================================================================
+ */
+void
+thread_attrSetCpu (THREAD_ATTR_T* attrPtr, long cpu)
+{
+#ifdef __linux__
+    cpu_set_t cpuSet;
+
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    pthread_attr_setaffinity_np(attrPtr, sizeof(cpuSet), &cpuSet);
+#endif
+}
+
+
+/* =============================================================================
+ * thread_setPlacement
+ * -- Overrides the THREAD_PLACEMENT environment variable
+ * =============================================================================
+ */
+void
+thread_setPlacement (const char* spec)
+{
+    global_placementSpec = spec;
+}
+
+
+/* =============================================================================
+ * setupPlacement
+ * -- Pins the primary thread and returns TRUE if secondaries should be pinned
+ * =============================================================================
+ */
+static bool_t
+setupPlacement (long numThread)
+{
+    const char* spec = global_placementSpec;
+
+    if (spec == NULL) {
+        spec = getenv("THREAD_PLACEMENT");
+    }
+    if (spec == NULL || spec[0] == '\0' || strcmp(spec, "none") == 0) {
+        return FALSE;
+    }
+
+#ifdef __linux__
+    assert(global_placementCpus == NULL);
+    global_placementCpus = computePlacement(spec, numThread);
+    if (global_placementCpus == NULL) {
+        fprintf(stderr, "Invalid thread placement \"%s\"; not pinning\n", spec);
+        return FALSE;
+    }
+    {
+        cpu_set_t cpuSet;
+        pthread_getaffinity_np(pthread_self(),
+                               sizeof(global_primaryCpuSet),
+                               &global_primaryCpuSet);
+        CPU_ZERO(&cpuSet);
+        CPU_SET(global_placementCpus[0], &cpuSet);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    }
+    return TRUE;
+#else /* !__linux__ */
+    fprintf(stderr, "Thread placement is not supported here; not pinning\n");
+    return FALSE;
+#endif /* !__linux__ */
+}
+
+
 /* =============================================================================
  * thread_startup
  * -- Create pool of secondary threads
@@ -121,6 +481,7 @@ void
 thread_startup (long numThread)
 {
     long i;
+    bool_t isPinned;
 
     global_numThread = numThread;
     global_doShutdown = FALSE;
@@ -144,10 +505,25 @@ thread_startup (long numThread)
     assert(global_threads == NULL);
     global_threads = (THREAD_T*)malloc(numThread * sizeof(THREAD_T));
     assert(global_threads);
+    assert(global_threadCpus == NULL);
+    global_threadCpus = (volatile long*)malloc(numThread * sizeof(long));
+    assert(global_threadCpus);
+    for (i = 0; i < numThread; i++) {
+        global_threadCpus[i] = -1;
+    }
+
+    perfctr_startup(numThread);
+#ifdef LINE_TRACE
+    linetrace_startup(numThread);
+#endif
 
     /* Set up pool */
     THREAD_ATTR_INIT(global_threadAttr);
+    isPinned = setupPlacement(numThread);
     for (i = 1; i < numThread; i++) {
+        if (isPinned) {
+            THREAD_ATTR_SETCPU(global_threadAttr, global_placementCpus[i]);
+        }
         THREAD_CREATE(global_threads[i],
                       global_threadAttr,
                       &threadWait,
@@ -200,6 +576,24 @@ thread_shutdown ()
     THREAD_BARRIER_FREE(global_barrierPtr);
     global_barrierPtr = NULL;
 
+    perfctr_shutdown();
+#ifdef LINE_TRACE
+    linetrace_shutdown();
+#endif
+
+    if (global_placementCpus != NULL) {
+        thread_printPlacement();
+#ifdef __linux__
+        pthread_setaffinity_np(pthread_self(),
+                               sizeof(global_primaryCpuSet),
+                               &global_primaryCpuSet);
+#endif
+        free(global_placementCpus);
+        global_placementCpus = NULL;
+    }
+    free((void*)global_threadCpus);
+    global_threadCpus = NULL;
+
     free(global_threadIds);
     global_threadIds = NULL;
 
@@ -220,11 +614,28 @@ thread_barrier_alloc (long numThread)
     thread_barrier_t* barrierPtr;
 
     assert(numThread > 0);
-    assert((numThread & (numThread - 1)) == 0); /* must be power of 2 */
-    barrierPtr = (thread_barrier_t*)malloc(numThread * sizeof(thread_barrier_t));
-    if (barrierPtr != NULL) {
-        barrierPtr->numThread = numThread;
+    if (posix_memalign((void**)&barrierPtr,
+                       THREAD_CACHE_LINE_SIZE,
+                       sizeof(thread_barrier_t)) != 0)
+    {
+        return NULL;
+    }
+    if (posix_memalign((void**)&barrierPtr->localSenses,
+                       THREAD_CACHE_LINE_SIZE,
+                       numThread * sizeof(thread_barrier_sense_t)) != 0)
+    {
+        free(barrierPtr);
+        return NULL;
+    }
+    barrierPtr->numThread = numThread;
+
+    /* Spinning only delays the threads we wait for if they lack a CPU */
+    barrierPtr->spinLimit = THREAD_BARRIER_SPIN_LIMIT;
+#ifdef _SC_NPROCESSORS_ONLN
+    if (numThread > sysconf(_SC_NPROCESSORS_ONLN)) {
+        barrierPtr->spinLimit = 0;
     }
+#endif
 
     return barrierPtr;
 }
@@ -237,6 +648,7 @@ thread_barrier_alloc (long numThread)
 void
 thread_barrier_free (thread_barrier_t* barrierPtr)
 {
+    free(barrierPtr->localSenses);
     free(barrierPtr);
 }
 
@@ -251,67 +663,79 @@ thread_barrier_init (thread_barrier_t* barrierPtr)
     long i;
     long numThread = barrierPtr->numThread;
 
+    barrierPtr->count = 0;
+    barrierPtr->sense = 0;
+    barrierPtr->numSleeper = 0;
     for (i = 0; i < numThread; i++) {
-        barrierPtr[i].count = 0;
-        THREAD_MUTEX_INIT(barrierPtr[i].countLock);
-        THREAD_COND_INIT(barrierPtr[i].proceedCond);
-        THREAD_COND_INIT(barrierPtr[i].proceedAllCond);
+        barrierPtr->localSenses[i].value = 0;
+    }
+}
+
+
+/* =============================================================================
+ * waitSense
+ * -- Returns once barrierPtr->sense == sense
+ * =============================================================================
+ */
+static void
+waitSense (thread_barrier_t* barrierPtr, int sense)
+{
+    long i;
+
+    for (i = 0; i < barrierPtr->spinLimit; i++) {
+        if (__atomic_load_n(&barrierPtr->sense, __ATOMIC_ACQUIRE) == sense) {
+            return;
+        }
+        THREAD_PAUSE();
+    }
+
+    __atomic_add_fetch(&barrierPtr->numSleeper, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&barrierPtr->sense, __ATOMIC_SEQ_CST) != sense) {
+#ifdef __linux__
+        /* Returns immediately if sense already flipped */
+        syscall(SYS_futex, &barrierPtr->sense, FUTEX_WAIT_PRIVATE,
+                !sense, NULL, NULL, 0);
+#else
+        sched_yield();
+#endif
     }
+    __atomic_sub_fetch(&barrierPtr->numSleeper, 1, __ATOMIC_RELAXED);
 }
 
 
 /* =============================================================================
  * thread_barrier
- * -- Simple logarithmic barrier
+ * -- Sense-reversing barrier for any number of threads
+ * -- Spins briefly, then sleeps on a futex (yields where futexes are missing)
  * =============================================================================
  */
 void
 thread_barrier (thread_barrier_t* barrierPtr, long threadId)
 {
-    long i = 2;
-    long base = 0;
-    long index;
     long numThread = barrierPtr->numThread;
+    int sense;
 
     if (numThread < 2) {
         return;
     }
 
-    do {
-        index = base + threadId / i;
-        if ((threadId % i) == 0) {
-            THREAD_MUTEX_LOCK(barrierPtr[index].countLock);
-            barrierPtr[index].count++;
-            while (barrierPtr[index].count < 2) {
-                THREAD_COND_WAIT(barrierPtr[index].proceedCond,
-                                 barrierPtr[index].countLock);
-            }
-            THREAD_MUTEX_UNLOCK(barrierPtr[index].countLock);
-        } else {
-            THREAD_MUTEX_LOCK(barrierPtr[index].countLock);
-            barrierPtr[index].count++;
-            if (barrierPtr[index].count == 2) {
-                THREAD_COND_SIGNAL(barrierPtr[index].proceedCond);
-            }
-            while (THREAD_COND_WAIT(barrierPtr[index].proceedAllCond,
-                                    barrierPtr[index].countLock) != 0)
-            {
-                /* wait */
-            }
-            THREAD_MUTEX_UNLOCK(barrierPtr[index].countLock);
-            break;
+    sense = !barrierPtr->localSenses[threadId].value;
+    barrierPtr->localSenses[threadId].value = sense;
+
+    if (__atomic_add_fetch(&barrierPtr->count, 1, __ATOMIC_ACQ_REL) ==
+        numThread)
+    {
+        /* Last to arrive: reset for the next episode and release the rest */
+        barrierPtr->count = 0;
+        __atomic_store_n(&barrierPtr->sense, sense, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&barrierPtr->numSleeper, __ATOMIC_SEQ_CST) > 0) {
+#ifdef __linux__
+            syscall(SYS_futex, &barrierPtr->sense, FUTEX_WAKE_PRIVATE,
+                    (int)(numThread - 1), NULL, NULL, 0);
+#endif
         }
-        base = base + numThread / i;
-        i *= 2;
-    } while (i <= numThread);
-
-    for (i /= 2; i > 1; i /= 2) {
-        base = base - numThread / i;
-        index = base + threadId / i;
-        THREAD_MUTEX_LOCK(barrierPtr[index].countLock);
-        barrierPtr[index].count = 0;
-        THREAD_COND_SIGNAL(barrierPtr[index].proceedAllCond);
-        THREAD_MUTEX_UNLOCK(barrierPtr[index].countLock);
+    } else {
+        waitSense(barrierPtr, sense);
     }
 }
 
@@ -340,6 +764,40 @@ thread_getNumThread()
 }
 
 
+/* =============================================================================
+ * thread_getCpu
+ * -- Returns CPU on which threadId finished its last parallel region, or -1
+ * =============================================================================
+ */
+long
+thread_getCpu (long threadId)
+{
+    return ((global_threadCpus != NULL) ? global_threadCpus[threadId] : -1);
+}
+
+
+/* =============================================================================
+ * thread_printPlacement
+ * =============================================================================
+ */
+void
+thread_printPlacement ()
+{
+    long i;
+
+    printf("Thread placement:");
+    for (i = 0; i < global_numThread; i++) {
+        printf(" %li->%li", i, thread_getCpu(i));
+        if (global_placementCpus != NULL &&
+            global_placementCpus[i] != thread_getCpu(i))
+        {
+            printf("(pinned %li)", global_placementCpus[i]);
+        }
+    }
+    puts("");
+}
+
+
 /* =============================================================================
  * thread_barrier_wait
  * -- Call after thread_start() to synchronize threads inside parallel region
@@ -366,8 +824,9 @@ thread_barrier_wait()
 #include <unistd.h>
 
 
-#define NUM_THREADS    (4)
+#define NUM_THREADS    (6) /* need not be a power of 2 */
 #define NUM_ITERATIONS (3)
+#define NUM_EPISODE    (10000)
 
 
 
@@ -394,6 +853,27 @@ printId (void* argPtr)
 }
 
 
+volatile long global_arrived = 0;
+volatile bool_t global_isBarrierOk = TRUE;
+
+
+void
+checkBarrier (void* argPtr)
+{
+    long numThread = thread_getNumThread();
+    long e;
+
+    for (e = 0; e < NUM_EPISODE; e++) {
+        __atomic_add_fetch(&global_arrived, 1, __ATOMIC_RELAXED);
+        thread_barrier_wait();
+        if (global_arrived != (e + 1) * numThread) {
+            global_isBarrierOk = FALSE;
+        }
+        thread_barrier_wait();
+    }
+}
+
+
 int
 main ()
 {
@@ -405,9 +885,12 @@ main ()
     thread_start(printId, NULL);
     thread_start(printId, NULL);
     thread_start(printId, NULL);
+    thread_start(checkBarrier, NULL);
     /* Stop timing here */
     thread_shutdown();
 
+    assert(global_isBarrierOk);
+
     puts("Done.");
 
     return 0;
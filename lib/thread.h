@@ -89,6 +89,11 @@ extern "C" {
 #define THREAD_ATTR_T                       pthread_attr_t
 
 #define THREAD_ATTR_INIT(attr)              pthread_attr_init(&attr)
+#ifdef __linux__
+#  define THREAD_ATTR_SETCPU(attr, cpu)     thread_attrSetCpu(&(attr), cpu)
+#else
+#  define THREAD_ATTR_SETCPU(attr, cpu)     /* nothing */
+#endif
 #define THREAD_JOIN(tid)                    pthread_join(tid, (void**)NULL)
 #define THREAD_CREATE(tid, attr, fn, arg)   pthread_create(&(tid), \
                                                            &(attr), \
@@ -125,19 +130,42 @@ extern "C" {
 #  define THREAD_BARRIER_FREE(bar)          thread_barrier_free(bar)
 #endif /* !SIMULATOR */
 
+#define THREAD_CACHE_LINE_SIZE              (64)
+
+typedef struct thread_barrier_sense {
+    int value;
+    char padding[THREAD_CACHE_LINE_SIZE - sizeof(int)];
+} thread_barrier_sense_t;
+
 typedef struct thread_barrier {
-    THREAD_MUTEX_T countLock;
-    THREAD_COND_T proceedCond;
-    THREAD_COND_T proceedAllCond;
-    long count;
+    volatile long count;
+    char padding1[THREAD_CACHE_LINE_SIZE - sizeof(long)];
+    volatile int sense;       /* futex word */
+    volatile int numSleeper;
+    char padding2[THREAD_CACHE_LINE_SIZE - 2 * sizeof(int)];
     long numThread;
+    long spinLimit;           /* 0 if oversubscribed */
+    thread_barrier_sense_t* localSenses; /* one per thread */
 } thread_barrier_t;
 
 
+/* =============================================================================
+ * thread_setPlacement
+ * -- Call before thread_startup; overrides the THREAD_PLACEMENT variable
+ * -- spec is "compact" (fill a socket's cores, then its SMT siblings, then
+ *    the next socket), "scatter" (round-robin over sockets), an explicit CPU
+ *    list such as "0,2,4-7" (thread i runs on the i-th entry), or "none"
+ * =============================================================================
+ */
+void
+thread_setPlacement (const char* spec);
+
+
 /* =============================================================================
  * thread_startup
  * -- Create pool of secondary threads
  * -- numThread is total number of threads (primary + secondary)
+ * -- Pins threads if a placement is set; thread_shutdown then reports the CPUs
  * =============================================================================
  */
 void
@@ -190,7 +218,8 @@ thread_barrier_init (thread_barrier_t* barrierPtr);
 
 /* =============================================================================
  * thread_barrier
- * -- Simple logarithmic barrier
+ * -- Sense-reversing barrier for any number of threads
+ * -- Spins briefly, then sleeps on a futex (yields where futexes are missing)
  * =============================================================================
  */
 void
@@ -215,6 +244,31 @@ long
 thread_getNumThread();
 
 
+/* =============================================================================
+ * thread_getCpu
+ * -- Returns CPU on which threadId finished its last parallel region, or -1
+ * =============================================================================
+ */
+long
+thread_getCpu (long threadId);
+
+
+/* =============================================================================
+ * thread_printPlacement
+ * =============================================================================
+ */
+void
+thread_printPlacement ();
+
+
+/* =============================================================================
+ * thread_attrSetCpu
+ * =============================================================================
+ */
+void
+thread_attrSetCpu (THREAD_ATTR_T* attrPtr, long cpu);
+
+
 /* =============================================================================
  * thread_barrier_wait
  * -- Call after thread_start() to synchronize threads inside parallel region
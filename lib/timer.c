@@ -0,0 +1,454 @@
+/* =============================================================================
+ *
+ * timer.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timer.h"
+
+
+enum timer_tuning {
+    TIMER_MAX_NAME        = 32,
+    TIMER_CALIBRATE_NS    = 10000000, /* 10 ms */
+    TIMER_CACHE_LINE_SIZE = 64,
+};
+
+typedef struct timer_phase {
+    char name[TIMER_MAX_NAME];
+} timer_phase_t;
+
+/* Each thread writes only its own row */
+typedef struct timer_row {
+    unsigned long long totals[TIMER_MAX_PHASE]; /* ns */
+    unsigned long counts[TIMER_MAX_PHASE];
+} timer_row_t;
+
+static timer_phase_t   global_phases[TIMER_MAX_PHASE];
+static volatile long   global_numPhase = 0;
+static pthread_mutex_t global_phaseLock = PTHREAD_MUTEX_INITIALIZER;
+static timer_row_t     global_rows[TIMER_MAX_THREAD]
+                           __attribute__ ((aligned (TIMER_CACHE_LINE_SIZE)));
+
+#if defined(TIMER_TSC) && (defined(__i386__) || defined(__x86_64__))
+#  define TIMER_USE_TSC
+static double global_nsPerTick = 0.0;
+/* Ticks are converted relative to these, so doubles keep ns resolution */
+static unsigned long long global_baseTsc = 0;
+static unsigned long long global_baseNs = 0;
+#endif
+
+
+/* =============================================================================
+ * readClock
+ * =============================================================================
+ */
+static inline unsigned long long
+readClock ()
+{
+    struct timespec time;
+
+    clock_gettime(TIMER_CLOCK, &time);
+
+    return ((unsigned long long)time.tv_sec * 1000000000ULL +
+            (unsigned long long)time.tv_nsec);
+}
+
+
+#ifdef TIMER_USE_TSC
+/* =============================================================================
+ * readTsc
+ * =============================================================================
+ */
+static inline unsigned long long
+readTsc ()
+{
+    unsigned int lo;
+    unsigned int hi;
+
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+
+    return (((unsigned long long)hi << 32) | lo);
+}
+
+
+/* =============================================================================
+ * calibrateTsc
+ * -- Called with global_phaseLock held
+ * =============================================================================
+ */
+static void
+calibrateTsc ()
+{
+    unsigned long long clockStart = readClock();
+    unsigned long long tscStart = readTsc();
+    unsigned long long clockStop;
+    unsigned long long tscStop;
+    double nsPerTick;
+
+    do {
+        clockStop = readClock();
+    } while (clockStop - clockStart < TIMER_CALIBRATE_NS);
+    tscStop = readTsc();
+
+    nsPerTick = (double)(clockStop - clockStart) / (double)(tscStop - tscStart);
+    global_baseTsc = tscStop;
+    global_baseNs = clockStop;
+    __atomic_store(&global_nsPerTick, &nsPerTick, __ATOMIC_RELEASE);
+}
+#endif /* TIMER_USE_TSC */
+
+
+/* =============================================================================
+ * timer_getNanoseconds
+ * =============================================================================
+ */
+unsigned long long
+timer_getNanoseconds ()
+{
+#ifdef TIMER_USE_TSC
+    double nsPerTick;
+    __atomic_load(&global_nsPerTick, &nsPerTick, __ATOMIC_ACQUIRE);
+    if (nsPerTick > 0.0) {
+        long long numTick = (long long)(readTsc() - global_baseTsc);
+        return (global_baseNs + (long long)((double)numTick * nsPerTick));
+    }
+#endif
+
+    return readClock();
+}
+
+
+/* =============================================================================
+ * printAtExit
+ * =============================================================================
+ */
+static void
+printAtExit ()
+{
+    timer_printPhases(stdout);
+}
+
+
+/* =============================================================================
+ * registerPhase
+ * -- Returns id; phases with the same name share an id
+ * =============================================================================
+ */
+static long
+registerPhase (const char* name)
+{
+    long id;
+
+    pthread_mutex_lock(&global_phaseLock);
+
+    for (id = 0; id < global_numPhase; id++) {
+        if (strncmp(global_phases[id].name, name, TIMER_MAX_NAME - 1) == 0) {
+            break;
+        }
+    }
+
+    if (id == global_numPhase) {
+        assert(id < TIMER_MAX_PHASE);
+        if (id == 0) {
+#ifdef TIMER_USE_TSC
+            calibrateTsc();
+#endif
+            atexit(&printAtExit);
+        }
+        strncpy(global_phases[id].name, name, TIMER_MAX_NAME - 1);
+        global_phases[id].name[TIMER_MAX_NAME - 1] = '\0';
+        __atomic_store_n(&global_numPhase, id + 1, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&global_phaseLock);
+
+    return id;
+}
+
+
+/* =============================================================================
+ * timer_phaseBegin
+ * =============================================================================
+ */
+unsigned long long
+timer_phaseBegin (long* idPtr, const char* name)
+{
+    if (__atomic_load_n(idPtr, __ATOMIC_ACQUIRE) < 0) {
+        __atomic_store_n(idPtr, registerPhase(name), __ATOMIC_RELEASE);
+    }
+
+    return timer_getNanoseconds();
+}
+
+
+/* =============================================================================
+ * timer_phaseEnd
+ * =============================================================================
+ */
+void
+timer_phaseEnd (long id, long threadId, unsigned long long start)
+{
+    unsigned long long stop = timer_getNanoseconds();
+    timer_row_t* rowPtr;
+
+    assert(threadId >= 0 && threadId < TIMER_MAX_THREAD);
+    rowPtr = &global_rows[threadId];
+    rowPtr->totals[id] += ((stop > start) ? (stop - start) : 0);
+    rowPtr->counts[id]++;
+}
+
+
+/* =============================================================================
+ * timer_getNumPhase
+ * =============================================================================
+ */
+long
+timer_getNumPhase ()
+{
+    return __atomic_load_n(&global_numPhase, __ATOMIC_ACQUIRE);
+}
+
+
+/* =============================================================================
+ * timer_getPhaseSummary
+ * =============================================================================
+ */
+void
+timer_getPhaseSummary (long id, timer_summary_t* summaryPtr)
+{
+    unsigned long long minNs = ~0ULL;
+    unsigned long long maxNs = 0;
+    unsigned long long sumNs = 0;
+    unsigned long numCall = 0;
+    long numThread = 0;
+    long t;
+
+    for (t = 0; t < TIMER_MAX_THREAD; t++) {
+        timer_row_t* rowPtr = &global_rows[t];
+        unsigned long long ns = rowPtr->totals[id];
+        if (rowPtr->counts[id] == 0) {
+            continue;
+        }
+        numThread++;
+        numCall += rowPtr->counts[id];
+        sumNs += ns;
+        if (ns < minNs) {
+            minNs = ns;
+        }
+        if (ns > maxNs) {
+            maxNs = ns;
+        }
+    }
+
+    summaryPtr->name      = global_phases[id].name;
+    summaryPtr->numThread = numThread;
+    summaryPtr->numCall   = numCall;
+    if (numThread == 0) {
+        summaryPtr->minSeconds  = 0.0;
+        summaryPtr->maxSeconds  = 0.0;
+        summaryPtr->meanSeconds = 0.0;
+        return;
+    }
+    summaryPtr->minSeconds  = (double)minNs / 1e9;
+    summaryPtr->maxSeconds  = (double)maxNs / 1e9;
+    summaryPtr->meanSeconds = (double)sumNs / (double)numThread / 1e9;
+}
+
+
+/* =============================================================================
+ * timer_printPhases
+ * =============================================================================
+ */
+void
+timer_printPhases (FILE* stream)
+{
+    long numPhase = timer_getNumPhase();
+    long p;
+
+    if (numPhase == 0) {
+        return;
+    }
+
+#ifdef TIMER_USE_TSC
+    fprintf(stream, "Phase times (ms, per-thread totals, TSC at %.3f GHz):\n",
+            1.0 / global_nsPerTick);
+#else
+    fprintf(stream, "Phase times (ms, per-thread totals):\n");
+#endif
+    fprintf(stream, "  %-24s %7s %10s %14s %14s %14s %8s\n",
+            "phase", "threads", "calls", "min", "max", "mean", "max/mean");
+
+    for (p = 0; p < numPhase; p++) {
+        timer_summary_t summary;
+        timer_getPhaseSummary(p, &summary);
+        if (summary.numThread == 0) {
+            continue;
+        }
+        fprintf(stream, "  %-24s %7li %10lu %14.6f %14.6f %14.6f %8.2f\n",
+                summary.name,
+                summary.numThread,
+                summary.numCall,
+                summary.minSeconds * 1e3,
+                summary.maxSeconds * 1e3,
+                summary.meanSeconds * 1e3,
+                ((summary.meanSeconds > 0.0) ?
+                 (summary.maxSeconds / summary.meanSeconds) : 1.0));
+    }
+}
+
+
+/* =============================================================================
+ * TEST_TIMER
+ * =============================================================================
+ */
+#ifdef TEST_TIMER
+
+
+#include <unistd.h>
+#include "thread.h"
+
+#define NUM_THREAD (4)
+
+
+static void
+sleepByThreadId (void* argPtr)
+{
+    long threadId = thread_getId();
+
+    TIMER_PHASE_BEGIN("sleep");
+    usleep((threadId + 1) * 10000);
+    TIMER_PHASE_END();
+
+    TIMER_PHASE_BEGIN("empty");
+    TIMER_PHASE_END();
+}
+
+
+int
+main ()
+{
+    TIMER_T start;
+    TIMER_T stop;
+    unsigned long long startNs;
+    unsigned long long stopNs;
+    timer_summary_t summary;
+    long t;
+
+    puts("Starting...");
+
+    TIMER_READ(start);
+    startNs = timer_getNanoseconds();
+    usleep(20000);
+    stopNs = timer_getNanoseconds();
+    TIMER_READ(stop);
+    assert(TIMER_DIFF_SECONDS(start, stop) >= 0.02);
+    assert(stopNs - startNs >= 20000000ULL);
+
+    thread_startup(NUM_THREAD);
+    thread_start(sleepByThreadId, NULL);
+    thread_start(sleepByThreadId, NULL);
+    thread_shutdown();
+
+    assert(global_numPhase == 2);
+    for (t = 0; t < NUM_THREAD; t++) {
+        unsigned long long expectedNs = 2ULL * (t + 1) * 10000000ULL;
+        assert(global_rows[t].counts[0] == 2);
+        assert(global_rows[t].totals[0] >= expectedNs);
+        assert(global_rows[t].counts[1] == 2);
+    }
+
+    assert(timer_getNumPhase() == 2);
+    timer_getPhaseSummary(0, &summary);
+    assert(strcmp(summary.name, "sleep") == 0);
+    assert(summary.numThread == NUM_THREAD);
+    assert(summary.numCall == 2 * NUM_THREAD);
+    assert(summary.minSeconds >= 0.02);
+    assert(summary.maxSeconds >= 2.0 * NUM_THREAD * 0.01);
+    assert(summary.meanSeconds >= summary.minSeconds);
+    assert(summary.meanSeconds <= summary.maxSeconds);
+
+    puts("All tests passed."); /* phase table follows at exit */
+
+    return 0;
+}
+
+
+#endif /* TEST_TIMER */
+
+
+/* =============================================================================
+ *
+ * End of timer.c
+ *
+ * =============================================================================
+ */
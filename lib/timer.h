@@ -73,16 +73,130 @@
 #define TIMER_H 1
 
 
-#include <sys/time.h>
+#include <stdio.h>
+#include <time.h>
 
 
-#define TIMER_T                         struct timeval
+#ifdef __cplusplus
+extern "C" {
+#endif
 
-#define TIMER_READ(time)                gettimeofday(&(time), NULL)
+
+#ifdef CLOCK_MONOTONIC_RAW
+#  define TIMER_CLOCK                   CLOCK_MONOTONIC_RAW
+#else
+#  define TIMER_CLOCK                   CLOCK_MONOTONIC
+#endif
+
+#define TIMER_T                         struct timespec
+
+#define TIMER_READ(time)                clock_gettime(TIMER_CLOCK, &(time))
 
 #define TIMER_DIFF_SECONDS(start, stop) \
-    (((double)(stop.tv_sec)  + (double)(stop.tv_usec / 1000000.0)) - \
-     ((double)(start.tv_sec) + (double)(start.tv_usec / 1000000.0)))
+    (((double)(stop.tv_sec)  + (double)(stop.tv_nsec / 1000000000.0)) - \
+     ((double)(start.tv_sec) + (double)(start.tv_nsec / 1000000000.0)))
+
+
+/* =============================================================================
+ * Phase timers
+ *
+ * TIMER_PHASE_BEGIN(name) ... TIMER_PHASE_END() brackets a region of code
+ * (like TM_BEGIN/TM_END, they open and close a block). Each thread
+ * accumulates the nanoseconds it spends in each named phase; phases with
+ * the same name share totals. At exit, a table with the minimum, maximum,
+ * and mean per-thread total of every phase is printed, so load imbalance
+ * shows up as max/mean > 1.
+ *
+ * Times come from clock_gettime(TIMER_CLOCK). Compiling lib/timer.c with
+ * -DTIMER_TSC on x86 reads the time-stamp counter instead, scaled by a
+ * factor calibrated against TIMER_CLOCK at the first phase; this assumes
+ * an invariant TSC.
+ *
+ * The caller must be able to use thread_getId().
+ * =============================================================================
+ */
+
+enum timer_config {
+    TIMER_MAX_PHASE  = 64,
+    TIMER_MAX_THREAD = 256,
+};
+
+#define TIMER_PHASE_BEGIN(name) \
+    { \
+        static long timer_phaseId = -1; \
+        unsigned long long timer_phaseStart = \
+            timer_phaseBegin(&timer_phaseId, (name))
+
+#define TIMER_PHASE_END() \
+        timer_phaseEnd(timer_phaseId, thread_getId(), timer_phaseStart); \
+    }
+
+
+/* =============================================================================
+ * timer_getNanoseconds
+ * =============================================================================
+ */
+unsigned long long
+timer_getNanoseconds ();
+
+
+/* =============================================================================
+ * timer_phaseBegin
+ * -- Registers the phase on first use and stores its id in *idPtr
+ * -- Returns start time
+ * =============================================================================
+ */
+unsigned long long
+timer_phaseBegin (long* idPtr, const char* name);
+
+
+/* =============================================================================
+ * timer_phaseEnd
+ * =============================================================================
+ */
+void
+timer_phaseEnd (long id, long threadId, unsigned long long start);
+
+
+/* =============================================================================
+ * timer_getNumPhase
+ * =============================================================================
+ */
+long
+timer_getNumPhase ();
+
+
+/* =============================================================================
+ * timer_getPhaseSummary
+ * -- Statistics over the per-thread totals of phase id (0 <= id < number of
+ *    phases); numThread is 0 if no thread has finished the phase yet
+ * =============================================================================
+ */
+typedef struct timer_summary {
+    const char* name;
+    long numThread;
+    unsigned long numCall;
+    double minSeconds;
+    double maxSeconds;
+    double meanSeconds;
+} timer_summary_t;
+
+void
+timer_getPhaseSummary (long id, timer_summary_t* summaryPtr);
+
+
+/* =============================================================================
+ * timer_printPhases
+ * -- Called automatically at exit if any phase was timed
+ * =============================================================================
+ */
+void
+timer_printPhases (FILE* stream);
+
+
+#ifdef __cplusplus
+}
+#endif
 
 
 #endif /* TIMER_H */
@@ -206,6 +206,11 @@
  * TM_MALLOC(size)
  *     Allocate memory inside atomic block / transaction
  *
+ * P_MALLOC_TYPE(typePtr), TM_MALLOC_TYPE(typePtr)
+ *     Like P_MALLOC and TM_MALLOC, but for objects of a memory_type_t
+ *     (memory.h), which come from spans of their own where the flavor
+ *     supports it; release them with P_FREE and TM_FREE
+ *
  * TM_FREE(ptr)
  *     Deallocate memory inside atomic block / transaction
  *
@@ -213,7 +218,15 @@
  *     Begin atomic block / transaction
  *
  * TM_BEGIN_RO()
- *     Begin atomic block / transaction that only reads shared data
+ *     Begin atomic block / transaction that only reads shared data. The
+ *     in-tree STM can run these on a snapshot of old versions so that they
+ *     do not abort (see stm.h)
+ *
+ * TM_BEGIN_IRREVOCABLE()
+ *     Begin atomic block / transaction that must not abort (e.g., because it
+ *     does I/O); it runs alone once all other transactions have finished.
+ *     The in-tree STM and lock runtimes also run a transaction this way
+ *     after it has aborted too often in a row (see cm.h)
  *
  * TM_END()
  *     End atomic block / transaction
@@ -221,6 +234,40 @@
  * TM_RESTART()
  *     Restart atomic block / transaction
  *
+ * TM_BEGIN_NESTED()
+ *     Begin closed nested atomic block inside a transaction. With the in-tree
+ *     STM, a conflict inside it may re-execute just the nested block; other
+ *     flavors fold it into the enclosing transaction
+ *
+ * TM_END_NESTED()
+ *     End closed nested atomic block
+ *
+ * TM_BEGIN_OPEN()
+ *     Begin open nested atomic block inside a transaction. With the in-tree
+ *     STM, it commits at TM_END_OPEN even though the enclosing transaction
+ *     may still abort; it must not touch data the enclosing transaction
+ *     reads or writes (its commit would make the enclosing transaction's
+ *     reads stale and abort it). Other flavors fold it into the enclosing
+ *     transaction
+ *
+ * TM_END_OPEN()
+ *     End open nested atomic block
+ *
+ * TM_COMPENSATE(handler, argPtr)
+ *     Inside an open nested block: if the enclosing transaction aborts, undo
+ *     the block's effects by running handler(TM_ARG argPtr) as an open nested
+ *     block of its own. Declare handler as void handler (TM_ARGDECL void*)
+ *
+ * TM_BATCH_BEGIN(batchPtr)
+ *     Begin atomic block / transaction that handles TM_BATCH_SIZE(batchPtr)
+ *     items of a loop; the size adapts to the abort rate (see tmbatch.h)
+ *
+ * TM_BATCH_SIZE(batchPtr)
+ *     Number of items the current attempt of the batch must handle
+ *
+ * TM_BATCH_END(batchPtr)
+ *     End atomic block / transaction begun with TM_BATCH_BEGIN
+ *
  * TM_EARLY_RELEASE()
  *     Remove speculatively read line from the read set
  *
@@ -310,6 +357,7 @@
 #    define thread_barrier_wait();      _Pragma ("omp barrier")
 #    define TM_BEGIN()                  _Pragma ("omp transaction") {
 #    define TM_BEGIN_RO()               _Pragma ("omp transaction") {
+#    define TM_BEGIN_IRREVOCABLE()      _Pragma ("omp transaction") {
 #    define TM_END()                    }
 #    define TM_RESTART()                _TM_Abort()
 
@@ -319,6 +367,7 @@
 
 #    define TM_BEGIN()                    TM_BeginClosed()
 #    define TM_BEGIN_RO()                 TM_BeginClosed()
+#    define TM_BEGIN_IRREVOCABLE()        TM_BeginClosed()
 #    define TM_END()                      TM_EndClosed()
 #    define TM_RESTART()                  _TM_Abort()
 #    define TM_EARLY_RELEASE(var)         TM_Release(&(var))
@@ -335,6 +384,8 @@
 
 #  include <string.h>
 #  include <stm.h>
+#  include "linetrace.h"
+#  include "memory.h"
 #  include "thread.h"
 
 #  if defined (OTM)
@@ -424,9 +475,11 @@
                                         STM_INIT_THREAD(TM_ARG_ALONE, thread_getId())
 #      define TM_THREAD_EXIT()          STM_FREE_THREAD(TM_ARG_ALONE)
 
-#      define P_MALLOC(size)            malloc(size)
-#      define P_FREE(ptr)               free(ptr)
+#      define P_MALLOC(size)            memory_alloc(size)
+#      define P_MALLOC_TYPE(typePtr)    memory_allocType(typePtr)
+#      define P_FREE(ptr)               memory_free(ptr)
 #      define TM_MALLOC(size)           STM_MALLOC(size)
+#      define TM_MALLOC_TYPE(typePtr)   STM_MALLOC_TYPE(typePtr)
 #      define TM_FREE(ptr)              STM_FREE(ptr)
 
 #    endif /* !OTM */
@@ -437,6 +490,7 @@
 
 #    define TM_BEGIN()                  _Pragma ("omp transaction") {
 #    define TM_BEGIN_RO()               _Pragma ("omp transaction") {
+#    define TM_BEGIN_IRREVOCABLE()      _Pragma ("omp transaction") {
 #    define TM_END()                    }
 #    define TM_RESTART()                omp_abort()
 
@@ -444,8 +498,10 @@
 
 #  else /* !OTM */
 
-#    define TM_BEGIN()                  STM_BEGIN_WR()
-#    define TM_BEGIN_RO()               STM_BEGIN_RD()
+#    define TM_BEGIN()                  LINETRACE_BEGIN_TX() STM_BEGIN_WR()
+#    define TM_BEGIN_RO()               LINETRACE_BEGIN_TX() STM_BEGIN_RD()
+#    define TM_BEGIN_IRREVOCABLE()      LINETRACE_BEGIN_TX() \
+                                        STM_BEGIN_IRREVOCABLE()
 #    define TM_END()                    STM_END()
 #    define TM_RESTART()                STM_RESTART()
 
@@ -454,6 +510,53 @@
 #  endif /* !OTM */
 
 
+/* =============================================================================
+ * LOCK - Lock-based atomic blocks (global lock or striped address locks)
+ * =============================================================================
+ */
+
+#elif defined(LOCK)
+
+#  ifdef SIMULATOR
+#    error LOCK does not support SIMULATOR
+#  endif
+
+#  include <string.h>
+#  include "linetrace.h"
+#  include "lock.h"
+#  include "memory.h"
+#  include "thread.h"
+
+#  define TM_ARG                        LOCK_SELF,
+#  define TM_ARG_ALONE                  LOCK_SELF
+#  define TM_ARGDECL                    LOCK_THREAD_T* TM_ARG
+#  define TM_ARGDECL_ALONE              LOCK_THREAD_T* TM_ARG_ALONE
+#  define TM_CALLABLE                   /* nothing */
+
+#  define TM_STARTUP(numThread)         LOCK_STARTUP()
+#  define TM_SHUTDOWN()                 LOCK_SHUTDOWN()
+
+#  define TM_THREAD_ENTER()             TM_ARGDECL_ALONE = LOCK_NEW_THREAD(); \
+                                        LOCK_INIT_THREAD(TM_ARG_ALONE, thread_getId())
+#  define TM_THREAD_EXIT()              LOCK_FREE_THREAD(TM_ARG_ALONE)
+
+#  define P_MALLOC(size)                memory_alloc(size)
+#  define P_MALLOC_TYPE(typePtr)        memory_allocType(typePtr)
+#  define P_FREE(ptr)                   memory_free(ptr)
+#  define TM_MALLOC(size)               LOCK_MALLOC(size)
+#  define TM_MALLOC_TYPE(typePtr)       LOCK_MALLOC_TYPE(typePtr)
+#  define TM_FREE(ptr)                  LOCK_FREE(ptr)
+
+#  define TM_BEGIN()                    LINETRACE_BEGIN_TX() LOCK_BEGIN()
+#  define TM_BEGIN_RO()                 LINETRACE_BEGIN_TX() LOCK_BEGIN()
+#  define TM_BEGIN_IRREVOCABLE()        LINETRACE_BEGIN_TX() \
+                                        LOCK_BEGIN_IRREVOCABLE()
+#  define TM_END()                      LOCK_END()
+#  define TM_RESTART()                  LOCK_RESTART()
+
+#  define TM_EARLY_RELEASE(var)         /* nothing */
+
+
 /* =============================================================================
  * Sequential execution
  * =============================================================================
@@ -469,8 +572,17 @@
 #  define TM_ARGDECL_ALONE              /* nothing */
 #  define TM_CALLABLE                   /* nothing */
 
-#  define TM_STARTUP(numThread)         /* nothing */
-#  define TM_SHUTDOWN()                 /* nothing */
+#  ifdef RWSET_PROFILE
+#    ifdef SIMULATOR
+#      error RWSET_PROFILE does not support SIMULATOR
+#    endif
+#    include "rwset.h"
+#    define TM_STARTUP(numThread)       rwset_startup()
+#    define TM_SHUTDOWN()               rwset_shutdown()
+#  else /* !RWSET_PROFILE */
+#    define TM_STARTUP(numThread)       /* nothing */
+#    define TM_SHUTDOWN()               /* nothing */
+#  endif /* !RWSET_PROFILE */
 
 #  define TM_THREAD_ENTER()             /* nothing */
 #  define TM_THREAD_EXIT()              /* nothing */
@@ -486,16 +598,28 @@
 
 #  else /* !SIMULATOR */
 
-#    define P_MALLOC(size)              malloc(size)
-#    define P_FREE(ptr)                 free(ptr)
-#    define TM_MALLOC(size)             malloc(size)
-#    define TM_FREE(ptr)                free(ptr)
+#    include "memory.h"
+
+#    define P_MALLOC(size)              memory_alloc(size)
+#    define P_MALLOC_TYPE(typePtr)      memory_allocType(typePtr)
+#    define P_FREE(ptr)                 memory_free(ptr)
+#    define TM_MALLOC(size)             memory_alloc(size)
+#    define TM_MALLOC_TYPE(typePtr)     memory_allocType(typePtr)
+#    define TM_FREE(ptr)                memory_free(ptr)
 
 #  endif /* !SIMULATOR */
 
-#  define TM_BEGIN()                    /* nothing */
-#  define TM_BEGIN_RO()                 /* nothing */
-#  define TM_END()                      /* nothing */
+#  ifdef RWSET_PROFILE
+#    define TM_BEGIN()                  RWSET_BEGIN(FALSE)
+#    define TM_BEGIN_RO()               RWSET_BEGIN(TRUE)
+#    define TM_BEGIN_IRREVOCABLE()      RWSET_BEGIN(FALSE)
+#    define TM_END()                    RWSET_END()
+#  else /* !RWSET_PROFILE */
+#    define TM_BEGIN()                  /* nothing */
+#    define TM_BEGIN_RO()               /* nothing */
+#    define TM_BEGIN_IRREVOCABLE()      /* nothing */
+#    define TM_END()                    /* nothing */
+#  endif /* !RWSET_PROFILE */
 #  define TM_RESTART()                  assert(0)
 
 #  define TM_EARLY_RELEASE(var)         /* nothing */
@@ -531,13 +655,16 @@
 
 #else /* OTM */
 
-#  define TM_SHARED_READ(var)           STM_READ(var)
-#  define TM_SHARED_READ_P(var)         STM_READ_P(var)
-#  define TM_SHARED_READ_F(var)         STM_READ_F(var)
+#  define TM_SHARED_READ(var)           LINETRACE_READ(var, STM_READ(var))
+#  define TM_SHARED_READ_P(var)         LINETRACE_READ(var, STM_READ_P(var))
+#  define TM_SHARED_READ_F(var)         LINETRACE_READ(var, STM_READ_F(var))
 
-#  define TM_SHARED_WRITE(var, val)     STM_WRITE((var), val)
-#  define TM_SHARED_WRITE_P(var, val)   STM_WRITE_P((var), val)
-#  define TM_SHARED_WRITE_F(var, val)   STM_WRITE_F((var), val)
+#  define TM_SHARED_WRITE(var, val)     LINETRACE_WRITE(var, \
+                                                        STM_WRITE((var), val))
+#  define TM_SHARED_WRITE_P(var, val)   LINETRACE_WRITE(var, \
+                                                        STM_WRITE_P((var), val))
+#  define TM_SHARED_WRITE_F(var, val)   LINETRACE_WRITE(var, \
+                                                        STM_WRITE_F((var), val))
 
 #  define TM_LOCAL_WRITE(var, val)      STM_LOCAL_WRITE(var, val)
 #  define TM_LOCAL_WRITE_P(var, val)    STM_LOCAL_WRITE_P(var, val)
@@ -545,7 +672,38 @@
 
 #endif /* !OTM */
 
-#else /* !STM */
+#elif defined(LOCK)
+
+#  define TM_SHARED_READ(var)           LINETRACE_READ(var, LOCK_READ(var))
+#  define TM_SHARED_READ_P(var)         LINETRACE_READ(var, LOCK_READ_P(var))
+#  define TM_SHARED_READ_F(var)         LINETRACE_READ(var, LOCK_READ_F(var))
+
+#  define TM_SHARED_WRITE(var, val)     LINETRACE_WRITE(var, \
+                                                        LOCK_WRITE((var), val))
+#  define TM_SHARED_WRITE_P(var, val)   LINETRACE_WRITE(var, \
+                                                        LOCK_WRITE_P((var), val))
+#  define TM_SHARED_WRITE_F(var, val)   LINETRACE_WRITE(var, \
+                                                        LOCK_WRITE_F((var), val))
+
+#  define TM_LOCAL_WRITE(var, val)      LOCK_LOCAL_WRITE(var, val)
+#  define TM_LOCAL_WRITE_P(var, val)    LOCK_LOCAL_WRITE_P(var, val)
+#  define TM_LOCAL_WRITE_F(var, val)    LOCK_LOCAL_WRITE_F(var, val)
+
+#elif defined(RWSET_PROFILE)
+
+#  define TM_SHARED_READ(var)           RWSET_READ(var)
+#  define TM_SHARED_READ_P(var)         RWSET_READ(var)
+#  define TM_SHARED_READ_F(var)         RWSET_READ(var)
+
+#  define TM_SHARED_WRITE(var, val)     RWSET_WRITE(var, val)
+#  define TM_SHARED_WRITE_P(var, val)   RWSET_WRITE(var, val)
+#  define TM_SHARED_WRITE_F(var, val)   RWSET_WRITE(var, val)
+
+#  define TM_LOCAL_WRITE(var, val)      ({var = val; var;})
+#  define TM_LOCAL_WRITE_P(var, val)    ({var = val; var;})
+#  define TM_LOCAL_WRITE_F(var, val)    ({var = val; var;})
+
+#else /* !STM && !LOCK && !RWSET_PROFILE */
 
 #  define TM_SHARED_READ(var)           (var)
 #  define TM_SHARED_READ_P(var)         (var)
@@ -559,7 +717,64 @@
 #  define TM_LOCAL_WRITE_P(var, val)    ({var = val; var;})
 #  define TM_LOCAL_WRITE_F(var, val)    ({var = val; var;})
 
-#endif /* !STM */
+#endif /* !STM && !LOCK && !RWSET_PROFILE */
+
+
+/* =============================================================================
+ * Nested atomic blocks
+ * =============================================================================
+ */
+
+#if defined(STM) && !defined(OTM)
+
+#  define TM_BEGIN_NESTED()             STM_BEGIN_NESTED()
+#  define TM_END_NESTED()               STM_END_NESTED()
+#  define TM_BEGIN_OPEN()               STM_BEGIN_OPEN()
+#  define TM_END_OPEN()                 STM_END_OPEN()
+#  define TM_COMPENSATE(handler, argPtr) \
+                                        STM_COMPENSATE(handler, argPtr)
+
+#else /* !STM || OTM */
+
+/* Flattened: an abort rolls back the whole transaction, open blocks too */
+#  define TM_BEGIN_NESTED()             do {
+#  define TM_END_NESTED()               } while (0)
+#  define TM_BEGIN_OPEN()               do {
+#  define TM_END_OPEN()                 } while (0)
+#  define TM_COMPENSATE(handler, argPtr) \
+                                        ((void)(handler), (void)(argPtr))
+
+#endif /* !STM || OTM */
+
+
+/* =============================================================================
+ * Typed allocation (all flavors)
+ * -- Flavors without typed spans allocate by size
+ * =============================================================================
+ */
+
+#include "memory.h"
+
+#ifndef P_MALLOC_TYPE
+#  define P_MALLOC_TYPE(typePtr)        P_MALLOC((typePtr)->numByte)
+#endif
+#ifndef TM_MALLOC_TYPE
+#  define TM_MALLOC_TYPE(typePtr)       TM_MALLOC((typePtr)->numByte)
+#endif
+
+
+/* =============================================================================
+ * Adaptive batching of fine-grained atomic blocks (all flavors)
+ * =============================================================================
+ */
+
+#include "tmbatch.h"
+
+#define TM_BATCH_BEGIN(batchPtr)        TM_BEGIN(); \
+                                        tmbatch_begin(batchPtr)
+#define TM_BATCH_SIZE(batchPtr)         tmbatch_getSize(batchPtr)
+#define TM_BATCH_END(batchPtr)          TM_END(); \
+                                        tmbatch_end(batchPtr)
 
 
 #endif /* TM_H */
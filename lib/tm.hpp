@@ -0,0 +1,384 @@
+/* =============================================================================
+ *
+ * tm.hpp
+ * -- C++ atomic blocks and type-dispatched shared accessors
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef TM_HPP
+#define TM_HPP 1
+
+
+#include <type_traits>
+#include "tm.h"
+
+
+/* =============================================================================
+ * C++ interface to tm.h
+ *
+ * tx::atomic(TM_ARG [&] { ... })
+ *     Runs the lambda as one atomic block (TM_BEGIN()..TM_END()). Each call
+ *     site is a site of its own in the per-site statistics and is labeled
+ *     with the caller's file and line, so pass a lambda rather than a named
+ *     function object that several sites share
+ *
+ * tx::shared<T>::read(TM_ARG var)
+ * tx::shared<T>::write(TM_ARG var, val)
+ * tx::shared<T>::writeLocal(TM_ARG var, val)
+ *     TM_SHARED_READ, TM_SHARED_WRITE, and TM_LOCAL_WRITE for a variable of
+ *     type T, picking the _P variant for pointers and the _F variant for
+ *     float at compile time and returning T, so that callers need no (long)
+ *     or (void*) casts. Integer, bool, and enum types use the plain variant
+ *     and keep their size. T is deduced by tx::read, tx::write, and
+ *     tx::writeLocal
+ *
+ * All of these are inline and expand to the same calls as the C macros. The
+ * C layer has no path for double or for aggregates, so they are rejected at
+ * compile time. The namespace is tx, as tm is taken by struct tm in time.h.
+ * =============================================================================
+ */
+
+namespace tx {
+
+
+namespace detail {
+
+enum kind_t {
+    KIND_WORD,
+    KIND_POINTER,
+    KIND_FLOAT,
+    KIND_NONE
+};
+
+template <typename T>
+struct kind {
+    static const kind_t value =
+        std::is_pointer<T>::value ? KIND_POINTER :
+        std::is_same<T, float>::value ? KIND_FLOAT :
+        ((std::is_integral<T>::value || std::is_enum<T>::value) &&
+         sizeof(T) <= sizeof(long)) ? KIND_WORD :
+        KIND_NONE;
+};
+
+template <typename T, kind_t K = kind<T>::value>
+struct access {
+    static_assert(K != KIND_NONE,
+                  "tx::shared supports integers, enums, pointers, and float");
+};
+
+template <typename T>
+struct access<T, KIND_WORD> {
+    static inline T read (TM_ARGDECL  const T& var) {
+        return (T)TM_SHARED_READ(var);
+    }
+    static inline void write (TM_ARGDECL  T& var, T val) {
+        TM_SHARED_WRITE(var, val);
+    }
+    static inline void writeLocal (TM_ARGDECL  T& var, T val) {
+        TM_LOCAL_WRITE(var, val);
+    }
+};
+
+template <typename T>
+struct access<T, KIND_POINTER> {
+    static inline T read (TM_ARGDECL  const T& var) {
+        return (T)TM_SHARED_READ_P(var);
+    }
+    static inline void write (TM_ARGDECL  T& var, T val) {
+        TM_SHARED_WRITE_P(var, val);
+    }
+    static inline void writeLocal (TM_ARGDECL  T& var, T val) {
+        TM_LOCAL_WRITE_P(var, val);
+    }
+};
+
+template <typename T>
+struct access<T, KIND_FLOAT> {
+    static inline T read (TM_ARGDECL  const T& var) {
+        return TM_SHARED_READ_F(var);
+    }
+    static inline void write (TM_ARGDECL  T& var, T val) {
+        TM_SHARED_WRITE_F(var, val);
+    }
+    static inline void writeLocal (TM_ARGDECL  T& var, T val) {
+        TM_LOCAL_WRITE_F(var, val);
+    }
+};
+
+} /* namespace detail */
+
+
+template <typename T>
+struct shared {
+    static inline T read (TM_ARGDECL  const T& var) {
+        return detail::access<T>::read(TM_ARG  var);
+    }
+    static inline void write (TM_ARGDECL  T& var, T val) {
+        detail::access<T>::write(TM_ARG  var, val);
+    }
+    static inline void writeLocal (TM_ARGDECL  T& var, T val) {
+        detail::access<T>::writeLocal(TM_ARG  var, val);
+    }
+};
+
+
+template <typename T>
+inline T
+read (TM_ARGDECL  const T& var)
+{
+    return shared<T>::read(TM_ARG  var);
+}
+
+
+/* val is not used to deduce T, so that write(TM_ARG count, 0) works */
+template <typename T>
+struct identity {
+    typedef T type;
+};
+
+template <typename T>
+inline void
+write (TM_ARGDECL  T& var, typename identity<T>::type val)
+{
+    shared<T>::write(TM_ARG  var, val);
+}
+
+template <typename T>
+inline void
+writeLocal (TM_ARGDECL  T& var, typename identity<T>::type val)
+{
+    shared<T>::writeLocal(TM_ARG  var, val);
+}
+
+
+/*
+ * TM_BEGIN declares a static per-site record initialized from __FILE__ and
+ * __LINE__, which here would name this header; label it with the caller's
+ * location instead. Each lambda type gets its own instantiation, and thus
+ * its own record.
+ */
+#pragma push_macro("TMSTATS_SITE_INIT")
+#pragma push_macro("RWSET_SITE_INIT")
+#undef TMSTATS_SITE_INIT
+#undef RWSET_SITE_INIT
+#define TMSTATS_SITE_INIT               { file, line, -1 }
+#define RWSET_SITE_INIT(isReadOnly)     { file, line, isReadOnly, -1 }
+
+template <typename F>
+inline void
+atomic (TM_ARGDECL  F body,
+        const char* file = __builtin_FILE(), long line = __builtin_LINE())
+{
+    (void)file;
+    (void)line;
+    TM_BEGIN();
+    body();
+    TM_END();
+}
+
+#pragma pop_macro("RWSET_SITE_INIT")
+#pragma pop_macro("TMSTATS_SITE_INIT")
+
+
+} /* namespace tx */
+
+
+#endif /* TM_HPP */
+
+
+/* =============================================================================
+ * TEST_TM_HPP
+ * =============================================================================
+ */
+#ifdef TEST_TM_HPP
+
+
+#include <assert.h>
+#include <stdio.h>
+#include "thread.h"
+
+#define NUM_THREAD   (4)
+#define NUM_TRANSFER (20000)
+#define NUM_ACCOUNT  (8)
+
+enum color { RED, BLACK };
+
+struct account {
+    long balance;
+    float weight;
+    char tag;      /* neighbors of a sub-word field must not be widened */
+    bool isActive;
+    short numUse;
+    enum color color;
+    struct account* nextPtr;
+};
+
+static struct account global_accounts[NUM_ACCOUNT];
+static struct account* global_headPtr;
+
+
+static void
+transfer (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    long id = thread_getId();
+    long i;
+
+    for (i = 0; i < NUM_TRANSFER; i++) {
+        long from = (id + i) % NUM_ACCOUNT;
+        long to = (id + 3 * i + 1) % NUM_ACCOUNT;
+        if (from == to) {
+            to = (to + 1) % NUM_ACCOUNT;
+        }
+        tx::atomic(TM_ARG [&] {
+            struct account* fromPtr = &global_accounts[from];
+            struct account* toPtr = &global_accounts[to];
+            tx::write(TM_ARG  fromPtr->balance,
+                      tx::read(TM_ARG  fromPtr->balance) - 1);
+            tx::write(TM_ARG  toPtr->balance,
+                      tx::read(TM_ARG  toPtr->balance) + 1);
+            tx::write(TM_ARG  fromPtr->weight,
+                      tx::read(TM_ARG  fromPtr->weight) - 0.5f);
+            tx::write(TM_ARG  toPtr->weight,
+                      tx::read(TM_ARG  toPtr->weight) + 0.5f);
+            tx::write(TM_ARG  toPtr->numUse,
+                      (short)(tx::read(TM_ARG  toPtr->numUse) + 1));
+            tx::write(TM_ARG  toPtr->isActive,
+                      !tx::read(TM_ARG  toPtr->isActive));
+            tx::write(TM_ARG  toPtr->color,
+                      (tx::read(TM_ARG  toPtr->color) == RED) ? BLACK : RED);
+            /* Move the head of the ring one step */
+            struct account* headPtr = tx::read(TM_ARG  global_headPtr);
+            tx::write(TM_ARG  global_headPtr,
+                      tx::shared<struct account*>::read(TM_ARG
+                                                        headPtr->nextPtr));
+        });
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+int
+main ()
+{
+    long i;
+
+    puts("Starting...");
+
+    for (i = 0; i < NUM_ACCOUNT; i++) {
+        global_accounts[i].tag = 'a' + i;
+        global_accounts[i].nextPtr = &global_accounts[(i + 1) % NUM_ACCOUNT];
+    }
+    global_headPtr = &global_accounts[0];
+
+    TM_STARTUP(NUM_THREAD);
+    thread_startup(NUM_THREAD);
+    thread_start(transfer, NULL);
+    thread_shutdown();
+    TM_SHUTDOWN();
+
+    long sumBalance = 0;
+    float sumWeight = 0;
+    long sumUse = 0;
+    long numActive = 0;
+    long numBlack = 0;
+    for (i = 0; i < NUM_ACCOUNT; i++) {
+        struct account* accountPtr = &global_accounts[i];
+        assert(accountPtr->tag == 'a' + i);
+        sumBalance += accountPtr->balance;
+        sumWeight += accountPtr->weight;
+        sumUse += accountPtr->numUse;
+        numActive += accountPtr->isActive;
+        numBlack += (accountPtr->color == BLACK);
+        assert(accountPtr->isActive == (accountPtr->numUse % 2 == 1));
+        assert((accountPtr->color == BLACK) == accountPtr->isActive);
+    }
+    assert(sumBalance == 0);
+    assert(sumWeight == 0);
+    assert(sumUse == NUM_THREAD * NUM_TRANSFER);
+    assert(numActive == numBlack);
+    assert(global_headPtr ==
+           &global_accounts[(NUM_THREAD * NUM_TRANSFER) % NUM_ACCOUNT]);
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_TM_HPP */
+
+
+/* =============================================================================
+ *
+ * End of tm.hpp
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,265 @@
+/* =============================================================================
+ *
+ * tmbatch.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "tmbatch.h"
+#include "types.h"
+
+
+/* =============================================================================
+ * tmbatch_init
+ * =============================================================================
+ */
+void
+tmbatch_init (tmbatch_t* batchPtr)
+{
+    const char* maxString = getenv("TM_BATCH_MAX");
+
+    batchPtr->size     = 1;
+    batchPtr->maxSize  = TMBATCH_DEFAULT_MAX;
+    batchPtr->numClean = 0;
+    batchPtr->isOpen   = FALSE;
+
+    if (maxString != NULL && maxString[0] != '\0') {
+        char* end;
+        long value = strtol(maxString, &end, 10);
+        if (*end != '\0' || value < 1 || value > TMBATCH_MAX_SIZE) {
+            fprintf(stderr, "Bad TM_BATCH_MAX=%s; using %ld\n",
+                    maxString, batchPtr->maxSize);
+        } else {
+            batchPtr->maxSize = value;
+        }
+    }
+}
+
+
+/* =============================================================================
+ * tmbatch_begin
+ * =============================================================================
+ */
+void
+tmbatch_begin (tmbatch_t* batchPtr)
+{
+    if (batchPtr->isOpen) {
+        if (batchPtr->size > 1) {
+            batchPtr->size /= 2;
+        }
+        batchPtr->numClean = 0;
+    }
+    batchPtr->isOpen = TRUE;
+}
+
+
+/* =============================================================================
+ * tmbatch_end
+ * =============================================================================
+ */
+void
+tmbatch_end (tmbatch_t* batchPtr)
+{
+    assert(batchPtr->isOpen);
+    batchPtr->isOpen = FALSE;
+
+    if (++batchPtr->numClean >= TMBATCH_GROW_AFTER) {
+        batchPtr->numClean = 0;
+        batchPtr->size *= 2;
+        if (batchPtr->size > batchPtr->maxSize) {
+            batchPtr->size = batchPtr->maxSize;
+        }
+    }
+}
+
+
+/* =============================================================================
+ * tmbatch_getSize
+ * =============================================================================
+ */
+long
+tmbatch_getSize (tmbatch_t* batchPtr)
+{
+    return batchPtr->size;
+}
+
+
+/* =============================================================================
+ * TEST_TMBATCH
+ * =============================================================================
+ */
+#ifdef TEST_TMBATCH
+
+
+#include "thread.h"
+#include "tm.h"
+
+#define NUM_THREAD  (4)
+#define NUM_ITEM    (100000)
+#define NUM_COUNTER (4)
+
+long global_counters[NUM_COUNTER];
+
+
+static void
+add (void* argPtr)
+{
+    TM_THREAD_ENTER();
+
+    tmbatch_t batch;
+    long numDone = 0;
+
+    tmbatch_init(&batch);
+
+    while (numDone < NUM_ITEM) {
+        long numItem;
+        long i;
+        TM_BATCH_BEGIN(&batch);
+        numItem = TM_BATCH_SIZE(&batch);
+        if (numItem > NUM_ITEM - numDone) {
+            numItem = NUM_ITEM - numDone;
+        }
+        for (i = 0; i < numItem; i++) {
+            long c = (numDone + i) % NUM_COUNTER;
+            TM_SHARED_WRITE(global_counters[c],
+                            TM_SHARED_READ(global_counters[c]) + 1);
+        }
+        TM_BATCH_END(&batch);
+        numDone += numItem;
+    }
+
+    TM_THREAD_EXIT();
+}
+
+
+int
+main ()
+{
+    tmbatch_t batch;
+    long sum = 0;
+    long i;
+
+    puts("Starting...");
+
+    /* Grows to the maximum without aborts, halves on each abort */
+    setenv("TM_BATCH_MAX", "8", 1);
+    tmbatch_init(&batch);
+    assert(tmbatch_getSize(&batch) == 1);
+    for (i = 0; i < 100; i++) {
+        tmbatch_begin(&batch);
+        tmbatch_end(&batch);
+    }
+    assert(tmbatch_getSize(&batch) == 8);
+    tmbatch_begin(&batch);
+    tmbatch_begin(&batch);
+    tmbatch_begin(&batch);
+    assert(tmbatch_getSize(&batch) == 2);
+    tmbatch_end(&batch);
+    assert(tmbatch_getSize(&batch) == 2);
+    tmbatch_begin(&batch);
+    tmbatch_end(&batch);
+    assert(tmbatch_getSize(&batch) == 4);
+
+    setenv("TM_BATCH_MAX", "1", 1);
+    tmbatch_init(&batch);
+    for (i = 0; i < 100; i++) {
+        tmbatch_begin(&batch);
+        tmbatch_end(&batch);
+    }
+    assert(tmbatch_getSize(&batch) == 1);
+
+    /* Retried batches must not lose or repeat items */
+    unsetenv("TM_BATCH_MAX");
+    TM_STARTUP(NUM_THREAD);
+    thread_startup(NUM_THREAD);
+    thread_start(add, NULL);
+    thread_shutdown();
+    TM_SHUTDOWN();
+
+    for (i = 0; i < NUM_COUNTER; i++) {
+        sum += global_counters[i];
+    }
+    assert(sum == NUM_THREAD * NUM_ITEM);
+
+    puts("All tests passed.");
+
+    return 0;
+}
+
+
+#endif /* TEST_TMBATCH */
+
+
+/* =============================================================================
+ *
+ * End of tmbatch.c
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,169 @@
+/* =============================================================================
+ *
+ * tmbatch.h
+ * -- Adaptive batching of fine-grained atomic blocks
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef TMBATCH_H
+#define TMBATCH_H 1
+
+
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Adaptive transaction batching
+ *
+ * Loops that run one tiny atomic block per item pay the begin and commit
+ * overhead once per item. A tmbatch_t lets one atomic block cover several
+ * items instead: TM_BATCH_BEGIN(batchPtr) begins a transaction in which the
+ * caller handles TM_BATCH_SIZE(batchPtr) items, and TM_BATCH_END(batchPtr)
+ * commits it (see tm.h).
+ *
+ * The size starts at 1, doubles after TMBATCH_GROW_AFTER commits without an
+ * abort, and halves whenever an attempt aborts, so it stays large when
+ * contention is low and falls back to one item per transaction when it is
+ * high. It never exceeds the TM_BATCH_MAX environment variable (16 by
+ * default, at most TMBATCH_MAX_SIZE; 1 turns batching off).
+ *
+ * A retried attempt starts over at TM_BATCH_BEGIN, possibly with a smaller
+ * size, so the items of a batch must only be consumed after TM_BATCH_END,
+ * and the block must not change private state that it also reads.
+ * =============================================================================
+ */
+
+enum tmbatch_config {
+    TMBATCH_MAX_SIZE     = 64, /* for callers' per-batch arrays */
+    TMBATCH_DEFAULT_MAX  = 16,
+    TMBATCH_GROW_AFTER   = 2,
+};
+
+typedef struct tmbatch {
+    long size;       /* items per transaction */
+    long maxSize;
+    long numClean;   /* commits at this size without an abort */
+    bool_t isOpen;   /* inside TM_BATCH_BEGIN..TM_BATCH_END */
+} tmbatch_t;
+
+
+/* =============================================================================
+ * tmbatch_init
+ * -- Reads TM_BATCH_MAX
+ * =============================================================================
+ */
+void
+tmbatch_init (tmbatch_t* batchPtr);
+
+
+/* =============================================================================
+ * tmbatch_begin
+ * -- Called at the start of every attempt; a repeated call without
+ *    tmbatch_end means the previous attempt aborted
+ * =============================================================================
+ */
+void
+tmbatch_begin (tmbatch_t* batchPtr);
+
+
+/* =============================================================================
+ * tmbatch_end
+ * -- Called after the transaction has committed
+ * =============================================================================
+ */
+void
+tmbatch_end (tmbatch_t* batchPtr);
+
+
+/* =============================================================================
+ * tmbatch_getSize
+ * =============================================================================
+ */
+long
+tmbatch_getSize (tmbatch_t* batchPtr);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* TMBATCH_H */
+
+
+/* =============================================================================
+ *
+ * End of tmbatch.h
+ *
+ * =============================================================================
+ */
@@ -0,0 +1,444 @@
+/* =============================================================================
+ *
+ * tmstats.c
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tmstats.h"
+#include "types.h"
+
+
+typedef struct tmstats_count {
+    unsigned long numCommit;
+    unsigned long numAbort;
+    unsigned long maxRetry;
+    unsigned long totalTime; /* nanoseconds */
+    unsigned long retryHistogram[TMSTATS_NUM_RETRY_BUCKET];
+    unsigned long timeHistogram[TMSTATS_NUM_TIME_BUCKET];
+} tmstats_count_t;
+
+struct tmstats_thread {
+    long siteId;
+    unsigned long numRetry;
+    unsigned long startTime;
+    tmstats_count_t counts[TMSTATS_MAX_SITE];
+};
+
+static pthread_mutex_t  global_lock = PTHREAD_MUTEX_INITIALIZER;
+static tmstats_site_t*  global_sites[TMSTATS_MAX_SITE];
+static volatile long    global_numSite = 0;
+static tmstats_count_t  global_counts[TMSTATS_MAX_SITE];
+
+
+/* =============================================================================
+ * getTime
+ * -- Returns nanoseconds
+ * =============================================================================
+ */
+static inline unsigned long
+getTime ()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long)ts.tv_sec * 1000000000UL + (unsigned long)ts.tv_nsec;
+}
+
+
+/* =============================================================================
+ * getBucket
+ * -- 0 for 0, else 1 + floor(log2(value)), clamped to numBucket - 1
+ * =============================================================================
+ */
+static inline long
+getBucket (unsigned long value, long numBucket)
+{
+    long bucket = 0;
+
+    while (value > 0 && bucket < (numBucket - 1)) {
+        value >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+
+/* =============================================================================
+ * isStaleOverflow
+ * -- A site put in the overflow slot before tmstats_reset registers again
+ * =============================================================================
+ */
+static inline bool_t
+isStaleOverflow (long id)
+{
+    return ((id == TMSTATS_MAX_SITE - 1) &&
+            (__atomic_load_n(&global_numSite, __ATOMIC_RELAXED) <
+             TMSTATS_MAX_SITE));
+}
+
+
+/* =============================================================================
+ * registerSite
+ * =============================================================================
+ */
+static long
+registerSite (tmstats_site_t* sitePtr)
+{
+    long id;
+
+    pthread_mutex_lock(&global_lock);
+    id = sitePtr->id;
+    if (id < 0 || isStaleOverflow(id)) {
+        id = global_numSite;
+        if (id < TMSTATS_MAX_SITE - 1) {
+            global_sites[id] = sitePtr;
+            global_numSite = id + 1;
+        } else {
+            /* Overflow shares the last slot, reported as other sites */
+            id = TMSTATS_MAX_SITE - 1;
+            global_sites[id] = NULL;
+            global_numSite = TMSTATS_MAX_SITE;
+        }
+        __atomic_store_n(&sitePtr->id, id, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&global_lock);
+
+    return id;
+}
+
+
+/* =============================================================================
+ * tmstats_reset
+ * =============================================================================
+ */
+void
+tmstats_reset ()
+{
+    long s;
+
+    pthread_mutex_lock(&global_lock);
+    for (s = 0; s < global_numSite; s++) {
+        if (global_sites[s] != NULL) {
+            global_sites[s]->id = -1;
+        }
+    }
+    global_numSite = 0;
+    memset(global_counts, 0, sizeof(global_counts));
+    pthread_mutex_unlock(&global_lock);
+}
+
+
+/* =============================================================================
+ * tmstats_newThread
+ * =============================================================================
+ */
+tmstats_thread_t*
+tmstats_newThread ()
+{
+    tmstats_thread_t* threadPtr =
+        (tmstats_thread_t*)calloc(1, sizeof(tmstats_thread_t));
+
+    if (threadPtr != NULL) {
+        threadPtr->siteId = -1;
+    }
+
+    return threadPtr;
+}
+
+
+/* =============================================================================
+ * tmstats_freeThread
+ * =============================================================================
+ */
+void
+tmstats_freeThread (tmstats_thread_t* threadPtr)
+{
+    long numSite;
+    long s;
+
+    pthread_mutex_lock(&global_lock);
+    numSite = global_numSite;
+    for (s = 0; s < numSite; s++) {
+        tmstats_count_t* srcPtr = &threadPtr->counts[s];
+        tmstats_count_t* dstPtr = &global_counts[s];
+        long b;
+        dstPtr->numCommit += srcPtr->numCommit;
+        dstPtr->numAbort  += srcPtr->numAbort;
+        dstPtr->totalTime += srcPtr->totalTime;
+        if (srcPtr->maxRetry > dstPtr->maxRetry) {
+            dstPtr->maxRetry = srcPtr->maxRetry;
+        }
+        for (b = 0; b < TMSTATS_NUM_RETRY_BUCKET; b++) {
+            dstPtr->retryHistogram[b] += srcPtr->retryHistogram[b];
+        }
+        for (b = 0; b < TMSTATS_NUM_TIME_BUCKET; b++) {
+            dstPtr->timeHistogram[b] += srcPtr->timeHistogram[b];
+        }
+    }
+    pthread_mutex_unlock(&global_lock);
+
+    free(threadPtr);
+}
+
+
+/* =============================================================================
+ * tmstats_begin
+ * =============================================================================
+ */
+void
+tmstats_begin (tmstats_thread_t* threadPtr, tmstats_site_t* sitePtr)
+{
+    long id = __atomic_load_n(&sitePtr->id, __ATOMIC_ACQUIRE);
+
+    if (id < 0 || isStaleOverflow(id)) {
+        id = registerSite(sitePtr);
+    }
+
+    if (threadPtr->numRetry == 0 || threadPtr->siteId != id) {
+        threadPtr->numRetry = 0;
+        threadPtr->startTime = getTime();
+    }
+    threadPtr->siteId = id;
+}
+
+
+/* =============================================================================
+ * tmstats_abort
+ * =============================================================================
+ */
+void
+tmstats_abort (tmstats_thread_t* threadPtr)
+{
+    threadPtr->counts[threadPtr->siteId].numAbort++;
+    threadPtr->numRetry++;
+}
+
+
+/* =============================================================================
+ * tmstats_commit
+ * =============================================================================
+ */
+void
+tmstats_commit (tmstats_thread_t* threadPtr)
+{
+    tmstats_count_t* countPtr = &threadPtr->counts[threadPtr->siteId];
+    unsigned long numRetry = threadPtr->numRetry;
+    unsigned long elapsed = getTime() - threadPtr->startTime;
+
+    countPtr->numCommit++;
+    countPtr->totalTime += elapsed;
+    if (numRetry > countPtr->maxRetry) {
+        countPtr->maxRetry = numRetry;
+    }
+    countPtr->retryHistogram[getBucket(numRetry, TMSTATS_NUM_RETRY_BUCKET)]++;
+    countPtr->timeHistogram[getBucket(elapsed / 1000, TMSTATS_NUM_TIME_BUCKET)]++;
+
+    threadPtr->numRetry = 0;
+}
+
+
+/* =============================================================================
+ * tmstats_getTotals
+ * =============================================================================
+ */
+void
+tmstats_getTotals (unsigned long* numCommitPtr, unsigned long* numAbortPtr)
+{
+    unsigned long numCommit = 0;
+    unsigned long numAbort = 0;
+    long s;
+
+    pthread_mutex_lock(&global_lock);
+    for (s = 0; s < global_numSite; s++) {
+        numCommit += global_counts[s].numCommit;
+        numAbort  += global_counts[s].numAbort;
+    }
+    pthread_mutex_unlock(&global_lock);
+
+    *numCommitPtr = numCommit;
+    *numAbortPtr = numAbort;
+}
+
+
+/* =============================================================================
+ * printHistogram
+ * -- Bucket b > 0 covers [2^(b-1), 2^b)
+ * =============================================================================
+ */
+static void
+printHistogram (FILE* stream, const char* label,
+                unsigned long* histogram, long numBucket)
+{
+    long b;
+
+    fprintf(stream, "    %-10s", label);
+    for (b = 0; b < numBucket; b++) {
+        if (histogram[b] == 0) {
+            continue;
+        }
+        if (b == 0) {
+            fprintf(stream, " 0:%lu", histogram[b]);
+        } else if (b == 1) {
+            fprintf(stream, " 1:%lu", histogram[b]);
+        } else {
+            fprintf(stream, " %lu-%lu:%lu",
+                    1UL << (b - 1), (1UL << b) - 1, histogram[b]);
+        }
+    }
+    fputc('\n', stream);
+}
+
+
+/* =============================================================================
+ * compareByAborts
+ * =============================================================================
+ */
+static int
+compareByAborts (const void* aPtr, const void* bPtr)
+{
+    long a = *(const long*)aPtr;
+    long b = *(const long*)bPtr;
+    unsigned long abortA = global_counts[a].numAbort;
+    unsigned long abortB = global_counts[b].numAbort;
+
+    if (abortA != abortB) {
+        return ((abortA > abortB) ? -1 : 1);
+    }
+
+    return ((a < b) ? -1 : ((a > b) ? 1 : 0));
+}
+
+
+/* =============================================================================
+ * tmstats_print
+ * =============================================================================
+ */
+void
+tmstats_print (FILE* stream)
+{
+    long order[TMSTATS_MAX_SITE];
+    long numSite;
+    long s;
+
+    pthread_mutex_lock(&global_lock);
+
+    numSite = global_numSite;
+    for (s = 0; s < numSite; s++) {
+        order[s] = s;
+    }
+    qsort(order, numSite, sizeof(long), &compareByAborts);
+
+    fprintf(stream, "Transaction sites:\n");
+    fprintf(stream, "    %-28s %12s %12s %8s %8s %12s\n",
+            "site", "commits", "aborts", "abort%", "maxRetry", "meanTime(us)");
+    for (s = 0; s < numSite; s++) {
+        long id = order[s];
+        tmstats_count_t* countPtr = &global_counts[id];
+        unsigned long numAttempt = countPtr->numCommit + countPtr->numAbort;
+        char name[64];
+        if (global_sites[id] != NULL) {
+            snprintf(name, sizeof(name), "%s:%li",
+                     global_sites[id]->file, global_sites[id]->line);
+        } else {
+            snprintf(name, sizeof(name), "(other sites)");
+        }
+        fprintf(stream, "  %-30s %12lu %12lu %7.2f%% %8lu %12.3f\n",
+                name,
+                countPtr->numCommit,
+                countPtr->numAbort,
+                ((numAttempt > 0) ?
+                 (100.0 * countPtr->numAbort / numAttempt) : 0.0),
+                countPtr->maxRetry,
+                ((countPtr->numCommit > 0) ?
+                 (countPtr->totalTime / 1000.0 / countPtr->numCommit) : 0.0));
+        printHistogram(stream, "retries",
+                       countPtr->retryHistogram, TMSTATS_NUM_RETRY_BUCKET);
+        printHistogram(stream, "time(us)",
+                       countPtr->timeHistogram, TMSTATS_NUM_TIME_BUCKET);
+    }
+
+    pthread_mutex_unlock(&global_lock);
+
+    fflush(stream);
+}
+
+
+/* =============================================================================
+ *
+ * End of tmstats.c
+ *
+ * =============================================================================
+ */
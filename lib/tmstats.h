@@ -0,0 +1,194 @@
+/* =============================================================================
+ *
+ * tmstats.h
+ * -- Per-site transaction statistics
+ *
+ * =============================================================================
+ *
+ * Copyright (C) Stanford University, 2006.  All Rights Reserved.
+ * Author: Chi Cao Minh
+ *
+ * =============================================================================
+ *
+ * For the license of bayes/sort.h and bayes/sort.c, please see the header
+ * of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of kmeans, please see kmeans/LICENSE.kmeans
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of ssca2, please see ssca2/COPYRIGHT
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/mt19937ar.c and lib/mt19937ar.h, please see the
+ * header of the files.
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * For the license of lib/rbtree.h and lib/rbtree.c, please see
+ * lib/LEGALNOTICE.rbtree and lib/LICENSE.rbtree
+ * 
+ * ------------------------------------------------------------------------
+ * 
+ * Unless otherwise noted, the following license applies to STAMP files:
+ * 
+ * Copyright (c) 2007, Stanford University
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ * 
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ * 
+ *     * Neither the name of Stanford University nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY STANFORD UNIVERSITY ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL STANFORD UNIVERSITY BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * =============================================================================
+ */
+
+
+#ifndef TMSTATS_H
+#define TMSTATS_H 1
+
+
+#include <stdio.h>
+#include "types.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* =============================================================================
+ * Every TM_BEGIN owns a static tmstats_site_t tagged with its file and line.
+ * The runtime reports, per site, commits, aborts, retries before commit, and
+ * a histogram of the time from first attempt to commit. Sites past the first
+ * TMSTATS_MAX_SITE - 1 share one slot, reported as "(other sites)".
+ * =============================================================================
+ */
+
+enum tmstats_config {
+    TMSTATS_MAX_SITE         = 256,
+    TMSTATS_NUM_RETRY_BUCKET = 16, /* 0, 1, 2-3, 4-7, ... */
+    TMSTATS_NUM_TIME_BUCKET  = 32, /* <1, 1-2, 2-4, ... microseconds */
+};
+
+typedef struct tmstats_site {
+    const char* file;
+    long line;
+    volatile long id; /* -1 until first executed */
+} tmstats_site_t;
+
+#define TMSTATS_SITE_INIT               { __FILE__, __LINE__, -1 }
+
+typedef struct tmstats_thread tmstats_thread_t;
+
+
+/* =============================================================================
+ * tmstats_reset
+ * -- Forget all sites and counts; call from TM_STARTUP
+ * =============================================================================
+ */
+void
+tmstats_reset ();
+
+
+/* =============================================================================
+ * tmstats_newThread
+ * -- Returns NULL on failure
+ * =============================================================================
+ */
+tmstats_thread_t*
+tmstats_newThread ();
+
+
+/* =============================================================================
+ * tmstats_freeThread
+ * -- Merges the thread's counts into the global totals
+ * =============================================================================
+ */
+void
+tmstats_freeThread (tmstats_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * tmstats_begin
+ * -- Call at the start of every attempt, including retries
+ * =============================================================================
+ */
+void
+tmstats_begin (tmstats_thread_t* threadPtr, tmstats_site_t* sitePtr);
+
+
+/* =============================================================================
+ * tmstats_abort
+ * =============================================================================
+ */
+void
+tmstats_abort (tmstats_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * tmstats_commit
+ * =============================================================================
+ */
+void
+tmstats_commit (tmstats_thread_t* threadPtr);
+
+
+/* =============================================================================
+ * tmstats_getTotals
+ * -- Sums over all sites of threads that have been freed
+ * =============================================================================
+ */
+void
+tmstats_getTotals (unsigned long* numCommitPtr, unsigned long* numAbortPtr);
+
+
+/* =============================================================================
+ * tmstats_print
+ * -- Prints one block per site, ordered by number of aborts
+ * =============================================================================
+ */
+void
+tmstats_print (FILE* stream);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* TMSTATS_H */
+
+
+/* =============================================================================
+ *
+ * End of tmstats.h
+ *
+ * =============================================================================
+ */
@@ -71,6 +71,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include "memory.h"
 #include "tm.h"
 #include "types.h"
 #include "utility.h"
@@ -95,6 +96,7 @@ vector_alloc (long initCapacity)
         vectorPtr->capacity = capacity;
         vectorPtr->elements = (void**)malloc(capacity * sizeof(void*));
         if (vectorPtr->elements == NULL) {
+            free(vectorPtr);
             return NULL;
         }
     }
@@ -121,6 +123,34 @@ Pvector_alloc (long initCapacity)
         vectorPtr->capacity = capacity;
         vectorPtr->elements = (void**)P_MALLOC(capacity * sizeof(void*));
         if (vectorPtr->elements == NULL) {
+            P_FREE(vectorPtr);
+            return NULL;
+        }
+    }
+
+    return vectorPtr;
+}
+
+
+/* =============================================================================
+ * TMvector_alloc
+ * -- Returns NULL if failed
+ * =============================================================================
+ */
+vector_t*
+TMvector_alloc (TM_ARGDECL  long initCapacity)
+{
+    vector_t* vectorPtr;
+    long capacity = MAX(initCapacity, 1);
+
+    vectorPtr = (vector_t*)TM_MALLOC(sizeof(vector_t));
+
+    if (vectorPtr != NULL) {
+        vectorPtr->size = 0;
+        vectorPtr->capacity = capacity;
+        vectorPtr->elements = (void**)TM_MALLOC(capacity * sizeof(void*));
+        if (vectorPtr->elements == NULL) {
+            TM_FREE(vectorPtr);
             return NULL;
         }
     }
@@ -136,8 +166,8 @@ Pvector_alloc (long initCapacity)
 void
 vector_free (vector_t* vectorPtr)
 {
-    free(vectorPtr->elements);
-    free(vectorPtr);
+    memory_free(vectorPtr->elements);
+    memory_free(vectorPtr);
 }
 
 
@@ -153,6 +183,18 @@ Pvector_free (vector_t* vectorPtr)
 }
 
 
+/* =============================================================================
+ * TMvector_free
+ * =============================================================================
+ */
+void
+TMvector_free (TM_ARGDECL  vector_t* vectorPtr)
+{
+    TM_FREE(vectorPtr->elements);
+    TM_FREE(vectorPtr);
+}
+
+
 /* =============================================================================
  * vector_at
  * -- Returns NULL if failed
@@ -188,7 +230,7 @@ vector_pushBack (vector_t* vectorPtr, void* dataPtr)
         for (i = 0; i < vectorPtr->size; i++) {
             newElements[i] = vectorPtr->elements[i];
         }
-        free(vectorPtr->elements);
+        memory_free(vectorPtr->elements);
         vectorPtr->elements = newElements;
     }
 
@@ -227,6 +269,36 @@ Pvector_pushBack (vector_t* vectorPtr, void* dataPtr)
 }
 
 
+/* =============================================================================
+ * TMvector_pushBack
+ * -- Returns FALSE if fail, else TRUE
+ * -- Vector must be private to the transaction (e.g., from TMvector_alloc)
+ * =============================================================================
+ */
+bool_t
+TMvector_pushBack (TM_ARGDECL  vector_t* vectorPtr, void* dataPtr)
+{
+    if (vectorPtr->size == vectorPtr->capacity) {
+        long i;
+        long newCapacity = vectorPtr->capacity * 2;
+        void** newElements = (void**)TM_MALLOC(newCapacity * sizeof(void*));
+        if (newElements == NULL) {
+            return FALSE;
+        }
+        vectorPtr->capacity = newCapacity;
+        for (i = 0; i < vectorPtr->size; i++) {
+            newElements[i] = vectorPtr->elements[i];
+        }
+        TM_FREE(vectorPtr->elements);
+        vectorPtr->elements = newElements;
+    }
+
+    vectorPtr->elements[vectorPtr->size++] = dataPtr;
+
+    return TRUE;
+}
+
+
 /* =============================================================================
  * vector_popBack
  * Returns NULL if fail, else returns last element
@@ -291,7 +363,7 @@ vector_copy (vector_t* dstVectorPtr, vector_t* srcVectorPtr)
         if (elements == NULL) {
             return FALSE;
         }
-        free(dstVectorPtr->elements);
+        memory_free(dstVectorPtr->elements);
         dstVectorPtr->elements = elements;
         dstVectorPtr->capacity = srcCapacity;
     }
@@ -107,6 +107,16 @@ vector_t*
 Pvector_alloc (long initCapacity);
 
 
+/* =============================================================================
+ * TMvector_alloc
+ * -- Returns NULL if failed
+ * -- Freed automatically if the enclosing transaction aborts
+ * =============================================================================
+ */
+vector_t*
+TMvector_alloc (TM_ARGDECL  long initCapacity);
+
+
 /* =============================================================================
  * vector_free
  * =============================================================================
@@ -123,6 +133,14 @@ void
 Pvector_free (vector_t* vectorPtr);
 
 
+/* =============================================================================
+ * TMvector_free
+ * =============================================================================
+ */
+void
+TMvector_free (TM_ARGDECL  vector_t* vectorPtr);
+
+
 /* =============================================================================
  * vector_at
  * -- Returns NULL if failed
@@ -150,6 +168,16 @@ bool_t
 Pvector_pushBack (vector_t* vectorPtr, void* dataPtr);
 
 
+/* =============================================================================
+ * TMvector_pushBack
+ * -- Returns FALSE if fail, else TRUE
+ * -- Vector must be private to the transaction (e.g., from TMvector_alloc)
+ * =============================================================================
+ */
+bool_t
+TMvector_pushBack (TM_ARGDECL  vector_t* vectorPtr, void* dataPtr);
+
+
 /* =============================================================================
  * vector_popBack
  * -- Returns NULL if fail, else returns last element
@@ -209,6 +237,10 @@ Pvector_copy (vector_t* dstVectorPtr, vector_t* srcVectorPtr);
 #define PVECTOR_SORT(v, cmp)        vector_sort(v, cmp)
 #define PVECTOR_COPY(dst, src)      Pvector_copy(dst, src)
 
+#define TMVECTOR_ALLOC(n)           TMvector_alloc(TM_ARG  n)
+#define TMVECTOR_FREE(v)            TMvector_free(TM_ARG  v)
+#define TMVECTOR_PUSHBACK(v, data)  TMvector_pushBack(TM_ARG  v, data)
+
 
 #ifdef __cplusplus
 }
@@ -19,8 +19,11 @@ SRCS += \
 	globals.c \
 	ssca2.c \
 	$(LIB)/mt19937ar.c \
+	$(LIB)/perfctr.c \
 	$(LIB)/random.c \
+	$(LIB)/report.c \
 	$(LIB)/thread.c \
+	$(LIB)/timer.c \
 #
 OBJS := ${SRCS:.c=.o}
 
@@ -75,6 +75,7 @@
 #include "getStartLists.h"
 #include "getUserParameters.h"
 #include "globals.h"
+#include "report.h"
 #include "timer.h"
 #include "thread.h"
 #include "tm.h"
@@ -142,6 +143,7 @@ MAIN(argc, argv)
     getUserParameters(argc, (char** const) argv);
 
     SIM_GET_NUM_CPU(THREADS);
+    report_startup("ssca2", argc, (char**)argv);
     TM_STARTUP(THREADS);
     P_MEMORY_STARTUP(THREADS);
     thread_startup(THREADS);
@@ -156,6 +158,14 @@ MAIN(argc, argv)
     printf("Subgraph edge length:       %ld\n", SUBGR_EDGE_LENGTH);
     printf("Kernel 3 data structure:    %ld\n", K3_DS);
     puts("");
+    report_addParam("threads", THREADS);
+    report_addParam("scale", SCALE);
+    report_addParam("max_parallel_edges", MAX_PARAL_EDGES);
+    report_addParam("percent_int_weights", PERC_INT_WEIGHTS);
+    report_addParam("prob_unidirectional", PROB_UNIDIRECTIONAL);
+    report_addParam("prob_inter_clique", PROB_INTERCL_EDGES);
+    report_addParam("subgraph_edge_length", SUBGR_EDGE_LENGTH);
+    report_addParam("kernel3_data_structure", K3_DS);
 
     /*
      * Scalable Data Generator
@@ -191,6 +201,7 @@ MAIN(argc, argv)
     totalTime += time;
 
     printf("\nTime taken for Scalable Data Generation is %9.6f sec.\n\n", time);
+    report_addTime("generation", time);
     printf("\n\tgenScalData() completed execution.\n");
 
 
@@ -232,6 +243,7 @@ MAIN(argc, argv)
 
     printf("\n\tcomputeGraph() completed execution.\n");
     printf("\nTime taken for kernel 1 is %9.6f sec.\n", time);
+    report_addTime("kernel 1", time);
 
 #endif /* ENABLE_KERNEL1 */
 
@@ -278,6 +290,7 @@ MAIN(argc, argv)
 
     printf("\n\tgetStartLists() completed execution.\n");
     printf("\nTime taken for kernel 2 is %9.6f sec.\n\n", time);
+    report_addTime("kernel 2", time);
 
 #endif /* ENABLE_KERNEL2 */
 
@@ -451,6 +464,7 @@ MAIN(argc, argv)
 
     printf("\n\tfindSubGraphs() completed execution.\n");
     printf("\nTime taken for kernel 3 is %9.6f sec.\n\n", time);
+    report_addTime("kernel 3", time);
 
 #endif /* ENABLE_KERNEL3 */
 
@@ -483,10 +497,13 @@ MAIN(argc, argv)
 
     printf("\n\tcutClusters() completed execution.\n");
     printf("\nTime taken for Kernel 4 is %9.6f sec.\n\n", time);
+    report_addTime("kernel 4", time);
 
 #endif /* ENABLE_KERNEL4 */
 
     printf("\nTime taken for all is %9.6f sec.\n\n", totalTime);
+    report_addTime("total", totalTime);
+    report_setThroughput("edges", SDGdata->numEdgesPlaced, totalTime);
 
     /* -------------------------------------------------------------------------
      * Cleanup
@@ -566,6 +583,7 @@ MAIN(argc, argv)
 
     TM_SHUTDOWN();
     P_MEMORY_SHUTDOWN();
+    report_write(); /* ssca2 has no verification */
 
     GOTO_SIM();
 
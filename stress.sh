@@ -0,0 +1,146 @@
+#!/bin/bash
+# ==============================================================================
+#
+# stress.sh
+#
+# ==============================================================================
+#
+# Builds one parallel flavor of some benchmarks and runs each many times with
+# parameters that make transactions conflict often, counting the runs that
+# crash, fail an assertion, or exit with an error. Failures that show up in a
+# few percent of runs (e.g., a rollback that misses some state) are invisible
+# to a single run or to a short sweep.
+#
+# Usage: ./stress.sh [options]
+#
+#   -f flavor   Makefile flavor: stm, lock, lock-striped, ... (default: stm)
+#   -a apps     Space-separated list of apps (default: "intruder vacation yada")
+#   -t threads  Thread count (default: 8)
+#   -r runs     Runs per app (default: 50)
+#   -T seconds  Time limit per run (default: 120)
+#
+# Logs of failed runs are kept in a work directory (STRESS_WORK, default:
+# /tmp/stamp-stress-$USER). The exit status is 1 if any run failed.
+#
+# ==============================================================================
+
+
+set -u
+
+ROOT=$(cd "$(dirname "$0")" && pwd)
+
+FLAVOR=stm
+APPS="intruder vacation yada"
+NUM_THREAD=8
+NUM_RUN=50
+TIME_LIMIT=120
+WORK=${STRESS_WORK:-/tmp/stamp-stress-${USER:-$(id -u)}}
+
+
+# Prints the arguments of app (without the thread count)
+get_params () {
+    case "$1" in
+        bayes)     echo "-v32 -r1024 -n2 -p20 -s0 -i2 -e2" ;;
+        genome)    echo "-g256 -s16 -n16384" ;;
+        intruder)  echo "-a10 -l16 -n4096 -s1" ;;
+        kmeans)    echo "-m15 -n15 -t0.05 -i inputs/random-n2048-d16-c16.txt" ;;
+        labyrinth) echo "-i inputs/random-x32-y32-z3-n96.txt" ;;
+        ssca2)     echo "-s13 -i1.0 -u1.0 -l3 -p3" ;;
+        vacation)  echo "-n4 -q60 -u90 -r16384 -t16384" ;;
+        yada)      echo "-a15 -i inputs/ttimeu10000.2" ;;
+        *)         return 1 ;;
+    esac
+}
+
+# kmeans takes -p and vacation -c (its -t is the number of tasks)
+get_thread_option () {
+    case "$1" in
+        kmeans)   echo "-p" ;;
+        vacation) echo "-c" ;;
+        *)        echo "-t" ;;
+    esac
+}
+
+die () {
+    echo "stress.sh: $*" >&2
+    exit 1
+}
+
+
+# ==============================================================================
+# Main
+# ==============================================================================
+
+while getopts "f:a:t:r:T:" opt; do
+    case $opt in
+        f) FLAVOR=$OPTARG ;;
+        a) APPS=$OPTARG ;;
+        t) NUM_THREAD=$OPTARG ;;
+        r) NUM_RUN=$OPTARG ;;
+        T) TIME_LIMIT=$OPTARG ;;
+        *) sed -n '/^# Usage/,/^# =/p' "$0" | sed '$d; s/^# \{0,1\}//' >&2
+           exit 1 ;;
+    esac
+done
+
+mkdir -p "$WORK" || die "cannot create $WORK"
+status=0
+
+for app in $APPS; do
+    params=$(get_params "$app") || die "unknown app $app"
+    makefile=Makefile.${FLAVOR%%-*}
+    mode=
+    case "$FLAVOR" in
+        *-*) mode="LOCK_MODE=${FLAVOR#*-}" ;;
+    esac
+    [ -f "$ROOT/$app/$makefile" ] || die "$app has no $makefile"
+
+    # Objects in lib/ are shared by all flavors, so always start clean
+    if ! { make -C "$ROOT/$app" -f $makefile clean &&
+           make -C "$ROOT/$app" -f $makefile $mode; } > "$WORK/build-$app.log" 2>&1
+    then
+        die "build of $app ($FLAVOR) failed; see $WORK/build-$app.log"
+    fi
+    cp "$ROOT/$app/$app" "$WORK/$app.$FLAVOR"
+    make -C "$ROOT/$app" -f $makefile clean > /dev/null 2>&1
+
+    # yada names a prefix of .node/.ele/.poly files
+    for word in $params; do
+        case "$word" in
+            inputs/*) ;;
+            *) continue ;;
+        esac
+        for path in "$word" "$word.node" "$word.ele" "$word.poly"; do
+            file=$ROOT/$app/$path
+            if [ ! -f "$file" ] && [ -f "$file.gz" ]; then
+                gunzip -c "$file.gz" > "$file"
+            fi
+        done
+    done
+
+    numFailed=0
+    for ((r = 1; r <= NUM_RUN; r++)); do
+        log=$WORK/run-$app-$FLAVOR-t$NUM_THREAD-$r.log
+        if (cd "$ROOT/$app" &&
+            timeout "$TIME_LIMIT" "$WORK/$app.$FLAVOR" $params \
+                "$(get_thread_option "$app")$NUM_THREAD") > "$log" 2>&1
+        then
+            rm -f "$log"
+        else
+            numFailed=$((numFailed + 1))
+            echo "Run $r of $app failed; see $log" >&2
+        fi
+    done
+
+    echo "$app ($FLAVOR, $NUM_THREAD threads): $numFailed of $NUM_RUN runs failed"
+    [ $numFailed -eq 0 ] || status=1
+done
+
+exit $status
+
+
+# ==============================================================================
+#
+# End of stress.sh
+#
+# ==============================================================================
@@ -0,0 +1,346 @@
+#!/bin/bash
+# ==============================================================================
+#
+# sweep.sh
+#
+# ==============================================================================
+#
+# Builds one flavor of every benchmark (plus the sequential baseline), runs
+# each with the parameters recommended in its README over a range of thread
+# counts, and writes one table with the median and standard deviation of the
+# reported time and the speedup over the sequential build.
+#
+# Usage: ./sweep.sh [options]
+#
+#   -f flavor   Makefile flavor to sweep: stm, lock, lock-striped, htm, ...
+#               (default: stm)
+#   -a apps     Space-separated list of apps; kmeans and vacation may be
+#               suffixed with -low or -high (default: all, both contentions)
+#   -s sets     Parameter sets: sim, nonsim, or "sim nonsim" (default: sim)
+#   -t threads  Space-separated thread counts (default: "1 2 4 8")
+#   -r trials   Runs per configuration (default: 3)
+#   -T seconds  Time limit per run; 0 for none (default: 0)
+#   -o file     CSV output (default: sweep.csv)
+#   -j file     JSON output (default: sweep.json)
+#   -k          Keep going: skip the rest of a configuration that fails and
+#               report it with no time; without -k, a failed run stops the sweep
+#   -n          Print the commands instead of running them
+#
+# The seq baseline always runs with one thread. Binaries and logs go to a
+# work directory (SWEEP_WORK, default: /tmp/stamp-sweep-$USER); compressed
+# inputs are unpacked next to the originals.
+#
+# ==============================================================================
+
+
+set -u
+
+ROOT=$(cd "$(dirname "$0")" && pwd)
+
+FLAVOR=stm
+APPS="bayes genome intruder kmeans-low kmeans-high labyrinth ssca2 \
+vacation-low vacation-high yada"
+SETS=sim
+THREADS="1 2 4 8"
+NUM_TRIAL=3
+TIME_LIMIT=0
+CSV=sweep.csv
+JSON=sweep.json
+KEEP_GOING=0
+DRY_RUN=0
+WORK=${SWEEP_WORK:-/tmp/stamp-sweep-${USER:-$(id -u)}}
+
+
+# ==============================================================================
+# Parameters from each application's README
+# ==============================================================================
+
+# Prints the arguments of app (without the thread count) for a parameter set.
+# Inputs that do not ship with STAMP are replaced by the largest one that does.
+get_params () {
+    case "$1/$2" in
+        bayes/sim)            echo "-v32 -r1024 -n2 -p20 -s0 -i2 -e2" ;;
+        bayes/nonsim)         echo "-v32 -r4096 -n10 -p40 -i2 -e8 -s1" ;;
+        genome/sim)           echo "-g256 -s16 -n16384" ;;
+        genome/nonsim)        echo "-g16384 -s64 -n16777216" ;;
+        intruder/sim)         echo "-a10 -l4 -n2038 -s1" ;;
+        intruder/nonsim)      echo "-a10 -l128 -n262144 -s1" ;;
+        kmeans-low/sim)       echo "-m40 -n40 -t0.05 -i inputs/random-n2048-d16-c16.txt" ;;
+        kmeans-high/sim)      echo "-m15 -n15 -t0.05 -i inputs/random-n2048-d16-c16.txt" ;;
+        kmeans-low/nonsim)    echo "-m40 -n40 -t0.00001 -i inputs/random-n16384-d24-c16.txt" ;;
+        kmeans-high/nonsim)   echo "-m15 -n15 -t0.00001 -i inputs/random-n16384-d24-c16.txt" ;;
+        labyrinth/sim)        echo "-i inputs/random-x32-y32-z3-n96.txt" ;;
+        labyrinth/nonsim)     echo "-i inputs/random-x512-y512-z7-n512.txt" ;;
+        ssca2/sim)            echo "-s13 -i1.0 -u1.0 -l3 -p3" ;;
+        ssca2/nonsim)         echo "-s20 -i1.0 -u1.0 -l3 -p3" ;;
+        vacation-low/sim)     echo "-n2 -q90 -u98 -r16384 -t4096" ;;
+        vacation-high/sim)    echo "-n4 -q60 -u90 -r16384 -t4096" ;;
+        vacation-low/nonsim)  echo "-n2 -q90 -u98 -r1048576 -t4194304" ;;
+        vacation-high/nonsim) echo "-n4 -q60 -u90 -r1048576 -t4194304" ;;
+        yada/sim)             echo "-a20 -i inputs/633.2" ;;
+        yada/nonsim)          echo "-a15 -i inputs/ttimeu100000.2" ;;
+        *)                    return 1 ;;
+    esac
+}
+
+# kmeans takes -p and vacation -c (its -t is the number of tasks)
+get_thread_option () {
+    case "$1" in
+        kmeans)   echo "-p" ;;
+        vacation) echo "-c" ;;
+        *)        echo "-t" ;;
+    esac
+}
+
+# Entry of "times_s" in the REPORT_JSON output that holds the measured time
+get_time_name () {
+    case "$1" in
+        bayes) echo "learn" ;;
+        *)     echo "total" ;;
+    esac
+}
+
+
+# ==============================================================================
+# Helpers
+# ==============================================================================
+
+die () {
+    echo "sweep.sh: $*" >&2
+    exit 1
+}
+
+run () {
+    if [ $DRY_RUN -eq 1 ]; then
+        echo "$*"
+        return 0
+    fi
+    "$@"
+}
+
+# build <app> <flavor>: leaves the binary at $WORK/bin/<app>.<flavor>
+build () {
+    local app=$1
+    local flavor=$2
+    local makefile=Makefile.${flavor%%-*}
+    local mode=
+    local log=$WORK/log/build-$app-$flavor.log
+
+    case "$flavor" in
+        *-*) mode="LOCK_MODE=${flavor#*-}" ;;
+    esac
+
+    [ -f "$ROOT/$app/$makefile" ] || die "$app has no $makefile"
+
+    # Objects in lib/ are shared by all flavors, so always start clean
+    if [ $DRY_RUN -eq 1 ]; then
+        echo "make -C $ROOT/$app -f $makefile clean && make -C $ROOT/$app -f $makefile $mode"
+        return 0
+    fi
+    if ! { make -C "$ROOT/$app" -f $makefile clean &&
+           make -C "$ROOT/$app" -f $makefile $mode; } > "$log" 2>&1
+    then
+        echo "Build of $app ($flavor) failed; see $log" >&2
+        return 1
+    fi
+    cp "$ROOT/$app/$app" "$WORK/bin/$app.$flavor"
+    make -C "$ROOT/$app" -f $makefile clean > /dev/null 2>&1
+}
+
+# Decompresses the inputs named in the arguments, if needed
+prepare_inputs () {
+    local app=$1
+    local params=$2
+    local word
+    local path
+    local file
+
+    for word in $params; do
+        case "$word" in
+            inputs/*) ;;
+            *) continue ;;
+        esac
+        # yada names a prefix of .node/.ele/.poly files
+        for path in "$word" "$word.node" "$word.ele" "$word.poly"; do
+            file=$ROOT/$app/$path
+            if [ ! -f "$file" ] && [ -f "$file.gz" ]; then
+                run sh -c "gunzip -c '$file.gz' > '$file'"
+            fi
+        done
+    done
+}
+
+# time_of <app> <json>: prints the reported time in seconds
+time_of () {
+    awk -v name="\"$(get_time_name "$1")\":" '
+        /^  "times_s": / { inTimes = 1; next }
+        inTimes && /^  }/ { exit }
+        inTimes && $1 == name { sub(/,$/, "", $2); print $2; exit }
+    ' "$2"
+}
+
+# Prints "median stddev" of the numbers on stdin
+summarize () {
+    sort -g | awk '
+        { x[NR] = $1; sum += $1 }
+        END {
+            if (NR == 0) { print "nan nan"; exit }
+            mean = sum / NR
+            for (i = 1; i <= NR; i++) { ss += (x[i] - mean) ^ 2 }
+            median = (NR % 2) ? x[(NR + 1) / 2] : (x[NR / 2] + x[NR / 2 + 1]) / 2
+            printf "%.6f %.6f\n", median, ((NR > 1) ? sqrt(ss / (NR - 1)) : 0)
+        }'
+}
+
+# measure <app> <variant> <set> <flavor> <threads>: sets MEDIAN, STDDEV, and
+# NUM_FAILED. Runs in the current shell, so that a failed run stops the sweep.
+# With -k, the first failed run ends the configuration; its median and stddev
+# are nan and NUM_FAILED counts the trials that reported no time, so that a
+# partial set of trials is never summarized.
+measure () {
+    local app=$1
+    local variant=$2
+    local set=$3
+    local flavor=$4
+    local numThread=$5
+    local params
+    local log
+    local t
+    local json
+    local time
+    local times=
+    local limit=
+
+    MEDIAN=nan
+    STDDEV=nan
+    NUM_FAILED=0
+    params=$(get_params "$variant" "$set")
+    [ "$TIME_LIMIT" != 0 ] && limit="timeout $TIME_LIMIT"
+
+    for ((t = 1; t <= NUM_TRIAL; t++)); do
+        log=$WORK/log/run-$variant-$set-$flavor-t$numThread-$t.log
+        json=${log%.log}.json
+        if [ $DRY_RUN -eq 1 ]; then
+            echo "(cd $ROOT/$app && $limit $WORK/bin/$app.$flavor $params" \
+                 "$(get_thread_option "$app")$numThread)" >&2
+            continue
+        fi
+        if ! (cd "$ROOT/$app" &&
+              REPORT_JSON=$json $limit "$WORK/bin/$app.$flavor" $params \
+                  "$(get_thread_option "$app")$numThread") > "$log" 2>&1
+        then
+            time=
+        else
+            time=$(time_of "$app" "$json" 2> /dev/null)
+        fi
+        if [ -z "$time" ]; then
+            echo "Run failed: $variant/$set $flavor t=$numThread; see $log" >&2
+            [ $KEEP_GOING -eq 1 ] || exit 1
+            NUM_FAILED=$((NUM_TRIAL - t + 1))
+            return 1
+        fi
+        times="$times $time"
+    done
+
+    [ $DRY_RUN -eq 1 ] && return 0
+    read -r MEDIAN STDDEV < <(printf '%s\n' $times | summarize)
+}
+
+
+# ==============================================================================
+# Main
+# ==============================================================================
+
+while getopts "f:a:s:t:r:T:o:j:kn" opt; do
+    case $opt in
+        f) FLAVOR=$OPTARG ;;
+        a) APPS=$OPTARG ;;
+        s) SETS=$OPTARG ;;
+        t) THREADS=$OPTARG ;;
+        r) NUM_TRIAL=$OPTARG ;;
+        T) TIME_LIMIT=$OPTARG ;;
+        o) CSV=$OPTARG ;;
+        j) JSON=$OPTARG ;;
+        k) KEEP_GOING=1 ;;
+        n) DRY_RUN=1 ;;
+        *) sed -n '/^# Usage/,/^# =/p' "$0" | sed '$d; s/^# \{0,1\}//' >&2
+           exit 1 ;;
+    esac
+done
+
+[ "$FLAVOR" != seq ] || die "sweep a parallel flavor; seq is the baseline"
+mkdir -p "$WORK/bin" "$WORK/log" || die "cannot create $WORK"
+
+# Expand "kmeans" and "vacation" into both contention levels
+VARIANTS=
+for a in $APPS; do
+    case "$a" in
+        kmeans|vacation) VARIANTS="$VARIANTS $a-low $a-high" ;;
+        *)               VARIANTS="$VARIANTS $a" ;;
+    esac
+done
+
+BUILT=
+for variant in $VARIANTS; do
+    app=${variant%%-*}
+    get_params "$variant" sim > /dev/null || die "unknown app $variant"
+    case " $BUILT " in
+        *" $app "*) continue ;;
+    esac
+    echo "Building $app (seq, $FLAVOR)..." >&2
+    build "$app" seq && build "$app" "$FLAVOR" || exit 1
+    BUILT="$BUILT $app"
+done
+
+echo "flavor,app,set,params,threads,trials,failed,median_s,stddev_s,speedup" > "$CSV"
+echo "[" > "$JSON"
+isFirst=1
+
+for set in $SETS; do
+    for variant in $VARIANTS; do
+        app=${variant%%-*}
+        params=$(get_params "$variant" "$set") || die "unknown set $set"
+        prepare_inputs "$app" "$params"
+
+        echo "Running $variant/$set..." >&2
+        measure "$app" "$variant" "$set" seq 1
+        seqMedian=$MEDIAN
+        rows="seq 1 $NUM_FAILED $MEDIAN $STDDEV"
+
+        for numThread in $THREADS; do
+            measure "$app" "$variant" "$set" "$FLAVOR" "$numThread"
+            rows="$rows $FLAVOR $numThread $NUM_FAILED $MEDIAN $STDDEV"
+        done
+
+        set -- $rows
+        while [ $# -ge 5 ]; do
+            speedup=$(awk -v s="$seqMedian" -v p="$4" 'BEGIN {
+                if (s == "nan" || p == "nan" || p + 0 == 0) print "nan";
+                else printf "%.3f\n", s / p }')
+            echo "$1,$variant,$set,\"$params\",$2,$NUM_TRIAL,$3,$4,$5,$speedup" \
+                >> "$CSV"
+            [ $isFirst -eq 1 ] || echo "," >> "$JSON"
+            isFirst=0
+            printf '  {"flavor": "%s", "app": "%s", "set": "%s", "params": "%s",'\
+' "threads": %s, "trials": %s, "failed": %s, "median_s": %s,'\
+' "stddev_s": %s, "speedup": %s}' "$1" "$variant" "$set" "$params" "$2" \
+                "$NUM_TRIAL" "$3" \
+                "$(echo "$4" | sed 's/^nan$/null/')" \
+                "$(echo "$5" | sed 's/^nan$/null/')" \
+                "$(echo "$speedup" | sed 's/^nan$/null/')" >> "$JSON"
+            shift 5
+        done
+    done
+done
+
+printf "\n]\n" >> "$JSON"
+
+column -s, -t < "$CSV" 2> /dev/null || cat "$CSV"
+echo "Wrote $CSV and $JSON" >&2
+
+
+# ==============================================================================
+#
+# End of sweep.sh
+#
+# ==============================================================================
@@ -93,6 +93,10 @@ TM_CALLABLE
 static long 
 queryPrice (TM_ARGDECL  MAP_T* tablePtr, long id);
 
+TM_CALLABLE
+static bool_t 
+reserveItem (TM_ARGDECL MAP_T* tablePtr, MAP_T* customerTablePtr, long customerId, long id, reservation_type_t type);
+
 TM_CALLABLE
 static bool_t 
 reserve (TM_ARGDECL MAP_T* tablePtr, MAP_T* customerTablePtr, long customerId, long id, reservation_type_t type);
@@ -632,15 +636,15 @@ manager_queryCustomerBill (TM_ARGDECL  manager_t* managerPtr, long customerId)
 
 
 /* =============================================================================
- * reserve
+ * reserveItem
  * -- Customer is not allowed to reserve same (type, id) multiple times
  * -- Returns TRUE on success, else FALSE
  * =============================================================================
  */
 static bool_t
-reserve (TM_ARGDECL
-         MAP_T* tablePtr, MAP_T* customerTablePtr,
-         long customerId, long id, reservation_type_t type)
+reserveItem (TM_ARGDECL
+             MAP_T* tablePtr, MAP_T* customerTablePtr,
+             long customerId, long id, reservation_type_t type)
 {
     customer_t* customerPtr;
     reservation_t* reservationPtr;
@@ -677,6 +681,29 @@ reserve (TM_ARGDECL
 }
 
 
+/* =============================================================================
+ * reserve
+ * -- A conflict on the item re-executes only this reservation, not the
+ *    queries of the client's transaction before it (see TM_BEGIN_NESTED)
+ * -- Returns TRUE on success, else FALSE
+ * =============================================================================
+ */
+static bool_t
+reserve (TM_ARGDECL
+         MAP_T* tablePtr, MAP_T* customerTablePtr,
+         long customerId, long id, reservation_type_t type)
+{
+    bool_t isReserved;
+
+    TM_BEGIN_NESTED();
+    isReserved = reserveItem(TM_ARG
+                             tablePtr, customerTablePtr, customerId, id, type);
+    TM_END_NESTED();
+
+    return isReserved;
+}
+
+
 /* =============================================================================
  * manager_reserveCar
  * -- Returns failure if the car or customer does not exist
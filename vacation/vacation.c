@@ -81,6 +81,7 @@
 #include "memory.h"
 #include "operation.h"
 #include "random.h"
+#include "report.h"
 #include "reservation.h"
 #include "thread.h"
 #include "timer.h"
@@ -419,6 +420,13 @@ MAIN(argc, argv)
     /* Initialization */
     parseArgs(argc, (char** const)argv);
     SIM_GET_NUM_CPU(global_params[PARAM_CLIENTS]);
+    report_startup("vacation", argc, (char**)argv);
+    report_addParam("clients", global_params[PARAM_CLIENTS]);
+    report_addParam("number", global_params[PARAM_NUMBER]);
+    report_addParam("queries", global_params[PARAM_QUERIES]);
+    report_addParam("relations", global_params[PARAM_RELATIONS]);
+    report_addParam("transactions", global_params[PARAM_TRANSACTIONS]);
+    report_addParam("user", global_params[PARAM_USER]);
     managerPtr = initializeManager();
     assert(managerPtr != NULL);
     clients = initializeClients(managerPtr);
@@ -447,7 +455,12 @@ MAIN(argc, argv)
     printf("Time = %0.6lf\n",
            TIMER_DIFF_SECONDS(start, stop));
     fflush(stdout);
+    report_addTime("total", TIMER_DIFF_SECONDS(start, stop));
+    report_setThroughput("transactions",
+                         global_params[PARAM_TRANSACTIONS],
+                         TIMER_DIFF_SECONDS(start, stop));
     checkTables(managerPtr);
+    report_setVerified(TRUE); /* checkTables asserts */
 
     /* Clean up */
     printf("Deallocating memory... ");
@@ -462,6 +475,7 @@ MAIN(argc, argv)
 
     TM_SHUTDOWN();
     P_MEMORY_SHUTDOWN();
+    report_write();
 
     GOTO_SIM();
 
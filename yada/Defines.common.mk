@@ -21,10 +21,14 @@ SRCS += \
 	$(LIB)/list.c \
 	$(LIB)/mt19937ar.c \
 	$(LIB)/pair.c \
+	$(LIB)/perfctr.c \
 	$(LIB)/queue.c \
 	$(LIB)/random.c \
 	$(LIB)/rbtree.c \
+	$(LIB)/report.c \
 	$(LIB)/thread.c \
+	$(LIB)/timer.c \
+	$(LIB)/tmbatch.c \
 	$(LIB)/vector.c \
 #
 OBJS := ${SRCS:.c=.o}
@@ -402,11 +402,11 @@ element_printAngles (element_t* elementPtr);
 
 
 #define PELEMENT_ALLOC(c, n)            Pelement_alloc(c, n)
-#define PELEMENT_FREE(e)                /*Pelement_free(e)*/
+#define PELEMENT_FREE(e)                Pelement_free(e)
 
 
 #define TMELEMENT_ALLOC(c, n)           TMelement_alloc(TM_ARG  c, n)
-#define TMELEMENT_FREE(e)               /*TMelement_free(TM_ARG  e)*/
+#define TMELEMENT_FREE(e)               TMelement_free(TM_ARG  e)
 #define TMELEMENT_ISREFERENCED(e)       TMelement_isReferenced(TM_ARG  e)
 #define TMELEMENT_SETISREFERENCED(e, s) TMelement_setIsReferenced(TM_ARG  e, s)
 #define TMELEMENT_ISGARBAGE(e)          TMelement_isGarbage(TM_ARG  e)
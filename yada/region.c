@@ -330,7 +330,13 @@ TMregion_refine (TM_ARGDECL
     MAP_T* edgeMapPtr = NULL;
     element_t* encroachElementPtr = NULL;
 
-    TMELEMENT_ISGARBAGE(elementPtr); /* so we can detect conflicts */
+    /*
+     * Another thread may have removed the element since it was checked; its
+     * neighbor list is then stale and may point to freed elements.
+     */
+    if (TMELEMENT_ISGARBAGE(elementPtr)) {
+        return 0;
+    }
 
     while (1) {
         edgeMapPtr = PMAP_ALLOC(NULL, &element_mapCompareEdge);
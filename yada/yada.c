@@ -77,6 +77,8 @@
 #include "list.h"
 #include "mesh.h"
 #include "heap.h"
+#include "linetrace.h"
+#include "report.h"
 #include "thread.h"
 #include "timer.h"
 #include "tm.h"
@@ -200,54 +202,76 @@ process ()
     regionPtr = PREGION_ALLOC();
     assert(regionPtr);
 
-    while (1) {
+    tmbatch_t batch;
+    element_t* elements[TMBATCH_MAX_SIZE];
+    long numElement;
+    long e;
 
-        element_t* elementPtr;
+    tmbatch_init(&batch);
 
-        TM_BEGIN();
-        elementPtr = TMHEAP_REMOVE(workHeapPtr);
-        TM_END();
-        if (elementPtr == NULL) {
-            break;
-        }
+    while (1) {
 
-        bool_t isGarbage;
-        TM_BEGIN();
-        isGarbage = TMELEMENT_ISGARBAGE(elementPtr);
-        TM_END();
-        if (isGarbage) {
-            /*
-             * Handle delayed deallocation
-             */
-            PELEMENT_FREE(elementPtr);
-            continue;
+        /* One transaction takes as many elements as the batch size allows */
+        TM_BATCH_BEGIN(&batch);
+        for (numElement = 0;
+             numElement < TM_BATCH_SIZE(&batch);
+             numElement++)
+        {
+            element_t* elementPtr = TMHEAP_REMOVE(workHeapPtr);
+            if (elementPtr == NULL) {
+                break;
+            }
+            elements[numElement] = elementPtr;
         }
-
-        long numAdded;
-
-        TM_BEGIN();
-        PREGION_CLEARBAD(regionPtr);
-        numAdded = TMREGION_REFINE(regionPtr, elementPtr, meshPtr);
-        TM_END();
-
-        TM_BEGIN();
-        TMELEMENT_SETISREFERENCED(elementPtr, FALSE);
-        isGarbage = TMELEMENT_ISGARBAGE(elementPtr);
-        TM_END();
-        if (isGarbage) {
-            /*
-             * Handle delayed deallocation
-             */
-            PELEMENT_FREE(elementPtr);
+        TM_BATCH_END(&batch);
+        if (numElement == 0) {
+            break;
         }
 
-        totalNumAdded += numAdded;
-
-        TM_BEGIN();
-        TMREGION_TRANSFERBAD(regionPtr, workHeapPtr);
-        TM_END();
-
-        numProcess++;
+        for (e = 0; e < numElement; e++) {
+
+            element_t* elementPtr = elements[e];
+
+            bool_t isGarbage;
+            TM_BEGIN();
+            isGarbage = TMELEMENT_ISGARBAGE(elementPtr);
+            if (isGarbage) {
+                /*
+                 * Handle delayed deallocation
+                 */
+                TMELEMENT_FREE(elementPtr);
+            }
+            TM_END();
+            if (isGarbage) {
+                continue;
+            }
+
+            long numAdded;
+
+            TM_BEGIN();
+            PREGION_CLEARBAD(regionPtr);
+            numAdded = TMREGION_REFINE(regionPtr, elementPtr, meshPtr);
+            TM_END();
+
+            TM_BEGIN();
+            TMELEMENT_SETISREFERENCED(elementPtr, FALSE);
+            isGarbage = TMELEMENT_ISGARBAGE(elementPtr);
+            if (isGarbage) {
+                /*
+                 * Handle delayed deallocation
+                 */
+                TMELEMENT_FREE(elementPtr);
+            }
+            TM_END();
+
+            totalNumAdded += numAdded;
+
+            TM_BEGIN();
+            TMREGION_TRANSFERBAD(regionPtr, workHeapPtr);
+            TM_END();
+
+            numProcess++;
+        }
 
     }
 
@@ -278,6 +302,10 @@ MAIN(argc, argv)
 
     parseArgs(argc, (char** const)argv);
     SIM_GET_NUM_CPU(global_numThread);
+    report_startup("yada", argc, (char**)argv);
+    report_addParam("angle", global_angleConstraint);
+    report_addParamString("input", global_inputPrefix);
+    report_addParam("threads", global_numThread);
     TM_STARTUP(global_numThread);
     P_MEMORY_STARTUP(global_numThread);
     thread_startup(global_numThread);
@@ -300,6 +328,9 @@ MAIN(argc, argv)
      * Run benchmark
      */
 
+    LINETRACE_NAME(global_totalNumAdded);
+    LINETRACE_NAME(global_numProcess);
+
     TIMER_T start;
     TIMER_READ(start);
     GOTO_SIM();
@@ -328,6 +359,10 @@ MAIN(argc, argv)
     printf("Final mesh size                 = %li\n", finalNumElement);
     printf("Number of elements processed    = %li\n", global_numProcess);
     fflush(stdout);
+    report_addTime("total", TIMER_DIFF_SECONDS(start, stop));
+    report_setThroughput("elements",
+                         global_numProcess,
+                         TIMER_DIFF_SECONDS(start, stop));
 
 #if 0
     bool_t isSuccess = mesh_check(global_meshPtr, finalNumElement);
@@ -344,6 +379,7 @@ MAIN(argc, argv)
 
     TM_SHUTDOWN();
     P_MEMORY_SHUTDOWN();
+    report_write(); /* mesh_check is disabled, so verified stays null */
 
     GOTO_SIM();
 